@@ -68,6 +68,10 @@ bool Function::raytracing() const noexcept {
     return _builder->raytracing();
 }
 
+bool Function::force_inline() const noexcept {
+    return _builder->force_inline();
+}
+
 std::span<const Function::HeapBinding> Function::captured_heaps() const noexcept {
     return _builder->captured_heaps();
 }
@@ -90,6 +90,7 @@ public:
     [[nodiscard]] const ScopeStmt *body() const noexcept;
     [[nodiscard]] uint64_t hash() const noexcept;
     [[nodiscard]] bool raytracing() const noexcept;
+    [[nodiscard]] bool force_inline() const noexcept;
     [[nodiscard]] auto builder() const noexcept { return _builder; }
     [[nodiscard]] auto operator==(Function rhs) const noexcept { return _builder == rhs._builder; }
 };
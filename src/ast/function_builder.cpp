@@ -77,6 +77,10 @@ void FunctionBuilder::_void_expr(const Expression *expr) noexcept {
     _append(_arena->create<ExprStmt>(expr));
 }
 
+void FunctionBuilder::void_(const Expression *expr) noexcept {
+    _void_expr(expr);
+}
+
 void FunctionBuilder::switch_(const Expression *expr, const ScopeStmt *body) noexcept {
     _append(_arena->create<SwitchStmt>(expr, body));
 }
@@ -312,9 +316,178 @@ void FunctionBuilder::call(Function custom, std::initializer_list<const Expressi
     _void_expr(call(nullptr, custom, args));
 }
 
+namespace {
+
+// Computes a structural hash of the AST that is stable across runs, i.e., it
+// depends only on types, ops, variable uids and constant contents but never on
+// addresses or captured resource handles.
+class FunctionHasher final : public ExprVisitor, public StmtVisitor {
+
+private:
+    uint64_t _hash;
+
+private:
+    template<typename T>
+    void _update_scalar(T x) noexcept { _hash = xxh3_hash64(&x, sizeof(T), _hash); }
+
+    template<typename T>
+    void _update_value(T v) noexcept {
+        if constexpr (is_scalar_v<T>) {
+            _update_scalar(v);
+        } else if constexpr (is_vector_v<T>) {
+            for (auto i = 0u; i < T::dimension; i++) { _update_scalar(v[i]); }
+        } else {
+            for (auto &&c : v.cols) { _update_value(c); }
+        }
+    }
+
+    void _update(const Type *t) noexcept { _update_scalar(t == nullptr ? 0ull : t->hash()); }
+    void _update(Variable v) noexcept {
+        _update(v.type());
+        _update_scalar(to_underlying(v.tag()));
+        _update_scalar(v.uid());
+    }
+    void _update(const Expression *expr) noexcept {
+        if (expr == nullptr) {
+            _update_scalar(~0ull);
+        } else {
+            _update_scalar(to_underlying(expr->tag()));
+            _update(expr->type());
+            expr->accept(*this);
+        }
+    }
+    void _update(const Statement *stmt) noexcept {
+        if (stmt == nullptr) {
+            _update_scalar(~0ull);
+        } else {
+            stmt->accept(*this);
+        }
+    }
+
+public:
+    explicit FunctionHasher(uint64_t seed) noexcept : _hash{seed} {}
+    [[nodiscard]] auto hash() const noexcept { return _hash; }
+
+    void visit(const UnaryExpr *expr) override {
+        _update_scalar(to_underlying(expr->op()));
+        _update(expr->operand());
+    }
+    void visit(const BinaryExpr *expr) override {
+        _update_scalar(to_underlying(expr->op()));
+        _update(expr->lhs());
+        _update(expr->rhs());
+    }
+    void visit(const MemberExpr *expr) override {
+        if (expr->is_swizzle()) {
+            _update_scalar(expr->swizzle_size());
+            for (auto i = 0u; i < expr->swizzle_size(); i++) { _update_scalar(expr->swizzle_index(i)); }
+        } else {
+            _update_scalar(expr->member_index());
+        }
+        _update(expr->self());
+    }
+    void visit(const AccessExpr *expr) override {
+        _update(expr->range());
+        _update(expr->index());
+    }
+    void visit(const LiteralExpr *expr) override {
+        _update_scalar(expr->value().index());
+        std::visit([this](auto v) noexcept { _update_value(v); }, expr->value());
+    }
+    void visit(const RefExpr *expr) override { _update(expr->variable()); }
+    void visit(const ConstantExpr *expr) override { _update_scalar(expr->data().hash()); }
+    void visit(const CallExpr *expr) override {
+        _update_scalar(to_underlying(expr->op()));
+        if (!expr->is_builtin()) { _update_scalar(expr->custom().hash()); }
+        _update_scalar(expr->arguments().size());
+        for (auto arg : expr->arguments()) { _update(arg); }
+    }
+    void visit(const CastExpr *expr) override {
+        _update_scalar(to_underlying(expr->op()));
+        _update(expr->expression());
+    }
+
+    void visit(const BreakStmt *) override { _update_scalar(0x0bu); }
+    void visit(const ContinueStmt *) override { _update_scalar(0x0cu); }
+    void visit(const ReturnStmt *stmt) override {
+        _update_scalar(0x0eu);
+        _update(stmt->expression());
+    }
+    void visit(const ScopeStmt *stmt) override {
+        _update_scalar(stmt->statements().size());
+        for (auto s : stmt->statements()) { _update(s); }
+    }
+    void visit(const DeclareStmt *stmt) override {
+        _update(stmt->variable());
+        _update_scalar(stmt->initializer().size());
+        for (auto i : stmt->initializer()) { _update(i); }
+    }
+    void visit(const IfStmt *stmt) override {
+        _update(stmt->condition());
+        _update(stmt->true_branch());
+        _update(stmt->false_branch());
+    }
+    void visit(const WhileStmt *stmt) override {
+        _update(stmt->condition());
+        _update(stmt->body());
+    }
+    void visit(const ExprStmt *stmt) override { _update(stmt->expression()); }
+    void visit(const SwitchStmt *stmt) override {
+        _update(stmt->expression());
+        _update(stmt->body());
+    }
+    void visit(const SwitchCaseStmt *stmt) override {
+        _update(stmt->expression());
+        _update(stmt->body());
+    }
+    void visit(const SwitchDefaultStmt *stmt) override { _update(stmt->body()); }
+    void visit(const AssignStmt *stmt) override {
+        _update_scalar(to_underlying(stmt->op()));
+        _update(stmt->lhs());
+        _update(stmt->rhs());
+    }
+    void visit(const ForStmt *stmt) override {
+        _update(stmt->initialization());
+        _update(stmt->condition());
+        _update(stmt->update());
+        _update(stmt->body());
+    }
+
+    void update(Function f) noexcept {
+        _update_scalar(to_underlying(f.tag()));
+        _update_value(f.block_size());
+        _update_scalar(f.raytracing());
+        for (auto v : f.arguments()) { _update(v); }
+        for (auto v : f.builtin_variables()) { _update(v); }
+        for (auto v : f.shared_variables()) { _update(v); }
+        for (auto &&b : f.captured_buffers()) { _update(b.variable); }
+        for (auto &&b : f.captured_textures()) { _update(b.variable); }
+        for (auto &&b : f.captured_heaps()) { _update(b.variable); }
+        for (auto &&b : f.captured_accels()) { _update(b.variable); }
+        _update(f.body());
+    }
+};
+
+}// namespace
+
 void FunctionBuilder::_compute_hash() noexcept {
-    // TODO: compute hash based on the AST
-    _hash = std::hash<uint64_t>{}(reinterpret_cast<uint64_t>(this));
+    FunctionHasher hasher{Hash{}("luisa-compute")};
+    hasher.update(function());
+    _hash = hasher.hash();
+}
+
+void FunctionBuilder::set_block_size(uint3 size) noexcept {
+    _block_size = size;
+    // block size is part of the function identity, so
+    // re-hash if the definition has already been finished
+    if (_scope_stack.empty()) { _compute_hash(); }
+}
+
+void FunctionBuilder::set_force_inline(bool force) noexcept {
+    if (_tag != Tag::CALLABLE) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Only callables can be marked as force-inline.");
+    }
+    _force_inline = force;
 }
 
 const RefExpr *FunctionBuilder::heap_binding(uint64_t handle) noexcept {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 
 #include <util/arena.h>
 #include <core/hash.h>
@@ -69,6 +70,7 @@ private:
     uint3 _block_size;
     Tag _tag;
     bool _raytracing{false};
+    bool _force_inline{false};
 
 protected:
     [[nodiscard]] static std::vector<FunctionBuilder *> &_function_stack() noexcept;
@@ -117,6 +119,7 @@ public:
     [[nodiscard]] auto block_size() const noexcept { return _block_size; }
     [[nodiscard]] auto hash() const noexcept { return _hash; }
     [[nodiscard]] auto raytracing() const noexcept { return _raytracing; }
+    [[nodiscard]] auto force_inline() const noexcept { return _force_inline; }
 
     // build primitives
     template<typename Def>
@@ -137,6 +140,19 @@ public:
         return std::shared_ptr<const FunctionBuilder>{f, [](FunctionBuilder *f) noexcept { delete f->_arena; }};
     }
 
+    // defines a kernel without inserting the dispatch range guard,
+    // for rebuilding kernels from already complete (e.g., transformed) ASTs;
+    // `retained` (e.g., the source kernel, whose arena owns the callables
+    // defined inside it) is kept alive until the new kernel is destroyed
+    template<typename Def>
+    static auto define_kernel_verbatim(Def &&def, std::shared_ptr<const void> retained = nullptr) noexcept {
+        auto arena = new Arena;
+        auto f = arena->create<FunctionBuilder>(arena, Function::Tag::KERNEL);
+        _define(f, std::forward<Def>(def));
+        return std::shared_ptr<const FunctionBuilder>{
+            f, [retained = std::move(retained)](FunctionBuilder *f) noexcept { delete f->_arena; }};
+    }
+
     template<typename Def>
     static auto define_callable(Def &&def) noexcept {
         auto arena = _function_stack().empty()              // callables use
@@ -148,7 +164,9 @@ public:
     }
 
     // config
-    void set_block_size(uint3 size) noexcept { _block_size = size; }
+    void set_block_size(uint3 size) noexcept;
+    // callables marked force-inline are always expanded into their callers by the inliner
+    void set_force_inline(bool force) noexcept;
 
     // built-in variables
     [[nodiscard]] const RefExpr *thread_id() noexcept;
@@ -192,6 +210,7 @@ public:
     void call(Function custom, std::span<const Expression *const> args) noexcept;
 
     // statements
+    void void_(const Expression *expr) noexcept;// evaluates expr for its side effects only
     void break_() noexcept;
     void continue_() noexcept;
     void return_(const Expression *expr = nullptr /* nullptr for void */) noexcept;
@@ -0,0 +1,777 @@
+//
+// Created by Mike Smith on 2021/9/6.
+//
+
+#include <map>
+#include <cstring>
+#include <unordered_map>
+
+#include <core/logging.h>
+#include <ast/function_builder.h>
+#include <ast/function_serializer.h>
+
+namespace luisa::compute {
+
+namespace {
+
+enum struct StmtTag : uint8_t {
+    BREAK,
+    CONTINUE,
+    RETURN,
+    SCOPE,
+    DECLARE,
+    IF,
+    WHILE,
+    EXPR,
+    SWITCH,
+    SWITCH_CASE,
+    SWITCH_DEFAULT,
+    ASSIGN,
+    FOR
+};
+
+// how a non-local variable enters the function
+enum struct VariableRole : uint8_t {
+    ARGUMENT,
+    BUILTIN,
+    SHARED,
+    CAPTURED
+};
+
+constexpr auto null_tag = 0xffu;
+
+class Writer {
+
+private:
+    std::vector<std::byte> _bytes;
+
+public:
+    void write_uint(uint64_t x) noexcept {
+        while (x >= 0x80u) {
+            _bytes.emplace_back(static_cast<std::byte>((x & 0x7fu) | 0x80u));
+            x >>= 7u;
+        }
+        _bytes.emplace_back(static_cast<std::byte>(x));
+    }
+    void write_bytes(const void *data, size_t size) noexcept {
+        auto p = static_cast<const std::byte *>(data);
+        _bytes.insert(_bytes.end(), p, p + size);
+    }
+    void write_tag(uint8_t tag) noexcept { _bytes.emplace_back(static_cast<std::byte>(tag)); }
+    void write(const Writer &other) noexcept { write_bytes(other._bytes.data(), other._bytes.size()); }
+    [[nodiscard]] auto &bytes() noexcept { return _bytes; }
+};
+
+class Reader {
+
+private:
+    std::span<const std::byte> _data;
+    size_t _offset{0u};
+
+private:
+    void _require(size_t size) const noexcept {
+        if (_offset + size > _data.size()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Truncated function blob (offset = {}, required = {}, size = {}).",
+                _offset, size, _data.size());
+        }
+    }
+
+public:
+    explicit Reader(std::span<const std::byte> data) noexcept : _data{data} {}
+    [[nodiscard]] uint64_t read_uint() noexcept {
+        auto x = 0ull;
+        for (auto shift = 0u; shift < 64u; shift += 7u) {
+            _require(1u);
+            auto b = static_cast<uint64_t>(_data[_offset++]);
+            x |= (b & 0x7fu) << shift;
+            if ((b & 0x80u) == 0u) { return x; }
+        }
+        LUISA_ERROR_WITH_LOCATION("Malformed integer in function blob at offset {}.", _offset);
+    }
+    [[nodiscard]] uint32_t read_uint32() noexcept {
+        auto x = read_uint();
+        if (x > std::numeric_limits<uint32_t>::max()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Integer {} out of range in function blob.", x);
+        }
+        return static_cast<uint32_t>(x);
+    }
+    void read_bytes(void *data, size_t size) noexcept {
+        _require(size);
+        std::memcpy(data, _data.data() + _offset, size);
+        _offset += size;
+    }
+    [[nodiscard]] uint8_t read_tag() noexcept {
+        _require(1u);
+        return static_cast<uint8_t>(_data[_offset++]);
+    }
+    [[nodiscard]] auto remaining() const noexcept { return _data.size() - _offset; }
+    [[nodiscard]] auto exhausted() const noexcept { return _offset == _data.size(); }
+};
+
+// Layout (all integers LEB128):
+//   magic, version, root tag, root hash,
+//   #types, { description length, description }...,
+//   #constants, { basic type index, #elements, raw elements }...,
+//   #functions, { function }... (callees first, the root last),
+// where each function is
+//   hash, tag, block size (x, y, z), force inline,
+//   #variables, { uid, variable tag, type index, role[, handle[, offset]] }...,
+//   body statements.
+// Type index 0 denotes no type (e.g., void calls), others are 1-based.
+class Serializer final : public ExprVisitor, public StmtVisitor {
+
+private:
+    Writer _body;
+    std::vector<const Type *> _types;
+    std::unordered_map<uint64_t, uint32_t> _type_indices;
+    std::vector<ConstantData> _constants;
+    std::unordered_map<uint64_t, uint32_t> _constant_indices;
+    std::vector<Function> _functions;
+    std::unordered_map<uint64_t, uint32_t> _function_indices;
+
+private:
+    [[nodiscard]] uint32_t _type_index(const Type *t) noexcept {
+        if (t == nullptr) { return 0u; }
+        auto [iter, first] = _type_indices.try_emplace(t->hash(), static_cast<uint32_t>(_types.size() + 1u));
+        if (first) { _types.emplace_back(t); }
+        return iter->second;
+    }
+
+    void _collect(Function f) noexcept {
+        if (_function_indices.contains(f.hash())) { return; }
+        for (auto c : f.custom_callables()) { _collect(c); }
+        for (auto c : f.constants()) {
+            if (_constant_indices.try_emplace(c.data.hash(), static_cast<uint32_t>(_constants.size())).second) {
+                _constants.emplace_back(c.data);
+            }
+        }
+        _function_indices.emplace(f.hash(), static_cast<uint32_t>(_functions.size()));
+        _functions.emplace_back(f);
+    }
+
+    void _write(const Expression *expr) noexcept {
+        if (expr == nullptr) {
+            _body.write_tag(null_tag);
+            return;
+        }
+        _body.write_tag(static_cast<uint8_t>(expr->tag()));
+        _body.write_uint(_type_index(expr->type()));
+        expr->accept(*this);
+    }
+
+    void _write(const Statement *stmt) noexcept {
+        if (stmt == nullptr) {
+            _body.write_tag(null_tag);
+            return;
+        }
+        stmt->accept(*this);
+    }
+
+    void _write_scope(const ScopeStmt *scope) noexcept {
+        _body.write_uint(scope->statements().size());
+        for (auto s : scope->statements()) { _write(s); }
+    }
+
+    void _write_variable(Variable v, VariableRole role) noexcept {
+        _body.write_uint(v.uid());
+        _body.write_uint(to_underlying(v.tag()));
+        _body.write_uint(_type_index(v.type()));
+        _body.write_tag(to_underlying(role));
+    }
+
+    void _write_function(Function f) noexcept {
+        _body.write_uint(f.hash());
+        _body.write_uint(to_underlying(f.tag()));
+        for (auto i = 0u; i < 3u; i++) { _body.write_uint(f.block_size()[i]); }
+        _body.write_tag(f.force_inline());
+        _body.write_uint(f.arguments().size() + f.builtin_variables().size() +
+                         f.shared_variables().size() + f.captured_buffers().size() +
+                         f.captured_textures().size() + f.captured_heaps().size() +
+                         f.captured_accels().size());
+        for (auto v : f.arguments()) { _write_variable(v, VariableRole::ARGUMENT); }
+        for (auto v : f.builtin_variables()) { _write_variable(v, VariableRole::BUILTIN); }
+        for (auto v : f.shared_variables()) { _write_variable(v, VariableRole::SHARED); }
+        for (auto &&b : f.captured_buffers()) {
+            _write_variable(b.variable, VariableRole::CAPTURED);
+            _body.write_uint(b.handle);
+            _body.write_uint(b.offset_bytes);
+        }
+        auto write_captured = [this](auto bindings) noexcept {
+            for (auto &&b : bindings) {
+                _write_variable(b.variable, VariableRole::CAPTURED);
+                _body.write_uint(b.handle);
+            }
+        };
+        write_captured(f.captured_textures());
+        write_captured(f.captured_heaps());
+        write_captured(f.captured_accels());
+        _write_scope(f.body());
+    }
+
+public:
+    void visit(const UnaryExpr *expr) override {
+        _body.write_uint(to_underlying(expr->op()));
+        _write(expr->operand());
+    }
+    void visit(const BinaryExpr *expr) override {
+        _body.write_uint(to_underlying(expr->op()));
+        _write(expr->lhs());
+        _write(expr->rhs());
+    }
+    void visit(const MemberExpr *expr) override {
+        if (expr->is_swizzle()) {
+            auto code = 0ull;
+            for (auto i = 0u; i < expr->swizzle_size(); i++) {
+                code |= static_cast<uint64_t>(expr->swizzle_index(i)) << (i * 4u);
+            }
+            _body.write_uint(expr->swizzle_size());
+            _body.write_uint(code);
+        } else {
+            _body.write_uint(0u);
+            _body.write_uint(expr->member_index());
+        }
+        _write(expr->self());
+    }
+    void visit(const AccessExpr *expr) override {
+        _write(expr->range());
+        _write(expr->index());
+    }
+    void visit(const LiteralExpr *expr) override {
+        _body.write_uint(expr->value().index());
+        std::visit([this](auto v) noexcept { _body.write_bytes(&v, sizeof(v)); }, expr->value());
+    }
+    void visit(const RefExpr *expr) override { _body.write_uint(expr->variable().uid()); }
+    void visit(const ConstantExpr *expr) override {
+        auto iter = _constant_indices.find(expr->data().hash());
+        if (iter == _constant_indices.cend()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Constant #{} is not captured by the function.",
+                hash_to_string(expr->data().hash()));
+        }
+        _body.write_uint(iter->second);
+    }
+    void visit(const CallExpr *expr) override {
+        _body.write_uint(to_underlying(expr->op()));
+        if (!expr->is_builtin()) { _body.write_uint(_function_indices.at(expr->custom().hash())); }
+        _body.write_uint(expr->arguments().size());
+        for (auto arg : expr->arguments()) { _write(arg); }
+    }
+    void visit(const CastExpr *expr) override {
+        _body.write_uint(to_underlying(expr->op()));
+        _write(expr->expression());
+    }
+
+    void visit(const BreakStmt *) override { _body.write_tag(to_underlying(StmtTag::BREAK)); }
+    void visit(const ContinueStmt *) override { _body.write_tag(to_underlying(StmtTag::CONTINUE)); }
+    void visit(const ReturnStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::RETURN));
+        _write(stmt->expression());
+    }
+    void visit(const ScopeStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::SCOPE));
+        _write_scope(stmt);
+    }
+    void visit(const DeclareStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::DECLARE));
+        _body.write_uint(stmt->variable().uid());
+        _body.write_uint(_type_index(stmt->variable().type()));
+        _body.write_uint(stmt->initializer().size());
+        for (auto i : stmt->initializer()) { _write(i); }
+    }
+    void visit(const IfStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::IF));
+        _write(stmt->condition());
+        _write_scope(stmt->true_branch());
+        _body.write_tag(stmt->false_branch() != nullptr);
+        if (stmt->false_branch() != nullptr) { _write_scope(stmt->false_branch()); }
+    }
+    void visit(const WhileStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::WHILE));
+        _write(stmt->condition());
+        _write_scope(stmt->body());
+    }
+    void visit(const ExprStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::EXPR));
+        _write(stmt->expression());
+    }
+    void visit(const SwitchStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::SWITCH));
+        _write(stmt->expression());
+        _write_scope(stmt->body());
+    }
+    void visit(const SwitchCaseStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::SWITCH_CASE));
+        _write(stmt->expression());
+        _write_scope(stmt->body());
+    }
+    void visit(const SwitchDefaultStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::SWITCH_DEFAULT));
+        _write_scope(stmt->body());
+    }
+    void visit(const AssignStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::ASSIGN));
+        _body.write_uint(to_underlying(stmt->op()));
+        _write(stmt->lhs());
+        _write(stmt->rhs());
+    }
+    void visit(const ForStmt *stmt) override {
+        _body.write_tag(to_underlying(StmtTag::FOR));
+        _write(stmt->initialization());
+        _write(stmt->condition());
+        _write(stmt->update());
+        _write_scope(stmt->body());
+    }
+
+    [[nodiscard]] std::vector<std::byte> serialize(Function root) noexcept {
+        _collect(root);
+        _body.write_uint(_functions.size());
+        for (auto f : _functions) {
+            if (!f.captured_buffers().empty() || !f.captured_textures().empty() ||
+                !f.captured_heaps().empty() || !f.captured_accels().empty()) {
+                LUISA_WARNING_WITH_LOCATION(
+                    "Function #{} captures resources, which are serialized "
+                    "by handle and not portable across processes.",
+                    hash_to_string(f.hash()));
+            }
+            _write_function(f);
+        }
+        Writer w;
+        w.write_uint(FunctionSerializer::magic);
+        w.write_uint(FunctionSerializer::version);
+        w.write_uint(to_underlying(root.tag()));
+        w.write_uint(root.hash());
+        w.write_uint(_types.size());
+        for (auto t : _types) {
+            auto desc = t->description();
+            w.write_uint(desc.size());
+            w.write_bytes(desc.data(), desc.size());
+        }
+        w.write_uint(_constants.size());
+        for (auto &&c : _constants) {
+            w.write_uint(c.view().index());
+            std::visit(
+                [&w](auto view) noexcept {
+                    w.write_uint(view.size());
+                    w.write_bytes(view.data(), view.size_bytes());
+                },
+                c.view());
+        }
+        w.write(_body);
+        return std::move(w.bytes());
+    }
+};
+
+class Deserializer {
+
+private:
+    struct PendingVariable {
+        Variable::Tag tag;
+        VariableRole role;
+        const Type *type;
+        uint64_t handle;
+        size_t offset_bytes;
+    };
+
+private:
+    Reader _reader;
+    Function::Tag _root_tag{};
+    uint64_t _root_hash{};
+    std::vector<const Type *> _types;
+    std::vector<ConstantData> _constants;
+    std::vector<Function> _functions;
+    detail::FunctionBuilder *_builder{nullptr};
+    std::map<uint32_t, PendingVariable> _pending_variables;
+    std::unordered_map<uint32_t, const RefExpr *> _variables;
+
+private:
+    [[nodiscard]] const Type *_read_type() noexcept {
+        auto index = _reader.read_uint();
+        if (index == 0u) { return nullptr; }
+        if (index > _types.size()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid type index {} in function blob.", index);
+        }
+        return _types[index - 1u];
+    }
+
+    template<typename T, size_t... i>
+    [[nodiscard]] T _read_variant(size_t index, std::index_sequence<i...>) noexcept {
+        T value;
+        auto read = [&]<size_t k>(std::integral_constant<size_t, k>) noexcept {
+            std::variant_alternative_t<k, T> x;
+            _reader.read_bytes(&x, sizeof(x));
+            value = x;
+        };
+        if (!((index == i ? (read(std::integral_constant<size_t, i>{}), true) : false) || ...)) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid literal type index {} in function blob.", index);
+        }
+        return value;
+    }
+
+    template<size_t... i>
+    [[nodiscard]] ConstantData _read_constant(size_t index, std::index_sequence<i...>) noexcept {
+        ConstantData data;
+        auto read = [&]<size_t k>(std::integral_constant<size_t, k>) noexcept {
+            using T = std::tuple_element_t<k, basic_types>;
+            auto count = _reader.read_uint();
+            if (count > _reader.remaining() / sizeof(T)) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION("Truncated constant data ({} elements) in function blob.", count);
+            }
+            auto elements = std::make_unique<T[]>(count);// not std::vector, for bool
+            _reader.read_bytes(elements.get(), count * sizeof(T));
+            data = ConstantData::create(std::span<const T>{elements.get(), count});
+        };
+        if (!((index == i ? (read(std::integral_constant<size_t, i>{}), true) : false) || ...)) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid constant type index {} in function blob.", index);
+        }
+        return data;
+    }
+
+    // variables are created in the order of their uids, so that
+    // the rebuilt function gets the same uids and hence the same hash
+    void _create_variables_until(uint32_t uid, bool inclusive) noexcept {
+        auto f = _builder;
+        auto end = inclusive ? _pending_variables.upper_bound(uid) : _pending_variables.lower_bound(uid);
+        for (auto iter = _pending_variables.begin(); iter != end; iter = _pending_variables.erase(iter)) {
+            auto &&[v_uid, v] = *iter;
+            auto ref = [&]() noexcept -> const RefExpr * {
+                switch (v.role) {
+                    case VariableRole::ARGUMENT:
+                        switch (v.tag) {
+                            case Variable::Tag::LOCAL: return f->argument(v.type);
+                            case Variable::Tag::BUFFER: return f->buffer(v.type);
+                            case Variable::Tag::TEXTURE: return f->texture(v.type);
+                            case Variable::Tag::HEAP: return f->heap();
+                            case Variable::Tag::ACCEL: return f->accel();
+                            default: break;
+                        }
+                        break;
+                    case VariableRole::BUILTIN:
+                        switch (v.tag) {
+                            case Variable::Tag::THREAD_ID: return f->thread_id();
+                            case Variable::Tag::BLOCK_ID: return f->block_id();
+                            case Variable::Tag::DISPATCH_ID: return f->dispatch_id();
+                            case Variable::Tag::DISPATCH_SIZE: return f->dispatch_size();
+                            default: break;
+                        }
+                        break;
+                    case VariableRole::SHARED: return f->shared(v.type);
+                    case VariableRole::CAPTURED:
+                        switch (v.tag) {
+                            case Variable::Tag::BUFFER: return f->buffer_binding(v.type, v.handle, v.offset_bytes);
+                            case Variable::Tag::TEXTURE: return f->texture_binding(v.type, v.handle);
+                            case Variable::Tag::HEAP: return f->heap_binding(v.handle);
+                            case Variable::Tag::ACCEL: return f->accel_binding(v.handle);
+                            default: break;
+                        }
+                        break;
+                }
+                LUISA_ERROR_WITH_LOCATION(
+                    "Invalid variable #{} (tag = {}, role = {}) in function blob.",
+                    v_uid, to_underlying(v.tag), to_underlying(v.role));
+            }();
+            _variables.emplace(v_uid, ref);
+        }
+    }
+
+    [[nodiscard]] const RefExpr *_variable(uint32_t uid) noexcept {
+        if (auto iter = _variables.find(uid); iter != _variables.cend()) { return iter->second; }
+        _create_variables_until(uid, true);
+        auto iter = _variables.find(uid);
+        if (iter == _variables.cend()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Variable #{} referenced before declaration in function blob.", uid);
+        }
+        return iter->second;
+    }
+
+    [[nodiscard]] Function _function(uint64_t index) const noexcept {
+        if (index >= _functions.size()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid callable index {} in function blob.", index);
+        }
+        return _functions[index];
+    }
+
+    [[nodiscard]] std::vector<const Expression *> _read_arguments() noexcept {
+        std::vector<const Expression *> args(_reader.read_uint());
+        for (auto &&arg : args) { arg = _read_expression(); }
+        return args;
+    }
+
+    // calls in expression statements are issued as statements without result types
+    [[nodiscard]] const CallExpr *_read_call(const Type *type, bool as_statement = false) noexcept {
+        auto f = _builder;
+        auto op = static_cast<CallOp>(_reader.read_uint32());
+        auto custom = op == CallOp::CUSTOM ? _function(_reader.read_uint()) : Function{};
+        auto args = _read_arguments();
+        std::span<const Expression *const> arg_span{args};
+        if (as_statement) {
+            if (op == CallOp::CUSTOM) {
+                f->call(custom, arg_span);
+            } else {
+                f->call(op, arg_span);
+            }
+            return nullptr;
+        }
+        return op == CallOp::CUSTOM ? f->call(type, custom, arg_span) : f->call(type, op, arg_span);
+    }
+
+    [[nodiscard]] const Expression *_read_expression() noexcept {
+        auto f = _builder;
+        auto tag = _reader.read_tag();
+        if (tag == null_tag) { return nullptr; }
+        auto type = _read_type();
+        switch (static_cast<Expression::Tag>(tag)) {
+            case Expression::Tag::UNARY: {
+                auto op = static_cast<UnaryOp>(_reader.read_uint32());
+                return f->unary(type, op, _read_expression());
+            }
+            case Expression::Tag::BINARY: {
+                auto op = static_cast<BinaryOp>(_reader.read_uint32());
+                auto lhs = _read_expression();
+                auto rhs = _read_expression();
+                return f->binary(type, op, lhs, rhs);
+            }
+            case Expression::Tag::MEMBER: {
+                auto swizzle_size = _reader.read_uint();
+                auto code = _reader.read_uint();
+                auto self = _read_expression();
+                return swizzle_size == 0u ? f->member(type, self, code) :
+                                            f->swizzle(type, self, swizzle_size, code);
+            }
+            case Expression::Tag::ACCESS: {
+                auto range = _read_expression();
+                auto index = _read_expression();
+                return f->access(type, range, index);
+            }
+            case Expression::Tag::LITERAL: {
+                using Value = LiteralExpr::Value;
+                auto index = _reader.read_uint();
+                return f->literal(type, _read_variant<Value>(index, std::make_index_sequence<std::variant_size_v<Value>>{}));
+            }
+            case Expression::Tag::REF: return _variable(_reader.read_uint32());
+            case Expression::Tag::CONSTANT: {
+                auto index = _reader.read_uint();
+                if (index >= _constants.size()) [[unlikely]] {
+                    LUISA_ERROR_WITH_LOCATION("Invalid constant index {} in function blob.", index);
+                }
+                return f->constant(type, _constants[index]);
+            }
+            case Expression::Tag::CALL: return _read_call(type);
+            case Expression::Tag::CAST: {
+                auto op = static_cast<CastOp>(_reader.read_uint32());
+                return f->cast(type, op, _read_expression());
+            }
+        }
+        LUISA_ERROR_WITH_LOCATION("Invalid expression tag {} in function blob.", tag);
+    }
+
+    void _read_statements() noexcept {
+        auto count = _reader.read_uint();
+        for (auto i = 0u; i < count; i++) { _read_statement(); }
+    }
+
+    [[nodiscard]] ScopeStmt *_read_scope() noexcept {
+        auto s = _builder->scope();
+        _builder->with(s, [this] { _read_statements(); });
+        return s;
+    }
+
+    // returns false for null statements
+    bool _read_statement() noexcept {
+        auto f = _builder;
+        auto tag = _reader.read_tag();
+        if (tag == null_tag) { return false; }
+        switch (static_cast<StmtTag>(tag)) {
+            case StmtTag::BREAK: f->break_(); break;
+            case StmtTag::CONTINUE: f->continue_(); break;
+            case StmtTag::RETURN: f->return_(_read_expression()); break;
+            case StmtTag::SCOPE: _read_statements(); break;
+            case StmtTag::DECLARE: {
+                auto uid = _reader.read_uint32();
+                auto type = _read_type();
+                auto init = _read_arguments();
+                _create_variables_until(uid, false);
+                _variables.emplace(uid, f->local(type, std::span<const Expression *>{init}));
+                break;
+            }
+            case StmtTag::IF: {
+                auto cond = _read_expression();
+                auto true_branch = _read_scope();
+                auto false_branch = _reader.read_tag() ? _read_scope() : nullptr;
+                f->if_(cond, true_branch, false_branch);
+                break;
+            }
+            case StmtTag::WHILE: {
+                auto cond = _read_expression();
+                f->while_(cond, _read_scope());
+                break;
+            }
+            case StmtTag::EXPR: {
+                if (_reader.read_tag() != to_underlying(Expression::Tag::CALL)) [[unlikely]] {
+                    LUISA_ERROR_WITH_LOCATION("Only calls are allowed in expression statements.");
+                }
+                static_cast<void>(_read_type());
+                static_cast<void>(_read_call(nullptr, true));
+                break;
+            }
+            case StmtTag::SWITCH: {
+                auto expr = _read_expression();
+                f->switch_(expr, _read_scope());
+                break;
+            }
+            case StmtTag::SWITCH_CASE: {
+                auto expr = _read_expression();
+                f->case_(expr, _read_scope());
+                break;
+            }
+            case StmtTag::SWITCH_DEFAULT: f->default_(_read_scope()); break;
+            case StmtTag::ASSIGN: {
+                auto op = static_cast<AssignOp>(_reader.read_uint32());
+                auto lhs = _read_expression();
+                auto rhs = _read_expression();
+                f->assign(op, lhs, rhs);
+                break;
+            }
+            case StmtTag::FOR: {
+                // same as the DSL, initialization and update are
+                // recorded into a detached scope
+                auto header = f->scope();
+                auto init = f->with(header, [&] { return _read_statement(); }) ? header->statements().back() : nullptr;
+                auto cond = _read_expression();
+                auto update = f->with(header, [&] { return _read_statement(); }) ? header->statements().back() : nullptr;
+                f->for_(init, cond, update, _read_scope());
+                break;
+            }
+            default: LUISA_ERROR_WITH_LOCATION("Invalid statement tag {} in function blob.", tag);
+        }
+        return true;
+    }
+
+    // reads one function record into the current builder, returns the serialized hash
+    [[nodiscard]] uint64_t _read_function(Function::Tag expected_tag) noexcept {
+        _builder = detail::FunctionBuilder::current();
+        _pending_variables.clear();
+        _variables.clear();
+        auto hash = _reader.read_uint();
+        auto tag = static_cast<Function::Tag>(_reader.read_uint32());
+        if (tag != expected_tag) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Unexpected function tag {} in function blob.", to_underlying(tag));
+        }
+        uint3 block_size;
+        for (auto i = 0u; i < 3u; i++) { block_size[i] = _reader.read_uint32(); }
+        _builder->set_block_size(block_size);
+        if (_reader.read_tag()) { _builder->set_force_inline(true); }
+        auto variable_count = _reader.read_uint();
+        for (auto i = 0u; i < variable_count; i++) {
+            auto uid = _reader.read_uint32();
+            PendingVariable v{};
+            v.tag = static_cast<Variable::Tag>(_reader.read_uint32());
+            v.type = _read_type();
+            v.role = static_cast<VariableRole>(_reader.read_tag());
+            if (v.role == VariableRole::CAPTURED) {
+                v.handle = _reader.read_uint();
+                if (v.tag == Variable::Tag::BUFFER) { v.offset_bytes = _reader.read_uint(); }
+            }
+            _pending_variables.emplace(uid, v);
+        }
+        _read_statements();
+        // unused arguments and the like
+        _create_variables_until(std::numeric_limits<uint32_t>::max(), true);
+        return hash;
+    }
+
+    void _check_hash(Function f, uint64_t expected) const noexcept {
+        if (f.hash() != expected) [[unlikely]] {
+            LUISA_WARNING_WITH_LOCATION(
+                "Hash mismatch for loaded function (expected {}, got {}).",
+                hash_to_string(expected), hash_to_string(f.hash()));
+        }
+    }
+
+    void _read_callables(size_t count) noexcept {
+        for (auto i = 0u; i < count; i++) {
+            auto hash = 0ull;
+            auto callable = detail::FunctionBuilder::define_callable([this, &hash] {
+                hash = _read_function(Function::Tag::CALLABLE);
+            });
+            _check_hash(callable->function(), hash);
+            _functions.emplace_back(callable->function());
+        }
+    }
+
+public:
+    explicit Deserializer(std::span<const std::byte> data) noexcept : _reader{data} {
+        if (auto magic = _reader.read_uint(); magic != FunctionSerializer::magic) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid function blob (magic = {:08x}).", magic);
+        }
+        if (auto version = _reader.read_uint(); version != FunctionSerializer::version) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Unsupported function blob version {} (expected {}).",
+                version, FunctionSerializer::version);
+        }
+        _root_tag = static_cast<Function::Tag>(_reader.read_uint32());
+        _root_hash = _reader.read_uint();
+        _types.resize(_reader.read_uint());
+        for (auto &&t : _types) {
+            std::string desc(_reader.read_uint(), '\0');
+            _reader.read_bytes(desc.data(), desc.size());
+            t = Type::from(desc);
+        }
+        // constants must be created outside any function builder to live in the global arena
+        _constants.resize(_reader.read_uint());
+        for (auto &&c : _constants) {
+            auto index = _reader.read_uint();
+            c = _read_constant(index, std::make_index_sequence<std::tuple_size_v<basic_types>>{});
+        }
+    }
+
+    [[nodiscard]] auto load_kernel() noexcept {
+        if (_root_tag != Function::Tag::KERNEL) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Function blob does not contain a kernel.");
+        }
+        auto count = _reader.read_uint();
+        if (count == 0u) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Empty function blob."); }
+        // callables are defined inside the kernel so that they share its arena
+        auto kernel = detail::FunctionBuilder::define_kernel_verbatim([this, count] {
+            _read_callables(count - 1u);
+            static_cast<void>(_read_function(Function::Tag::KERNEL));
+        });
+        _finish(kernel->function());
+        return kernel;
+    }
+
+    [[nodiscard]] auto load_callable() noexcept {
+        if (_root_tag != Function::Tag::CALLABLE) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Function blob does not contain a callable.");
+        }
+        auto count = _reader.read_uint();
+        if (count == 0u) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Empty function blob."); }
+        _read_callables(count);
+        auto callable = _functions.back().builder();
+        _finish(callable->function());
+        return callable;
+    }
+
+    void _finish(Function root) noexcept {
+        _check_hash(root, _root_hash);
+        if (!_reader.exhausted()) [[unlikely]] {
+            LUISA_WARNING_WITH_LOCATION("Trailing bytes in function blob.");
+        }
+    }
+};
+
+}// namespace
+
+std::vector<std::byte> FunctionSerializer::serialize(Function f) noexcept {
+    return Serializer{}.serialize(f);
+}
+
+std::shared_ptr<const detail::FunctionBuilder> FunctionSerializer::deserialize_kernel(std::span<const std::byte> data) noexcept {
+    return Deserializer{data}.load_kernel();
+}
+
+const detail::FunctionBuilder *FunctionSerializer::deserialize_callable(std::span<const std::byte> data) noexcept {
+    return Deserializer{data}.load_callable();
+}
+
+}// namespace luisa::compute
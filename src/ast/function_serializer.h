@@ -0,0 +1,43 @@
+//
+// Created by Mike Smith on 2021/9/6.
+//
+
+#pragma once
+
+#include <span>
+#include <vector>
+#include <memory>
+
+#include <ast/function.h>
+
+namespace luisa::compute {
+
+namespace detail {
+class FunctionBuilder;
+}
+
+// Compact, versioned binary format for function ASTs, so that kernels can be
+// shipped pre-built and loaded without re-running the DSL definitions.
+//   - types are referenced by their descriptions, stored once per blob;
+//   - constant arrays are stored once per blob and shared by all functions;
+//   - callables are stored once, callees before callers, followed by the root;
+//   - integers are LEB128-encoded, literal and constant payloads are raw
+//     host-endian bytes.
+// Loading replays the original builder calls, so loaded functions have the
+// same hashes as the serialized ones. Captured resources are stored by
+// handle and only valid within the process that created them; libraries
+// should pass resources as arguments instead.
+class FunctionSerializer {
+
+public:
+    static constexpr uint32_t magic = 0x4e46434cu;// "LCFN"
+    static constexpr uint32_t version = 1u;
+
+public:
+    [[nodiscard]] static std::vector<std::byte> serialize(Function f) noexcept;
+    [[nodiscard]] static std::shared_ptr<const detail::FunctionBuilder> deserialize_kernel(std::span<const std::byte> data) noexcept;
+    // loaded callables live in the global arena, like callables defined in global scope
+    [[nodiscard]] static const detail::FunctionBuilder *deserialize_callable(std::span<const std::byte> data) noexcept;
+};
+
+}// namespace luisa::compute
@@ -173,6 +173,9 @@ enum struct CallOp : uint32_t {
     MAKE_FLOAT2,
     MAKE_FLOAT3,
     MAKE_FLOAT4,
+    MAKE_HALF2,
+    MAKE_HALF3,
+    MAKE_HALF4,
 
     MAKE_FLOAT2X2,
     MAKE_FLOAT3X3,
@@ -62,6 +62,7 @@ const Type *Type::from(std::string_view description) noexcept {
         TRY_PARSE_SCALAR_TYPE(float, FLOAT)
         TRY_PARSE_SCALAR_TYPE(int, INT)
         TRY_PARSE_SCALAR_TYPE(uint, UINT)
+        TRY_PARSE_SCALAR_TYPE(half, HALF)
 #undef TRY_PARSE_SCALAR_TYPE
 
         if (type_identifier == "vector"sv) {
@@ -34,6 +34,7 @@ public:
         FLOAT,
         INT,
         UINT,
+        HALF,
 
         VECTOR,
         MATRIX,
@@ -90,7 +91,8 @@ public:
         return _tag == Tag::BOOL
                || _tag == Tag::FLOAT
                || _tag == Tag::INT
-               || _tag == Tag::UINT;
+               || _tag == Tag::UINT
+               || _tag == Tag::HALF;
     }
 
     [[nodiscard]] constexpr bool is_array() const noexcept { return _tag == Tag::ARRAY; }
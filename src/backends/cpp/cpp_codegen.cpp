@@ -0,0 +1,538 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#include <core/hash.h>
+#include <core/logging.h>
+#include <backends/cpp/cpp_codegen.h>
+
+namespace luisa::compute::cpp {
+
+void CppJitCodegen::emit(Function f) {
+    _emit_preamble();
+    _emit_type_decl();
+    _emit_function(f);
+    _emit_entry(f);
+}
+
+void CppJitCodegen::visit(const MemberExpr *expr) {
+    // multi-component swizzles are member functions of luisa::Vector
+    CppCodegen::visit(expr);
+    if (expr->is_swizzle() && expr->swizzle_size() > 1u) { _scratch << "()"; }
+}
+
+void CppJitCodegen::visit(const CallExpr *expr) {
+    switch (expr->op()) {
+        case CallOp::CUSTOM:
+            _scratch << "custom_" << hash_to_string(expr->custom().hash()) << "(";
+            for (auto arg : expr->arguments()) {
+                arg->accept(*this);
+                _scratch << ", ";
+            }
+            _scratch << "tid, bid, did, ls)";
+            return;
+        case CallOp::GROUP_MEMORY_BARRIER:
+            LUISA_ERROR_WITH_LOCATION(
+                "Block-level barriers are not supported by the C++ JIT backend.");
+        case CallOp::TEXTURE_READ:
+        case CallOp::TEXTURE_WRITE:
+        case CallOp::TEXTURE_HEAP_SAMPLE2D:
+        case CallOp::TEXTURE_HEAP_SAMPLE2D_LEVEL:
+        case CallOp::TEXTURE_HEAP_SAMPLE2D_GRAD:
+        case CallOp::TEXTURE_HEAP_SAMPLE3D:
+        case CallOp::TEXTURE_HEAP_SAMPLE3D_LEVEL:
+        case CallOp::TEXTURE_HEAP_SAMPLE3D_GRAD:
+        case CallOp::TEXTURE_HEAP_READ2D:
+        case CallOp::TEXTURE_HEAP_READ3D:
+        case CallOp::TEXTURE_HEAP_READ2D_LEVEL:
+        case CallOp::TEXTURE_HEAP_READ3D_LEVEL:
+        case CallOp::TEXTURE_HEAP_SIZE2D:
+        case CallOp::TEXTURE_HEAP_SIZE3D:
+        case CallOp::TEXTURE_HEAP_SIZE2D_LEVEL:
+        case CallOp::TEXTURE_HEAP_SIZE3D_LEVEL:
+        case CallOp::BUFFER_HEAP_READ:
+            LUISA_ERROR_WITH_LOCATION(
+                "Textures and heaps are not supported by the C++ JIT backend.");
+        case CallOp::TRACE_CLOSEST:
+        case CallOp::TRACE_ANY:
+            LUISA_ERROR_WITH_LOCATION(
+                "Ray tracing is not supported by the C++ JIT backend.");
+        default: break;
+    }
+    // the remaining builtins are implemented in the preamble with an `lc_` prefix
+    _scratch << "lc_";
+    CppCodegen::visit(expr);
+}
+
+void CppJitCodegen::_emit_function(Function f) noexcept {
+
+    if (!_generated_functions.emplace(f.hash()).second) { return; }
+
+    for (auto callable : f.custom_callables()) { _emit_function(callable); }
+
+    auto hash = hash_to_string(f.hash());
+    if (!f.shared_variables().empty()) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Shared variables in function #{} are not supported by the C++ JIT backend.", hash);
+    }
+    if (!f.captured_textures().empty() || !f.captured_heaps().empty() || !f.captured_accels().empty() ||
+        std::any_of(f.arguments().begin(), f.arguments().end(), [](auto v) noexcept {
+            return v.tag() != Variable::Tag::LOCAL && v.tag() != Variable::Tag::BUFFER;
+        })) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Function #{} uses resources other than buffers, "
+            "which are not supported by the C++ JIT backend.",
+            hash);
+    }
+
+    _function = f;
+    _indent = 0u;
+
+    // constants
+    if (!f.constants().empty()) {
+        for (auto c : f.constants()) { _emit_constant(c); }
+        _scratch << "\n";
+    }
+
+    // signature
+    if (f.tag() == Function::Tag::KERNEL) {
+        _scratch << "__kernel__ void kernel_" << hash;
+    } else {
+        _scratch << "__device__ ";
+        if (f.return_type() != nullptr) {
+            _emit_type_name(f.return_type());
+        } else {
+            _scratch << "void";
+        }
+        _scratch << " custom_" << hash;
+    }
+
+    // arguments, then (for kernels) captured buffers, then builtin variables
+    _scratch << "(";
+    for (auto arg : f.arguments()) {
+        _scratch << "\n    ";
+        if (f.tag() == Function::Tag::KERNEL && arg.tag() == Variable::Tag::LOCAL) {
+            _scratch << "__uniform__ ";
+        }
+        _emit_variable_decl(arg);
+        _scratch << ",";
+    }
+    if (f.tag() == Function::Tag::KERNEL) {
+        for (auto &&buffer : f.captured_buffers()) {
+            _scratch << "\n    ";
+            _emit_variable_decl(buffer.variable);
+            _scratch << ",";
+        }
+    }
+    _scratch << "\n    uint3 tid, uint3 bid, uint3 did, uint3 ls) {";
+
+    // buffers captured by callables are baked in as device addresses
+    if (f.tag() == Function::Tag::CALLABLE && !f.captured_buffers().empty()) {
+        _scratch << "\n";
+        for (auto &&buffer : f.captured_buffers()) {
+            _scratch << "\n  ";
+            _emit_variable_decl(buffer.variable);
+            _scratch << " = reinterpret_cast<";
+            _emit_type_name(buffer.variable.type()->element());
+            _scratch << " *>(" << static_cast<size_t>(buffer.handle + buffer.offset_bytes) << "ull);";
+        }
+        _scratch << "\n";
+    }
+    _emit_statements(f.body()->statements());
+    _scratch << "}\n\n";
+}
+
+void CppJitCodegen::_emit_entry(Function f) noexcept {
+    auto bs = f.block_size();
+    _scratch << "LUISA_JIT_EXPORT void " << entry_name
+             << "(void *const *args, const uint *dispatch_size, uint block_begin, uint block_end) {\n"
+             << "  constexpr uint3 bs{" << bs.x << "u, " << bs.y << "u, " << bs.z << "u};\n"
+             << "  uint3 ls{dispatch_size[0], dispatch_size[1], dispatch_size[2]};\n"
+             << "  auto nb = (ls + bs - 1u) / bs;\n";
+    auto slot = 0u;
+    auto emit_slot = [&](Variable v) noexcept {
+        _scratch << "  ";
+        if (v.tag() == Variable::Tag::BUFFER) {
+            _scratch << "auto ";
+            _emit_variable_name(v);
+            _scratch << " = static_cast<";
+            _emit_type_name(v.type()->element());
+            _scratch << " *>(args[" << slot << "u]);\n";
+        } else {
+            _emit_type_name(v.type());
+            _scratch << " ";
+            _emit_variable_name(v);
+            _scratch << ";\n  std::memcpy(&";
+            _emit_variable_name(v);
+            _scratch << ", args[" << slot << "u], sizeof(";
+            _emit_variable_name(v);
+            _scratch << "));\n";
+        }
+        slot++;
+    };
+    for (auto arg : f.arguments()) { emit_slot(arg); }
+    for (auto &&buffer : f.captured_buffers()) { emit_slot(buffer.variable); }
+    _scratch << "  for (auto block = block_begin; block < block_end; block++) {\n"
+             << "    uint3 bid{block % nb.x, block / nb.x % nb.y, block / nb.x / nb.y};\n"
+             << "    for (auto z = 0u; z < bs.z; z++) {\n"
+             << "      for (auto y = 0u; y < bs.y; y++) {\n"
+             << "        for (auto x = 0u; x < bs.x; x++) {\n"
+             << "          uint3 tid{x, y, z};\n"
+             << "          auto did = bid * bs + tid;\n"
+             << "          if (lc_all(did < ls)) {\n"
+             << "            kernel_" << hash_to_string(f.hash()) << "(";
+    for (auto arg : f.arguments()) {
+        _emit_variable_name(arg);
+        _scratch << ", ";
+    }
+    for (auto &&buffer : f.captured_buffers()) {
+        _emit_variable_name(buffer.variable);
+        _scratch << ", ";
+    }
+    _scratch << "tid, bid, did, ls);\n"
+             << "          }\n"
+             << "        }\n"
+             << "      }\n"
+             << "    }\n"
+             << "  }\n"
+             << "}\n";
+}
+
+void CppJitCodegen::_emit_preamble() noexcept {
+    _scratch << R"(#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <core/basic_types.h>
+#include <core/mathematics.h>
+
+using namespace luisa;
+
+#if defined(_WIN32) || defined(_WIN64)
+#define LUISA_JIT_EXPORT extern "C" __declspec(dllexport)
+#else
+#define LUISA_JIT_EXPORT extern "C" [[gnu::visibility("default")]]
+#endif
+
+#define __kernel__ static inline
+#define __device__
+#define __uniform__
+#define __constant__ static const
+
+template<typename T, size_t N>
+using array = std::array<T, N>;
+
+namespace lc_detail {
+
+template<typename T>
+struct dimension { static constexpr size_t value = 1u; };
+
+template<typename T, size_t N>
+struct dimension<Vector<T, N>> { static constexpr size_t value = N; };
+
+template<typename T>
+[[nodiscard]] inline auto element(T x, size_t i) noexcept {
+    if constexpr (dimension<T>::value == 1u) {
+        return x;
+    } else {
+        return x[i];
+    }
+}
+
+// applies a scalar function element-wise, broadcasting scalar arguments
+template<typename F, typename... Args>
+[[nodiscard]] inline auto map(F f, Args... args) noexcept {
+    constexpr auto n = std::max({dimension<Args>::value...});
+    if constexpr (n == 1u) {
+        return f(args...);
+    } else {
+        using R = decltype(f(element(args, 0u)...));
+        Vector<R, n> r;
+        for (auto i = 0u; i < n; i++) { r[i] = f(element(args, i)...); }
+        return r;
+    }
+}
+
+template<typename T>
+[[nodiscard]] inline T to(float x) noexcept { return static_cast<T>(x); }
+
+}// namespace lc_detail
+
+#define LUISA_JIT_FLOAT_UNARY(name, ...)                         \
+    template<typename X>                                         \
+    [[nodiscard]] inline auto lc_##name(X v) noexcept {          \
+        return lc_detail::map(                                   \
+            [](auto x) noexcept {                                \
+                auto f = static_cast<float>(x);                  \
+                return lc_detail::to<decltype(x)>(__VA_ARGS__);  \
+            },                                                   \
+            v);                                                  \
+    }
+
+#define LUISA_JIT_FLOAT_BINARY(name, ...)                        \
+    template<typename X, typename Y>                             \
+    [[nodiscard]] inline auto lc_##name(X u, Y v) noexcept {     \
+        return lc_detail::map(                                   \
+            [](auto x, auto y) noexcept {                        \
+                auto a = static_cast<float>(x);                  \
+                auto b = static_cast<float>(y);                  \
+                return lc_detail::to<decltype(x)>(__VA_ARGS__);  \
+            },                                                   \
+            u, v);                                               \
+    }
+
+#define LUISA_JIT_FLOAT_TERNARY(name, ...)                             \
+    template<typename X, typename Y, typename Z>                       \
+    [[nodiscard]] inline auto lc_##name(X u, Y v, Z w) noexcept {      \
+        return lc_detail::map(                                         \
+            [](auto x, auto y, auto z) noexcept {                      \
+                auto a = static_cast<float>(x);                        \
+                auto b = static_cast<float>(y);                        \
+                auto c = static_cast<float>(z);                        \
+                return lc_detail::to<decltype(x)>(__VA_ARGS__);        \
+            },                                                         \
+            u, v, w);                                                  \
+    }
+
+LUISA_JIT_FLOAT_UNARY(acos, std::acos(f))
+LUISA_JIT_FLOAT_UNARY(acosh, std::acosh(f))
+LUISA_JIT_FLOAT_UNARY(asin, std::asin(f))
+LUISA_JIT_FLOAT_UNARY(asinh, std::asinh(f))
+LUISA_JIT_FLOAT_UNARY(atan, std::atan(f))
+LUISA_JIT_FLOAT_UNARY(atanh, std::atanh(f))
+LUISA_JIT_FLOAT_UNARY(cos, std::cos(f))
+LUISA_JIT_FLOAT_UNARY(cosh, std::cosh(f))
+LUISA_JIT_FLOAT_UNARY(sin, std::sin(f))
+LUISA_JIT_FLOAT_UNARY(sinh, std::sinh(f))
+LUISA_JIT_FLOAT_UNARY(tan, std::tan(f))
+LUISA_JIT_FLOAT_UNARY(tanh, std::tanh(f))
+LUISA_JIT_FLOAT_UNARY(exp, std::exp(f))
+LUISA_JIT_FLOAT_UNARY(exp2, std::exp2(f))
+LUISA_JIT_FLOAT_UNARY(exp10, std::pow(10.0f, f))
+LUISA_JIT_FLOAT_UNARY(log, std::log(f))
+LUISA_JIT_FLOAT_UNARY(log2, std::log2(f))
+LUISA_JIT_FLOAT_UNARY(log10, std::log10(f))
+LUISA_JIT_FLOAT_UNARY(sqrt, std::sqrt(f))
+LUISA_JIT_FLOAT_UNARY(rsqrt, 1.0f / std::sqrt(f))
+LUISA_JIT_FLOAT_UNARY(ceil, std::ceil(f))
+LUISA_JIT_FLOAT_UNARY(floor, std::floor(f))
+LUISA_JIT_FLOAT_UNARY(fract, f - std::floor(f))
+LUISA_JIT_FLOAT_UNARY(trunc, std::trunc(f))
+LUISA_JIT_FLOAT_UNARY(round, std::round(f))
+LUISA_JIT_FLOAT_UNARY(degrees, f * (180.0f / constants::pi))
+LUISA_JIT_FLOAT_UNARY(radians, f * (constants::pi / 180.0f))
+LUISA_JIT_FLOAT_UNARY(saturate, std::clamp(f, 0.0f, 1.0f))
+LUISA_JIT_FLOAT_UNARY(sign, f > 0.0f ? 1.0f : (f < 0.0f ? -1.0f : 0.0f))
+
+LUISA_JIT_FLOAT_BINARY(atan2, std::atan2(a, b))
+LUISA_JIT_FLOAT_BINARY(pow, std::pow(a, b))
+LUISA_JIT_FLOAT_BINARY(fmod, std::fmod(a, b))
+LUISA_JIT_FLOAT_BINARY(mod, a - b * std::floor(a / b))
+LUISA_JIT_FLOAT_BINARY(copysign, std::copysign(a, b))
+LUISA_JIT_FLOAT_BINARY(step, b < a ? 0.0f : 1.0f)
+
+LUISA_JIT_FLOAT_TERNARY(fma, std::fma(a, b, c))
+LUISA_JIT_FLOAT_TERNARY(mix, a + c * (b - a))
+LUISA_JIT_FLOAT_TERNARY(smoothstep, [t = std::clamp((c - a) / (b - a), 0.0f, 1.0f)] { return t * t * (3.0f - 2.0f * t); }())
+
+#undef LUISA_JIT_FLOAT_UNARY
+#undef LUISA_JIT_FLOAT_BINARY
+#undef LUISA_JIT_FLOAT_TERNARY
+
+namespace lc_precise {
+template<typename X>
+[[nodiscard]] inline auto isinf(X v) noexcept {
+    return lc_detail::map([](auto x) noexcept { return std::isinf(static_cast<float>(x)); }, v);
+}
+template<typename X>
+[[nodiscard]] inline auto isnan(X v) noexcept {
+    return lc_detail::map([](auto x) noexcept { return std::isnan(static_cast<float>(x)); }, v);
+}
+}// namespace lc_precise
+
+template<typename X>
+[[nodiscard]] inline auto lc_abs(X v) noexcept {
+    return lc_detail::map(
+        [](auto x) noexcept {
+            using T = decltype(x);
+            if constexpr (std::is_unsigned_v<T>) {
+                return x;
+            } else if constexpr (std::is_integral_v<T>) {
+                return x < 0 ? -x : x;
+            } else {
+                return lc_detail::to<T>(std::abs(static_cast<float>(x)));
+            }
+        },
+        v);
+}
+
+template<typename X, typename Y>
+[[nodiscard]] inline auto lc_min(X u, Y v) noexcept {
+    return lc_detail::map([](auto x, auto y) noexcept { return y < x ? y : x; }, u, v);
+}
+
+template<typename X, typename Y>
+[[nodiscard]] inline auto lc_max(X u, Y v) noexcept {
+    return lc_detail::map([](auto x, auto y) noexcept { return x < y ? y : x; }, u, v);
+}
+
+template<typename X, typename Y, typename Z>
+[[nodiscard]] inline auto lc_clamp(X u, Y lo, Z hi) noexcept {
+    return lc_min(lc_max(u, lo), hi);
+}
+
+template<typename X, typename Y, typename Z>
+[[nodiscard]] inline auto lc_select(X f, Y t, Z p) noexcept {
+    return lc_detail::map([](auto x, auto y, bool p) noexcept { return p ? y : x; }, f, t, p);
+}
+
+template<size_t N>
+[[nodiscard]] inline auto lc_all(Vector<bool, N> v) noexcept { return luisa::all(v); }
+template<size_t N>
+[[nodiscard]] inline auto lc_any(Vector<bool, N> v) noexcept { return luisa::any(v); }
+template<size_t N>
+[[nodiscard]] inline auto lc_none(Vector<bool, N> v) noexcept { return luisa::none(v); }
+
+template<typename X>
+[[nodiscard]] inline auto lc_clz(X v) noexcept {
+    return lc_detail::map([](auto x) noexcept { return static_cast<decltype(x)>(std::countl_zero(static_cast<uint>(x))); }, v);
+}
+
+template<typename X>
+[[nodiscard]] inline auto lc_ctz(X v) noexcept {
+    return lc_detail::map([](auto x) noexcept { return static_cast<decltype(x)>(std::countr_zero(static_cast<uint>(x))); }, v);
+}
+
+template<typename X>
+[[nodiscard]] inline auto lc_popcount(X v) noexcept {
+    return lc_detail::map([](auto x) noexcept { return static_cast<decltype(x)>(std::popcount(static_cast<uint>(x))); }, v);
+}
+
+template<typename X>
+[[nodiscard]] inline auto lc_reverse_bits(X v) noexcept {
+    return lc_detail::map(
+        [](auto x) noexcept {
+            auto u = static_cast<uint>(x);
+            u = ((u >> 1u) & 0x55555555u) | ((u & 0x55555555u) << 1u);
+            u = ((u >> 2u) & 0x33333333u) | ((u & 0x33333333u) << 2u);
+            u = ((u >> 4u) & 0x0f0f0f0fu) | ((u & 0x0f0f0f0fu) << 4u);
+            u = ((u >> 8u) & 0x00ff00ffu) | ((u & 0x00ff00ffu) << 8u);
+            return static_cast<decltype(x)>((u >> 16u) | (u << 16u));
+        },
+        v);
+}
+
+template<size_t N>
+[[nodiscard]] inline auto lc_dot(Vector<float, N> u, Vector<float, N> v) noexcept { return luisa::dot(u, v); }
+[[nodiscard]] inline auto lc_cross(float3 u, float3 v) noexcept { return luisa::cross(u, v); }
+template<size_t N>
+[[nodiscard]] inline auto lc_length_squared(Vector<float, N> v) noexcept { return luisa::dot(v, v); }
+template<size_t N>
+[[nodiscard]] inline auto lc_length(Vector<float, N> v) noexcept { return std::sqrt(lc_length_squared(v)); }
+template<size_t N>
+[[nodiscard]] inline auto lc_distance_squared(Vector<float, N> u, Vector<float, N> v) noexcept { return lc_length_squared(u - v); }
+template<size_t N>
+[[nodiscard]] inline auto lc_distance(Vector<float, N> u, Vector<float, N> v) noexcept { return lc_length(u - v); }
+template<size_t N>
+[[nodiscard]] inline auto lc_normalize(Vector<float, N> v) noexcept { return v * (1.0f / lc_length(v)); }
+[[nodiscard]] inline auto lc_faceforward(float3 n, float3 i, float3 n_ref) noexcept { return luisa::dot(n_ref, i) < 0.0f ? n : -n; }
+
+template<size_t N>
+[[nodiscard]] inline auto lc_transpose(Matrix<N> m) noexcept { return luisa::transpose(m); }
+template<size_t N>
+[[nodiscard]] inline auto lc_inverse(Matrix<N> m) noexcept { return luisa::inverse(m); }
+
+[[nodiscard]] inline auto lc_determinant(float2x2 m) noexcept {
+    return m[0].x * m[1].y - m[1].x * m[0].y;
+}
+
+[[nodiscard]] inline auto lc_determinant(float3x3 m) noexcept {
+    return luisa::dot(m[0], luisa::cross(m[1], m[2]));
+}
+
+[[nodiscard]] inline auto lc_determinant(float4x4 m) noexcept {
+    auto minor = [&m](uint c) noexcept {
+        float3 cols[3];
+        for (auto i = 0u, k = 0u; i < 4u; i++) {
+            if (i != c) { cols[k++] = float3{m[i].y, m[i].z, m[i].w}; }
+        }
+        return luisa::dot(cols[0], luisa::cross(cols[1], cols[2]));
+    };
+    return m[0].x * minor(0u) - m[1].x * minor(1u) + m[2].x * minor(2u) - m[3].x * minor(3u);
+}
+
+inline void lc_device_memory_barrier() noexcept { std::atomic_thread_fence(std::memory_order_seq_cst); }
+inline void lc_all_memory_barrier() noexcept { std::atomic_thread_fence(std::memory_order_seq_cst); }
+
+template<typename T>
+[[nodiscard]] inline auto lc_atomic_load(T &x) noexcept { return std::atomic_ref<T>{x}.load(); }
+template<typename T>
+inline void lc_atomic_store(T &x, T v) noexcept { std::atomic_ref<T>{x}.store(v); }
+template<typename T>
+[[nodiscard]] inline auto lc_atomic_exchange(T &x, T v) noexcept { return std::atomic_ref<T>{x}.exchange(v); }
+template<typename T>
+[[nodiscard]] inline auto lc_atomic_compare_exchange(T &x, T expected, T desired) noexcept {
+    std::atomic_ref<T>{x}.compare_exchange_strong(expected, desired);
+    return expected;
+}
+template<typename T>
+[[nodiscard]] inline auto lc_atomic_fetch_add(T &x, T v) noexcept { return std::atomic_ref<T>{x}.fetch_add(v); }
+template<typename T>
+[[nodiscard]] inline auto lc_atomic_fetch_sub(T &x, T v) noexcept { return std::atomic_ref<T>{x}.fetch_sub(v); }
+template<typename T>
+[[nodiscard]] inline auto lc_atomic_fetch_and(T &x, T v) noexcept { return std::atomic_ref<T>{x}.fetch_and(v); }
+template<typename T>
+[[nodiscard]] inline auto lc_atomic_fetch_or(T &x, T v) noexcept { return std::atomic_ref<T>{x}.fetch_or(v); }
+template<typename T>
+[[nodiscard]] inline auto lc_atomic_fetch_xor(T &x, T v) noexcept { return std::atomic_ref<T>{x}.fetch_xor(v); }
+template<typename T>
+[[nodiscard]] inline auto lc_atomic_fetch_min(T &x, T v) noexcept {
+    std::atomic_ref<T> a{x};
+    auto old = a.load();
+    while (v < old && !a.compare_exchange_weak(old, v)) {}
+    return old;
+}
+template<typename T>
+[[nodiscard]] inline auto lc_atomic_fetch_max(T &x, T v) noexcept {
+    std::atomic_ref<T> a{x};
+    auto old = a.load();
+    while (old < v && !a.compare_exchange_weak(old, v)) {}
+    return old;
+}
+
+template<typename T, typename U>
+[[nodiscard]] inline auto as(U u) noexcept { return std::bit_cast<T>(u); }
+
+#define LUISA_JIT_MAKE_VECTOR(type)                                                                   \
+    template<typename... Args>                                                                        \
+    [[nodiscard]] inline auto lc_##type##2(Args... args) noexcept { return make_##type##2(args...); } \
+    template<typename... Args>                                                                        \
+    [[nodiscard]] inline auto lc_##type##3(Args... args) noexcept { return make_##type##3(args...); } \
+    template<typename... Args>                                                                        \
+    [[nodiscard]] inline auto lc_##type##4(Args... args) noexcept { return make_##type##4(args...); }
+LUISA_JIT_MAKE_VECTOR(bool)
+LUISA_JIT_MAKE_VECTOR(int)
+LUISA_JIT_MAKE_VECTOR(uint)
+LUISA_JIT_MAKE_VECTOR(float)
+LUISA_JIT_MAKE_VECTOR(half)
+#undef LUISA_JIT_MAKE_VECTOR
+
+template<typename... Args>
+[[nodiscard]] inline auto lc_float2x2(Args... args) noexcept { return make_float2x2(args...); }
+template<typename... Args>
+[[nodiscard]] inline auto lc_float3x3(Args... args) noexcept { return make_float3x3(args...); }
+template<typename... Args>
+[[nodiscard]] inline auto lc_float4x4(Args... args) noexcept { return make_float4x4(args...); }
+
+// matrix literals are printed as constructor calls
+#define float2x2(...) make_float2x2(__VA_ARGS__)
+#define float3x3(...) make_float3x3(__VA_ARGS__)
+#define float4x4(...) make_float4x4(__VA_ARGS__)
+
+)";
+}
+
+}// namespace luisa::compute::cpp
@@ -0,0 +1,37 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#pragma once
+
+#include <compile/cpp_codegen.h>
+
+namespace luisa::compute::cpp {
+
+// Emits host C++ for a kernel on top of the generic CppCodegen: builtins are
+// lowered onto core/basic_types.h and core/mathematics.h, builtin variables are
+// threaded through every function as trailing arguments, and an exported
+// `kernel_main` entry runs a range of blocks of the dispatch.
+class CppJitCodegen final : public CppCodegen {
+
+public:
+    static constexpr std::string_view entry_name = "kernel_main";
+
+    // signature of the exported entry: arguments in kernel order (uniform
+    // arguments are passed by address, buffers as device pointers), the
+    // dispatch size and the half-open range of linearized block indices
+    using Entry = void(void *const *arguments, const uint *dispatch_size, uint block_begin, uint block_end);
+
+private:
+    void visit(const MemberExpr *expr) override;
+    void visit(const CallExpr *expr) override;
+    void _emit_function(Function f) noexcept override;
+    void _emit_preamble() noexcept;
+    void _emit_entry(Function f) noexcept;
+
+public:
+    explicit CppJitCodegen(Codegen::Scratch &scratch) noexcept : CppCodegen{scratch} {}
+    void emit(Function f) override;
+};
+
+}// namespace luisa::compute::cpp
@@ -0,0 +1,58 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#include <cstring>
+
+#include <core/logging.h>
+#include <backends/cpp/cpp_device.h>
+#include <backends/cpp/cpp_shader.h>
+#include <backends/cpp/cpp_command_encoder.h>
+
+namespace luisa::compute::cpp {
+
+namespace detail {
+
+[[nodiscard]] inline auto buffer_address(uint64_t handle, size_t offset) noexcept {
+    return reinterpret_cast<std::byte *>(handle) + offset;
+}
+
+inline void unsupported(std::string_view what) noexcept {
+    LUISA_ERROR_WITH_LOCATION("{} are not supported by the C++ JIT backend.", what);
+}
+
+}// namespace detail
+
+void CppCommandEncoder::visit(const BufferUploadCommand *command) noexcept {
+    std::memcpy(detail::buffer_address(command->handle(), command->offset()),
+                command->data(), command->size());
+}
+
+void CppCommandEncoder::visit(const BufferDownloadCommand *command) noexcept {
+    std::memcpy(command->data(),
+                detail::buffer_address(command->handle(), command->offset()),
+                command->size());
+}
+
+void CppCommandEncoder::visit(const BufferCopyCommand *command) noexcept {
+    std::memmove(detail::buffer_address(command->dst_handle(), command->dst_offset()),
+                 detail::buffer_address(command->src_handle(), command->src_offset()),
+                 command->size());
+}
+
+void CppCommandEncoder::visit(const ShaderDispatchCommand *command) noexcept {
+    auto shader = reinterpret_cast<const CppShader *>(command->handle());
+    shader->dispatch(_device->thread_pool(), command);
+}
+
+void CppCommandEncoder::visit(const BufferToTextureCopyCommand *) noexcept { detail::unsupported("Textures"); }
+void CppCommandEncoder::visit(const TextureUploadCommand *) noexcept { detail::unsupported("Textures"); }
+void CppCommandEncoder::visit(const TextureDownloadCommand *) noexcept { detail::unsupported("Textures"); }
+void CppCommandEncoder::visit(const TextureCopyCommand *) noexcept { detail::unsupported("Textures"); }
+void CppCommandEncoder::visit(const TextureToBufferCopyCommand *) noexcept { detail::unsupported("Textures"); }
+void CppCommandEncoder::visit(const AccelUpdateCommand *) noexcept { detail::unsupported("Acceleration structures"); }
+void CppCommandEncoder::visit(const AccelBuildCommand *) noexcept { detail::unsupported("Acceleration structures"); }
+void CppCommandEncoder::visit(const MeshUpdateCommand *) noexcept { detail::unsupported("Meshes"); }
+void CppCommandEncoder::visit(const MeshBuildCommand *) noexcept { detail::unsupported("Meshes"); }
+
+}// namespace luisa::compute::cpp
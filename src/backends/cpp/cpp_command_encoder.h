@@ -0,0 +1,35 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#pragma once
+
+#include <runtime/command.h>
+
+namespace luisa::compute::cpp {
+
+class CppDevice;
+
+class CppCommandEncoder : public CommandVisitor {
+
+private:
+    CppDevice *_device;
+
+public:
+    explicit CppCommandEncoder(CppDevice *device) noexcept : _device{device} {}
+    void visit(const BufferUploadCommand *command) noexcept override;
+    void visit(const BufferDownloadCommand *command) noexcept override;
+    void visit(const BufferCopyCommand *command) noexcept override;
+    void visit(const BufferToTextureCopyCommand *command) noexcept override;
+    void visit(const ShaderDispatchCommand *command) noexcept override;
+    void visit(const TextureUploadCommand *command) noexcept override;
+    void visit(const TextureDownloadCommand *command) noexcept override;
+    void visit(const TextureCopyCommand *command) noexcept override;
+    void visit(const TextureToBufferCopyCommand *command) noexcept override;
+    void visit(const AccelUpdateCommand *command) noexcept override;
+    void visit(const AccelBuildCommand *command) noexcept override;
+    void visit(const MeshUpdateCommand *command) noexcept override;
+    void visit(const MeshBuildCommand *command) noexcept override;
+};
+
+}// namespace luisa::compute::cpp
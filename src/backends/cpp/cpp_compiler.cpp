@@ -0,0 +1,210 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#include <atomic>
+#include <random>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <core/hash.h>
+#include <core/clock.h>
+#include <core/logging.h>
+#include <core/platform.h>
+#include <runtime/context.h>
+#include <backends/cpp/cpp_codegen.h>
+#include <backends/cpp/cpp_compiler.h>
+
+#ifndef LUISA_CPP_JIT_COMPILER
+#define LUISA_CPP_JIT_COMPILER "c++"
+#endif
+
+#ifndef LUISA_CPP_JIT_INCLUDE_DIR
+#define LUISA_CPP_JIT_INCLUDE_DIR "."
+#endif
+
+namespace luisa::compute::cpp {
+
+namespace detail {
+
+// a file name stem unique across the threads and processes (possibly on
+// other hosts) sharing the cache directory, for files renamed in place later
+[[nodiscard]] std::string temporary_name(std::string_view name) noexcept {
+    static const auto process_tag = std::random_device{}();
+    static std::atomic<uint64_t> counter{0u};
+    return fmt::format("{}.{}-{:08x}-{}.tmp", name, current_process_id(), process_tag,
+                       counter.fetch_add(1u, std::memory_order_relaxed));
+}
+
+// the target macros (e.g., __AVX2__) -march=native resolves to on this host, as the
+// command alone does not tell objects built for different CPUs apart
+[[nodiscard]] std::string native_target_macros(std::string_view compiler, const std::filesystem::path &directory) noexcept {
+    auto temp_name = temporary_name("native_target");
+    auto source_path = directory / fmt::format("{}.cpp", temp_name);
+    auto output_path = directory / fmt::format("{}.txt", temp_name);
+    std::ofstream{source_path}.close();
+    auto command = fmt::format(
+        R"("{}" -std=c++20 -march=native -dM -E "{}" > "{}" 2>&1)",
+        compiler, source_path.string(), output_path.string());
+    auto status = std::system(command.c_str());
+    std::ostringstream macros;
+    macros << std::ifstream{output_path}.rdbuf();
+    std::error_code ec;
+    std::filesystem::remove(source_path, ec);
+    std::filesystem::remove(output_path, ec);
+    if (status != 0) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to query the native target (exit status {}) with command: {}\n{}",
+            status, command, macros.str());
+        return {};
+    }
+    return std::move(macros).str();
+}
+
+}// namespace detail
+
+CppCompiler::CppCompiler(const Context &ctx) noexcept
+    : _cache_directory{ctx.cache_directory() / "cpp"} {
+    std::error_code ec;
+    std::filesystem::create_directories(_cache_directory, ec);
+    if (ec) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Failed to create C++ JIT cache directory '{}': {}.",
+            _cache_directory.string(), ec.message());
+    }
+    std::string_view compiler = LUISA_CPP_JIT_COMPILER;
+    if (auto env = std::getenv("LUISA_CPP_JIT_COMPILER"); env != nullptr && *env != '\0') { compiler = env; }
+    _command = fmt::format(
+        R"("{}" -std=c++20 -O3 -march=native -fPIC -shared -w -I"{}")",
+        compiler, LUISA_CPP_JIT_INCLUDE_DIR);
+    auto target = detail::native_target_macros(compiler, _cache_directory);
+    _command_hash = xxh3_hash64(target.data(), target.size(), xxh3_hash64(_command.data(), _command.size()));
+    _binary_format = fmt::format("cpp-{:016x}", _command_hash);
+    LUISA_INFO("C++ JIT compile command: {} (native target hash = {:016x}).",
+               _command, xxh3_hash64(target.data(), target.size()));
+}
+
+CppCompiler::Object CppCompiler::compile(Function kernel) noexcept {
+
+    auto hash_string = std::string{hash_to_string(kernel.hash())};
+    LUISA_INFO("Compiling kernel #{}.", hash_string);
+
+    Clock clock;
+    auto scratch = Codegen::ScratchPool::acquire();
+    CppJitCodegen codegen{*scratch};
+    codegen.emit(kernel);
+
+    auto s = scratch->view();
+    auto digest = xxh3_hash64(s.data(), s.size(), _command_hash);
+    LUISA_VERBOSE(
+        "Generated source (hash = 0x{:016x}) for kernel #{} in {} ms:\n\n{}",
+        digest, hash_string, clock.toc(), s);
+
+    // try memory cache
+    {
+        std::scoped_lock lock{_cache_mutex};
+        if (auto iter = _cache.find(digest); iter != _cache.cend()) {
+            LUISA_VERBOSE_WITH_LOCATION(
+                "Cache hit for kernel #{}. Compilation skipped.", hash_string);
+            return iter->second;
+        }
+    }
+
+    // try disk cache, otherwise compile from uniquely named temporary files
+    // and rename the results, so concurrent compilations of the same kernel
+    // never write to the same file and no process loads a partial object
+    auto name = fmt::format("kernel_{}_{:016x}", hash_string, digest);
+    auto library_path = dynamic_module_path(name, _cache_directory);
+    if (std::filesystem::exists(library_path)) {
+        LUISA_VERBOSE_WITH_LOCATION(
+            "Found cached object '{}' for kernel #{}.",
+            library_path.string(), hash_string);
+    } else {
+        clock.tic();
+        auto temp_name = detail::temporary_name(name);
+        auto source_path = _cache_directory / fmt::format("{}.cpp", temp_name);
+        auto log_path = _cache_directory / fmt::format("{}.log", temp_name);
+        auto temp_path = _cache_directory / temp_name;
+        {
+            std::ofstream source_file{source_path, std::ios::binary};
+            source_file.write(s.data(), static_cast<std::streamsize>(s.size()));
+            if (!source_file) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION(
+                    "Failed to write source '{}' for kernel #{}.",
+                    source_path.string(), hash_string);
+            }
+        }
+        auto command = fmt::format(
+            R"({} "{}" -o "{}" > "{}" 2>&1)", _command,
+            source_path.string(), temp_path.string(), log_path.string());
+        if (auto status = std::system(command.c_str()); status != 0) [[unlikely]] {
+            std::ostringstream log;
+            log << std::ifstream{log_path}.rdbuf();
+            LUISA_ERROR_WITH_LOCATION(
+                "Failed to compile kernel #{} (exit status {}) with command: {}\n{}",
+                hash_string, status, command, log.str());
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp_path, library_path, ec);
+        if (ec) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Failed to move compiled object to '{}': {}.",
+                library_path.string(), ec.message());
+        }
+        // the source is kept for debugging
+        std::filesystem::rename(source_path, _cache_directory / fmt::format("{}.cpp", name), ec);
+        if (ec) [[unlikely]] {
+            LUISA_WARNING_WITH_LOCATION(
+                "Failed to keep source of kernel #{}: {}.",
+                hash_string, ec.message());
+            std::filesystem::remove(source_path, ec);
+        }
+        std::filesystem::remove(log_path, ec);
+        LUISA_INFO("Compiled kernel #{} in {} ms.", hash_string, clock.toc());
+    }
+
+    return _load(digest, name);
+}
+
+CppCompiler::Object CppCompiler::_load(uint64_t digest, const std::string &name) noexcept {
+    Object object{std::make_shared<DynamicModule>(_cache_directory, name),
+                  dynamic_module_path(name, _cache_directory)};
+    std::scoped_lock lock{_cache_mutex};
+    return _cache.try_emplace(digest, std::move(object)).first->second;
+}
+
+CppCompiler::Object CppCompiler::load(Function kernel, std::span<const std::byte> binary) noexcept {
+    auto digest = xxh3_hash64(binary.data(), binary.size(), ~_command_hash);
+    {
+        std::scoped_lock lock{_cache_mutex};
+        if (auto iter = _cache.find(digest); iter != _cache.cend()) { return iter->second; }
+    }
+    auto name = fmt::format("kernel_{}_{:016x}", hash_to_string(kernel.hash()), digest);
+    auto library_path = dynamic_module_path(name, _cache_directory);
+    if (!std::filesystem::exists(library_path)) {
+        auto temp_path = _cache_directory / detail::temporary_name(name);
+        {
+            std::ofstream file{temp_path, std::ios::binary};
+            file.write(reinterpret_cast<const char *>(binary.data()), static_cast<std::streamsize>(binary.size()));
+            if (!file) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION(
+                    "Failed to write object '{}' for kernel #{}.",
+                    temp_path.string(), hash_to_string(kernel.hash()));
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp_path, library_path, ec);
+        if (ec) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Failed to move object to '{}': {}.",
+                library_path.string(), ec.message());
+        }
+    }
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Loaded precompiled object for kernel #{}.",
+        hash_to_string(kernel.hash()));
+    return _load(digest, name);
+}
+
+}// namespace luisa::compute::cpp
@@ -0,0 +1,58 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#pragma once
+
+#include <span>
+#include <memory>
+#include <string>
+#include <filesystem>
+#include <unordered_map>
+
+#include <util/spin_mutex.h>
+#include <util/dynamic_module.h>
+#include <ast/function.h>
+
+namespace luisa::compute {
+class Context;
+}
+
+namespace luisa::compute::cpp {
+
+// Compiles generated kernel sources with the host C++ compiler into shared
+// objects under `<cache>/cpp`. Objects are named after the kernel hash and a
+// digest of the source, the compile command and the host CPU features it
+// targets, so they are reused across runs and rebuilt whenever one changes.
+class CppCompiler {
+
+public:
+    struct Object {
+        std::shared_ptr<DynamicModule> module;
+        std::filesystem::path path;
+    };
+
+private:
+    std::filesystem::path _cache_directory;
+    std::string _command;
+    std::string _binary_format;
+    uint64_t _command_hash;
+    std::unordered_map<uint64_t, Object> _cache;
+    spin_mutex _cache_mutex;
+
+private:
+    [[nodiscard]] Object _load(uint64_t digest, const std::string &name) noexcept;
+
+public:
+    // the compiler is taken from $LUISA_CPP_JIT_COMPILER if set,
+    // otherwise the one that built this backend is used
+    explicit CppCompiler(const Context &ctx) noexcept;
+    [[nodiscard]] auto &command() const noexcept { return _command; }
+    // objects are only compatible with the same compile command and host CPU features
+    [[nodiscard]] auto &binary_format() const noexcept { return _binary_format; }
+    [[nodiscard]] Object compile(Function kernel) noexcept;
+    // installs a previously compiled object into the cache and loads it
+    [[nodiscard]] Object load(Function kernel, std::span<const std::byte> binary) noexcept;
+};
+
+}// namespace luisa::compute::cpp
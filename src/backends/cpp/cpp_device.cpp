@@ -0,0 +1,202 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#include <limits>
+#include <cstdlib>
+#include <string_view>
+
+#include <core/clock.h>
+#include <core/platform.h>
+#include <core/logging.h>
+#include <runtime/context.h>
+#include <runtime/texture.h>
+#include <backends/cpp/cpp_stream.h>
+#include <backends/cpp/cpp_shader.h>
+#include <backends/cpp/cpp_command_encoder.h>
+#include <backends/cpp/cpp_device.h>
+
+namespace luisa::compute::cpp {
+
+namespace detail {
+
+[[nodiscard]] int cpp_device_numa_node(uint device_id) noexcept {
+    if (auto binding = std::getenv("LUISA_CPP_NUMA_BINDING");
+        binding != nullptr && std::string_view{binding} != "0") {
+        if (auto count = numa_node_count(); device_id < count) { return static_cast<int>(device_id); }
+        LUISA_WARNING_WITH_LOCATION(
+            "Invalid device index {} for the C++ JIT backend with NUMA "
+            "binding ({} node(s) available). Falling back to node 0.",
+            device_id, numa_node_count());
+        return 0;
+    }
+    if (device_id != 0u) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Invalid device index {} for the C++ JIT backend (only 0 is available "
+            "without LUISA_CPP_NUMA_BINDING). Falling back to device 0.",
+            device_id);
+    }
+    return -1;
+}
+
+}// namespace detail
+
+CppDevice::CppDevice(const Context &ctx, uint device_id) noexcept
+    : Device::Interface{ctx}, _compiler{ctx},
+      _numa_node{detail::cpp_device_numa_node(device_id)},
+      _thread_pool{std::thread::hardware_concurrency(), _numa_node} {}
+
+uint64_t CppDevice::create_buffer(size_t size_bytes, uint64_t heap_handle, uint32_t) noexcept {
+    if (heap_handle != std::numeric_limits<uint64_t>::max()) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Heaps are not supported by the C++ JIT backend.");
+    }
+    // buffers of a huge page or more get whole pages of their own, as huge as the
+    // system gives and on the node of the device, to cut TLB misses and remote reads
+    if (auto huge = std::max(huge_page_size(), static_cast<size_t>(2_mb)); size_bytes >= huge) {
+        if (auto pages = allocate_pages(size_bytes, {.huge_pages = true, .numa_node = _numa_node});
+            !pages.empty()) [[likely]] {
+            auto handle = reinterpret_cast<uint64_t>(pages.data());
+            std::scoped_lock lock{_large_buffer_mutex};
+            _large_buffers.emplace(handle, LargeBuffer{pages, false});
+            return handle;
+        }
+    }
+    // cache-line aligned, so that vector loads never straddle allocations
+    auto buffer = aligned_alloc(64u, std::max(size_bytes, static_cast<size_t>(1u)));
+    if (buffer == nullptr) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Failed to allocate buffer of {} bytes.", size_bytes);
+    }
+    return reinterpret_cast<uint64_t>(buffer);
+}
+
+void CppDevice::destroy_buffer(uint64_t handle) noexcept {
+    auto large = [this, handle]() -> LargeBuffer {
+        std::scoped_lock lock{_large_buffer_mutex};
+        if (_large_buffers.empty()) [[likely]] { return {}; }
+        auto iter = _large_buffers.find(handle);
+        if (iter == _large_buffers.end()) { return {}; }
+        auto b = iter->second;
+        _large_buffers.erase(iter);
+        return b;
+    }();
+    if (large.pages.empty()) {
+        aligned_free(reinterpret_cast<void *>(handle));
+    } else if (large.file_mapping) {
+        memory_unmap_file(large.pages);
+    } else {
+        free_pages(large.pages);
+    }
+}
+
+uint64_t CppDevice::create_file_buffer(std::span<const std::byte> mapping) noexcept {
+    // mappings are page-aligned, and kernels read the page cache in place
+    auto handle = reinterpret_cast<uint64_t>(mapping.data());
+    std::scoped_lock lock{_large_buffer_mutex};
+    _large_buffers.emplace(handle, LargeBuffer{{const_cast<std::byte *>(mapping.data()), mapping.size()}, true});
+    return handle;
+}
+
+uint64_t CppDevice::create_texture(PixelFormat, uint, uint, uint, uint, uint, TextureSampler, uint64_t, uint32_t) {
+    LUISA_ERROR_WITH_LOCATION("Textures are not supported by the C++ JIT backend.");
+}
+
+void CppDevice::destroy_texture(uint64_t) noexcept {}
+
+uint64_t CppDevice::create_heap(size_t) noexcept {
+    LUISA_ERROR_WITH_LOCATION("Heaps are not supported by the C++ JIT backend.");
+}
+
+size_t CppDevice::query_heap_memory_usage(uint64_t) noexcept { return 0u; }
+void CppDevice::destroy_heap(uint64_t) noexcept {}
+
+uint64_t CppDevice::create_stream() noexcept {
+    return reinterpret_cast<uint64_t>(new CppStream);
+}
+
+void CppDevice::destroy_stream(uint64_t handle) noexcept {
+    delete reinterpret_cast<CppStream *>(handle);
+}
+
+void CppDevice::synchronize_stream(uint64_t stream_handle) noexcept {
+    // wait for any list being executed on the stream by other threads
+    reinterpret_cast<CppStream *>(stream_handle)->with_locked([] {});
+}
+
+void CppDevice::dispatch(uint64_t stream_handle, CommandList list) noexcept {
+    reinterpret_cast<CppStream *>(stream_handle)->with_locked([this, &list] {
+        CppCommandEncoder encoder{this};
+        for (auto command : list) { command->accept(encoder); }
+    });
+}
+
+void CppDevice::dispatch_profiled(uint64_t stream_handle, CommandList list, TimestampCallback callback) noexcept {
+    // commands complete before the encoder returns, so the host clock gives exact intervals
+    std::vector<CommandTimestamps> timestamps;
+    reinterpret_cast<CppStream *>(stream_handle)->with_locked([this, &list, &timestamps] {
+        CppCommandEncoder encoder{this};
+        for (auto command : list) {
+            auto start = Clock::timestamp();
+            command->accept(encoder);
+            timestamps.emplace_back(CommandTimestamps{start, Clock::timestamp()});
+        }
+    });
+    callback(timestamps);
+}
+
+uint64_t CppDevice::create_shader(Function kernel) noexcept {
+    auto object = _compiler.compile(kernel);
+    return reinterpret_cast<uint64_t>(new CppShader{std::move(object), kernel});
+}
+
+void CppDevice::destroy_shader(uint64_t handle) noexcept {
+    delete reinterpret_cast<CppShader *>(handle);
+}
+
+std::string_view CppDevice::shader_binary_format() const noexcept {
+    return _compiler.binary_format();
+}
+
+std::vector<std::byte> CppDevice::shader_binary(uint64_t handle) noexcept {
+    return reinterpret_cast<const CppShader *>(handle)->binary();
+}
+
+uint64_t CppDevice::create_shader_from_binary(Function kernel, std::span<const std::byte> binary) noexcept {
+    auto object = _compiler.load(kernel, binary);
+    return reinterpret_cast<uint64_t>(new CppShader{std::move(object), kernel});
+}
+
+uint64_t CppDevice::create_event() noexcept {
+    return reinterpret_cast<uint64_t>(new CppEvent);
+}
+
+void CppDevice::destroy_event(uint64_t handle) noexcept {
+    delete reinterpret_cast<CppEvent *>(handle);
+}
+
+// streams execute eagerly, so events are signaled as soon as they are recorded
+void CppDevice::signal_event(uint64_t, uint64_t) noexcept {}
+void CppDevice::wait_event(uint64_t, uint64_t) noexcept {}
+void CppDevice::synchronize_event(uint64_t) noexcept {}
+bool CppDevice::query_event(uint64_t) noexcept { return true; }
+
+uint64_t CppDevice::create_mesh() noexcept {
+    LUISA_ERROR_WITH_LOCATION("Meshes are not supported by the C++ JIT backend.");
+}
+
+void CppDevice::destroy_mesh(uint64_t) noexcept {}
+
+uint64_t CppDevice::create_accel() noexcept {
+    LUISA_ERROR_WITH_LOCATION("Acceleration structures are not supported by the C++ JIT backend.");
+}
+
+void CppDevice::destroy_accel(uint64_t) noexcept {}
+
+}// namespace luisa::compute::cpp
+
+LUISA_EXPORT luisa::compute::Device::Interface *create(const luisa::compute::Context &ctx, uint32_t id) noexcept {
+    return new luisa::compute::cpp::CppDevice{ctx, id};
+}
+
+LUISA_EXPORT void destroy(luisa::compute::Device::Interface *device) noexcept {
+    delete device;
+}
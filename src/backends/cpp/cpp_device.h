@@ -0,0 +1,78 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#pragma once
+
+#include <unordered_map>
+
+#include <util/spin_mutex.h>
+#include <runtime/device.h>
+#include <backends/cpp/cpp_compiler.h>
+#include <backends/cpp/cpp_thread_pool.h>
+
+namespace luisa::compute::cpp {
+
+// CPU device running kernels generated by CppJitCodegen and compiled by the
+// host toolchain. Buffers live in host memory with their addresses as
+// handles; textures, heaps, meshes and acceleration structures are not
+// supported. File-backed buffers point kernels at the file mappings.
+//
+// With LUISA_CPP_NUMA_BINDING set (to anything but 0), device index i is bound
+// to NUMA node i: the workers run on the processors of the node, and large
+// buffers are placed on it. Otherwise index 0 is the only device, unpinned.
+class CppDevice final : public Device::Interface {
+
+private:
+    struct LargeBuffer {
+        std::span<std::byte> pages;
+        bool file_mapping;// from memory_map_file(), otherwise allocate_pages()
+    };
+
+private:
+    CppCompiler _compiler;
+    int _numa_node;
+    CppThreadPool _thread_pool;
+    spin_mutex _large_buffer_mutex;
+    std::unordered_map<uint64_t, LargeBuffer> _large_buffers;// handle -> pages
+
+public:
+    CppDevice(const Context &ctx, uint device_id) noexcept;
+    ~CppDevice() noexcept override = default;
+    [[nodiscard]] auto &thread_pool() noexcept { return _thread_pool; }
+    [[nodiscard]] auto numa_node() const noexcept { return _numa_node; }// -1 if not bound
+    uint64_t create_buffer(size_t size_bytes, uint64_t heap_handle, uint32_t index_in_heap) noexcept override;
+    void destroy_buffer(uint64_t handle) noexcept override;
+    // buffers are host memory anyway
+    MappedBufferAccess mapped_buffer_access() const noexcept override { return MappedBufferAccess::UNIFIED; }
+    void *mapped_buffer_address(uint64_t handle) noexcept override { return reinterpret_cast<void *>(handle); }
+    bool file_buffers_supported() const noexcept override { return true; }
+    uint64_t create_file_buffer(std::span<const std::byte> mapping) noexcept override;
+    uint64_t create_texture(PixelFormat format, uint dimension, uint width, uint height, uint depth, uint mipmap_levels, TextureSampler sampler, uint64_t heap_handle, uint32_t index_in_heap) override;
+    void destroy_texture(uint64_t handle) noexcept override;
+    uint64_t create_heap(size_t size) noexcept override;
+    size_t query_heap_memory_usage(uint64_t handle) noexcept override;
+    void destroy_heap(uint64_t handle) noexcept override;
+    uint64_t create_stream() noexcept override;
+    void destroy_stream(uint64_t handle) noexcept override;
+    void synchronize_stream(uint64_t stream_handle) noexcept override;
+    void dispatch(uint64_t stream_handle, CommandList list) noexcept override;
+    void dispatch_profiled(uint64_t stream_handle, CommandList list, TimestampCallback callback) noexcept override;
+    uint64_t create_shader(Function kernel) noexcept override;
+    void destroy_shader(uint64_t handle) noexcept override;
+    [[nodiscard]] std::string_view shader_binary_format() const noexcept override;
+    [[nodiscard]] std::vector<std::byte> shader_binary(uint64_t handle) noexcept override;
+    [[nodiscard]] uint64_t create_shader_from_binary(Function kernel, std::span<const std::byte> binary) noexcept override;
+    uint64_t create_event() noexcept override;
+    void destroy_event(uint64_t handle) noexcept override;
+    void signal_event(uint64_t handle, uint64_t stream_handle) noexcept override;
+    void wait_event(uint64_t handle, uint64_t stream_handle) noexcept override;
+    void synchronize_event(uint64_t handle) noexcept override;
+    bool query_event(uint64_t handle) noexcept override;
+    uint64_t create_mesh() noexcept override;
+    void destroy_mesh(uint64_t handle) noexcept override;
+    uint64_t create_accel() noexcept override;
+    void destroy_accel(uint64_t handle) noexcept override;
+};
+
+}// namespace luisa::compute::cpp
@@ -0,0 +1,77 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#include <fstream>
+
+#include <core/hash.h>
+#include <core/logging.h>
+#include <backends/cpp/cpp_thread_pool.h>
+#include <backends/cpp/cpp_shader.h>
+
+namespace luisa::compute::cpp {
+
+CppShader::CppShader(CppCompiler::Object object, Function kernel) noexcept
+    : _object{std::move(object)},
+      _entry{_object.module->function<CppJitCodegen::Entry>(CppJitCodegen::entry_name)},
+      _block_size{kernel.block_size()} {
+    if (_entry == nullptr) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Failed to find entry '{}' for kernel #{}.",
+            CppJitCodegen::entry_name, hash_to_string(kernel.hash()));
+    }
+    // the same order as the parameters of the generated entry
+    for (auto arg : kernel.arguments()) {
+        _argument_slots.emplace(arg.uid(), static_cast<uint>(_argument_slots.size()));
+    }
+    for (auto &&buffer : kernel.captured_buffers()) {
+        _argument_slots.emplace(buffer.variable.uid(), static_cast<uint>(_argument_slots.size()));
+    }
+}
+
+void CppShader::dispatch(CppThreadPool &pool, const ShaderDispatchCommand *command) const noexcept {
+    std::vector<void *> arguments(_argument_slots.size(), nullptr);
+    auto slot = [this](uint32_t uid) noexcept {
+        auto iter = _argument_slots.find(uid);
+        if (iter == _argument_slots.cend()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Unknown argument #{} in shader dispatch.", uid);
+        }
+        return iter->second;
+    };
+    command->decode([&](auto uid, auto argument) noexcept {
+        using T = decltype(argument);
+        if constexpr (std::is_same_v<T, ShaderDispatchCommand::BufferArgument>) {
+            arguments[slot(uid)] = reinterpret_cast<std::byte *>(argument.handle) + argument.offset;
+        } else if constexpr (std::is_same_v<T, std::span<const std::byte>>) {
+            // uniforms live in the command, which outlives the synchronous dispatch
+            arguments[slot(uid)] = const_cast<std::byte *>(argument.data());
+        } else {
+            LUISA_ERROR_WITH_LOCATION(
+                "Unsupported argument #{} in shader dispatch "
+                "(only buffers and uniforms are supported by the C++ JIT backend).",
+                uid);
+        }
+    });
+    auto dispatch_size = command->dispatch_size();
+    auto block_count = (dispatch_size + _block_size - 1u) / _block_size;
+    auto n = block_count.x * block_count.y * block_count.z;
+    // a few chunks per thread to balance uneven blocks
+    auto grain = std::max(n / (pool.size() * 4u), 1u);
+    uint size[]{dispatch_size.x, dispatch_size.y, dispatch_size.z};
+    pool.parallel_for(n, grain, [&](uint begin, uint end) noexcept {
+        _entry(arguments.data(), size, begin, end);
+    });
+}
+
+std::vector<std::byte> CppShader::binary() const noexcept {
+    std::ifstream file{_object.path, std::ios::binary | std::ios::ate};
+    if (!file) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Failed to open object '{}'.", _object.path.string());
+    }
+    std::vector<std::byte> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return bytes;
+}
+
+}// namespace luisa::compute::cpp
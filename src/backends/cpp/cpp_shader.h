@@ -0,0 +1,37 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include <util/dynamic_module.h>
+#include <runtime/command.h>
+#include <backends/cpp/cpp_codegen.h>
+#include <backends/cpp/cpp_compiler.h>
+
+namespace luisa::compute::cpp {
+
+class CppThreadPool;
+
+// A kernel compiled into a shared object, together with the mapping from
+// variable uids to the argument slots expected by its entry.
+class CppShader {
+
+private:
+    CppCompiler::Object _object;
+    CppJitCodegen::Entry *_entry;
+    std::unordered_map<uint32_t, uint> _argument_slots;
+    uint3 _block_size;
+
+public:
+    CppShader(CppCompiler::Object object, Function kernel) noexcept;
+    void dispatch(CppThreadPool &pool, const ShaderDispatchCommand *command) const noexcept;
+    // contents of the shared object
+    [[nodiscard]] std::vector<std::byte> binary() const noexcept;
+};
+
+}// namespace luisa::compute::cpp
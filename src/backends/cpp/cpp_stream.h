@@ -0,0 +1,29 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#pragma once
+
+#include <mutex>
+
+namespace luisa::compute::cpp {
+
+// Command lists are executed eagerly on the dispatching thread (kernels are
+// spread over the thread pool and joined before returning), so a stream only
+// has to serialize the lists submitted to it and events are always signaled.
+class CppStream {
+
+private:
+    std::mutex _mutex;
+
+public:
+    template<typename F>
+    decltype(auto) with_locked(F &&f) noexcept {
+        std::scoped_lock lock{_mutex};
+        return f();
+    }
+};
+
+struct CppEvent {};
+
+}// namespace luisa::compute::cpp
@@ -0,0 +1,85 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#include <core/logging.h>
+#include <core/platform.h>
+#include <backends/cpp/cpp_thread_pool.h>
+
+namespace luisa::compute::cpp {
+
+CppThreadPool::CppThreadPool(uint thread_count, int numa_node) noexcept {
+    if (numa_node >= 0) {
+        auto processors = numa_node_processors(static_cast<uint>(numa_node));
+        if (!processors.empty()) { thread_count = static_cast<uint>(processors.size()); }
+    }
+    auto worker_count = std::max(thread_count, 1u) - 1u;
+    _workers.reserve(worker_count);
+    for (auto i = 0u; i < worker_count; i++) {
+        _workers.emplace_back([this, numa_node] {
+            if (numa_node >= 0 && !bind_thread_to_numa_node(static_cast<uint>(numa_node))) [[unlikely]] {
+                LUISA_WARNING_WITH_LOCATION(
+                    "Failed to bind C++ JIT worker thread to NUMA node {}.",
+                    numa_node);
+            }
+            uint64_t epoch{0u};
+            for (;;) {
+                {
+                    std::unique_lock lock{_mutex};
+                    _cv.wait(lock, [&] { return _should_stop || _epoch != epoch; });
+                    if (_should_stop) { break; }
+                    epoch = _epoch;
+                }
+                _run_chunks();
+                std::scoped_lock lock{_mutex};
+                if (--_active_workers == 0u) { _done_cv.notify_one(); }
+            }
+        });
+    }
+    if (numa_node >= 0) {
+        LUISA_INFO("Created C++ JIT thread pool with {} thread(s) on NUMA node {}.", size(), numa_node);
+    } else {
+        LUISA_INFO("Created C++ JIT thread pool with {} thread(s).", size());
+    }
+}
+
+CppThreadPool::~CppThreadPool() noexcept {
+    {
+        std::scoped_lock lock{_mutex};
+        _should_stop = true;
+    }
+    _cv.notify_all();
+    for (auto &&worker : _workers) { worker.join(); }
+}
+
+void CppThreadPool::_run_chunks() noexcept {
+    for (;;) {
+        auto begin = _next.fetch_add(_grain, std::memory_order_relaxed);
+        if (begin >= _count) { break; }
+        (*_task)(begin, std::min(begin + _grain, _count));
+    }
+}
+
+void CppThreadPool::parallel_for(uint count, uint grain, const Task &task) noexcept {
+    if (count == 0u) { return; }
+    std::scoped_lock dispatch_lock{_dispatch_mutex};
+    if (_workers.empty() || count <= grain) {
+        task(0u, count);
+        return;
+    }
+    {
+        std::scoped_lock lock{_mutex};
+        _task = &task;
+        _count = count;
+        _grain = std::max(grain, 1u);
+        _next.store(0u, std::memory_order_relaxed);
+        _active_workers = static_cast<uint>(_workers.size());
+        _epoch++;
+    }
+    _cv.notify_all();
+    _run_chunks();
+    std::unique_lock lock{_mutex};
+    _done_cv.wait(lock, [this] { return _active_workers == 0u; });
+}
+
+}// namespace luisa::compute::cpp
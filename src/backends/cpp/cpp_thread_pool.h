@@ -0,0 +1,56 @@
+//
+// Created by Mike Smith on 2021/9/2.
+//
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include <core/basic_types.h>
+
+namespace luisa::compute::cpp {
+
+// Fixed set of workers executing one blocking parallel-for at a time. Items
+// are handed out in chunks of `grain` through an atomic counter, and the
+// calling thread takes part in the work as well.
+class CppThreadPool {
+
+public:
+    using Task = std::function<void(uint /* begin */, uint /* end */)>;
+
+private:
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::mutex _dispatch_mutex;
+    std::condition_variable _cv;
+    std::condition_variable _done_cv;
+    const Task *_task{nullptr};
+    uint _count{0u};
+    uint _grain{1u};
+    std::atomic<uint> _next{0u};
+    uint _active_workers{0u};
+    uint64_t _epoch{0u};
+    bool _should_stop{false};
+
+private:
+    void _run_chunks() noexcept;
+
+public:
+    // uses one worker fewer than the hardware concurrency, as the caller joins in;
+    // with a NUMA node, one thread per processor of the node, each bound to the node
+    explicit CppThreadPool(uint thread_count = std::thread::hardware_concurrency(), int numa_node = -1) noexcept;
+    ~CppThreadPool() noexcept;
+    CppThreadPool(CppThreadPool &&) noexcept = delete;
+    CppThreadPool(const CppThreadPool &) noexcept = delete;
+    CppThreadPool &operator=(CppThreadPool &&) noexcept = delete;
+    CppThreadPool &operator=(const CppThreadPool &) noexcept = delete;
+    [[nodiscard]] auto size() const noexcept { return static_cast<uint>(_workers.size() + 1u); }
+    void parallel_for(uint count, uint grain, const Task &task) noexcept;
+};
+
+}// namespace luisa::compute::cpp
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <runtime/sub_allocator.h>
 #include <backends/cuda/cuda_error.h>
 
 namespace luisa::compute::cuda {
@@ -18,15 +19,26 @@ private:
         size_t _index;
     };
     CUDAHeap *_heap{nullptr};
+    SubAllocator::Allocation _allocation{};
+    void *_host_address{nullptr};
 
 public:
     explicit CUDABuffer(CUdeviceptr handle = 0u) noexcept
         : _handle{handle} {}
+    // sub-allocated from the device's buffer blocks
+    explicit CUDABuffer(SubAllocator::Allocation allocation) noexcept
+        : _handle{static_cast<CUdeviceptr>(allocation.block + allocation.offset)},
+          _allocation{allocation} {}
+    // mapped pinned host memory
+    CUDABuffer(CUdeviceptr handle, void *host_address) noexcept
+        : _handle{handle}, _host_address{host_address} {}
     CUDABuffer(CUDAHeap *heap, size_t index) noexcept
         : _index{index}, _heap{heap} {}
     [[nodiscard]] CUdeviceptr handle() const noexcept;
     [[nodiscard]] auto index() const noexcept { return _index; }
     [[nodiscard]] auto heap() const noexcept { return _heap; }
+    [[nodiscard]] auto allocation() const noexcept { return _allocation; }
+    [[nodiscard]] auto host_address() const noexcept { return _host_address; }
 };
 
 }// namespace luisa::compute::cuda
@@ -2,6 +2,9 @@
 // Created by Mike on 7/28/2021.
 //
 
+#include <algorithm>
+
+#include <core/clock.h>
 #include <runtime/texture.h>
 #include <runtime/heap.h>
 #include <backends/cuda/cuda_heap.h>
@@ -13,26 +16,63 @@ namespace luisa::compute::cuda {
 
 uint64_t CUDADevice::create_buffer(size_t size_bytes, uint64_t heap_handle, uint32_t index_in_heap) noexcept {
     if (heap_handle != Heap::invalid_handle) {// from heap
-        return with_handle([heap = reinterpret_cast<CUDAHeap *>(heap_handle), index = index_in_heap, size = size_bytes] {
-            return reinterpret_cast<uint64_t>(heap->allocate_buffer(index, size));
+        auto heap = reinterpret_cast<CUDAHeap *>(heap_handle);
+        auto handle = _buffers.create(heap, index_in_heap);
+        with_handle([heap, handle, index = index_in_heap, size = size_bytes] {
+            heap->allocate_buffer(handle, index, size);
         });
+        return handle;
     }
-    return with_handle([size = size_bytes] {
-        CUdeviceptr ptr = 0ul;
-        LUISA_CHECK_CUDA(cuMemAllocAsync(&ptr, size, nullptr));
-        return reinterpret_cast<uint64_t>(new CUDABuffer{ptr});
-    });
+    auto allocation = _buffer_allocator.allocate(size_bytes);
+    if (!allocation) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Failed to allocate CUDA buffer with {} bytes.", size_bytes);
+    }
+    return _buffers.create(allocation);
 }
 
 void CUDADevice::destroy_buffer(uint64_t handle) noexcept {
-    with_handle([buffer = reinterpret_cast<CUDABuffer *>(handle)] {
-        if (auto heap = buffer->heap(); heap != nullptr) {
-            heap->destroy_buffer(buffer);
-        } else {
-            LUISA_CHECK_CUDA(cuMemFreeAsync(buffer->handle(), nullptr));
-            delete buffer;
-        }
+    if (auto &&buffer = _buffers[handle]; buffer.heap() != nullptr) {
+        with_handle([heap = buffer.heap(), handle, index = buffer.index()] {
+            heap->destroy_buffer(handle, index);
+        });
+    } else if (auto host_address = buffer.host_address(); host_address != nullptr) {
+        with_handle([host_address] { LUISA_CHECK_CUDA(cuMemFreeHost(host_address)); });
+    } else {
+        // the destruction queue only hands the buffer over once the streams using it
+        // have passed their last use (see runtime/destruction_queue.h), so no stream-ordering here
+        _buffer_allocator.free(buffer.allocation());
+    }
+    _buffers.destroy(handle);
+}
+
+std::string CUDADevice::device_name() const noexcept {
+    auto driver_version = 0;
+    LUISA_CHECK_CUDA(cuDriverGetVersion(&driver_version));
+    return fmt::format("{} (driver {})", _handle.name(), driver_version);
+}
+
+MappedBufferAccess CUDADevice::mapped_buffer_access() const noexcept {
+    auto can_map = 0;
+    auto integrated = 0;
+    LUISA_CHECK_CUDA(cuDeviceGetAttribute(&can_map, CU_DEVICE_ATTRIBUTE_CAN_MAP_HOST_MEMORY, _handle.device()));
+    LUISA_CHECK_CUDA(cuDeviceGetAttribute(&integrated, CU_DEVICE_ATTRIBUTE_INTEGRATED, _handle.device()));
+    if (!can_map) { return MappedBufferAccess::NONE; }
+    return integrated ? MappedBufferAccess::UNIFIED : MappedBufferAccess::REMOTE;
+}
+
+uint64_t CUDADevice::create_mapped_buffer(size_t size_bytes) noexcept {
+    auto [device_address, host_address] = with_handle([size_bytes] {
+        void *host_address = nullptr;
+        CUdeviceptr device_address = 0u;
+        LUISA_CHECK_CUDA(cuMemHostAlloc(&host_address, size_bytes, CU_MEMHOSTALLOC_PORTABLE | CU_MEMHOSTALLOC_DEVICEMAP));
+        LUISA_CHECK_CUDA(cuMemHostGetDevicePointer(&device_address, host_address, 0u));
+        return std::make_pair(device_address, host_address);
     });
+    return _buffers.create(device_address, host_address);
+}
+
+void *CUDADevice::mapped_buffer_address(uint64_t handle) noexcept {
+    return _buffers[handle].host_address();
 }
 
 uint64_t CUDADevice::create_texture(PixelFormat format, uint dimension, uint width, uint height, uint depth, uint mipmap_levels, TextureSampler sampler, uint64_t heap_handle, uint32_t index_in_heap) {
@@ -209,38 +249,102 @@ size_t CUDADevice::query_heap_memory_usage(uint64_t handle) noexcept {
 }
 
 void CUDADevice::destroy_heap(uint64_t handle) noexcept {
-    with_handle([heap = reinterpret_cast<CUDAHeap *>(handle)] {
-        delete heap;
-    });
+    auto heap = reinterpret_cast<CUDAHeap *>(handle);
+    // buffers still in the heap die with it
+    for (auto buffer : heap->active_buffers()) { _buffers.destroy(buffer); }
+    with_handle([heap] { delete heap; });
 }
 
 uint64_t CUDADevice::create_stream() noexcept {
-    return with_handle([&] {
-        return reinterpret_cast<uint64_t>(new CUDAStream);
-    });
+    return with_handle([this] { return _streams.create(); });
 }
 
 void CUDADevice::destroy_stream(uint64_t handle) noexcept {
-    with_handle([stream = reinterpret_cast<CUDAStream *>(handle)] {
-        delete stream;
-    });
+    with_handle([this, handle] { _streams.destroy(handle); });
 }
 
 void CUDADevice::synchronize_stream(uint64_t handle) noexcept {
-    with_handle([stream = reinterpret_cast<CUDAStream *>(handle)] {
+    with_handle([stream = &_streams[handle]] {
         LUISA_CHECK_CUDA(cuStreamSynchronize(stream->handle()));
     });
+    _complete_profiled_lists(false);
 }
 
 void CUDADevice::dispatch(uint64_t stream_handle, CommandList list) noexcept {
-    with_handle([stream = reinterpret_cast<CUDAStream *>(stream_handle), cmd_list = std::move(list)] {
-        CUDACommandEncoder encoder{stream};
+    with_handle([this, stream = &_streams[stream_handle], cmd_list = std::move(list)] {
+        CUDACommandEncoder encoder{this, stream};
         for (auto cmd : cmd_list) {
             cmd->accept(encoder);
         }
+        stream->fence_staging();
     });
 }
 
+void CUDADevice::dispatch_profiled(uint64_t stream_handle, CommandList list, TimestampCallback callback) noexcept {
+    _complete_profiled_lists(false);
+    // timed with events on the stream, so the commands keep overlapping with the host and other streams
+    std::scoped_lock lock{_profile_mutex};
+    with_handle([this, stream = &_streams[stream_handle], cmd_list = std::move(list), &callback] {
+        if (_profile_epoch_event == nullptr) {
+            LUISA_CHECK_CUDA(cuEventCreate(&_profile_epoch_event, CU_EVENT_DEFAULT));
+            LUISA_CHECK_CUDA(cuEventRecord(_profile_epoch_event, nullptr));
+            LUISA_CHECK_CUDA(cuEventSynchronize(_profile_epoch_event));
+            _profile_epoch = Clock::timestamp();
+        }
+        auto record = [stream] {
+            CUevent event = nullptr;
+            LUISA_CHECK_CUDA(cuEventCreate(&event, CU_EVENT_DEFAULT));
+            LUISA_CHECK_CUDA(cuEventRecord(event, stream->handle()));
+            return event;
+        };
+        auto &&profiled = _profiled_lists.emplace_back(ProfiledList{{}, std::move(callback)});
+        profiled.events.emplace_back(record());
+        CUDACommandEncoder encoder{this, stream};
+        for (auto cmd : cmd_list) {
+            cmd->accept(encoder);
+            profiled.events.emplace_back(record());
+        }
+        stream->fence_staging();
+    });
+}
+
+void CUDADevice::_complete_profiled_lists(bool wait) noexcept {
+    std::vector<TimestampCallback> callbacks;
+    std::vector<std::vector<CommandTimestamps>> timestamps;
+    {
+        std::scoped_lock lock{_profile_mutex};
+        if (_profiled_lists.empty()) { return; }
+        with_handle([&] {
+            // event times are relative, so they are anchored to the host time of the epoch event
+            auto host_time = [this](CUevent event) noexcept {
+                auto ms = 0.0f;
+                LUISA_CHECK_CUDA(cuEventElapsedTime(&ms, _profile_epoch_event, event));
+                return _profile_epoch + static_cast<uint64_t>(std::max(static_cast<double>(ms), 0.0) * 1e6);
+            };
+            std::vector<ProfiledList> pending;
+            for (auto &&p : _profiled_lists) {
+                auto last = p.events.back();
+                if (wait) { LUISA_CHECK_CUDA(cuEventSynchronize(last)); }
+                if (auto result = cuEventQuery(last); result == CUDA_ERROR_NOT_READY) {
+                    pending.emplace_back(std::move(p));
+                    continue;
+                } else {
+                    LUISA_CHECK_CUDA(result);
+                }
+                auto &&t = timestamps.emplace_back();
+                for (auto i = 1u; i < p.events.size(); i++) {
+                    t.emplace_back(CommandTimestamps{host_time(p.events[i - 1u]), host_time(p.events[i])});
+                }
+                for (auto event : p.events) { LUISA_CHECK_CUDA(cuEventDestroy(event)); }
+                callbacks.emplace_back(std::move(p.callback));
+            }
+            _profiled_lists = std::move(pending);
+        });
+    }
+    // the callbacks may take other locks, so they are called without holding ours
+    for (auto i = 0u; i < callbacks.size(); i++) { callbacks[i](timestamps[i]); }
+}
+
 uint64_t CUDADevice::create_shader(Function kernel) noexcept {
     return 0;
 }
@@ -248,6 +352,13 @@ uint64_t CUDADevice::create_shader(Function kernel) noexcept {
 void CUDADevice::destroy_shader(uint64_t handle) noexcept {
 }
 
+uint32_t CUDADevice::shader_max_block_threads(uint64_t handle) noexcept {
+    // TODO: also bound by cuFuncGetAttribute(CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK) once shaders are compiled
+    auto max_threads = 0;
+    LUISA_CHECK_CUDA(cuDeviceGetAttribute(&max_threads, CU_DEVICE_ATTRIBUTE_MAX_THREADS_PER_BLOCK, _handle.device()));
+    return static_cast<uint32_t>(max_threads);
+}
+
 uint64_t CUDADevice::create_event() noexcept {
     return with_handle([] {
         CUevent event = nullptr;
@@ -265,14 +376,14 @@ void CUDADevice::destroy_event(uint64_t handle) noexcept {
 
 void CUDADevice::signal_event(uint64_t handle, uint64_t stream_handle) noexcept {
     with_handle([event = reinterpret_cast<CUevent>(handle),
-                 stream = reinterpret_cast<CUDAStream *>(stream_handle)] {
+                 stream = &_streams[stream_handle]] {
         LUISA_CHECK_CUDA(cuEventRecord(event, stream->handle()));
     });
 }
 
 void CUDADevice::wait_event(uint64_t handle, uint64_t stream_handle) noexcept {
     with_handle([event = reinterpret_cast<CUevent>(handle),
-                 stream = reinterpret_cast<CUDAStream *>(stream_handle)] {
+                 stream = &_streams[stream_handle]] {
         LUISA_CHECK_CUDA(cuStreamWaitEvent(stream->handle(), event, CU_EVENT_WAIT_DEFAULT));
     });
 }
@@ -283,6 +394,15 @@ void CUDADevice::synchronize_event(uint64_t handle) noexcept {
     });
 }
 
+bool CUDADevice::query_event(uint64_t handle) noexcept {
+    return with_handle([event = reinterpret_cast<CUevent>(handle)] {
+        auto result = cuEventQuery(event);
+        if (result == CUDA_ERROR_NOT_READY) { return false; }
+        LUISA_CHECK_CUDA(result);
+        return true;
+    });
+}
+
 uint64_t CUDADevice::create_mesh() noexcept {
     return 0;
 }
@@ -298,7 +418,28 @@ void CUDADevice::destroy_accel(uint64_t handle) noexcept {
 }
 
 CUDADevice::CUDADevice(const Context &ctx, uint device_id) noexcept
-    : Device::Interface{ctx}, _handle{device_id} {}
+    : Device::Interface{ctx}, _handle{device_id},
+      _buffer_allocator{SubAllocator::Callbacks{
+          .create_block = [this](size_t size) noexcept {
+              return with_handle([size] {
+                  CUdeviceptr ptr = 0u;
+                  if (cuMemAlloc(&ptr, size) != CUDA_SUCCESS) { return static_cast<uint64_t>(0u); }
+                  return static_cast<uint64_t>(ptr);
+              });
+          },
+          .destroy_block = [this](uint64_t block, size_t) noexcept {
+              with_handle([block] { LUISA_CHECK_CUDA(cuMemFree(static_cast<CUdeviceptr>(block))); });
+          }}} {}
+
+CUDADevice::~CUDADevice() noexcept {
+    _complete_profiled_lists(true);
+    // leaked objects are destroyed with the context current
+    with_handle([this] {
+        if (_profile_epoch_event != nullptr) { LUISA_CHECK_CUDA(cuEventDestroy(_profile_epoch_event)); }
+        _streams.clear();
+        _buffers.clear();
+    });
+}
 
 CUDADevice::Handle::Handle(uint index) noexcept {
     static std::once_flag flag;
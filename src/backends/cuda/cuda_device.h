@@ -6,7 +6,14 @@
 
 #include <cuda.h>
 
+#include <mutex>
+#include <vector>
+
 #include <runtime/device.h>
+#include <runtime/sub_allocator.h>
+#include <runtime/handle_table.h>
+#include <backends/cuda/cuda_buffer.h>
+#include <backends/cuda/cuda_stream.h>
 #include <backends/cuda/cuda_error.h>
 
 namespace luisa::compute::cuda {
@@ -52,16 +59,41 @@ public:
         [[nodiscard]] auto context() const noexcept { return _context; }
     };
 
+private:
+    // a profiled command list, with timing events recorded before its
+    // commands and after each of them, waiting to be read back
+    struct ProfiledList {
+        std::vector<CUevent> events;
+        TimestampCallback callback;
+    };
+
 private:
     Handle _handle;
     std::recursive_mutex _mutex;
+    CUevent _profile_epoch_event{nullptr};// created with the first profiled list, maps event times to the host clock
+    uint64_t _profile_epoch{0u};
+    std::mutex _profile_mutex;
+    std::vector<ProfiledList> _profiled_lists;
+    SubAllocator _buffer_allocator;// buffers not from heaps, declared after _handle to be released before it
+    HandleTable<CUDABuffer> _buffers;
+    HandleTable<CUDAStream> _streams;
+
+private:
+    // reports the profiled lists that have executed, or waits for all of them
+    void _complete_profiled_lists(bool wait) noexcept;
 
 public:
     CUDADevice(const Context &ctx, uint device_id) noexcept;
-    ~CUDADevice() noexcept override = default;
+    ~CUDADevice() noexcept override;
     [[nodiscard]] auto &handle() const noexcept { return _handle; }
+    [[nodiscard]] auto &buffer(uint64_t handle) const noexcept { return _buffers[handle]; }
+    [[nodiscard]] auto &stream(uint64_t handle) const noexcept { return _streams[handle]; }
+    std::string device_name() const noexcept override;
     uint64_t create_buffer(size_t size_bytes, uint64_t heap_handle, uint32_t index_in_heap) noexcept override;
     void destroy_buffer(uint64_t handle) noexcept override;
+    MappedBufferAccess mapped_buffer_access() const noexcept override;
+    uint64_t create_mapped_buffer(size_t size_bytes) noexcept override;
+    void *mapped_buffer_address(uint64_t handle) noexcept override;
     uint64_t create_texture(PixelFormat format, uint dimension, uint width, uint height, uint depth, uint mipmap_levels, TextureSampler sampler, uint64_t heap_handle, uint32_t index_in_heap) override;
     void destroy_texture(uint64_t handle) noexcept override;
     uint64_t create_heap(size_t size) noexcept override;
@@ -71,13 +103,16 @@ public:
     void destroy_stream(uint64_t handle) noexcept override;
     void synchronize_stream(uint64_t stream_handle) noexcept override;
     void dispatch(uint64_t stream_handle, CommandList list) noexcept override;
+    void dispatch_profiled(uint64_t stream_handle, CommandList list, TimestampCallback callback) noexcept override;
     uint64_t create_shader(Function kernel) noexcept override;
     void destroy_shader(uint64_t handle) noexcept override;
+    uint32_t shader_max_block_threads(uint64_t handle) noexcept override;
     uint64_t create_event() noexcept override;
     void destroy_event(uint64_t handle) noexcept override;
     void signal_event(uint64_t handle, uint64_t stream_handle) noexcept override;
     void wait_event(uint64_t handle, uint64_t stream_handle) noexcept override;
     void synchronize_event(uint64_t handle) noexcept override;
+    bool query_event(uint64_t handle) noexcept override;
     uint64_t create_mesh() noexcept override;
     void destroy_mesh(uint64_t handle) noexcept override;
     uint64_t create_accel() noexcept override;
@@ -2,6 +2,8 @@
 // Created by Mike on 7/30/2021.
 //
 
+#include <algorithm>
+
 #include <runtime/heap.h>
 #include <backends/cuda/cuda_heap.h>
 #include <backends/cuda/cuda_device.h>
@@ -19,11 +21,11 @@ CUDAHeap::CUDAHeap(CUDADevice *device, size_t capacity) noexcept
     LUISA_CHECK_CUDA(cuMemPoolCreate(&_handle, &props));
     LUISA_CHECK_CUDA(cuMemPoolSetAttribute(_handle, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD, &capacity));
     LUISA_CHECK_CUDA(cuMemAllocAsync(&_desc_array, sizeof(Item) * Heap::slot_count, nullptr));
+    LUISA_CHECK_CUDA(cuMemsetD8Async(_desc_array, 0u, sizeof(Item) * Heap::slot_count, nullptr));
     _items.resize(Heap::slot_count);
 }
 
 CUDAHeap::~CUDAHeap() noexcept {
-    for (auto b : _active_buffers) { delete b; }
     for (auto t : _active_textures) {
         LUISA_CHECK_CUDA(cuMipmappedArrayDestroy(t->mip_array()));
         LUISA_CHECK_CUDA(cuTexObjectDestroy(t->handle()));
@@ -33,7 +35,7 @@ CUDAHeap::~CUDAHeap() noexcept {
     LUISA_CHECK_CUDA(cuMemPoolDestroy(_handle));
 }
 
-CUDABuffer *CUDAHeap::allocate_buffer(size_t index, size_t size) noexcept {
+void CUDAHeap::allocate_buffer(uint64_t handle, size_t index, size_t size) noexcept {
     //    auto buffer_ptr = _device->with_locked([d = _device->handle().device(), handle = _handle, size]{
     //        CUmemoryPool pool = nullptr;
     //        CUdeviceptr buffer = 0u;
@@ -45,22 +47,18 @@ CUDABuffer *CUDAHeap::allocate_buffer(size_t index, size_t size) noexcept {
     //    });
     CUdeviceptr buffer_ptr = 0u;
     LUISA_CHECK_CUDA(cuMemAllocFromPoolAsync(&buffer_ptr, size, _handle, nullptr));
-    auto buffer = new CUDABuffer{this, index};
     std::scoped_lock lock{_mutex};
     _items[index].buffer = buffer_ptr;
-    _dirty = true;
-    _active_buffers.emplace(buffer);
-    return buffer;
+    _mark_dirty(index);
+    _active_buffers.emplace(handle);
 }
 
-void CUDAHeap::destroy_buffer(CUDABuffer *buffer) noexcept {
-    auto index = buffer->index();
+void CUDAHeap::destroy_buffer(uint64_t handle, size_t index) noexcept {
     auto address = _items[index].buffer;
-    delete buffer;
     LUISA_CHECK_CUDA(cuMemFreeAsync(address, nullptr));
     std::scoped_lock lock{_mutex};
     _items[index].buffer = 0u;
-    _active_buffers.erase(buffer);
+    _active_buffers.erase(handle);
 }
 
 size_t CUDAHeap::memory_usage() const noexcept {
@@ -69,11 +67,25 @@ size_t CUDAHeap::memory_usage() const noexcept {
     return usage;
 }
 
+void CUDAHeap::_mark_dirty(size_t index) noexcept {
+    if (_dirty_begin == _dirty_end) {
+        _dirty_begin = static_cast<uint32_t>(index);
+        _dirty_end = static_cast<uint32_t>(index + 1u);
+    } else {
+        _dirty_begin = std::min(_dirty_begin, static_cast<uint32_t>(index));
+        _dirty_end = std::max(_dirty_end, static_cast<uint32_t>(index + 1u));
+    }
+}
+
 CUdeviceptr CUDAHeap::descriptor_array() const noexcept {
     std::scoped_lock lock{_mutex};
-    if (_dirty) {
-        LUISA_CHECK_CUDA(cuMemcpyHtoDAsync(_desc_array, _items.data(), sizeof(Item) * Heap::slot_count, nullptr));
-        _dirty = false;
+    // all updates since the last launch go in a single copy of the changed range
+    if (_dirty_begin != _dirty_end) {
+        LUISA_CHECK_CUDA(cuMemcpyHtoDAsync(
+            _desc_array + sizeof(Item) * _dirty_begin, _items.data() + _dirty_begin,
+            sizeof(Item) * (_dirty_end - _dirty_begin), nullptr));
+        _dirty_begin = 0u;
+        _dirty_end = 0u;
     }
     return _desc_array;
 }
@@ -281,7 +293,7 @@ CUDATexture *CUDAHeap::allocate_texture(size_t index, PixelFormat format, uint d
     auto texture = new CUDATexture{this, index, array_handle, dim};
     std::scoped_lock lock{_mutex};
     _items[index].texture = texture_handle;
-    _dirty = true;
+    _mark_dirty(index);
     _active_textures.emplace(texture);
     return texture;
 }
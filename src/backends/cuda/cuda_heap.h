@@ -35,16 +35,22 @@ private:
     CUmemoryPool _handle;
     CUdeviceptr _desc_array;
     std::vector<Item> _items;
-    std::unordered_set<CUDABuffer *> _active_buffers;
+    std::unordered_set<uint64_t> _active_buffers;// handles in the device's buffer table
     std::unordered_set<CUDATexture *> _active_textures;
     mutable spin_mutex _mutex;
-    mutable bool _dirty{true};
+    // slots changed since the last upload of the descriptor array
+    mutable uint32_t _dirty_begin{0u};
+    mutable uint32_t _dirty_end{0u};
+
+private:
+    void _mark_dirty(size_t index) noexcept;
 
 public:
     CUDAHeap(CUDADevice *device, size_t capacity) noexcept;
     ~CUDAHeap() noexcept;
-    [[nodiscard]] CUDABuffer *allocate_buffer(size_t index, size_t size) noexcept;
-    void destroy_buffer(CUDABuffer *buffer) noexcept;
+    void allocate_buffer(uint64_t handle, size_t index, size_t size) noexcept;
+    void destroy_buffer(uint64_t handle, size_t index) noexcept;
+    [[nodiscard]] auto &active_buffers() const noexcept { return _active_buffers; }
     [[nodiscard]] CUDATexture *allocate_texture(size_t index, PixelFormat format, uint dim, uint3 size, uint mip_levels, TextureSampler sampler) noexcept;
     void destroy_texture(CUDATexture *texture) noexcept;
     [[nodiscard]] size_t memory_usage() const noexcept;
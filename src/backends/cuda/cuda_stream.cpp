@@ -2,18 +2,60 @@
 // Created by Mike on 8/1/2021.
 //
 
+#include <util/arena.h>
+#include <backends/cuda/cuda_error.h>
 #include <backends/cuda/cuda_stream.h>
 
 namespace luisa::compute::cuda {
 
+namespace detail {
+
+struct StagingFenceContext {
+    StagingRing *ring;
+    StagingRing::Fence fence;
+    StagingFenceContext(StagingRing *r, StagingRing::Fence f) noexcept
+        : ring{r}, fence{f} {}
+};
+
+[[nodiscard]] decltype(auto) staging_fence_context_pool() noexcept {
+    static Pool<StagingFenceContext> pool{Arena::global()};
+    return (pool);
+}
+
+}// namespace detail
+
 CUDAStream::CUDAStream() noexcept
     : _handle{nullptr},
-      _upload_pool{32_mb, true} {
+      _upload_ring{
+          staging_ring_size,
+          [](size_t size) noexcept {
+              // write-combined, as the host only writes to it
+              void *memory = nullptr;
+              LUISA_CHECK_CUDA(cuMemHostAlloc(&memory, size, CU_MEMHOSTALLOC_WRITECOMBINED));
+              return StagingRing::Block{static_cast<std::byte *>(memory), reinterpret_cast<uint64_t>(memory)};
+          },
+          [](StagingRing::Block block) noexcept {
+              LUISA_CHECK_CUDA(cuMemFreeHost(block.address));
+          }} {
     LUISA_CHECK_CUDA(cuStreamCreate(&_handle, CU_STREAM_DEFAULT));
 }
 
 CUDAStream::~CUDAStream() noexcept {
+    // the staging memory is freed after this
+    LUISA_CHECK_CUDA(cuStreamSynchronize(_handle));
     LUISA_CHECK_CUDA(cuStreamDestroy(_handle));
 }
 
+void CUDAStream::fence_staging() noexcept {
+    LUISA_CHECK_CUDA(cuLaunchHostFunc(
+        _handle, [](void *user_data) noexcept {
+            // no CUDA calls are allowed in host functions, so reclaim() only retires
+            // the overflow blocks, which are freed by later fences on this stream
+            auto context = static_cast<detail::StagingFenceContext *>(user_data);
+            context->ring->reclaim(context->fence);
+            detail::staging_fence_context_pool().recycle(context);
+        },
+        detail::staging_fence_context_pool().create(&_upload_ring, _upload_ring.fence())));
+}
+
 }// namespace luisa::compute::cuda
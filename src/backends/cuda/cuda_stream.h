@@ -5,21 +5,28 @@
 #pragma once
 
 #include <cuda.h>
-#include <backends/cuda/cuda_ring_buffer.h>
+
+#include <core/basic_types.h>
+#include <runtime/staging_ring.h>
 
 namespace luisa::compute::cuda {
 
 class CUDAStream {
 
+public:
+    static constexpr auto staging_ring_size = static_cast<size_t>(32_mb);
+
 private:
     CUstream _handle;
-    CUDARingBuffer _upload_pool;
+    StagingRing _upload_ring;
 
 public:
     CUDAStream() noexcept;
     ~CUDAStream() noexcept;
     [[nodiscard]] auto handle() const noexcept { return _handle; }
-    [[nodiscard]] decltype(auto) upload_pool() noexcept { return (_upload_pool); }
+    [[nodiscard]] auto &upload_ring() noexcept { return _upload_ring; }
+    // reclaims the staging memory of the commands encoded so far once the stream has passed them
+    void fence_staging() noexcept;
 };
 
-}
+}// namespace luisa::compute::cuda
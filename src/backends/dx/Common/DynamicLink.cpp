@@ -1,4 +1,5 @@
 #include <Common/DynamicLink.h>
+#include <util/NodeHashMap.h>
 namespace vstd {
 struct LinkTarget {
 	Runnable<void(), VEngine_AllocType::Default> funcPtr;
@@ -11,7 +12,8 @@ struct LinkTarget {
 	}
 };
 struct LinkMap {
-	using HashMapType = HashMap<string_view, LinkTarget, hash<string_view>, std::equal_to<string_view>, VEngine_AllocType::Default>;
+	// nodes, as GetFuncPair() hands out pointers into the targets
+	using HashMapType = NodeHashMap<string_view, LinkTarget, hash<string_view>, std::equal_to<string_view>, VEngine_AllocType::Default>;
 	StackObject<HashMapType> map;
 	luisa::spin_mutex mtx;
 	LinkMap() {
@@ -7,10 +7,12 @@
 #include <ShaderCompile/LuisaASTTranslator.h>
 #include <Utility/MD5.h>
 #include <util/linq.h>
+#include <util/NodeHashMap.h>
 namespace luisa::compute {
 namespace ShaderCompiler_Global {
 struct Data {
-	HashMap<Function, ShaderCompiler::ConstBufferData> globalVarOffsets;
+	// nodes, as the data is referenced after the lock is released
+	NodeHashMap<Function, ShaderCompiler::ConstBufferData> globalVarOffsets;
 	std::mutex mtx;
 };
 static StackObject<Data, true> data;
@@ -73,6 +73,8 @@ struct GetName {
 			return "int"_sv;
 		} else if constexpr (std::is_same_v<uint, T>) {
 			return "uint"_sv;
+		} else if constexpr (std::is_same_v<half, T>) {
+			return "half"_sv;
 		} else {
 			return "unknown"_sv;
 		}
@@ -103,6 +105,12 @@ struct PrintValue<float> {
 		vstd::to_string(v, str);
 	}
 };
+template<>
+struct PrintValue<half> {
+	void operator()(half const& v, vstd::string& str) {
+		vstd::to_string(static_cast<float>(v), str);
+	}
+};
 
 template<typename EleType, size_t N>
 struct PrintValue<Vector<EleType, N>> {
@@ -111,7 +119,11 @@ struct PrintValue<Vector<EleType, N>> {
 		varName += GetName<T>::Get();
 		varName += '(';
 		for (size_t i = 0; i < N; ++i) {
-			vstd::to_string(v[i], varName);
+			if constexpr (std::is_same_v<EleType, half>) {
+				vstd::to_string(static_cast<float>(v[i]), varName);
+			} else {
+				vstd::to_string(v[i], varName);
+			}
 			varName += ',';
 		}
 		varName[varName.size() - 1] = ')';
@@ -576,6 +588,9 @@ void CodegenUtility::GetTypeName(Type const& type, vstd::string& str, bool isWri
 		case Type::Tag::UINT:
 			str += "uint"_sv;
 			return;
+		case Type::Tag::HALF:
+			str += "half"_sv;
+			return;
 		case Type::Tag::MATRIX: {
 			auto dim = vstd::to_string(type.dimension());
 			CodegenUtility::GetTypeName(*type.element(), str, isWritable);
@@ -1046,6 +1061,21 @@ void CodegenUtility::GetFunctionName(CallExpr const* expr, vstd::string& result,
 			if (!IsType(expr->arguments()[0]->type(), Type::Tag::FLOAT, 4))
 				result << "make_float4"_sv;
 
+			break;
+		case CallOp::MAKE_HALF2:
+			if (!IsType(expr->arguments()[0]->type(), Type::Tag::HALF, 2))
+				result << "make_half2"_sv;
+
+			break;
+		case CallOp::MAKE_HALF3:
+			if (!IsType(expr->arguments()[0]->type(), Type::Tag::HALF, 3))
+				result << "make_half3"_sv;
+
+			break;
+		case CallOp::MAKE_HALF4:
+			if (!IsType(expr->arguments()[0]->type(), Type::Tag::HALF, 4))
+				result << "make_half4"_sv;
+
 			break;
 		default:
 			VEngine_Log("Function Not Implemented"_sv);
@@ -1187,6 +1217,7 @@ size_t CodegenUtility::PrintGlobalVariables(
 			case Type::Tag::UINT:
 			case Type::Tag::INT:
 			case Type::Tag::FLOAT:
+			case Type::Tag::HALF:
 				scalarArr.push_back(&var);
 				break;
 		}
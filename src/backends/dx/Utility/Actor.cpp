@@ -5,10 +5,10 @@ void* Actor::GetComponent(Type t) const {
 	return nullptr;
 }
 Actor::Pointer::~Pointer() {
-	disposer(ptr);
+	if (ptr) disposer(ptr);
 }
 void Actor::Pointer::operator=(Pointer const& p) {
-	disposer(ptr);
+	if (ptr) disposer(ptr);
 	ptr = p.ptr;
 	disposer = p.disposer;
 }
@@ -10,7 +10,9 @@ private:
 		void(*disposer)(void*);
 		void operator=(Pointer const& p);
 		~Pointer();
-		Pointer() {};
+		Pointer() : ptr(nullptr), disposer(nullptr) {};
+		// moved when the hash map rehashes, so only one of them disposes
+		Pointer(Pointer&& p) : ptr(p.ptr), disposer(p.disposer) { p.ptr = nullptr; }
 		Pointer(
 			void* ptr,
 			void(*disposer)(void*)) :
@@ -13,7 +13,6 @@ namespace luisa::compute::metal {
 
 class MetalDevice;
 class MetalStream;
-class MetalSharedBufferPool;
 
 class MetalAccel {
 
@@ -37,8 +36,7 @@ public:
         id<MTLCommandBuffer> command_buffer,
         AccelBuildHint hint,
         std::span<const uint64_t> mesh_handles,
-        std::span<const float4x4> transforms,
-        MetalSharedBufferPool *pool) noexcept;
+        std::span<const float4x4> transforms) noexcept;
     [[nodiscard]] id<MTLCommandBuffer> update(
         MetalStream *stream,
         id<MTLCommandBuffer> command_buffer,
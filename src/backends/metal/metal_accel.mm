@@ -12,8 +12,7 @@ id<MTLCommandBuffer> MetalAccel::build(
     id<MTLCommandBuffer> command_buffer,
     AccelBuildHint hint,
     std::span<const uint64_t> mesh_handles,
-    std::span<const float4x4> transforms,
-    MetalSharedBufferPool *pool) noexcept {
+    std::span<const float4x4> transforms) noexcept {
 
     // build instance buffer
     auto instance_buffer_size = mesh_handles.size() * sizeof(MTLAccelerationStructureInstanceDescriptor);
@@ -99,7 +98,7 @@ id<MTLCommandBuffer> MetalAccel::build(
                                   scratchBuffer:scratch_buffer
                             scratchBufferOffset:0u];
     if (hint != AccelBuildHint::FAST_REBUILD) {
-        auto compacted_size_buffer = pool->allocate();
+        auto compacted_size_buffer = MetalStream::buffer_view(stream->download_ring().allocate(sizeof(uint)));
         [command_encoder writeCompactedAccelerationStructureSize:_handle
                                                         toBuffer:compacted_size_buffer.handle()
                                                           offset:compacted_size_buffer.offset()];
@@ -110,7 +109,6 @@ id<MTLCommandBuffer> MetalAccel::build(
           *p_compacted_size = *reinterpret_cast<const uint *>(
               static_cast<const std::byte *>(compacted_size_buffer.handle().contents)
               + compacted_size_buffer.offset());
-          pool->recycle(compacted_size_buffer);
         }];
 
         stream->dispatch(command_buffer);
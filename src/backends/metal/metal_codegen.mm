@@ -91,50 +91,32 @@ public:
     }
     void operator()(int v) const noexcept { _s << v; }
     void operator()(uint v) const noexcept { _s << v << "u"; }
+    void operator()(half v) const noexcept {
+        auto f = static_cast<float>(v);
+        if (std::isnan(f)) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Encountered with NaN."); }
+        if (std::isinf(f)) {
+            _s << (f < 0.0f ? "(-HALF_INFINITY)" : "(+HALF_INFINITY)");
+        } else {
+            _s << f << "h";
+        }
+    }
 
     template<typename T, size_t N>
     void operator()(Vector<T, N> v) const noexcept {
-        auto t = Type::of<T>();
-        _s << t->description() << N << "(";
+        _s << Type::of<T>()->description() << N << "(";
         for (auto i = 0u; i < N; i++) {
+            if (i != 0u) { _s << ", "; }
             (*this)(v[i]);
-            _s << ", ";
-        }
-        _s.pop_back();
-        _s.pop_back();
-        _s << ")";
-    }
-
-    void operator()(float2x2 m) const noexcept {
-        _s << "float2x2(";
-        for (auto col = 0u; col < 2u; col++) {
-            for (auto row = 0u; row < 2u; row++) {
-                (*this)(m[col][row]);
-                _s << ", ";
-            }
-        }
-        _s.pop_back();
-        _s.pop_back();
-        _s << ")";
-    }
-
-    void operator()(float3x3 m) const noexcept {
-        _s << "float3x3(";
-        for (auto col = 0u; col < 3u; col++) {
-            for (auto row = 0u; row < 3u; row++) {
-                (*this)(m[col][row]);
-                _s << ", ";
-            }
         }
-        _s.pop_back();
-        _s.pop_back();
         _s << ")";
     }
 
-    void operator()(float4x4 m) const noexcept {
-        _s << "float4x4(";
-        for (auto col = 0u; col < 4u; col++) {
-            for (auto row = 0u; row < 4u; row++) {
+    template<size_t N>
+    void operator()(Matrix<N> m) const noexcept {
+        _s << "float" << N << "x" << N << "(";
+        for (auto col = 0u; col < N; col++) {
+            for (auto row = 0u; row < N; row++) {
+                if (col != 0u || row != 0u) { _s << ", "; }
                 (*this)(m[col][row]);
             }
         }
@@ -299,6 +281,9 @@ void MetalCodegen::visit(const CallExpr *expr) {
         case CallOp::MAKE_FLOAT2: _scratch << "float2"; break;
         case CallOp::MAKE_FLOAT3: _scratch << "float3"; break;
         case CallOp::MAKE_FLOAT4: _scratch << "float4"; break;
+        case CallOp::MAKE_HALF2: _scratch << "half2"; break;
+        case CallOp::MAKE_HALF3: _scratch << "half3"; break;
+        case CallOp::MAKE_HALF4: _scratch << "half4"; break;
         case CallOp::MAKE_FLOAT2X2: _scratch << "float2x2"; break;
         case CallOp::MAKE_FLOAT3X3: _scratch << "float3x3"; break;
         case CallOp::MAKE_FLOAT4X4: _scratch << "float4x4"; break;
@@ -616,6 +601,7 @@ void MetalCodegen::_emit_type_name(const Type *type) noexcept {
         case Type::Tag::FLOAT: _scratch << "float"; break;
         case Type::Tag::INT: _scratch << "int"; break;
         case Type::Tag::UINT: _scratch << "uint"; break;
+        case Type::Tag::HALF: _scratch << "half"; break;
         case Type::Tag::VECTOR:
             _emit_type_name(type->element());
             _scratch << type->dimension();
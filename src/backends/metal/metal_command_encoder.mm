@@ -249,34 +249,17 @@ void MetalCommandEncoder::visit(const ShaderDispatchCommand *command) noexcept {
 }
 
 MetalBufferView MetalCommandEncoder::_upload(const void *host_ptr, size_t size) noexcept {
-    auto rb = &_stream->upload_ring_buffer();
-    auto buffer = rb->allocate(size);
-    if (buffer.handle() == nullptr) {
-        auto options = MTLResourceStorageModeShared
-                       | MTLResourceCPUCacheModeWriteCombined
-                       | MTLResourceHazardTrackingModeUntracked;
-        auto handle = [_device->handle() newBufferWithBytes:host_ptr length:size options:options];
-        return {handle, 0u, size};
-    }
-    std::memcpy(static_cast<std::byte *>(buffer.handle().contents) + buffer.offset(), host_ptr, size);
-    [_command_buffer addCompletedHandler:^(id<MTLCommandBuffer>) { rb->recycle(buffer); }];
-    return buffer;
+    auto buffer = _stream->upload_ring().allocate(size);
+    std::memcpy(buffer.data(), host_ptr, size);
+    return MetalStream::buffer_view(buffer);
 }
 
 MetalBufferView MetalCommandEncoder::_download(void *host_ptr, size_t size) noexcept {
-    auto rb = &_stream->download_ring_buffer();
-    auto buffer = rb->allocate(size);
-    if (buffer.handle() == nullptr) {
-        auto options = MTLResourceStorageModeShared | MTLResourceHazardTrackingModeUntracked;
-        auto handle = [_device->handle() newBufferWithLength:size options:options];
-        [_command_buffer addCompletedHandler:^(id<MTLCommandBuffer>) { std::memcpy(host_ptr, handle.contents, size); }];
-        return {handle, 0u, size};
-    }
+    auto buffer = _stream->download_ring().allocate(size);
     [_command_buffer addCompletedHandler:^(id<MTLCommandBuffer>) {
-      std::memcpy(host_ptr, static_cast<const std::byte *>(buffer.handle().contents) + buffer.offset(), size);
-      rb->recycle(buffer);
+      std::memcpy(host_ptr, buffer.data(), size);
     }];
-    return buffer;
+    return MetalStream::buffer_view(buffer);
 }
 
 #ifdef LUISA_METAL_RAYTRACING_ENABLED
@@ -296,8 +279,7 @@ void MetalCommandEncoder::visit(const AccelBuildCommand *command) noexcept {
         _stream,
         _command_buffer, command->hint(),
         command->instance_mesh_handles(),
-        command->instance_transforms(),
-        _device->compacted_size_buffer_pool());
+        command->instance_transforms());
 }
 
 void MetalCommandEncoder::visit(const MeshUpdateCommand *command) noexcept {
@@ -313,8 +295,7 @@ void MetalCommandEncoder::visit(const MeshBuildCommand *command) noexcept {
         _stream,
         _command_buffer, command->hint(),
         v_buffer, command->vertex_buffer_offset(), command->vertex_stride(),
-        t_buffer, command->triangle_buffer_offset(), command->triangle_count(),
-        _device->compacted_size_buffer_pool());
+        t_buffer, command->triangle_buffer_offset(), command->triangle_count());
 }
 
 #else
@@ -17,11 +17,11 @@ MetalShader MetalCompiler::compile(Function kernel) noexcept {
 
     Clock clock;
 
-    Codegen::Scratch scratch;
-    MetalCodegen codegen{scratch};
+    auto scratch = Codegen::ScratchPool::acquire();
+    MetalCodegen codegen{*scratch};
     codegen.emit(kernel);
 
-    auto s = scratch.view();
+    auto s = scratch->view();
     auto hash = xxh3_hash64(s.data(), s.size());
     LUISA_VERBOSE(
         "Generated source (hash = 0x{:016x}) for kernel #{} in {} ms:\n\n{}",
@@ -19,7 +19,6 @@
 #import <backends/metal/metal_stream.h>
 #import <backends/metal/metal_compiler.h>
 #import <backends/metal/metal_heap.h>
-#import <backends/metal/metal_shared_buffer_pool.h>
 
 #ifdef LUISA_METAL_RAYTRACING_ENABLED
 #import <backends/metal/metal_mesh.h>
@@ -62,8 +61,6 @@ private:
     // for acceleration structures
     std::vector<std::unique_ptr<MetalAccel>> _accel_slots;
     std::vector<size_t> _available_accel_slots;
-
-    std::unique_ptr<MetalSharedBufferPool> _compacted_size_buffer_pool{nullptr};
 #endif
 
     // for events
@@ -102,8 +99,9 @@ public:
     [[nodiscard]] id<MTLTexture> texture(uint64_t handle) const noexcept;
     [[nodiscard]] MetalHeap *heap(uint64_t handle) const noexcept;
     [[nodiscard]] MetalShader compiled_kernel(uint64_t handle) const noexcept;
-    [[nodiscard]] MetalSharedBufferPool *compacted_size_buffer_pool() const noexcept;
+    std::string device_name() const noexcept override;
     void check_raytracing_supported() const noexcept;
+    [[nodiscard]] uint64_t _emplace_buffer(id<MTLBuffer> buffer) noexcept;
 
 public:
     uint64_t create_texture(PixelFormat format, uint dimension,
@@ -112,17 +110,22 @@ public:
     void destroy_texture(uint64_t handle) noexcept override;
     uint64_t create_buffer(size_t size_bytes, uint64_t heap_handle, uint32_t index_in_heap) noexcept override;
     void destroy_buffer(uint64_t handle) noexcept override;
+    MappedBufferAccess mapped_buffer_access() const noexcept override;
+    uint64_t create_mapped_buffer(size_t size_bytes) noexcept override;
+    void *mapped_buffer_address(uint64_t handle) noexcept override;
     uint64_t create_stream() noexcept override;
     void destroy_stream(uint64_t handle) noexcept override;
     void dispatch(uint64_t stream_handle, CommandList buffer) noexcept override;
     void synchronize_stream(uint64_t stream_handle) noexcept override;
     uint64_t create_shader(Function kernel) noexcept override;
     void destroy_shader(uint64_t handle) noexcept override;
+    uint32_t shader_max_block_threads(uint64_t handle) noexcept override;
     uint64_t create_event() noexcept override;
     void signal_event(uint64_t handle, uint64_t stream_handle) noexcept override;
     void wait_event(uint64_t handle, uint64_t stream_handle) noexcept override;
     void destroy_event(uint64_t handle) noexcept override;
     void synchronize_event(uint64_t handle) noexcept override;
+    bool query_event(uint64_t handle) noexcept override;
     uint64_t create_mesh() noexcept override;
     void destroy_mesh(uint64_t handle) noexcept override;
     uint64_t create_accel() noexcept override;
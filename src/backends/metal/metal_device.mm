@@ -41,23 +41,39 @@ uint64_t MetalDevice::create_buffer(size_t size_bytes, uint64_t heap_handle, uin
             size_bytes, clock.toc());
     }
 
-    auto buffer_handle = [&] {
-        auto h = 0ull;
-        std::scoped_lock lock{_buffer_mutex};
-        if (_available_buffer_slots.empty()) {
-            h = _buffer_slots.size();
-            _buffer_slots.emplace_back(buffer);
-        } else {
-            h = _available_buffer_slots.back();
-            _buffer_slots[h] = buffer;
-            _available_buffer_slots.pop_back();
-        }
-        return h;
-    }();
+    auto buffer_handle = _emplace_buffer(buffer);
     if (heap != nullptr) { heap->emplace_buffer(index_in_heap, buffer_handle); }
     return buffer_handle | (heap_handle << 32u);
 }
 
+uint64_t MetalDevice::_emplace_buffer(id<MTLBuffer> buffer) noexcept {
+    std::scoped_lock lock{_buffer_mutex};
+    if (_available_buffer_slots.empty()) {
+        auto h = _buffer_slots.size();
+        _buffer_slots.emplace_back(buffer);
+        return h;
+    }
+    auto h = _available_buffer_slots.back();
+    _buffer_slots[h] = buffer;
+    _available_buffer_slots.pop_back();
+    return h;
+}
+
+MappedBufferAccess MetalDevice::mapped_buffer_access() const noexcept {
+    return _handle.hasUnifiedMemory ? MappedBufferAccess::UNIFIED : MappedBufferAccess::REMOTE;
+}
+
+uint64_t MetalDevice::create_mapped_buffer(size_t size_bytes) noexcept {
+    auto buffer = [_handle newBufferWithLength:size_bytes
+                                       options:MTLResourceStorageModeShared];
+    LUISA_VERBOSE_WITH_LOCATION("Created mapped buffer with size {}.", size_bytes);
+    return _emplace_buffer(buffer) | (Heap::invalid_handle << 32u);
+}
+
+void *MetalDevice::mapped_buffer_address(uint64_t handle) noexcept {
+    return buffer(handle).contents;
+}
+
 void MetalDevice::destroy_buffer(uint64_t handle) noexcept {
     {
         auto buffer_handle = handle & 0xffffffffu;
@@ -125,10 +141,6 @@ MetalDevice::MetalDevice(const Context &ctx, uint32_t index) noexcept
 
     _compiler = std::make_unique<MetalCompiler>(this);
 
-#ifdef LUISA_METAL_RAYTRACING_ENABLED
-    _compacted_size_buffer_pool = std::make_unique<MetalSharedBufferPool>(_handle, sizeof(uint), 4096u / sizeof(uint), false);
-#endif
-
     static constexpr auto initial_buffer_count = 64u;
     _buffer_slots.resize(initial_buffer_count, nullptr);
     _available_buffer_slots.resize(initial_buffer_count);
@@ -193,6 +205,14 @@ MetalShader MetalDevice::compiled_kernel(uint64_t handle) const noexcept {
     return _shader_slots[handle];
 }
 
+std::string MetalDevice::device_name() const noexcept {
+    auto os_version = [[NSProcessInfo processInfo] operatingSystemVersionString];
+    return fmt::format(
+        "{} ({})",
+        [_handle.name cStringUsingEncoding:NSUTF8StringEncoding],
+        [os_version cStringUsingEncoding:NSUTF8StringEncoding]);
+}
+
 uint64_t MetalDevice::create_texture(
     PixelFormat format, uint dimension,
     uint width, uint height, uint depth,
@@ -342,6 +362,10 @@ void MetalDevice::synchronize_event(uint64_t handle) noexcept {
     event(handle)->synchronize();
 }
 
+bool MetalDevice::query_event(uint64_t handle) noexcept {
+    return event(handle)->query();
+}
+
 void MetalDevice::dispatch(uint64_t stream_handle, CommandList cmd_list) noexcept {
     @autoreleasepool {
         auto s = stream(stream_handle);
@@ -518,6 +542,10 @@ uint64_t MetalDevice::create_shader(Function kernel) noexcept {
     return s;
 }
 
+uint32_t MetalDevice::shader_max_block_threads(uint64_t handle) noexcept {
+    return static_cast<uint32_t>(compiled_kernel(handle).handle().maxTotalThreadsPerThreadgroup);
+}
+
 void MetalDevice::destroy_shader(uint64_t handle) noexcept {
     {
         std::scoped_lock lock{_shader_mutex};
@@ -539,10 +567,6 @@ MetalAccel *MetalDevice::accel(uint64_t handle) const noexcept {
     return _accel_slots[handle].get();
 }
 
-MetalSharedBufferPool *MetalDevice::compacted_size_buffer_pool() const noexcept {
-    return _compacted_size_buffer_pool.get();
-}
-
 #endif
 
 void MetalDevice::check_raytracing_supported() const noexcept {
@@ -52,6 +52,17 @@ public:
                 return cmd;
             }()) [[likely]] { [last waitUntilCompleted]; }
     }
+
+    [[nodiscard]] bool query() noexcept {
+        std::scoped_lock lock{_mutex};
+        if (auto last = _last; last != nullptr) {
+            auto status = [last status];
+            if (status != MTLCommandBufferStatusCompleted &&
+                status != MTLCommandBufferStatusError) { return false; }
+            _last = nullptr;
+        }
+        return true;
+    }
 };
 
 }// namespace luisa::compute::metal
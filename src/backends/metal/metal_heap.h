@@ -4,6 +4,7 @@
 
 #pragma once
 
+#import <algorithm>
 #import <unordered_set>
 #import <Metal/Metal.h>
 
@@ -30,11 +31,14 @@ private:
     mutable uint64_t _event_value{0u};
     mutable __weak id<MTLCommandBuffer> _last_update{nullptr};
     mutable spin_mutex _mutex;
-    mutable bool _dirty{true};
+    // slots changed since the last update, initially all to clear the private buffer
+    mutable uint32_t _dirty_begin{0u};
+    mutable uint32_t _dirty_end{Heap::slot_count};
     static constexpr auto slot_size = 32u;
 
 private:
     [[nodiscard]] static MTLHeapDescriptor *_heap_descriptor(size_t size) noexcept;
+    void _mark_dirty(uint32_t index) noexcept;
 
 public:
     MetalHeap(MetalDevice *device, size_t size) noexcept;
@@ -105,19 +105,23 @@ id<MTLCommandBuffer> MetalHeap::encode_update(
     id<MTLCommandBuffer> cmd_buf) const noexcept {
 
     std::scoped_lock lock{_mutex};
-    if (_dirty) {
+    // all updates since the last dispatch go in a single blit of the changed range
+    if (_dirty_begin != _dirty_end) {
         if (auto last = _last_update;
             last != nullptr) {
             [last waitUntilCompleted];
         }
         _last_update = cmd_buf;
-        _dirty = false;
+        auto offset = slot_size * _dirty_begin;
+        auto size = slot_size * (_dirty_end - _dirty_begin);
+        _dirty_begin = 0u;
+        _dirty_end = 0u;
         auto blit_encoder = [cmd_buf blitCommandEncoder];
         [blit_encoder copyFromBuffer:_buffer
-                        sourceOffset:0u
+                        sourceOffset:offset
                             toBuffer:_device_buffer
-                   destinationOffset:0u
-                                size:_buffer.length];
+                   destinationOffset:offset
+                                size:size];
         [blit_encoder endEncoding];
         [cmd_buf encodeSignalEvent:_event
                              value:++_event_value];
@@ -130,13 +134,23 @@ id<MTLCommandBuffer> MetalHeap::encode_update(
     return cmd_buf;
 }
 
+void MetalHeap::_mark_dirty(uint32_t index) noexcept {
+    if (_dirty_begin == _dirty_end) {
+        _dirty_begin = index;
+        _dirty_end = index + 1u;
+    } else {
+        _dirty_begin = std::min(_dirty_begin, index);
+        _dirty_end = std::max(_dirty_end, index + 1u);
+    }
+}
+
 void MetalHeap::emplace_buffer(uint32_t index, uint64_t buffer_handle) noexcept {
     auto buffer = _device->buffer(buffer_handle);
     std::scoped_lock lock{_mutex};
     [_encoder setArgumentBuffer:_buffer offset:slot_size * index];
     [_encoder setBuffer:buffer offset:0u atIndex:3u];
     _active_buffers.emplace(buffer_handle);
-    _dirty = true;
+    _mark_dirty(index);
 }
 
 void MetalHeap::emplace_texture(uint32_t index, uint64_t texture_handle, TextureSampler sampler) noexcept {
@@ -147,7 +161,7 @@ void MetalHeap::emplace_texture(uint32_t index, uint64_t texture_handle, Texture
     [_encoder setTexture:texture atIndex:texture.textureType == MTLTextureType2D ? 0u : 1u];
     [_encoder setSamplerState:sampler_state atIndex:2u];
     _active_textures.emplace(texture_handle);
-    _dirty = true;
+    _mark_dirty(index);
 }
 
 void MetalHeap::destroy_buffer(uint64_t b) noexcept {
@@ -10,7 +10,6 @@
 namespace luisa::compute::metal {
 
 class MetalStream;
-class MetalSharedBufferPool;
 
 class MetalMesh {
 
@@ -28,8 +27,7 @@ public:
         id<MTLCommandBuffer> command_buffer,
         AccelBuildHint hint,
         id<MTLBuffer> v_buffer, size_t v_offset, size_t v_stride,
-        id<MTLBuffer> t_buffer, size_t t_offset, size_t t_count,
-        MetalSharedBufferPool *pool) noexcept;
+        id<MTLBuffer> t_buffer, size_t t_offset, size_t t_count) noexcept;
     [[nodiscard]] id<MTLCommandBuffer> update(
         MetalStream *stream,
         id<MTLCommandBuffer> command_buffer);
@@ -4,7 +4,6 @@
 
 #import <backends/metal/metal_stream.h>
 #import <backends/metal/metal_mesh.h>
-#import <backends/metal/metal_shared_buffer_pool.h>
 
 namespace luisa::compute::metal {
 
@@ -13,8 +12,7 @@ id<MTLCommandBuffer> MetalMesh::build(
     id<MTLCommandBuffer> command_buffer,
     AccelBuildHint hint,
     id<MTLBuffer> v_buffer, size_t v_offset, size_t v_stride,
-    id<MTLBuffer> t_buffer, size_t t_offset, size_t t_count,
-    MetalSharedBufferPool *pool) noexcept {
+    id<MTLBuffer> t_buffer, size_t t_offset, size_t t_count) noexcept {
 
     auto mesh_desc = [MTLAccelerationStructureTriangleGeometryDescriptor descriptor];
     mesh_desc.vertexBuffer = v_buffer;
@@ -46,7 +44,7 @@ id<MTLCommandBuffer> MetalMesh::build(
                                   scratchBuffer:scratch_buffer
                             scratchBufferOffset:0u];
     if (hint != AccelBuildHint::FAST_REBUILD) {
-        auto compacted_size_buffer = pool->allocate();
+        auto compacted_size_buffer = MetalStream::buffer_view(stream->download_ring().allocate(sizeof(uint)));
         [command_encoder writeCompactedAccelerationStructureSize:_handle
                                                         toBuffer:compacted_size_buffer.handle()
                                                           offset:compacted_size_buffer.offset()];
@@ -57,7 +55,6 @@ id<MTLCommandBuffer> MetalMesh::build(
           *p_compacted_size = *reinterpret_cast<const uint *>(
               static_cast<const std::byte *>(compacted_size_buffer.handle().contents)
               + compacted_size_buffer.offset());
-          pool->recycle(compacted_size_buffer);
         }];
         stream->dispatch(command_buffer);
         [command_buffer waitUntilCompleted];
@@ -11,20 +11,21 @@
 
 #import <core/logging.h>
 #import <util/spin_mutex.h>
-#import <backends/metal/metal_ring_buffer.h>
+#import <runtime/staging_ring.h>
+#import <backends/metal/metal_buffer_view.h>
 
 namespace luisa::compute::metal {
 
 class MetalStream {
 
 public:
-    static constexpr auto ring_buffer_size = 32u * 1024u * 1024u;
+    static constexpr auto staging_ring_size = 32u * 1024u * 1024u;
 
 private:
     id<MTLCommandQueue> _handle;
     __weak id<MTLCommandBuffer> _last{nullptr};
-    MetalRingBuffer _upload_ring_buffer;
-    MetalRingBuffer _download_ring_buffer;
+    StagingRing _upload_ring;
+    StagingRing _download_ring;
     dispatch_semaphore_t _sem;
     spin_mutex _mutex;
 
@@ -34,8 +35,10 @@ public:
     [[nodiscard]] id<MTLCommandBuffer> command_buffer() noexcept;
     void dispatch(id<MTLCommandBuffer> command_buffer) noexcept;
     void synchronize() noexcept;
-    [[nodiscard]] auto &upload_ring_buffer() noexcept { return _upload_ring_buffer; }
-    [[nodiscard]] auto &download_ring_buffer() noexcept { return _download_ring_buffer; }
+    // staging memory, reclaimed once the command buffers dispatched after the allocations complete
+    [[nodiscard]] auto &upload_ring() noexcept { return _upload_ring; }
+    [[nodiscard]] auto &download_ring() noexcept { return _download_ring; }
+    [[nodiscard]] static MetalBufferView buffer_view(const StagingRing::Allocation &allocation) noexcept;
 };
 
 }// namespace luisa::compute::metal
@@ -6,12 +6,38 @@
 
 namespace luisa::compute::metal {
 
+namespace detail {
+
+[[nodiscard]] auto make_staging_ring(id<MTLDevice> device, size_t size, bool optimize_write) noexcept {
+    auto options = MTLResourceStorageModeShared | MTLResourceHazardTrackingModeUntracked;
+    if (optimize_write) { options |= MTLResourceCPUCacheModeWriteCombined; }
+    return StagingRing{
+        size,
+        [device, options](size_t size) noexcept {
+            id<MTLBuffer> buffer = [device newBufferWithLength:size options:options];
+            return StagingRing::Block{
+                static_cast<std::byte *>(buffer.contents),
+                reinterpret_cast<uint64_t>((__bridge_retained void *)buffer)};
+        },
+        [](StagingRing::Block block) noexcept {
+            id<MTLBuffer> buffer = (__bridge_transfer id<MTLBuffer>)reinterpret_cast<void *>(block.handle);
+            buffer = nullptr;
+        }};
+}
+
+}// namespace detail
+
 MetalStream::MetalStream(id<MTLDevice> device, uint max_command_buffers) noexcept
     : _handle{[device newCommandQueueWithMaxCommandBufferCount:max_command_buffers]},
-      _upload_ring_buffer{device, ring_buffer_size, true},
-      _download_ring_buffer{device, ring_buffer_size, false},
+      _upload_ring{detail::make_staging_ring(device, staging_ring_size, true)},
+      _download_ring{detail::make_staging_ring(device, staging_ring_size, false)},
       _sem{dispatch_semaphore_create(max_command_buffers)} {}
 
+MetalBufferView MetalStream::buffer_view(const StagingRing::Allocation &allocation) noexcept {
+    return {(__bridge id<MTLBuffer>)reinterpret_cast<void *>(allocation.block.handle),
+            allocation.offset, allocation.size};
+}
+
 MetalStream::~MetalStream() noexcept {
     synchronize();
     _handle = nullptr;
@@ -22,7 +48,12 @@ id<MTLCommandBuffer> MetalStream::command_buffer() noexcept {
 }
 
 void MetalStream::dispatch(id<MTLCommandBuffer> command_buffer) noexcept {
+    // after the handlers of the encoder, which read downloads from the staging memory
+    auto upload_fence = _upload_ring.fence();
+    auto download_fence = _download_ring.fence();
     [command_buffer addCompletedHandler:^(id<MTLCommandBuffer> cb) {
+      _upload_ring.reclaim(upload_fence);
+      _download_ring.reclaim(download_fence);
       LUISA_VERBOSE_WITH_LOCATION(
           "Command buffer completed in {} ms.",
           (cb.GPUEndTime - cb.GPUStartTime) * 1000.0f);
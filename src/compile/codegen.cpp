@@ -2,69 +2,61 @@
 // Created by Mike Smith on 2021/3/5.
 //
 
+#include <vector>
+#include <iterator>
+
 #include <ast/type_registry.h>
 #include <compile/codegen.h>
 
 namespace luisa::compute {
 
-Codegen::Scratch::Scratch() noexcept { _buffer.reserve(4096u - 1u); }
-std::string_view Codegen::Scratch::view() const noexcept { return _buffer; }
-
-namespace detail {
-
-template<typename T>
-[[nodiscard]] inline auto to_string(T x) noexcept {
-    static thread_local std::array<char, 128u> s;
-    auto [iter, size] = fmt::format_to_n(s.data(), s.size(), FMT_STRING("{}"), x);
-    if (iter != s.data() + size) [[unlikely]] {
-        LUISA_ERROR_WITH_LOCATION("No enough storage converting {} to string.", x);
-    }
-    return std::string_view{s.data(), size};
-}
-
-}// namespace detail
-
-Codegen::Scratch &Codegen::Scratch::operator<<(bool x) noexcept {
-    return *this << detail::to_string(x);
-}
+// generated kernels are seldom smaller than this
+Codegen::Scratch::Scratch() noexcept { _buffer.reserve(64_kb); }
 
 Codegen::Scratch &Codegen::Scratch::operator<<(float x) noexcept {
-    auto s = detail::to_string(x);
-    *this << s;
-    if (s.find('.') == std::string_view::npos && s.find('e') == std::string_view::npos) { *this << ".0"; }
+    auto offset = _buffer.size();
+    fmt::format_to(std::back_inserter(_buffer), FMT_STRING("{}"), x);
+    std::string_view s{_buffer.data() + offset, _buffer.size() - offset};
+    if (s.find_first_of(".e") == std::string_view::npos) { _append(".0"); }
     return *this;
 }
 
-Codegen::Scratch &Codegen::Scratch::operator<<(int x) noexcept {
-    return *this << detail::to_string(x);
+const char *Codegen::Scratch::c_str() const noexcept {
+    // terminate past the end without changing the size
+    _buffer.reserve(_buffer.size() + 1u);
+    _buffer.data()[_buffer.size()] = '\0';
+    return _buffer.data();
 }
 
-Codegen::Scratch &Codegen::Scratch::operator<<(uint x) noexcept {
-    return *this << detail::to_string(x);
-}
+namespace detail {
 
-Codegen::Scratch &Codegen::Scratch::operator<<(std::string_view s) noexcept {
-    _buffer.append(s);
-    return *this;
-}
+// keep a few scratches per thread; huge ones are dropped to bound idle memory
+static constexpr auto scratch_pool_capacity = 4u;
+static constexpr auto scratch_pool_max_size = 16_mb;
 
-Codegen::Scratch &Codegen::Scratch::operator<<(size_t x) noexcept {
-    return *this << detail::to_string(x);
+[[nodiscard]] static auto &scratch_pool() noexcept {
+    static thread_local std::vector<std::unique_ptr<Codegen::Scratch>> pool;
+    return pool;
 }
 
-Codegen::Scratch &Codegen::Scratch::operator<<(const char *s) noexcept {
-    return *this << std::string_view{s};
-}
+}// namespace detail
 
-Codegen::Scratch &Codegen::Scratch::operator<<(const std::string &s) noexcept {
-    return *this << std::string_view{s};
+Codegen::ScratchPool::Lease Codegen::ScratchPool::acquire() noexcept {
+    auto &&pool = detail::scratch_pool();
+    if (pool.empty()) { return Lease{std::make_unique<Scratch>()}; }
+    auto scratch = std::move(pool.back());
+    pool.pop_back();
+    return Lease{std::move(scratch)};
+}
+
+Codegen::ScratchPool::Lease::~Lease() noexcept {
+    if (_scratch == nullptr) { return; }
+    auto &&pool = detail::scratch_pool();
+    if (pool.size() < detail::scratch_pool_capacity &&
+        _scratch->size() <= detail::scratch_pool_max_size) {
+        _scratch->clear();
+        pool.emplace_back(std::move(_scratch));
+    }
 }
 
-void Codegen::Scratch::clear() noexcept { _buffer.clear(); }
-bool Codegen::Scratch::empty() const noexcept { return _buffer.empty(); }
-size_t Codegen::Scratch::size() const noexcept { return _buffer.size(); }
-void Codegen::Scratch::pop_back() noexcept { _buffer.pop_back(); }
-char Codegen::Scratch::back() const noexcept { return _buffer.back(); }
-const char *Codegen::Scratch::c_str() const noexcept { return _buffer.c_str(); }
-
 }// namespace luisa::compute
@@ -4,7 +4,12 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <core/concepts.h>
 #include <ast/function.h>
 
 namespace luisa::compute {
@@ -12,28 +17,71 @@ namespace luisa::compute {
 class Codegen {
 
 public:
+    // Output buffer of code generators. Text is appended to a contiguous
+    // fmt::memory_buffer, numbers are formatted in place without temporary
+    // strings, and the hot appends are inlined.
     class Scratch {
 
     private:
-        std::string _buffer;
+        mutable fmt::memory_buffer _buffer;
+
+    private:
+        Scratch &_append(std::string_view s) noexcept {
+            _buffer.append(s.data(), s.data() + s.size());
+            return *this;
+        }
 
     public:
         Scratch() noexcept;
-        Scratch &operator<<(bool x) noexcept;
+        Scratch &operator<<(bool x) noexcept { return _append(x ? "true" : "false"); }
         Scratch &operator<<(float x) noexcept;
-        Scratch &operator<<(int x) noexcept;
-        Scratch &operator<<(uint x) noexcept;
-        Scratch &operator<<(size_t x) noexcept;
-        Scratch &operator<<(std::string_view s) noexcept;
-        Scratch &operator<<(const char *s) noexcept;
-        Scratch &operator<<(const std::string &s) noexcept;
-        [[nodiscard]] std::string_view view() const noexcept;
+        Scratch &operator<<(int x) noexcept {
+            fmt::format_int s{x};
+            return _append({s.data(), s.size()});
+        }
+        Scratch &operator<<(uint x) noexcept {
+            fmt::format_int s{x};
+            return _append({s.data(), s.size()});
+        }
+        Scratch &operator<<(size_t x) noexcept {
+            fmt::format_int s{x};
+            return _append({s.data(), s.size()});
+        }
+        Scratch &operator<<(std::string_view s) noexcept { return _append(s); }
+        Scratch &operator<<(const char *s) noexcept { return _append(s); }
+        Scratch &operator<<(const std::string &s) noexcept { return _append(s); }
+        [[nodiscard]] std::string_view view() const noexcept { return {_buffer.data(), _buffer.size()}; }
         [[nodiscard]] const char *c_str() const noexcept;
-        [[nodiscard]] bool empty() const noexcept;
-        [[nodiscard]] size_t size() const noexcept;
-        void pop_back() noexcept;
-        void clear() noexcept;
-        [[nodiscard]] char back() const noexcept;
+        [[nodiscard]] bool empty() const noexcept { return _buffer.size() == 0u; }
+        [[nodiscard]] size_t size() const noexcept { return _buffer.size(); }
+        void pop_back() noexcept { _buffer.resize(_buffer.size() - 1u); }
+        void clear() noexcept { _buffer.clear(); }
+        [[nodiscard]] char back() const noexcept { return _buffer.data()[_buffer.size() - 1u]; }
+    };
+
+    // Scratch buffers recycled per thread, so that generating many kernels
+    // reuses the capacity grown by earlier ones instead of reallocating.
+    class ScratchPool {
+
+    public:
+        class Lease : concepts::Noncopyable {
+
+        private:
+            std::unique_ptr<Scratch> _scratch;
+
+        public:
+            explicit Lease(std::unique_ptr<Scratch> scratch) noexcept : _scratch{std::move(scratch)} {}
+            Lease(Lease &&) noexcept = default;
+            Lease &operator=(Lease &&) noexcept = default;
+            ~Lease() noexcept;
+            [[nodiscard]] Scratch &operator*() const noexcept { return *_scratch; }
+            [[nodiscard]] Scratch *operator->() const noexcept { return _scratch.get(); }
+        };
+
+    public:
+        // the returned scratch is empty and goes back to the
+        // pool of the releasing thread when the lease ends
+        [[nodiscard]] static Lease acquire() noexcept;
     };
 
 protected:
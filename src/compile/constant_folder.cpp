@@ -0,0 +1,260 @@
+//
+// Created by Mike Smith on 2021/8/21.
+//
+
+#include <cmath>
+#include <limits>
+
+#include <ast/type_registry.h>
+#include <compile/constant_folder.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+template<typename T, typename Tuple>
+struct is_one_of : std::false_type {};
+
+template<typename T, typename... U>
+struct is_one_of<T, std::tuple<U...>> : std::disjunction<std::is_same<T, U>...> {};
+
+template<typename T>
+constexpr auto is_literal_value_v = is_one_of<T, basic_types>::value;
+
+template<typename T>
+struct vector_element { using type = void; };
+
+template<typename T, size_t N>
+struct vector_element<Vector<T, N>> { using type = T; };
+
+template<typename T>
+using vector_element_t = typename vector_element<T>::type;
+
+template<typename T>
+[[nodiscard]] auto is_finite_value(T v) noexcept {
+    if constexpr (is_floating_point_v<T>) {
+        return std::isfinite(static_cast<float>(v));
+    } else if constexpr (is_vector_v<T>) {
+        for (auto i = 0u; i < T::dimension; i++) {
+            if (!is_finite_value(v[i])) { return false; }
+        }
+        return true;
+    } else {
+        return true;
+    }
+}
+
+template<typename T>
+[[nodiscard]] auto is_safe_divisor(T v) noexcept {
+    if constexpr (std::is_same_v<T, int> || std::is_same_v<T, uint>) {
+        return v != 0;
+    } else {
+        return true;
+    }
+}
+
+[[nodiscard]] std::optional<LiteralExpr::Value> make_literal(const Type *type, auto v) noexcept {
+    using R = std::remove_cvref_t<decltype(v)>;
+    if constexpr (is_literal_value_v<R>) {
+        if (*Type::of<R>() == *type && is_finite_value(v)) { return LiteralExpr::Value{v}; }
+    }
+    return std::nullopt;
+}
+
+}// namespace detail
+
+std::optional<LiteralExpr::Value> ConstantFolder::fold_unary(const Type *type, UnaryOp op, const LiteralExpr::Value &value) noexcept {
+    return std::visit(
+        [type, op](auto x) noexcept -> std::optional<LiteralExpr::Value> {
+            using T = decltype(x);
+            switch (op) {
+                case UnaryOp::PLUS:
+                    if constexpr (requires { +x; }) { return detail::make_literal(type, +x); }
+                    break;
+                case UnaryOp::MINUS:
+                    if constexpr (std::is_same_v<T, int>) {
+                        return detail::make_literal(type, static_cast<int>(0u - static_cast<uint>(x)));
+                    } else if constexpr (!std::is_same_v<T, bool> && requires { -x; }) {
+                        return detail::make_literal(type, -x);
+                    }
+                    break;
+                case UnaryOp::NOT:
+                    if constexpr (requires { !x; }) { return detail::make_literal(type, !x); }
+                    break;
+                case UnaryOp::BIT_NOT:
+                    if constexpr (is_integral_v<T>) { return detail::make_literal(type, static_cast<T>(~x)); }
+                    break;
+            }
+            return std::nullopt;
+        },
+        value);
+}
+
+std::optional<LiteralExpr::Value> ConstantFolder::fold_binary(const Type *type, BinaryOp op, const LiteralExpr::Value &lhs, const LiteralExpr::Value &rhs) noexcept {
+    if (lhs.index() != rhs.index()) { return std::nullopt; }
+    return std::visit(
+        [type, op, &rhs](auto a) noexcept -> std::optional<LiteralExpr::Value> {
+            using T = decltype(a);
+            auto b = std::get<T>(rhs);
+            // signed integers wrap on devices, so fold them in unsigned arithmetic
+            if constexpr (std::is_same_v<T, int>) {
+                auto ua = static_cast<uint>(a);
+                auto ub = static_cast<uint>(b);
+                switch (op) {
+                    case BinaryOp::ADD: return detail::make_literal(type, static_cast<int>(ua + ub));
+                    case BinaryOp::SUB: return detail::make_literal(type, static_cast<int>(ua - ub));
+                    case BinaryOp::MUL: return detail::make_literal(type, static_cast<int>(ua * ub));
+                    case BinaryOp::DIV:
+                    case BinaryOp::MOD:
+                        if (b == 0 || (a == std::numeric_limits<int>::min() && b == -1)) { return std::nullopt; }
+                        break;
+                    case BinaryOp::SHL:
+                    case BinaryOp::SHR:
+                        if (b < 0 || b >= 32) { return std::nullopt; }
+                        if (op == BinaryOp::SHL) { return detail::make_literal(type, static_cast<int>(ua << ub)); }
+                        break;
+                    default: break;
+                }
+            } else if constexpr (std::is_same_v<detail::vector_element_t<T>, int>) {
+                if (op == BinaryOp::ADD || op == BinaryOp::SUB || op == BinaryOp::MUL ||
+                    op == BinaryOp::DIV || op == BinaryOp::MOD || op == BinaryOp::SHL || op == BinaryOp::SHR) {
+                    return std::nullopt;
+                }
+            } else if constexpr (std::is_same_v<T, uint>) {
+                if ((op == BinaryOp::DIV || op == BinaryOp::MOD) && b == 0u) { return std::nullopt; }
+                if ((op == BinaryOp::SHL || op == BinaryOp::SHR) && b >= 32u) { return std::nullopt; }
+            } else if constexpr (std::is_same_v<detail::vector_element_t<T>, uint>) {
+                if (op == BinaryOp::DIV || op == BinaryOp::MOD || op == BinaryOp::SHL || op == BinaryOp::SHR) {
+                    return std::nullopt;
+                }
+            }
+            switch (op) {
+#define LUISA_OPTIMIZER_FOLD_BINARY(OP, op)                                    \
+    case BinaryOp::OP:                                                         \
+        if constexpr (requires { a op b; }) { return detail::make_literal(type, a op b); } \
+        break;
+                LUISA_OPTIMIZER_FOLD_BINARY(ADD, +)
+                LUISA_OPTIMIZER_FOLD_BINARY(SUB, -)
+                LUISA_OPTIMIZER_FOLD_BINARY(MUL, *)
+                LUISA_OPTIMIZER_FOLD_BINARY(BIT_AND, &)
+                LUISA_OPTIMIZER_FOLD_BINARY(BIT_OR, |)
+                LUISA_OPTIMIZER_FOLD_BINARY(BIT_XOR, ^)
+                LUISA_OPTIMIZER_FOLD_BINARY(SHL, <<)
+                LUISA_OPTIMIZER_FOLD_BINARY(SHR, >>)
+                LUISA_OPTIMIZER_FOLD_BINARY(AND, &&)
+                LUISA_OPTIMIZER_FOLD_BINARY(OR, ||)
+                LUISA_OPTIMIZER_FOLD_BINARY(LESS, <)
+                LUISA_OPTIMIZER_FOLD_BINARY(GREATER, >)
+                LUISA_OPTIMIZER_FOLD_BINARY(LESS_EQUAL, <=)
+                LUISA_OPTIMIZER_FOLD_BINARY(GREATER_EQUAL, >=)
+                LUISA_OPTIMIZER_FOLD_BINARY(EQUAL, ==)
+                LUISA_OPTIMIZER_FOLD_BINARY(NOT_EQUAL, !=)
+#undef LUISA_OPTIMIZER_FOLD_BINARY
+                case BinaryOp::DIV:
+                    if constexpr (requires { a / b; }) {
+                        if (detail::is_safe_divisor(b)) { return detail::make_literal(type, a / b); }
+                    }
+                    break;
+                case BinaryOp::MOD:
+                    if constexpr (is_integral_v<T>) {
+                        if (detail::is_safe_divisor(b)) { return detail::make_literal(type, a % b); }
+                    }
+                    break;
+            }
+            return std::nullopt;
+        },
+        lhs);
+}
+
+std::optional<LiteralExpr::Value> ConstantFolder::fold_cast(const Type *type, const LiteralExpr::Value &value) noexcept {
+    return std::visit(
+        [type](auto x) noexcept -> std::optional<LiteralExpr::Value> {
+            using T = decltype(x);
+            if constexpr (is_scalar_v<T>) {
+                auto as_float = static_cast<float>(x);
+                switch (type->tag()) {
+                    case Type::Tag::BOOL: return detail::make_literal(type, static_cast<float>(x) != 0.0f);
+                    case Type::Tag::FLOAT: return detail::make_literal(type, as_float);
+                    case Type::Tag::HALF: return detail::make_literal(type, half{as_float});
+                    case Type::Tag::INT:
+                        if constexpr (is_floating_point_v<T>) {
+                            if (!(as_float >= -2147483648.0f && as_float < 2147483648.0f)) { return std::nullopt; }
+                            return detail::make_literal(type, static_cast<int>(as_float));
+                        } else {
+                            return detail::make_literal(type, static_cast<int>(x));
+                        }
+                    case Type::Tag::UINT:
+                        if constexpr (is_floating_point_v<T>) {
+                            if (!(as_float >= 0.0f && as_float < 4294967296.0f)) { return std::nullopt; }
+                            return detail::make_literal(type, static_cast<uint>(as_float));
+                        } else {
+                            return detail::make_literal(type, static_cast<uint>(x));
+                        }
+                    default: break;
+                }
+            }
+            return std::nullopt;
+        },
+        value);
+}
+
+std::optional<LiteralExpr::Value> ConstantFolder::fold_access(const Type *type, ConstantData data, const LiteralExpr::Value &index) noexcept {
+    auto i = std::visit(
+        [](auto x) noexcept -> std::optional<size_t> {
+            using T = decltype(x);
+            if constexpr (std::is_same_v<T, int>) {
+                if (x >= 0) { return static_cast<size_t>(x); }
+            } else if constexpr (std::is_same_v<T, uint>) {
+                return static_cast<size_t>(x);
+            }
+            return std::nullopt;
+        },
+        index);
+    if (!i) { return std::nullopt; }
+    return std::visit(
+        [type, i = *i](auto view) noexcept -> std::optional<LiteralExpr::Value> {
+            if (i >= view.size()) { return std::nullopt; }
+            return detail::make_literal(type, view[i]);
+        },
+        data.view());
+}
+
+std::optional<LiteralExpr::Value> ConstantFolder::evaluate(
+    const Expression *expr, const std::unordered_map<uint32_t, LiteralExpr::Value> &values) noexcept {
+    switch (expr->tag()) {
+        case Expression::Tag::LITERAL:
+            return static_cast<const LiteralExpr *>(expr)->value();
+        case Expression::Tag::REF: {
+            auto uid = static_cast<const RefExpr *>(expr)->variable().uid();
+            if (auto iter = values.find(uid); iter != values.cend()) { return iter->second; }
+            return std::nullopt;
+        }
+        case Expression::Tag::UNARY: {
+            auto e = static_cast<const UnaryExpr *>(expr);
+            auto operand = evaluate(e->operand(), values);
+            return operand ? fold_unary(e->type(), e->op(), *operand) : std::nullopt;
+        }
+        case Expression::Tag::BINARY: {
+            auto e = static_cast<const BinaryExpr *>(expr);
+            auto lhs = evaluate(e->lhs(), values);
+            if (!lhs) { return std::nullopt; }
+            if (e->op() == BinaryOp::AND || e->op() == BinaryOp::OR) {
+                if (auto l = std::get_if<bool>(&*lhs); l != nullptr && *l == (e->op() == BinaryOp::OR)) {
+                    return lhs;
+                }
+            }
+            auto rhs = evaluate(e->rhs(), values);
+            return rhs ? fold_binary(e->type(), e->op(), *lhs, *rhs) : std::nullopt;
+        }
+        case Expression::Tag::CAST: {
+            auto e = static_cast<const CastExpr *>(expr);
+            if (e->op() != CastOp::STATIC) { return std::nullopt; }
+            auto value = evaluate(e->expression(), values);
+            return value ? fold_cast(e->type(), *value) : std::nullopt;
+        }
+        default: break;
+    }
+    return std::nullopt;
+}
+
+}// namespace luisa::compute
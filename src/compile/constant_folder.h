@@ -0,0 +1,34 @@
+//
+// Created by Mike Smith on 2021/8/21.
+//
+
+#pragma once
+
+#include <optional>
+#include <unordered_map>
+
+#include <ast/expression.h>
+
+namespace luisa::compute {
+
+// Evaluates operations over literal values the way the devices do, e.g.,
+// signed integers wrap around. Folding is refused (std::nullopt) whenever
+// the result is undefined, non-finite, or of a type other than the one
+// expected by the expression.
+class ConstantFolder {
+
+public:
+    [[nodiscard]] static std::optional<LiteralExpr::Value> fold_unary(
+        const Type *type, UnaryOp op, const LiteralExpr::Value &value) noexcept;
+    [[nodiscard]] static std::optional<LiteralExpr::Value> fold_binary(
+        const Type *type, BinaryOp op, const LiteralExpr::Value &lhs, const LiteralExpr::Value &rhs) noexcept;
+    [[nodiscard]] static std::optional<LiteralExpr::Value> fold_cast(
+        const Type *type, const LiteralExpr::Value &value) noexcept;
+    [[nodiscard]] static std::optional<LiteralExpr::Value> fold_access(
+        const Type *type, ConstantData data, const LiteralExpr::Value &index) noexcept;
+    // evaluates an expression tree with the given variables bound to literal values
+    [[nodiscard]] static std::optional<LiteralExpr::Value> evaluate(
+        const Expression *expr, const std::unordered_map<uint32_t, LiteralExpr::Value> &values) noexcept;
+};
+
+}// namespace luisa::compute
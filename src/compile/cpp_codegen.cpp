@@ -89,50 +89,28 @@ public:
     }
     void operator()(int v) const noexcept { _s << v; }
     void operator()(uint v) const noexcept { _s << v << "u"; }
+    void operator()(half v) const noexcept {
+        _s << "half(";
+        (*this)(static_cast<float>(v));
+        _s << ")";
+    }
 
     template<typename T, size_t N>
     void operator()(Vector<T, N> v) const noexcept {
-        auto t = Type::of<T>();
-        _s << t->description() << N << "(";
+        _s << Type::of<T>()->description() << N << "(";
         for (auto i = 0u; i < N; i++) {
+            if (i != 0u) { _s << ", "; }
             (*this)(v[i]);
-            _s << ", ";
-        }
-        _s.pop_back();
-        _s.pop_back();
-        _s << ")";
-    }
-
-    void operator()(float2x2 m) const noexcept {
-        _s << "float3x3(";
-        for (auto col = 0u; col < 2u; col++) {
-            for (auto row = 0u; row < 2u; row++) {
-                (*this)(m[col][row]);
-                _s << ", ";
-            }
-        }
-        _s.pop_back();
-        _s.pop_back();
-        _s << ")";
-    }
-
-    void operator()(float3x3 m) const noexcept {
-        _s << "float3x3(";
-        for (auto col = 0u; col < 3u; col++) {
-            for (auto row = 0u; row < 3u; row++) {
-                (*this)(m[col][row]);
-                _s << ", ";
-            }
         }
-        _s.pop_back();
-        _s.pop_back();
         _s << ")";
     }
 
-    void operator()(float4x4 m) const noexcept {
-        _s << "float4x4(";
-        for (auto col = 0u; col < 4u; col++) {
-            for (auto row = 0u; row < 4u; row++) {
+    template<size_t N>
+    void operator()(Matrix<N> m) const noexcept {
+        _s << "float" << N << "x" << N << "(";
+        for (auto col = 0u; col < N; col++) {
+            for (auto row = 0u; row < N; row++) {
+                if (col != 0u || row != 0u) { _s << ", "; }
                 (*this)(m[col][row]);
             }
         }
@@ -260,6 +238,7 @@ void CppCodegen::visit(const CallExpr *expr) {
             LUISA_METAL_CODEGEN_MAKE_VECTOR_CALL(int, INT)
             LUISA_METAL_CODEGEN_MAKE_VECTOR_CALL(uint, UINT)
             LUISA_METAL_CODEGEN_MAKE_VECTOR_CALL(float, FLOAT)
+            LUISA_METAL_CODEGEN_MAKE_VECTOR_CALL(half, HALF)
 #undef LUISA_METAL_CODEGEN_MAKE_VECTOR_CALL
         case CallOp::MAKE_FLOAT2X2: _scratch << "float2x2"; break;
         case CallOp::MAKE_FLOAT3X3: _scratch << "float3x3"; break;
@@ -268,13 +247,11 @@ void CppCodegen::visit(const CallExpr *expr) {
         case CallOp::TRACE_ANY: break;
     }
     _scratch << "(";
-    if (!expr->arguments().empty()) {
-        for (auto arg : expr->arguments()) {
-            arg->accept(*this);
-            _scratch << ", ";
-        }
-        _scratch.pop_back();
-        _scratch.pop_back();
+    auto first = true;
+    for (auto arg : expr->arguments()) {
+        if (!first) { _scratch << ", "; }
+        arg->accept(*this);
+        first = false;
     }
     _scratch << ")";
 }
@@ -323,13 +300,11 @@ void CppCodegen::visit(const ScopeStmt *stmt) {
 void CppCodegen::visit(const DeclareStmt *stmt) {
     _emit_variable_decl(stmt->variable());
     _scratch << "{";
-    if (!stmt->initializer().empty()) {
-        for (auto init : stmt->initializer()) {
-            init->accept(*this);
-            _scratch << ", ";
-        }
-        _scratch.pop_back();
-        _scratch.pop_back();
+    auto first = true;
+    for (auto init : stmt->initializer()) {
+        if (!first) { _scratch << ", "; }
+        init->accept(*this);
+        first = false;
     }
     _scratch << "};";
 }
@@ -408,9 +383,7 @@ void CppCodegen::emit(Function f) {
 
 void CppCodegen::_emit_function(Function f) noexcept {
 
-    if (auto iter = std::find(_generated_functions.cbegin(), _generated_functions.cend(), f);
-        iter != _generated_functions.cend()) { return; }
-    _generated_functions.emplace_back(f);
+    if (!_generated_functions.emplace(f.hash()).second) { return; }
 
     for (auto callable : f.custom_callables()) { _emit_function(callable); }
 
@@ -537,6 +510,7 @@ void CppCodegen::_emit_type_name(const Type *type) noexcept {
         case Type::Tag::FLOAT: _scratch << "float"; break;
         case Type::Tag::INT: _scratch << "int"; break;
         case Type::Tag::UINT: _scratch << "uint"; break;
+        case Type::Tag::HALF: _scratch << "half"; break;
         case Type::Tag::VECTOR:
             _emit_type_name(type->element());
             _scratch << type->dimension();
@@ -626,10 +600,7 @@ void CppCodegen::_emit_statements(std::span<const Statement *const> stmts) noexc
 
 void CppCodegen::_emit_constant(Function::ConstantBinding c) noexcept {
 
-    if (std::find(_generated_constants.cbegin(),
-                  _generated_constants.cend(), c.data.hash())
-        != _generated_constants.cend()) { return; }
-    _generated_constants.emplace_back(c.data.hash());
+    if (!_generated_constants.emplace(c.data.hash()).second) { return; }
 
     _scratch << "__constant__ ";
     _emit_type_name(c.type);
@@ -641,16 +612,12 @@ void CppCodegen::_emit_constant(Function::ConstantBinding c) noexcept {
         [count, this](auto ptr) {
             detail::LiteralPrinter print{_scratch};
             for (auto i = 0u; i < count; i++) {
+                if (i != 0u) { _scratch << ", "; }
                 if (count > wrap && i % wrap == 0u) { _scratch << "\n    "; }
                 print(ptr[i]);
-                _scratch << ", ";
             }
         },
         c.data.view());
-    if (count > 0u) {
-        _scratch.pop_back();
-        _scratch.pop_back();
-    }
     _scratch << "};\n";
 }
 
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <unordered_set>
+
 #include <ast/function.h>
 #include <ast/statement.h>
 #include <ast/expression.h>
@@ -11,15 +13,15 @@
 
 namespace luisa::compute {
 
-class CppCodegen : public Codegen, private TypeVisitor, private ExprVisitor, private StmtVisitor {
+class CppCodegen : public Codegen, protected TypeVisitor, protected ExprVisitor, protected StmtVisitor {
 
-private:
+protected:
     Function _function;
-    std::vector<Function> _generated_functions;
-    std::vector<uint64_t> _generated_constants;
+    std::unordered_set<uint64_t> _generated_functions;
+    std::unordered_set<uint64_t> _generated_constants;
     uint32_t _indent{0u};
 
-private:
+protected:
     void visit(const Type *type) noexcept override;
     void visit(const UnaryExpr *expr) override;
     void visit(const BinaryExpr *expr) override;
@@ -44,7 +46,7 @@ private:
     void visit(const ForStmt *stmt) override;
     void visit(const ConstantExpr *expr) override;
 
-private:
+protected:
     virtual void _emit_type_decl() noexcept;
     virtual void _emit_variable_decl(Variable v) noexcept;
     virtual void _emit_type_name(const Type *type) noexcept;
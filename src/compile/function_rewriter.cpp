@@ -0,0 +1,277 @@
+//
+// Created by Mike Smith on 2021/8/20.
+//
+
+#include <vector>
+
+#include <core/logging.h>
+#include <compile/function_rewriter.h>
+
+namespace luisa::compute {
+
+void FunctionRewriter::visit(const UnaryExpr *expr) {
+    _result = _builder->unary(expr->type(), expr->op(), _rewrite(expr->operand()));
+}
+
+void FunctionRewriter::visit(const BinaryExpr *expr) {
+    auto lhs = _rewrite(expr->lhs());
+    auto rhs = _rewrite(expr->rhs());
+    _result = _builder->binary(expr->type(), expr->op(), lhs, rhs);
+}
+
+void FunctionRewriter::visit(const MemberExpr *expr) {
+    auto self = _rewrite(expr->self());
+    if (expr->is_swizzle()) {
+        auto code = 0ull;
+        for (auto i = 0u; i < expr->swizzle_size(); i++) {
+            code |= static_cast<uint64_t>(expr->swizzle_index(i)) << (i * 4u);
+        }
+        _result = _builder->swizzle(expr->type(), self, expr->swizzle_size(), code);
+    } else {
+        _result = _builder->member(expr->type(), self, expr->member_index());
+    }
+}
+
+void FunctionRewriter::visit(const AccessExpr *expr) {
+    auto range = _rewrite(expr->range());
+    auto index = _rewrite(expr->index());
+    _result = _builder->access(expr->type(), range, index);
+}
+
+void FunctionRewriter::visit(const LiteralExpr *expr) {
+    _result = _builder->literal(expr->type(), expr->value());
+}
+
+void FunctionRewriter::visit(const RefExpr *expr) {
+    _result = _variable(expr->variable());
+}
+
+void FunctionRewriter::visit(const ConstantExpr *expr) {
+    auto hash = expr->data().hash();
+    if (auto iter = _constants.find(hash); iter != _constants.cend()) {
+        _result = iter->second;
+        return;
+    }
+    auto c = _builder->constant(expr->type(), expr->data());
+    _constants.emplace(hash, c);
+    _result = c;
+}
+
+void FunctionRewriter::visit(const CallExpr *expr) {
+    std::vector<const Expression *> args;
+    args.reserve(expr->arguments().size());
+    for (auto arg : expr->arguments()) { args.emplace_back(_rewrite(arg)); }
+    std::span<const Expression *const> arg_span{args};
+    _result = expr->is_builtin()
+                  ? _builder->call(expr->type(), expr->op(), arg_span)
+                  : _builder->call(expr->type(), expr->custom(), arg_span);
+}
+
+void FunctionRewriter::visit(const CastExpr *expr) {
+    _result = _builder->cast(expr->type(), expr->op(), _rewrite(expr->expression()));
+}
+
+void FunctionRewriter::visit(const BreakStmt *) { _builder->break_(); }
+void FunctionRewriter::visit(const ContinueStmt *) { _builder->continue_(); }
+
+void FunctionRewriter::visit(const ReturnStmt *stmt) {
+    if (auto expr = stmt->expression(); expr != nullptr) {
+        _builder->return_(_rewrite(expr));
+    } else {
+        _builder->return_();
+    }
+}
+
+void FunctionRewriter::visit(const ScopeStmt *stmt) {
+    _rewrite_statements(stmt->statements());
+}
+
+void FunctionRewriter::visit(const DeclareStmt *stmt) {
+    std::vector<const Expression *> init;
+    init.reserve(stmt->initializer().size());
+    for (auto i : stmt->initializer()) { init.emplace_back(_rewrite(i)); }
+    auto v = _builder->local(stmt->variable().type(), init);
+    _map_variable(stmt->variable(), v);
+}
+
+void FunctionRewriter::visit(const IfStmt *stmt) {
+    auto cond = _rewrite(stmt->condition());
+    auto true_branch = _rewrite_scope(stmt->true_branch());
+    auto false_branch = stmt->false_branch() == nullptr ? nullptr : _rewrite_scope(stmt->false_branch());
+    _builder->if_(cond, true_branch, false_branch);
+}
+
+void FunctionRewriter::visit(const WhileStmt *stmt) {
+    auto cond = _rewrite(stmt->condition());
+    _builder->while_(cond, _rewrite_scope(stmt->body()));
+}
+
+void FunctionRewriter::visit(const ExprStmt *stmt) {
+    auto expr = stmt->expression();
+    if (expr->tag() != Expression::Tag::CALL) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Only calls are allowed in expression statements.");
+    }
+    auto call = static_cast<const CallExpr *>(expr);
+    std::vector<const Expression *> args;
+    args.reserve(call->arguments().size());
+    for (auto arg : call->arguments()) { args.emplace_back(_rewrite(arg)); }
+    std::span<const Expression *const> arg_span{args};
+    if (call->is_builtin()) {
+        _builder->call(call->op(), arg_span);
+    } else {
+        _builder->call(call->custom(), arg_span);
+    }
+}
+
+void FunctionRewriter::visit(const SwitchStmt *stmt) {
+    auto expr = _rewrite(stmt->expression());
+    _builder->switch_(expr, _rewrite_scope(stmt->body()));
+}
+
+void FunctionRewriter::visit(const SwitchCaseStmt *stmt) {
+    auto expr = _rewrite(stmt->expression());
+    _builder->case_(expr, _rewrite_scope(stmt->body()));
+}
+
+void FunctionRewriter::visit(const SwitchDefaultStmt *stmt) {
+    _builder->default_(_rewrite_scope(stmt->body()));
+}
+
+void FunctionRewriter::visit(const AssignStmt *stmt) {
+    auto lhs = _rewrite(stmt->lhs());
+    auto rhs = _rewrite(stmt->rhs());
+    _builder->assign(stmt->op(), lhs, rhs);
+}
+
+void FunctionRewriter::visit(const ForStmt *stmt) {
+    // initialization and update are recorded into a detached scope,
+    // the same way the DSL builds range-for loops
+    auto header = _builder->scope();
+    auto init = [&]() noexcept -> const Statement * {
+        if (stmt->initialization() == nullptr) { return nullptr; }
+        _builder->with(header, [&] { _rewrite(stmt->initialization()); });
+        return header->statements().back();
+    }();
+    auto cond = stmt->condition() == nullptr ? nullptr : _rewrite(stmt->condition());
+    auto update = [&]() noexcept -> const Statement * {
+        if (stmt->update() == nullptr) { return nullptr; }
+        _builder->with(header, [&] { _rewrite(stmt->update()); });
+        return header->statements().back();
+    }();
+    _builder->for_(init, cond, update, _rewrite_scope(stmt->body()));
+}
+
+void FunctionRewriter::_rewrite_signature() noexcept {
+    auto f = _builder;
+    f->set_block_size(_function.block_size());
+    if (_function.force_inline()) { f->set_force_inline(true); }
+    for (auto v : _function.builtin_variables()) {
+        switch (v.tag()) {
+            case Variable::Tag::THREAD_ID: _map_variable(v, f->thread_id()); break;
+            case Variable::Tag::BLOCK_ID: _map_variable(v, f->block_id()); break;
+            case Variable::Tag::DISPATCH_ID: _map_variable(v, f->dispatch_id()); break;
+            case Variable::Tag::DISPATCH_SIZE: _map_variable(v, f->dispatch_size()); break;
+            default: LUISA_ERROR_WITH_LOCATION("Invalid builtin variable.");
+        }
+    }
+    for (auto v : _function.shared_variables()) { _map_variable(v, f->shared(v.type())); }
+    for (auto &&b : _function.captured_buffers()) { _map_variable(b.variable, f->buffer_binding(b.variable.type(), b.handle, b.offset_bytes)); }
+    for (auto &&b : _function.captured_textures()) { _map_variable(b.variable, f->texture_binding(b.variable.type(), b.handle)); }
+    for (auto &&b : _function.captured_heaps()) { _map_variable(b.variable, f->heap_binding(b.handle)); }
+    for (auto &&b : _function.captured_accels()) { _map_variable(b.variable, f->accel_binding(b.handle)); }
+    for (auto v : _function.arguments()) {
+        switch (v.tag()) {
+            case Variable::Tag::LOCAL: _map_variable(v, f->argument(v.type())); break;
+            case Variable::Tag::BUFFER: _map_variable(v, f->buffer(v.type())); break;
+            case Variable::Tag::TEXTURE: _map_variable(v, f->texture(v.type())); break;
+            case Variable::Tag::HEAP: _map_variable(v, f->heap()); break;
+            case Variable::Tag::ACCEL: _map_variable(v, f->accel()); break;
+            default: LUISA_ERROR_WITH_LOCATION("Invalid argument variable.");
+        }
+    }
+}
+
+const Expression *FunctionRewriter::_rewrite(const Expression *expr) noexcept {
+    _result = nullptr;
+    expr->accept(*this);
+    return _result;
+}
+
+void FunctionRewriter::_rewrite(const Statement *stmt) noexcept {
+    stmt->accept(*this);
+}
+
+void FunctionRewriter::_rewrite_statements(std::span<const Statement *const> stmts) noexcept {
+    for (auto s : stmts) { _rewrite(s); }
+}
+
+ScopeStmt *FunctionRewriter::_rewrite_scope(const ScopeStmt *scope) noexcept {
+    auto s = _builder->scope();
+    _builder->with(s, [&] { _rewrite_statements(scope->statements()); });
+    return s;
+}
+
+const Expression *FunctionRewriter::_variable(Variable v) const noexcept {
+    auto iter = _variables.find(v.uid());
+    if (iter == _variables.cend()) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Variable #{} referenced before declaration in function #{}.",
+            v.uid(), hash_to_string(_function.hash()));
+    }
+    return iter->second;
+}
+
+void FunctionRewriter::_rewrite_body(Function f) noexcept {
+    _function = f;
+    _builder = detail::FunctionBuilder::current();
+    _variables.clear();
+    _constants.clear();
+    _rewrite_signature();
+    _rewrite_statements(f.body()->statements());
+}
+
+const RefExpr *FunctionRewriter::root_reference(const Expression *lvalue) noexcept {
+    while (lvalue != nullptr) {
+        switch (lvalue->tag()) {
+            case Expression::Tag::REF: return static_cast<const RefExpr *>(lvalue);
+            case Expression::Tag::MEMBER: lvalue = static_cast<const MemberExpr *>(lvalue)->self(); break;
+            case Expression::Tag::ACCESS: lvalue = static_cast<const AccessExpr *>(lvalue)->range(); break;
+            default: return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const detail::FunctionBuilder> FunctionRewriter::rewrite_kernel(
+    std::shared_ptr<const detail::FunctionBuilder> kernel) noexcept {
+    auto f = kernel->function();
+    if (f.tag() != Function::Tag::KERNEL) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Function #{} is not a kernel.", hash_to_string(f.hash()));
+    }
+    return detail::FunctionBuilder::define_kernel_verbatim(
+        [this, f] { _rewrite_body(f); }, std::move(kernel));
+}
+
+std::shared_ptr<const detail::FunctionBuilder> FunctionRewriter::with_block_size(
+    std::shared_ptr<const detail::FunctionBuilder> kernel, uint3 block_size) noexcept {
+    auto f = kernel->function();
+    if (f.tag() != Function::Tag::KERNEL) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Function #{} is not a kernel.", hash_to_string(f.hash()));
+    }
+    FunctionRewriter rewriter;
+    return detail::FunctionBuilder::define_kernel_verbatim(
+        [&rewriter, f, block_size] {
+            rewriter._rewrite_body(f);
+            rewriter._builder->set_block_size(block_size);
+        },
+        std::move(kernel));
+}
+
+const detail::FunctionBuilder *FunctionRewriter::rewrite_callable(Function callable) noexcept {
+    if (callable.tag() != Function::Tag::CALLABLE) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Function #{} is not a callable.", hash_to_string(callable.hash()));
+    }
+    return detail::FunctionBuilder::define_callable([this, callable] { _rewrite_body(callable); });
+}
+
+}// namespace luisa::compute
@@ -0,0 +1,80 @@
+//
+// Created by Mike Smith on 2021/8/20.
+//
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include <ast/function.h>
+#include <ast/statement.h>
+#include <ast/expression.h>
+#include <ast/function_builder.h>
+
+namespace luisa::compute {
+
+// Rebuilds a function into a fresh FunctionBuilder, node by node. The default
+// visitors copy the AST verbatim; passes derive from this class and override
+// the visitors of the nodes they transform.
+class FunctionRewriter : protected ExprVisitor, protected StmtVisitor {
+
+protected:
+    Function _function;
+    detail::FunctionBuilder *_builder{nullptr};
+    std::unordered_map<uint32_t, const Expression *> _variables;
+    std::unordered_map<uint64_t, const ConstantExpr *> _constants;
+    const Expression *_result{nullptr};
+
+protected:
+    void visit(const UnaryExpr *expr) override;
+    void visit(const BinaryExpr *expr) override;
+    void visit(const MemberExpr *expr) override;
+    void visit(const AccessExpr *expr) override;
+    void visit(const LiteralExpr *expr) override;
+    void visit(const RefExpr *expr) override;
+    void visit(const ConstantExpr *expr) override;
+    void visit(const CallExpr *expr) override;
+    void visit(const CastExpr *expr) override;
+    void visit(const BreakStmt *stmt) override;
+    void visit(const ContinueStmt *stmt) override;
+    void visit(const ReturnStmt *stmt) override;
+    void visit(const ScopeStmt *stmt) override;
+    void visit(const DeclareStmt *stmt) override;
+    void visit(const IfStmt *stmt) override;
+    void visit(const WhileStmt *stmt) override;
+    void visit(const ExprStmt *stmt) override;
+    void visit(const SwitchStmt *stmt) override;
+    void visit(const SwitchCaseStmt *stmt) override;
+    void visit(const SwitchDefaultStmt *stmt) override;
+    void visit(const AssignStmt *stmt) override;
+    void visit(const ForStmt *stmt) override;
+
+protected:
+    // signature and bindings of the source function are reproduced in order
+    virtual void _rewrite_signature() noexcept;
+    [[nodiscard]] virtual const Expression *_rewrite(const Expression *expr) noexcept;
+    virtual void _rewrite(const Statement *stmt) noexcept;
+    virtual void _rewrite_statements(std::span<const Statement *const> stmts) noexcept;
+    [[nodiscard]] ScopeStmt *_rewrite_scope(const ScopeStmt *scope) noexcept;
+    [[nodiscard]] const Expression *_variable(Variable v) const noexcept;
+    void _map_variable(Variable v, const Expression *expr) noexcept { _variables[v.uid()] = expr; }
+    void _rewrite_body(Function f) noexcept;
+
+public:
+    virtual ~FunctionRewriter() noexcept = default;
+    // the variable an l-value expression (e.g., `v.x[i]`) is rooted at, if any
+    [[nodiscard]] static const RefExpr *root_reference(const Expression *lvalue) noexcept;
+    // the rewritten kernel keeps the source alive, as it may still refer to
+    // the callables allocated from the source kernel's arena
+    [[nodiscard]] std::shared_ptr<const detail::FunctionBuilder> rewrite_kernel(
+        std::shared_ptr<const detail::FunctionBuilder> kernel) noexcept;
+    // copies the kernel verbatim except for its block size, so that variants
+    // of a kernel shared with others can be compiled without modifying it
+    [[nodiscard]] static std::shared_ptr<const detail::FunctionBuilder> with_block_size(
+        std::shared_ptr<const detail::FunctionBuilder> kernel, uint3 block_size) noexcept;
+    // callables defined inside a kernel are allocated from the kernel's arena
+    [[nodiscard]] const detail::FunctionBuilder *rewrite_callable(Function callable) noexcept;
+};
+
+}// namespace luisa::compute
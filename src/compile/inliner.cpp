@@ -0,0 +1,210 @@
+//
+// Created by Mike Smith on 2021/8/21.
+//
+
+#include <core/logging.h>
+#include <compile/optimizer.h>
+#include <compile/inliner.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+class ReturnCounter final : public StmtVisitor {
+
+public:
+    size_t count{0u};
+    void visit(const BreakStmt *) override {}
+    void visit(const ContinueStmt *) override {}
+    void visit(const ReturnStmt *) override { count++; }
+    void visit(const ScopeStmt *stmt) override {
+        for (auto s : stmt->statements()) { s->accept(*this); }
+    }
+    void visit(const DeclareStmt *) override {}
+    void visit(const IfStmt *stmt) override {
+        stmt->true_branch()->accept(*this);
+        if (auto f = stmt->false_branch(); f != nullptr) { f->accept(*this); }
+    }
+    void visit(const WhileStmt *stmt) override { stmt->body()->accept(*this); }
+    void visit(const ExprStmt *) override {}
+    void visit(const SwitchStmt *stmt) override { stmt->body()->accept(*this); }
+    void visit(const SwitchCaseStmt *stmt) override { stmt->body()->accept(*this); }
+    void visit(const SwitchDefaultStmt *stmt) override { stmt->body()->accept(*this); }
+    void visit(const AssignStmt *) override {}
+    void visit(const ForStmt *stmt) override { stmt->body()->accept(*this); }
+};
+
+// values that can be referenced repeatedly without being copied into a local first
+[[nodiscard]] inline auto is_stable_value(const Expression *expr) noexcept {
+    if (expr->tag() == Expression::Tag::LITERAL) { return true; }
+    if (expr->tag() != Expression::Tag::REF) { return false; }
+    auto tag = static_cast<const RefExpr *>(expr)->variable().tag();
+    return tag != Variable::Tag::SHARED;
+}
+
+}// namespace detail
+
+Inliner::Config &Inliner::default_config() noexcept {
+    static Config config;
+    return config;
+}
+
+bool Inliner::is_inlinable(Function callee) noexcept {
+    if (callee.tag() != Function::Tag::CALLABLE ||
+        !callee.shared_variables().empty() ||
+        !callee.captured_buffers().empty() ||
+        !callee.captured_textures().empty() ||
+        !callee.captured_heaps().empty() ||
+        !callee.captured_accels().empty()) { return false; }
+    detail::ReturnCounter counter;
+    callee.body()->accept(counter);
+    auto body = callee.body()->statements();
+    auto trailing_return = !body.empty() && dynamic_cast<const ReturnStmt *>(body.back()) != nullptr;
+    return counter.count == (trailing_return ? 1u : 0u);
+}
+
+bool Inliner::_should_inline(const CallExpr *call) noexcept {
+    if (!_config.enabled || call->is_builtin() ||
+        _suppression != 0u || _depth >= _config.max_depth) { return false; }
+    auto callee = call->custom();
+    auto [iter, first] = _decisions.try_emplace(callee.builder(), false);
+    if (first) {
+        iter->second = is_inlinable(callee) &&
+                       (callee.force_inline() ||
+                        Optimizer::count_nodes(callee) <= _config.max_callee_nodes);
+    }
+    return iter->second;
+}
+
+std::vector<const Expression *> Inliner::_rewrite_arguments(const CallExpr *call) noexcept {
+    std::vector<const Expression *> args;
+    args.reserve(call->arguments().size());
+    for (auto arg : call->arguments()) { args.emplace_back(_rewrite(arg)); }
+    return args;
+}
+
+const Expression *Inliner::_inline(Function callee, std::span<const Expression *const> args) noexcept {
+    // the callee has its own variable uids, so it is rewritten with a fresh mapping
+    auto caller = std::exchange(_function, callee);
+    auto caller_variables = std::exchange(_variables, {});
+    for (auto v : callee.builtin_variables()) {
+        switch (v.tag()) {
+            case Variable::Tag::THREAD_ID: _map_variable(v, _builder->thread_id()); break;
+            case Variable::Tag::BLOCK_ID: _map_variable(v, _builder->block_id()); break;
+            case Variable::Tag::DISPATCH_ID: _map_variable(v, _builder->dispatch_id()); break;
+            case Variable::Tag::DISPATCH_SIZE: _map_variable(v, _builder->dispatch_size()); break;
+            default: LUISA_ERROR_WITH_LOCATION("Invalid builtin variable.");
+        }
+    }
+    // arguments are passed by value, so those written by the callee or
+    // bound to non-trivial expressions are copied into locals
+    for (auto i = 0u; i < args.size(); i++) {
+        auto v = callee.arguments()[i];
+        auto arg = args[i];
+        if (v.tag() == Variable::Tag::LOCAL &&
+            ((to_underlying(callee.variable_usage(v.uid())) & to_underlying(Usage::WRITE)) != 0u ||
+             !detail::is_stable_value(arg))) {
+            arg = _builder->local(v.type(), {arg});
+        }
+        _map_variable(v, arg);
+    }
+    _depth++;
+    auto body = callee.body()->statements();
+    auto ret = body.empty() ? nullptr : dynamic_cast<const ReturnStmt *>(body.back());
+    _rewrite_statements(ret == nullptr ? body : body.subspan(0u, body.size() - 1u));
+    const Expression *result = nullptr;
+    if (ret != nullptr && ret->expression() != nullptr) {
+        result = _rewrite(ret->expression());
+        if (!detail::is_stable_value(result)) {
+            result = _builder->local(callee.return_type(), {result});
+        }
+    }
+    _depth--;
+    _variables = std::move(caller_variables);
+    _function = caller;
+    _inlined_calls++;
+    return result;
+}
+
+void Inliner::visit(const BinaryExpr *expr) {
+    if (expr->op() != BinaryOp::AND && expr->op() != BinaryOp::OR) {
+        FunctionRewriter::visit(expr);
+        return;
+    }
+    // the right-hand side is conditionally evaluated
+    auto lhs = _rewrite(expr->lhs());
+    _suppression++;
+    auto rhs = _rewrite(expr->rhs());
+    _suppression--;
+    _result = _builder->binary(expr->type(), expr->op(), lhs, rhs);
+}
+
+void Inliner::visit(const CallExpr *expr) {
+    if (expr->type() != nullptr && _should_inline(expr)) {
+        auto args = _rewrite_arguments(expr);
+        _result = _inline(expr->custom(), args);
+        return;
+    }
+    FunctionRewriter::visit(expr);
+}
+
+void Inliner::visit(const WhileStmt *stmt) {
+    _suppression++;
+    auto cond = _rewrite(stmt->condition());
+    _suppression--;
+    _builder->while_(cond, _rewrite_scope(stmt->body()));
+}
+
+void Inliner::visit(const ExprStmt *stmt) {
+    if (auto expr = stmt->expression(); expr->tag() == Expression::Tag::CALL) {
+        if (auto call = static_cast<const CallExpr *>(expr); _should_inline(call)) {
+            auto args = _rewrite_arguments(call);
+            static_cast<void>(_inline(call->custom(), args));
+            return;
+        }
+    }
+    FunctionRewriter::visit(stmt);
+}
+
+void Inliner::visit(const ForStmt *stmt) {
+    _suppression++;
+    auto header = _builder->scope();
+    auto init = [&]() noexcept -> const Statement * {
+        if (stmt->initialization() == nullptr) { return nullptr; }
+        _builder->with(header, [&] { _rewrite(stmt->initialization()); });
+        return header->statements().back();
+    }();
+    auto cond = stmt->condition() == nullptr ? nullptr : _rewrite(stmt->condition());
+    auto update = [&]() noexcept -> const Statement * {
+        if (stmt->update() == nullptr) { return nullptr; }
+        _builder->with(header, [&] { _rewrite(stmt->update()); });
+        return header->statements().back();
+    }();
+    _suppression--;
+    _builder->for_(init, cond, update, _rewrite_scope(stmt->body()));
+}
+
+std::shared_ptr<const detail::FunctionBuilder> Inliner::inline_kernel(
+    std::shared_ptr<const detail::FunctionBuilder> kernel) noexcept {
+    if (!_config.enabled || kernel->custom_callables().empty()) { return kernel; }
+    _inlined_calls = 0u;
+    auto inlined = rewrite_kernel(kernel);
+    if (_inlined_calls == 0u) { return kernel; }
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Inlined {} call(s) into kernel #{}.",
+        _inlined_calls, hash_to_string(inlined->hash()));
+    return inlined;
+}
+
+const detail::FunctionBuilder *Inliner::inline_callable(const detail::FunctionBuilder *callable) noexcept {
+    if (!_config.enabled || callable->custom_callables().empty()) { return callable; }
+    _inlined_calls = 0u;
+    auto inlined = rewrite_callable(callable->function());
+    if (_inlined_calls == 0u) { return callable; }
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Inlined {} call(s) into callable #{}.",
+        _inlined_calls, hash_to_string(inlined->hash()));
+    return inlined;
+}
+
+}// namespace luisa::compute
@@ -0,0 +1,54 @@
+//
+// Created by Mike Smith on 2021/8/21.
+//
+
+#pragma once
+
+#include <compile/function_rewriter.h>
+
+namespace luisa::compute {
+
+// Expands calls to custom callables in place. A callable is inlined if it is
+// marked force-inline or small enough, and if its body can be spliced into
+// the caller, i.e., it captures no resources, declares no shared variables
+// and returns only at the end of its body. Calls in positions that are not
+// evaluated exactly once (loop conditions and headers, right-hand sides of
+// && and ||) are kept as calls.
+class Inliner final : public FunctionRewriter {
+
+public:
+    struct Config {
+        bool enabled{true};
+        size_t max_callee_nodes{64u};
+        uint max_depth{8u};
+    };
+
+private:
+    Config _config;
+    std::unordered_map<const detail::FunctionBuilder *, bool> _decisions;
+    size_t _inlined_calls{0u};
+    uint _depth{0u};
+    uint _suppression{0u};
+
+private:
+    void visit(const BinaryExpr *expr) override;
+    void visit(const CallExpr *expr) override;
+    void visit(const WhileStmt *stmt) override;
+    void visit(const ExprStmt *stmt) override;
+    void visit(const ForStmt *stmt) override;
+    [[nodiscard]] bool _should_inline(const CallExpr *call) noexcept;
+    [[nodiscard]] std::vector<const Expression *> _rewrite_arguments(const CallExpr *call) noexcept;
+    const Expression *_inline(Function callee, std::span<const Expression *const> args) noexcept;
+
+public:
+    explicit Inliner(Config config = default_config()) noexcept : _config{config} {}
+    [[nodiscard]] static bool is_inlinable(Function callee) noexcept;
+    // functions are returned as is when they call no custom callables
+    [[nodiscard]] std::shared_ptr<const detail::FunctionBuilder> inline_kernel(
+        std::shared_ptr<const detail::FunctionBuilder> kernel) noexcept;
+    [[nodiscard]] const detail::FunctionBuilder *inline_callable(const detail::FunctionBuilder *callable) noexcept;
+    [[nodiscard]] auto inlined_calls() const noexcept { return _inlined_calls; }
+    [[nodiscard]] static Config &default_config() noexcept;
+};
+
+}// namespace luisa::compute
@@ -0,0 +1,210 @@
+//
+// Created by Mike Smith on 2021/8/21.
+//
+
+#include <core/logging.h>
+#include <compile/constant_folder.h>
+#include <compile/optimizer.h>
+#include <compile/loop_unroller.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+// checks that a loop body neither writes the induction variable (except
+// for the ignored update statement) nor breaks out of or continues the loop
+class LoopBodyChecker final : public StmtVisitor {
+
+private:
+    uint32_t _variable;
+    const Statement *_ignored;
+    uint _loop_depth{0u};
+    uint _switch_depth{0u};
+
+public:
+    bool unrollable{true};
+    bool returns{false};
+
+public:
+    LoopBodyChecker(uint32_t variable, const Statement *ignored) noexcept
+        : _variable{variable}, _ignored{ignored} {}
+    void visit(const BreakStmt *) override {
+        if (_loop_depth == 0u && _switch_depth == 0u) { unrollable = false; }
+    }
+    void visit(const ContinueStmt *) override {
+        if (_loop_depth == 0u) { unrollable = false; }
+    }
+    void visit(const ReturnStmt *) override { returns = true; }
+    void visit(const ScopeStmt *stmt) override {
+        for (auto s : stmt->statements()) { s->accept(*this); }
+    }
+    void visit(const DeclareStmt *) override {}
+    void visit(const IfStmt *stmt) override {
+        stmt->true_branch()->accept(*this);
+        if (auto f = stmt->false_branch(); f != nullptr) { f->accept(*this); }
+    }
+    void visit(const WhileStmt *stmt) override {
+        _loop_depth++;
+        stmt->body()->accept(*this);
+        _loop_depth--;
+    }
+    void visit(const ExprStmt *) override {}
+    void visit(const SwitchStmt *stmt) override {
+        _switch_depth++;
+        stmt->body()->accept(*this);
+        _switch_depth--;
+    }
+    void visit(const SwitchCaseStmt *stmt) override { stmt->body()->accept(*this); }
+    void visit(const SwitchDefaultStmt *stmt) override { stmt->body()->accept(*this); }
+    void visit(const AssignStmt *stmt) override {
+        if (stmt == _ignored) { return; }
+        if (auto root = FunctionRewriter::root_reference(stmt->lhs());
+            root != nullptr && root->variable().uid() == _variable) {
+            unrollable = false;
+        }
+    }
+    void visit(const ForStmt *stmt) override {
+        if (auto init = stmt->initialization(); init != nullptr) { init->accept(*this); }
+        if (auto update = stmt->update(); update != nullptr) { update->accept(*this); }
+        _loop_depth++;
+        stmt->body()->accept(*this);
+        _loop_depth--;
+    }
+};
+
+[[nodiscard]] inline auto literal_initializer(const Statement *stmt) noexcept
+    -> std::optional<std::pair<Variable, LiteralExpr::Value>> {
+    if (auto decl = dynamic_cast<const DeclareStmt *>(stmt)) {
+        if (auto init = decl->initializer();
+            init.size() == 1u && init.front()->tag() == Expression::Tag::LITERAL) {
+            return std::make_pair(decl->variable(), static_cast<const LiteralExpr *>(init.front())->value());
+        }
+    } else if (auto assign = dynamic_cast<const AssignStmt *>(stmt)) {
+        if (assign->op() == AssignOp::ASSIGN &&
+            assign->lhs()->tag() == Expression::Tag::REF &&
+            assign->rhs()->tag() == Expression::Tag::LITERAL) {
+            return std::make_pair(static_cast<const RefExpr *>(assign->lhs())->variable(),
+                                  static_cast<const LiteralExpr *>(assign->rhs())->value());
+        }
+    }
+    return std::nullopt;
+}
+
+[[nodiscard]] inline auto is_update_of(const Statement *stmt, Variable v) noexcept -> const AssignStmt * {
+    auto assign = dynamic_cast<const AssignStmt *>(stmt);
+    if (assign == nullptr || assign->lhs()->tag() != Expression::Tag::REF ||
+        static_cast<const RefExpr *>(assign->lhs())->variable().uid() != v.uid()) { return nullptr; }
+    return assign;
+}
+
+}// namespace detail
+
+LoopUnroller::Config &LoopUnroller::default_config() noexcept {
+    static Config config;
+    return config;
+}
+
+std::optional<std::vector<LiteralExpr::Value>> LoopUnroller::_iterations(
+    const InductionVariable &iv, const Expression *condition, const ScopeStmt *body) const noexcept {
+
+    auto type = iv.variable.type();
+    if (iv.variable.tag() != Variable::Tag::LOCAL || condition == nullptr ||
+        (type->tag() != Type::Tag::INT && type->tag() != Type::Tag::UINT) ||
+        (iv.update->op() != AssignOp::ADD_ASSIGN && iv.update->op() != AssignOp::SUB_ASSIGN) ||
+        iv.update->rhs()->tag() != Expression::Tag::LITERAL) { return std::nullopt; }
+
+    detail::LoopBodyChecker checker{iv.variable.uid(), iv.update};
+    body->accept(checker);
+    // non-void functions may only have a single return statement
+    if (!checker.unrollable || (checker.returns && _function.return_type() != nullptr)) { return std::nullopt; }
+
+    auto op = iv.update->op() == AssignOp::ADD_ASSIGN ? BinaryOp::ADD : BinaryOp::SUB;
+    auto step = static_cast<const LiteralExpr *>(iv.update->rhs())->value();
+    auto body_nodes = std::max(Optimizer::count_nodes(body), static_cast<size_t>(1u));
+    std::unordered_map<uint32_t, LiteralExpr::Value> values;
+    std::vector<LiteralExpr::Value> iterations;
+    for (auto x = iv.initial;;) {
+        values.insert_or_assign(iv.variable.uid(), x);
+        auto c = ConstantFolder::evaluate(condition, values);
+        auto proceed = c ? std::get_if<bool>(&*c) : nullptr;
+        if (proceed == nullptr) { return std::nullopt; }
+        if (!*proceed) { break; }
+        if (iterations.size() >= _config.max_trip_count ||
+            (iterations.size() + 1u) * body_nodes > _config.max_unrolled_nodes) { return std::nullopt; }
+        iterations.emplace_back(x);
+        auto next = ConstantFolder::fold_binary(type, op, x, step);
+        if (!next) { return std::nullopt; }
+        x = *next;
+    }
+    return iterations;
+}
+
+void LoopUnroller::visit(const ForStmt *stmt) {
+    if (_config.enabled && stmt->initialization() != nullptr && stmt->update() != nullptr) {
+        if (auto init = detail::literal_initializer(stmt->initialization());
+            init && dynamic_cast<const DeclareStmt *>(stmt->initialization()) != nullptr) {
+            if (auto update = detail::is_update_of(stmt->update(), init->first)) {
+                if (auto iterations = _iterations({init->first, init->second, update}, stmt->condition(), stmt->body())) {
+                    // the induction variable is not written in the body, so
+                    // it is substituted with its value in each iteration
+                    for (auto &&x : *iterations) {
+                        _map_variable(init->first, _builder->literal(init->first.type(), x));
+                        _rewrite_statements(stmt->body()->statements());
+                    }
+                    _unrolled_loops++;
+                    return;
+                }
+            }
+        }
+    }
+    FunctionRewriter::visit(stmt);
+}
+
+bool LoopUnroller::_try_unroll_while(const Statement *prev, const WhileStmt *stmt) noexcept {
+    if (!_config.enabled) { return false; }
+    auto init = detail::literal_initializer(prev);
+    auto body = stmt->body()->statements();
+    if (!init || body.empty()) { return false; }
+    auto update = detail::is_update_of(body.back(), init->first);
+    if (update == nullptr) { return false; }
+    auto iterations = _iterations({init->first, init->second, update}, stmt->condition(), stmt->body());
+    if (!iterations) { return false; }
+    // the induction variable stays a variable and is still updated
+    // at the end of each copy of the body
+    for (auto i = 0u; i < iterations->size(); i++) { _rewrite_statements(body); }
+    _unrolled_loops++;
+    return true;
+}
+
+void LoopUnroller::_rewrite_statements(std::span<const Statement *const> stmts) noexcept {
+    for (auto i = 0u; i < stmts.size(); i++) {
+        if (auto w = dynamic_cast<const WhileStmt *>(stmts[i]);
+            w != nullptr && i != 0u && _try_unroll_while(stmts[i - 1u], w)) { continue; }
+        _rewrite(stmts[i]);
+    }
+}
+
+std::shared_ptr<const detail::FunctionBuilder> LoopUnroller::unroll_kernel(
+    std::shared_ptr<const detail::FunctionBuilder> kernel) noexcept {
+    if (!_config.enabled) { return kernel; }
+    _unrolled_loops = 0u;
+    auto unrolled = rewrite_kernel(kernel);
+    if (_unrolled_loops == 0u) { return kernel; }
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Unrolled {} loop(s) in kernel #{}.",
+        _unrolled_loops, hash_to_string(unrolled->hash()));
+    return unrolled;
+}
+
+const detail::FunctionBuilder *LoopUnroller::unroll_callable(const detail::FunctionBuilder *callable) noexcept {
+    if (!_config.enabled) { return callable; }
+    _unrolled_loops = 0u;
+    auto unrolled = rewrite_callable(callable->function());
+    if (_unrolled_loops == 0u) { return callable; }
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Unrolled {} loop(s) in callable #{}.",
+        _unrolled_loops, hash_to_string(unrolled->hash()));
+    return unrolled;
+}
+
+}// namespace luisa::compute
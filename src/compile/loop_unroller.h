@@ -0,0 +1,55 @@
+//
+// Created by Mike Smith on 2021/8/21.
+//
+
+#pragma once
+
+#include <optional>
+
+#include <compile/function_rewriter.h>
+
+namespace luisa::compute {
+
+// Fully unrolls loops whose trip counts are known from literals:
+//   - for loops with an integer induction variable initialized with a
+//     literal, stepped by a literal and not written in the body, in which
+//     case the variable is replaced by a literal in each iteration;
+//   - while loops immediately preceded by a literal initialization of an
+//     integer variable that is stepped by a literal at the end of the body.
+// Loops containing break/continue statements bound to themselves are kept.
+class LoopUnroller final : public FunctionRewriter {
+
+public:
+    struct Config {
+        bool enabled{true};
+        uint max_trip_count{16u};
+        size_t max_unrolled_nodes{1024u};
+    };
+
+    struct InductionVariable {
+        Variable variable;
+        LiteralExpr::Value initial;
+        const AssignStmt *update;
+    };
+
+private:
+    Config _config;
+    size_t _unrolled_loops{0u};
+
+private:
+    void visit(const ForStmt *stmt) override;
+    void _rewrite_statements(std::span<const Statement *const> stmts) noexcept override;
+    [[nodiscard]] std::optional<std::vector<LiteralExpr::Value>> _iterations(
+        const InductionVariable &iv, const Expression *condition, const ScopeStmt *body) const noexcept;
+    [[nodiscard]] bool _try_unroll_while(const Statement *prev, const WhileStmt *stmt) noexcept;
+
+public:
+    explicit LoopUnroller(Config config = default_config()) noexcept : _config{config} {}
+    [[nodiscard]] std::shared_ptr<const detail::FunctionBuilder> unroll_kernel(
+        std::shared_ptr<const detail::FunctionBuilder> kernel) noexcept;
+    [[nodiscard]] const detail::FunctionBuilder *unroll_callable(const detail::FunctionBuilder *callable) noexcept;
+    [[nodiscard]] auto unrolled_loops() const noexcept { return _unrolled_loops; }
+    [[nodiscard]] static Config &default_config() noexcept;
+};
+
+}// namespace luisa::compute
@@ -0,0 +1,741 @@
+//
+// Created by Mike Smith on 2021/8/20.
+//
+
+#include <optional>
+
+#include <core/hash.h>
+#include <core/logging.h>
+#include <compile/constant_folder.h>
+#include <compile/optimizer.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+[[nodiscard]] constexpr auto is_pure_builtin(CallOp op) noexcept {
+    return (op >= CallOp::ALL && op <= CallOp::INVERSE) ||
+           (op >= CallOp::MAKE_BOOL2 && op <= CallOp::MAKE_FLOAT4X4);
+}
+
+[[nodiscard]] constexpr auto is_memory_read_builtin(CallOp op) noexcept {
+    return op == CallOp::TEXTURE_READ ||
+           (op >= CallOp::TEXTURE_HEAP_SAMPLE2D && op <= CallOp::BUFFER_HEAP_READ);
+}
+
+[[nodiscard]] bool has_side_effects(const Expression *expr) noexcept {
+    switch (expr->tag()) {
+        case Expression::Tag::UNARY:
+            return has_side_effects(static_cast<const UnaryExpr *>(expr)->operand());
+        case Expression::Tag::BINARY: {
+            auto e = static_cast<const BinaryExpr *>(expr);
+            return has_side_effects(e->lhs()) || has_side_effects(e->rhs());
+        }
+        case Expression::Tag::MEMBER:
+            return has_side_effects(static_cast<const MemberExpr *>(expr)->self());
+        case Expression::Tag::ACCESS: {
+            auto e = static_cast<const AccessExpr *>(expr);
+            return has_side_effects(e->range()) || has_side_effects(e->index());
+        }
+        case Expression::Tag::LITERAL:
+        case Expression::Tag::REF:
+        case Expression::Tag::CONSTANT: return false;
+        case Expression::Tag::CALL: {
+            auto e = static_cast<const CallExpr *>(expr);
+            if (!is_pure_builtin(e->op()) && !is_memory_read_builtin(e->op())) { return true; }
+            return std::any_of(e->arguments().begin(), e->arguments().end(), has_side_effects);
+        }
+        case Expression::Tag::CAST:
+            return has_side_effects(static_cast<const CastExpr *>(expr)->expression());
+    }
+    return true;
+}
+
+// pure and not reading device memory, so it is safe to evaluate once and reuse
+[[nodiscard]] bool is_reusable(const Expression *expr) noexcept {
+    switch (expr->tag()) {
+        case Expression::Tag::UNARY:
+            return is_reusable(static_cast<const UnaryExpr *>(expr)->operand());
+        case Expression::Tag::BINARY: {
+            auto e = static_cast<const BinaryExpr *>(expr);
+            return is_reusable(e->lhs()) && is_reusable(e->rhs());
+        }
+        case Expression::Tag::MEMBER:
+            return is_reusable(static_cast<const MemberExpr *>(expr)->self());
+        case Expression::Tag::ACCESS: {
+            auto e = static_cast<const AccessExpr *>(expr);
+            return is_reusable(e->range()) && is_reusable(e->index());
+        }
+        case Expression::Tag::LITERAL:
+        case Expression::Tag::CONSTANT: return true;
+        case Expression::Tag::REF: {
+            auto tag = static_cast<const RefExpr *>(expr)->variable().tag();
+            return tag != Variable::Tag::BUFFER &&
+                   tag != Variable::Tag::TEXTURE &&
+                   tag != Variable::Tag::SHARED;
+        }
+        case Expression::Tag::CALL: {
+            auto e = static_cast<const CallExpr *>(expr);
+            return is_pure_builtin(e->op()) &&
+                   std::all_of(e->arguments().begin(), e->arguments().end(), is_reusable);
+        }
+        case Expression::Tag::CAST:
+            return is_reusable(static_cast<const CastExpr *>(expr)->expression());
+    }
+    return false;
+}
+
+[[nodiscard]] bool is_cse_candidate(const Expression *expr) noexcept {
+    auto tag = expr->tag();
+    return (tag == Expression::Tag::UNARY ||
+            tag == Expression::Tag::BINARY ||
+            tag == Expression::Tag::CALL ||
+            tag == Expression::Tag::CAST) &&
+           is_reusable(expr);
+}
+
+[[nodiscard]] uint64_t expr_hash(const Expression *expr, uint64_t seed = 0u) noexcept {
+    auto update = [&seed](auto x) noexcept { seed = xxh3_hash64(&x, sizeof(x), seed); };
+    update(to_underlying(expr->tag()));
+    update(expr->type() == nullptr ? 0ull : expr->type()->hash());
+    switch (expr->tag()) {
+        case Expression::Tag::UNARY: {
+            auto e = static_cast<const UnaryExpr *>(expr);
+            update(to_underlying(e->op()));
+            return expr_hash(e->operand(), seed);
+        }
+        case Expression::Tag::BINARY: {
+            auto e = static_cast<const BinaryExpr *>(expr);
+            update(to_underlying(e->op()));
+            return expr_hash(e->rhs(), expr_hash(e->lhs(), seed));
+        }
+        case Expression::Tag::MEMBER: {
+            auto e = static_cast<const MemberExpr *>(expr);
+            if (e->is_swizzle()) {
+                for (auto i = 0u; i < e->swizzle_size(); i++) { update(e->swizzle_index(i)); }
+            } else {
+                update(e->member_index() | (1ull << 63u));
+            }
+            return expr_hash(e->self(), seed);
+        }
+        case Expression::Tag::ACCESS: {
+            auto e = static_cast<const AccessExpr *>(expr);
+            return expr_hash(e->index(), expr_hash(e->range(), seed));
+        }
+        case Expression::Tag::LITERAL: {
+            auto e = static_cast<const LiteralExpr *>(expr);
+            update(e->value().index());
+            std::visit(
+                [&update](auto v) noexcept {
+                    if constexpr (is_scalar_v<decltype(v)>) {
+                        update(v);
+                    } else if constexpr (is_vector_v<decltype(v)>) {
+                        for (auto i = 0u; i < decltype(v)::dimension; i++) { update(v[i]); }
+                    } else {
+                        for (auto &&c : v.cols) {
+                            for (auto i = 0u; i < std::remove_cvref_t<decltype(c)>::dimension; i++) { update(c[i]); }
+                        }
+                    }
+                },
+                e->value());
+            return seed;
+        }
+        case Expression::Tag::REF:
+            update(static_cast<const RefExpr *>(expr)->variable().uid());
+            return seed;
+        case Expression::Tag::CONSTANT:
+            update(static_cast<const ConstantExpr *>(expr)->data().hash());
+            return seed;
+        case Expression::Tag::CALL: {
+            auto e = static_cast<const CallExpr *>(expr);
+            update(to_underlying(e->op()));
+            for (auto arg : e->arguments()) { seed = expr_hash(arg, seed); }
+            return seed;
+        }
+        case Expression::Tag::CAST: {
+            auto e = static_cast<const CastExpr *>(expr);
+            update(to_underlying(e->op()));
+            return expr_hash(e->expression(), seed);
+        }
+    }
+    return seed;
+}
+
+[[nodiscard]] bool expr_equal(const Expression *a, const Expression *b) noexcept {
+    if (a == b) { return true; }
+    if (a->tag() != b->tag() || a->type() != b->type()) { return false; }
+    switch (a->tag()) {
+        case Expression::Tag::UNARY: {
+            auto x = static_cast<const UnaryExpr *>(a);
+            auto y = static_cast<const UnaryExpr *>(b);
+            return x->op() == y->op() && expr_equal(x->operand(), y->operand());
+        }
+        case Expression::Tag::BINARY: {
+            auto x = static_cast<const BinaryExpr *>(a);
+            auto y = static_cast<const BinaryExpr *>(b);
+            return x->op() == y->op() && expr_equal(x->lhs(), y->lhs()) && expr_equal(x->rhs(), y->rhs());
+        }
+        case Expression::Tag::MEMBER: {
+            auto x = static_cast<const MemberExpr *>(a);
+            auto y = static_cast<const MemberExpr *>(b);
+            if (x->is_swizzle() != y->is_swizzle()) { return false; }
+            if (x->is_swizzle()) {
+                if (x->swizzle_size() != y->swizzle_size()) { return false; }
+                for (auto i = 0u; i < x->swizzle_size(); i++) {
+                    if (x->swizzle_index(i) != y->swizzle_index(i)) { return false; }
+                }
+            } else if (x->member_index() != y->member_index()) {
+                return false;
+            }
+            return expr_equal(x->self(), y->self());
+        }
+        case Expression::Tag::ACCESS: {
+            auto x = static_cast<const AccessExpr *>(a);
+            auto y = static_cast<const AccessExpr *>(b);
+            return expr_equal(x->range(), y->range()) && expr_equal(x->index(), y->index());
+        }
+        case Expression::Tag::LITERAL:
+            return expr_hash(a) == expr_hash(b);
+        case Expression::Tag::REF:
+            return static_cast<const RefExpr *>(a)->variable().uid() ==
+                   static_cast<const RefExpr *>(b)->variable().uid();
+        case Expression::Tag::CONSTANT:
+            return static_cast<const ConstantExpr *>(a)->data().hash() ==
+                   static_cast<const ConstantExpr *>(b)->data().hash();
+        case Expression::Tag::CALL: {
+            auto x = static_cast<const CallExpr *>(a);
+            auto y = static_cast<const CallExpr *>(b);
+            if (x->op() != y->op() || x->arguments().size() != y->arguments().size()) { return false; }
+            for (auto i = 0u; i < x->arguments().size(); i++) {
+                if (!expr_equal(x->arguments()[i], y->arguments()[i])) { return false; }
+            }
+            return true;
+        }
+        case Expression::Tag::CAST: {
+            auto x = static_cast<const CastExpr *>(a);
+            auto y = static_cast<const CastExpr *>(b);
+            return x->op() == y->op() && expr_equal(x->expression(), y->expression());
+        }
+    }
+    return false;
+}
+
+// records, for every statement that could be dropped, which local it defines
+// and which variables it reads
+class VariableUseCollector final : public ExprVisitor, public StmtVisitor {
+
+public:
+    struct Entry {
+        uint32_t defines;
+        bool pure;
+        std::vector<uint32_t> reads;
+    };
+    static constexpr auto no_variable = ~0u;
+
+private:
+    std::vector<uint32_t> *_reads{nullptr};
+    bool _in_loop_header{false};
+
+public:
+    std::vector<Entry> entries;
+    std::unordered_set<uint32_t> declared;
+    std::unordered_set<uint32_t> pinned;
+
+private:
+    void _collect(const Expression *expr) noexcept {
+        if (expr != nullptr) { expr->accept(*this); }
+    }
+    void _add(uint32_t defines, bool pure, std::initializer_list<const Expression *> reads) noexcept {
+        auto &&entry = entries.emplace_back(Entry{defines, pure, {}});
+        _reads = &entry.reads;
+        for (auto r : reads) { _collect(r); }
+        _reads = nullptr;
+        if (defines != no_variable && _in_loop_header) { pinned.emplace(defines); }
+    }
+
+public:
+    void visit(const UnaryExpr *expr) override { _collect(expr->operand()); }
+    void visit(const BinaryExpr *expr) override {
+        _collect(expr->lhs());
+        _collect(expr->rhs());
+    }
+    void visit(const MemberExpr *expr) override { _collect(expr->self()); }
+    void visit(const AccessExpr *expr) override {
+        _collect(expr->range());
+        _collect(expr->index());
+    }
+    void visit(const LiteralExpr *) override {}
+    void visit(const RefExpr *expr) override { _reads->emplace_back(expr->variable().uid()); }
+    void visit(const ConstantExpr *) override {}
+    void visit(const CallExpr *expr) override {
+        for (auto arg : expr->arguments()) { _collect(arg); }
+    }
+    void visit(const CastExpr *expr) override { _collect(expr->expression()); }
+
+    void visit(const BreakStmt *) override {}
+    void visit(const ContinueStmt *) override {}
+    void visit(const ReturnStmt *stmt) override { _add(no_variable, false, {stmt->expression()}); }
+    void visit(const ScopeStmt *stmt) override {
+        for (auto s : stmt->statements()) { s->accept(*this); }
+    }
+    void visit(const DeclareStmt *stmt) override {
+        auto pure = std::none_of(stmt->initializer().begin(), stmt->initializer().end(), has_side_effects);
+        auto &&entry = entries.emplace_back(Entry{stmt->variable().uid(), pure, {}});
+        _reads = &entry.reads;
+        for (auto i : stmt->initializer()) { _collect(i); }
+        _reads = nullptr;
+        if (_in_loop_header) {
+            pinned.emplace(stmt->variable().uid());
+        } else {
+            declared.emplace(stmt->variable().uid());
+        }
+    }
+    void visit(const IfStmt *stmt) override {
+        _add(no_variable, false, {stmt->condition()});
+        stmt->true_branch()->accept(*this);
+        if (auto f = stmt->false_branch(); f != nullptr) { f->accept(*this); }
+    }
+    void visit(const WhileStmt *stmt) override {
+        _add(no_variable, false, {stmt->condition()});
+        stmt->body()->accept(*this);
+    }
+    void visit(const ExprStmt *stmt) override { _add(no_variable, false, {stmt->expression()}); }
+    void visit(const SwitchStmt *stmt) override {
+        _add(no_variable, false, {stmt->expression()});
+        stmt->body()->accept(*this);
+    }
+    void visit(const SwitchCaseStmt *stmt) override {
+        _add(no_variable, false, {stmt->expression()});
+        stmt->body()->accept(*this);
+    }
+    void visit(const SwitchDefaultStmt *stmt) override { stmt->body()->accept(*this); }
+    void visit(const AssignStmt *stmt) override {
+        auto root = FunctionRewriter::root_reference(stmt->lhs());
+        auto defines = root != nullptr && root->variable().tag() == Variable::Tag::LOCAL
+                           ? root->variable().uid()
+                           : no_variable;
+        auto pure = !has_side_effects(stmt->lhs()) && !has_side_effects(stmt->rhs());
+        _add(defines, pure, {stmt->lhs(), stmt->rhs()});
+    }
+    void visit(const ForStmt *stmt) override {
+        _in_loop_header = true;
+        if (auto init = stmt->initialization(); init != nullptr) { init->accept(*this); }
+        if (auto update = stmt->update(); update != nullptr) { update->accept(*this); }
+        _in_loop_header = false;
+        _add(no_variable, false, {stmt->condition()});
+        stmt->body()->accept(*this);
+    }
+};
+
+class NodeCounter final : public ExprVisitor, public StmtVisitor {
+
+private:
+    void _count(const Expression *expr) noexcept {
+        if (expr != nullptr) {
+            count++;
+            expr->accept(*this);
+        }
+    }
+    void _count(const Statement *stmt) noexcept {
+        if (stmt != nullptr) {
+            count++;
+            stmt->accept(*this);
+        }
+    }
+
+public:
+    size_t count{0u};
+    void visit(const UnaryExpr *expr) override { _count(expr->operand()); }
+    void visit(const BinaryExpr *expr) override {
+        _count(expr->lhs());
+        _count(expr->rhs());
+    }
+    void visit(const MemberExpr *expr) override { _count(expr->self()); }
+    void visit(const AccessExpr *expr) override {
+        _count(expr->range());
+        _count(expr->index());
+    }
+    void visit(const LiteralExpr *) override {}
+    void visit(const RefExpr *) override {}
+    void visit(const ConstantExpr *) override {}
+    void visit(const CallExpr *expr) override {
+        for (auto arg : expr->arguments()) { _count(arg); }
+    }
+    void visit(const CastExpr *expr) override { _count(expr->expression()); }
+    void visit(const BreakStmt *) override {}
+    void visit(const ContinueStmt *) override {}
+    void visit(const ReturnStmt *stmt) override { _count(stmt->expression()); }
+    void visit(const ScopeStmt *stmt) override {
+        for (auto s : stmt->statements()) { _count(s); }
+    }
+    void visit(const DeclareStmt *stmt) override {
+        for (auto i : stmt->initializer()) { _count(i); }
+    }
+    void visit(const IfStmt *stmt) override {
+        _count(stmt->condition());
+        _count(stmt->true_branch());
+        _count(stmt->false_branch());
+    }
+    void visit(const WhileStmt *stmt) override {
+        _count(stmt->condition());
+        _count(stmt->body());
+    }
+    void visit(const ExprStmt *stmt) override { _count(stmt->expression()); }
+    void visit(const SwitchStmt *stmt) override {
+        _count(stmt->expression());
+        _count(stmt->body());
+    }
+    void visit(const SwitchCaseStmt *stmt) override {
+        _count(stmt->expression());
+        _count(stmt->body());
+    }
+    void visit(const SwitchDefaultStmt *stmt) override { _count(stmt->body()); }
+    void visit(const AssignStmt *stmt) override {
+        _count(stmt->lhs());
+        _count(stmt->rhs());
+    }
+    void visit(const ForStmt *stmt) override {
+        _count(stmt->initialization());
+        _count(stmt->condition());
+        _count(stmt->update());
+        _count(stmt->body());
+    }
+};
+
+[[nodiscard]] inline auto is_control_transfer(const Statement *stmt) noexcept {
+    return dynamic_cast<const ReturnStmt *>(stmt) != nullptr ||
+           dynamic_cast<const BreakStmt *>(stmt) != nullptr ||
+           dynamic_cast<const ContinueStmt *>(stmt) != nullptr;
+}
+
+// statements that may write variables or memory end the region in which
+// common subexpressions can be reused
+[[nodiscard]] inline auto ends_cse_epoch(const Statement *stmt) noexcept {
+    auto decl = dynamic_cast<const DeclareStmt *>(stmt);
+    return decl == nullptr ||
+           std::any_of(decl->initializer().begin(), decl->initializer().end(), has_side_effects);
+}
+
+[[nodiscard]] inline auto literal_bool(const Expression *expr) noexcept -> std::optional<bool> {
+    if (expr->tag() != Expression::Tag::LITERAL) { return std::nullopt; }
+    auto &&v = static_cast<const LiteralExpr *>(expr)->value();
+    if (auto p = std::get_if<bool>(&v)) { return *p; }
+    return std::nullopt;
+}
+
+}// namespace detail
+
+bool Optimizer::ExprKey::operator==(const Optimizer::ExprKey &rhs) const noexcept {
+    return hash == rhs.hash && detail::expr_equal(expr, rhs.expr);
+}
+
+Optimizer::Config &Optimizer::default_config() noexcept {
+    static Config config;
+    return config;
+}
+
+size_t Optimizer::count_nodes(Function f) noexcept {
+    return count_nodes(f.body());
+}
+
+size_t Optimizer::count_nodes(const Statement *stmt) noexcept {
+    detail::NodeCounter counter;
+    stmt->accept(counter);
+    return counter.count;
+}
+
+void Optimizer::visit(const UnaryExpr *expr) {
+    FunctionRewriter::visit(expr);
+    if (!_config.constant_folding) { return; }
+    auto e = static_cast<const UnaryExpr *>(_result);
+    if (e->operand()->tag() == Expression::Tag::LITERAL) {
+        auto operand = static_cast<const LiteralExpr *>(e->operand());
+        if (auto v = ConstantFolder::fold_unary(expr->type(), expr->op(), operand->value())) {
+            _result = _builder->literal(expr->type(), *v);
+            _statistics.folded_expressions++;
+        }
+    }
+}
+
+void Optimizer::visit(const BinaryExpr *expr) {
+    auto short_circuit = expr->op() == BinaryOp::AND || expr->op() == BinaryOp::OR;
+    auto lhs = _rewrite(expr->lhs());
+    if (short_circuit && _config.constant_folding && expr->type()->tag() == Type::Tag::BOOL) {
+        // the right-hand side is never evaluated if the left-hand side decides the result
+        if (auto l = detail::literal_bool(lhs)) {
+            _statistics.folded_expressions++;
+            if (*l == (expr->op() == BinaryOp::OR)) {
+                _result = lhs;
+            } else {
+                _result = _rewrite(expr->rhs());
+            }
+            return;
+        }
+    }
+    if (short_circuit) { _cse_suppression++; }
+    auto rhs = _rewrite(expr->rhs());
+    if (short_circuit) { _cse_suppression--; }
+    _result = _builder->binary(expr->type(), expr->op(), lhs, rhs);
+    if (_config.constant_folding &&
+        lhs->tag() == Expression::Tag::LITERAL &&
+        rhs->tag() == Expression::Tag::LITERAL) {
+        if (auto v = ConstantFolder::fold_binary(
+                expr->type(), expr->op(),
+                static_cast<const LiteralExpr *>(lhs)->value(),
+                static_cast<const LiteralExpr *>(rhs)->value())) {
+            _result = _builder->literal(expr->type(), *v);
+            _statistics.folded_expressions++;
+        }
+    }
+}
+
+void Optimizer::visit(const AccessExpr *expr) {
+    FunctionRewriter::visit(expr);
+    if (!_config.constant_folding) { return; }
+    auto e = static_cast<const AccessExpr *>(_result);
+    if (e->range()->tag() == Expression::Tag::CONSTANT &&
+        e->index()->tag() == Expression::Tag::LITERAL &&
+        expr->type()->is_scalar()) {
+        if (auto v = ConstantFolder::fold_access(
+                expr->type(),
+                static_cast<const ConstantExpr *>(e->range())->data(),
+                static_cast<const LiteralExpr *>(e->index())->value())) {
+            _result = _builder->literal(expr->type(), *v);
+            _statistics.folded_expressions++;
+        }
+    }
+}
+
+void Optimizer::visit(const CastExpr *expr) {
+    FunctionRewriter::visit(expr);
+    if (!_config.constant_folding || expr->op() != CastOp::STATIC) { return; }
+    auto e = static_cast<const CastExpr *>(_result);
+    if (e->expression()->tag() == Expression::Tag::LITERAL) {
+        if (auto v = ConstantFolder::fold_cast(expr->type(), static_cast<const LiteralExpr *>(e->expression())->value())) {
+            _result = _builder->literal(expr->type(), *v);
+            _statistics.folded_expressions++;
+        }
+    }
+}
+
+void Optimizer::visit(const DeclareStmt *stmt) {
+    if (_dead_variables.contains(stmt->variable().uid())) {
+        _statistics.eliminated_variables++;
+        return;
+    }
+    FunctionRewriter::visit(stmt);
+}
+
+void Optimizer::visit(const IfStmt *stmt) {
+    auto cond = _rewrite(stmt->condition());
+    if (_config.dead_code_elimination) {
+        if (auto c = detail::literal_bool(cond)) {
+            _statistics.eliminated_branches++;
+            if (*c) {
+                _rewrite_statements(stmt->true_branch()->statements());
+            } else if (auto f = stmt->false_branch(); f != nullptr) {
+                _rewrite_statements(f->statements());
+            }
+            return;
+        }
+    }
+    auto true_branch = _rewrite_scope(stmt->true_branch());
+    auto false_branch = stmt->false_branch() == nullptr ? nullptr : _rewrite_scope(stmt->false_branch());
+    _builder->if_(cond, true_branch, false_branch);
+}
+
+void Optimizer::visit(const WhileStmt *stmt) {
+    _cse_suppression++;
+    auto cond = _rewrite(stmt->condition());
+    _cse_suppression--;
+    if (_config.dead_code_elimination) {
+        if (auto c = detail::literal_bool(cond); c && !*c) {
+            _statistics.eliminated_branches++;
+            return;
+        }
+    }
+    _builder->while_(cond, _rewrite_scope(stmt->body()));
+}
+
+void Optimizer::visit(const AssignStmt *stmt) {
+    if (auto root = FunctionRewriter::root_reference(stmt->lhs());
+        root != nullptr && _dead_variables.contains(root->variable().uid())) {
+        return;
+    }
+    FunctionRewriter::visit(stmt);
+}
+
+void Optimizer::visit(const ForStmt *stmt) {
+    _cse_suppression++;
+    FunctionRewriter::visit(stmt);
+    _cse_suppression--;
+}
+
+const Expression *Optimizer::_rewrite(const Expression *expr) noexcept {
+    if (!_config.common_subexpression_elimination ||
+        _cse_suppression != 0u ||
+        _cse_frames.empty() ||
+        !detail::is_cse_candidate(expr)) {
+        return FunctionRewriter::_rewrite(expr);
+    }
+    ExprKey key{detail::expr_hash(expr), expr};
+    {
+        auto &&frame = _cse_frames.back();
+        if (auto iter = frame.counts.find(key); iter == frame.counts.cend() || iter->second < 2u) {
+            return FunctionRewriter::_rewrite(expr);
+        }
+        if (auto iter = frame.values.find(key); iter != frame.values.cend()) {
+            _statistics.eliminated_subexpressions++;
+            return iter->second;
+        }
+    }
+    auto value = FunctionRewriter::_rewrite(expr);
+    if (value->tag() == Expression::Tag::LITERAL) { return value; }
+    auto v = _builder->local(value->type(), {value});
+    _cse_frames.back().values.emplace(key, v);
+    return v;
+}
+
+void Optimizer::_count_subexpressions(CSEFrame &frame, const Expression *expr) const noexcept {
+    if (expr == nullptr) { return; }
+    if (detail::is_cse_candidate(expr)) { frame.counts[ExprKey{detail::expr_hash(expr), expr}]++; }
+    switch (expr->tag()) {
+        case Expression::Tag::UNARY:
+            _count_subexpressions(frame, static_cast<const UnaryExpr *>(expr)->operand());
+            break;
+        case Expression::Tag::BINARY: {
+            auto e = static_cast<const BinaryExpr *>(expr);
+            _count_subexpressions(frame, e->lhs());
+            if (e->op() != BinaryOp::AND && e->op() != BinaryOp::OR) {
+                _count_subexpressions(frame, e->rhs());
+            }
+            break;
+        }
+        case Expression::Tag::MEMBER:
+            _count_subexpressions(frame, static_cast<const MemberExpr *>(expr)->self());
+            break;
+        case Expression::Tag::ACCESS: {
+            auto e = static_cast<const AccessExpr *>(expr);
+            _count_subexpressions(frame, e->range());
+            _count_subexpressions(frame, e->index());
+            break;
+        }
+        case Expression::Tag::CALL:
+            for (auto arg : static_cast<const CallExpr *>(expr)->arguments()) {
+                _count_subexpressions(frame, arg);
+            }
+            break;
+        case Expression::Tag::CAST:
+            _count_subexpressions(frame, static_cast<const CastExpr *>(expr)->expression());
+            break;
+        default: break;
+    }
+}
+
+void Optimizer::_rewrite_statements(std::span<const Statement *const> stmts) noexcept {
+    if (!_config.common_subexpression_elimination) {
+        for (auto s : stmts) {
+            _rewrite(s);
+            if (_config.dead_code_elimination && detail::is_control_transfer(s)) { break; }
+        }
+        return;
+    }
+    // expressions may only be reused within runs of side-effect free
+    // declarations (plus the statement that ends the run), so occurrences
+    // are counted per run before rewriting it
+    auto begin = stmts.begin();
+    while (begin != stmts.end()) {
+        auto end = std::find_if(begin, stmts.end(), detail::ends_cse_epoch);
+        if (end != stmts.end()) { end++; }
+        auto &&frame = _cse_frames.emplace_back();
+        for (auto s : std::span{begin, end}) {
+            if (auto decl = dynamic_cast<const DeclareStmt *>(s)) {
+                for (auto i : decl->initializer()) { _count_subexpressions(frame, i); }
+            } else if (auto assign = dynamic_cast<const AssignStmt *>(s)) {
+                _count_subexpressions(frame, assign->rhs());
+            } else if (auto if_stmt = dynamic_cast<const IfStmt *>(s)) {
+                _count_subexpressions(frame, if_stmt->condition());
+            } else if (auto switch_stmt = dynamic_cast<const SwitchStmt *>(s)) {
+                _count_subexpressions(frame, switch_stmt->expression());
+            } else if (auto ret = dynamic_cast<const ReturnStmt *>(s)) {
+                _count_subexpressions(frame, ret->expression());
+            }
+        }
+        auto transferred = false;
+        for (auto s : std::span{begin, end}) {
+            _rewrite(s);
+            if (_config.dead_code_elimination && detail::is_control_transfer(s)) {
+                transferred = true;
+                break;
+            }
+        }
+        _cse_frames.pop_back();
+        if (transferred) { break; }
+        begin = end;
+    }
+}
+
+void Optimizer::_analyze_dead_variables(Function f) noexcept {
+    _dead_variables.clear();
+    if (!_config.dead_code_elimination) { return; }
+    detail::VariableUseCollector collector;
+    f.body()->accept(collector);
+    std::unordered_set<uint32_t> impure;
+    for (auto &&e : collector.entries) {
+        if (e.defines != detail::VariableUseCollector::no_variable && !e.pure) { impure.emplace(e.defines); }
+    }
+    std::unordered_map<uint32_t, size_t> read_counts;
+    for (auto changed = true; changed;) {
+        changed = false;
+        read_counts.clear();
+        for (auto &&e : collector.entries) {
+            if (_dead_variables.contains(e.defines)) { continue; }
+            for (auto r : e.reads) {
+                if (r != e.defines) { read_counts[r]++; }
+            }
+        }
+        for (auto v : collector.declared) {
+            if (!_dead_variables.contains(v) &&
+                !collector.pinned.contains(v) &&
+                !impure.contains(v) &&
+                !read_counts.contains(v)) {
+                _dead_variables.emplace(v);
+                changed = true;
+            }
+        }
+    }
+}
+
+void Optimizer::_finish(Function original, Function optimized) noexcept {
+    _statistics.nodes_before = count_nodes(original);
+    _statistics.nodes_after = count_nodes(optimized);
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Optimized {} #{}: removed {} of {} AST nodes "
+        "(folded = {}, cse = {}, dead variables = {}, dead branches = {}).",
+        optimized.tag() == Function::Tag::KERNEL ? "kernel" : "callable",
+        hash_to_string(optimized.hash()),
+        _statistics.removed_nodes(), _statistics.nodes_before,
+        _statistics.folded_expressions, _statistics.eliminated_subexpressions,
+        _statistics.eliminated_variables, _statistics.eliminated_branches);
+}
+
+std::shared_ptr<const detail::FunctionBuilder> Optimizer::optimize_kernel(
+    std::shared_ptr<const detail::FunctionBuilder> kernel) noexcept {
+    if (!enabled()) { return kernel; }
+    _statistics = {};
+    _analyze_dead_variables(kernel->function());
+    auto optimized = rewrite_kernel(kernel);
+    _finish(kernel->function(), optimized->function());
+    return optimized;
+}
+
+const detail::FunctionBuilder *Optimizer::optimize_callable(const detail::FunctionBuilder *callable) noexcept {
+    if (!enabled()) { return callable; }
+    _statistics = {};
+    _analyze_dead_variables(callable->function());
+    auto optimized = rewrite_callable(callable->function());
+    _finish(callable->function(), optimized->function());
+    return optimized;
+}
+
+}// namespace luisa::compute
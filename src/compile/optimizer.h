@@ -0,0 +1,102 @@
+//
+// Created by Mike Smith on 2021/8/20.
+//
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <compile/function_rewriter.h>
+
+namespace luisa::compute {
+
+// Optimization pipeline over function ASTs, run once before the
+// functions are handed to the backends for code generation:
+//   - constant folding over literals and indexed constant arrays;
+//   - common subexpression elimination by hash-consing pure expressions
+//     within straight-line runs of declarations;
+//   - dead code elimination of unread local variables, of branches with
+//     constant conditions and of statements after return/break/continue.
+class Optimizer final : public FunctionRewriter {
+
+public:
+    struct Config {
+        bool constant_folding{true};
+        bool common_subexpression_elimination{true};
+        bool dead_code_elimination{true};
+    };
+
+    struct Statistics {
+        size_t nodes_before{0u};
+        size_t nodes_after{0u};
+        size_t folded_expressions{0u};
+        size_t eliminated_subexpressions{0u};
+        size_t eliminated_variables{0u};
+        size_t eliminated_branches{0u};
+        [[nodiscard]] auto removed_nodes() const noexcept {
+            return nodes_before > nodes_after ? nodes_before - nodes_after : 0u;
+        }
+    };
+
+    struct ExprKey {
+        uint64_t hash;
+        const Expression *expr;
+        [[nodiscard]] bool operator==(const ExprKey &rhs) const noexcept;
+    };
+
+    struct ExprKeyHash {
+        [[nodiscard]] size_t operator()(const ExprKey &key) const noexcept { return key.hash; }
+    };
+
+private:
+    struct CSEFrame {
+        std::unordered_map<ExprKey, uint, ExprKeyHash> counts;
+        std::unordered_map<ExprKey, const Expression *, ExprKeyHash> values;
+    };
+
+private:
+    Config _config;
+    Statistics _statistics;
+    std::unordered_set<uint32_t> _dead_variables;
+    std::vector<CSEFrame> _cse_frames;
+    uint _cse_suppression{0u};
+
+private:
+    using FunctionRewriter::_rewrite;
+    void visit(const UnaryExpr *expr) override;
+    void visit(const BinaryExpr *expr) override;
+    void visit(const AccessExpr *expr) override;
+    void visit(const CastExpr *expr) override;
+    void visit(const DeclareStmt *stmt) override;
+    void visit(const IfStmt *stmt) override;
+    void visit(const WhileStmt *stmt) override;
+    void visit(const AssignStmt *stmt) override;
+    void visit(const ForStmt *stmt) override;
+    [[nodiscard]] const Expression *_rewrite(const Expression *expr) noexcept override;
+    void _rewrite_statements(std::span<const Statement *const> stmts) noexcept override;
+    void _analyze_dead_variables(Function f) noexcept;
+    void _count_subexpressions(CSEFrame &frame, const Expression *expr) const noexcept;
+    void _finish(Function original, Function optimized) noexcept;
+
+public:
+    explicit Optimizer(Config config = default_config()) noexcept : _config{config} {}
+    [[nodiscard]] auto enabled() const noexcept {
+        return _config.constant_folding ||
+               _config.common_subexpression_elimination ||
+               _config.dead_code_elimination;
+    }
+    // functions are returned as is when all passes are disabled
+    [[nodiscard]] std::shared_ptr<const detail::FunctionBuilder> optimize_kernel(
+        std::shared_ptr<const detail::FunctionBuilder> kernel) noexcept;
+    [[nodiscard]] const detail::FunctionBuilder *optimize_callable(const detail::FunctionBuilder *callable) noexcept;
+    [[nodiscard]] auto statistics() const noexcept { return _statistics; }
+
+    // global default configuration used by the DSL when defining functions
+    [[nodiscard]] static Config &default_config() noexcept;
+    [[nodiscard]] static size_t count_nodes(Function f) noexcept;
+    [[nodiscard]] static size_t count_nodes(const Statement *stmt) noexcept;
+};
+
+}// namespace luisa::compute
@@ -2,6 +2,7 @@
 // Created by Mike Smith on 2021/3/14.
 //
 
+#include <core/intrin.h>
 #include <core/basic_types.h>
 
 namespace luisa {
@@ -18,5 +19,74 @@ template struct Vector<int, 4>;
 template struct Vector<uint, 2>;
 template struct Vector<uint, 3>;
 template struct Vector<uint, 4>;
+template struct Vector<half, 2>;
+template struct Vector<half, 3>;
+template struct Vector<half, 4>;
+
+namespace detail {
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+
+#define LUISA_HALF_F16C_AVAILABLE
+#define LUISA_F16C_TARGET __attribute__((target("f16c")))
+
+[[nodiscard]] static bool f16c_supported() noexcept {
+    static auto supported = __builtin_cpu_supports("f16c") != 0;
+    return supported;
+}
+
+#elif defined(_M_X64) && defined(__AVX2__)
+
+#include <immintrin.h>
+#define LUISA_HALF_F16C_AVAILABLE
+#define LUISA_F16C_TARGET
+[[nodiscard]] static constexpr bool f16c_supported() noexcept { return true; }
+
+#endif
+
+#ifdef LUISA_HALF_F16C_AVAILABLE
+
+LUISA_F16C_TARGET static size_t half_to_float_f16c(const half *src, float *dst, size_t n) noexcept {
+    auto i = static_cast<size_t>(0u);
+    for (; i + 8u <= n; i += 8u) {
+        auto h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    return i;
+}
+
+LUISA_F16C_TARGET static size_t float_to_half_f16c(const float *src, half *dst, size_t n) noexcept {
+    auto i = static_cast<size_t>(0u);
+    for (; i + 8u <= n; i += 8u) {
+        auto f = _mm256_loadu_ps(src + i);
+        auto h = _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+    }
+    return i;
+}
+
+#undef LUISA_F16C_TARGET
+
+#endif
+
+}// namespace detail
+
+void half_to_float(const half *src, float *dst, size_t n) noexcept {
+    auto i = static_cast<size_t>(0u);
+#ifdef LUISA_HALF_F16C_AVAILABLE
+    if (detail::f16c_supported()) { i = detail::half_to_float_f16c(src, dst, n); }
+#endif
+    for (; i < n; i++) { dst[i] = static_cast<float>(src[i]); }
+}
+
+void float_to_half(const float *src, half *dst, size_t n) noexcept {
+    auto i = static_cast<size_t>(0u);
+#ifdef LUISA_HALF_F16C_AVAILABLE
+    if (detail::f16c_supported()) { i = detail::float_to_half_f16c(src, dst, n); }
+#endif
+    for (; i < n; i++) { dst[i] = half{src[i]}; }
+}
 
 }// namespace luisa
+
+#undef LUISA_HALF_F16C_AVAILABLE
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <bit>
 #include <cstdint>
 #include <cstddef>
 #include <tuple>
@@ -38,6 +39,110 @@ inline namespace size_literals {
 // scalars
 using uint = unsigned int;
 
+namespace detail {
+
+// IEEE 754 binary16 <-> binary32, round-to-nearest-even
+[[nodiscard]] constexpr uint16_t float_to_half_bits(float f) noexcept {
+    auto x = std::bit_cast<uint32_t>(f);
+    auto sign = static_cast<uint16_t>((x >> 16u) & 0x8000u);
+    auto abs = x & 0x7fffffffu;
+    if (abs >= 0x7f800000u) {// inf or nan
+        return sign | (abs > 0x7f800000u ? 0x7e00u : 0x7c00u);
+    }
+    if (abs >= 0x477ff000u) { return sign | 0x7c00u; }// overflow
+    if (abs < 0x38800000u) {                           // subnormal
+        if (abs <= 0x33000000u) { return sign; }
+        auto e = abs >> 23u;
+        auto m = (abs & 0x7fffffu) | 0x800000u;
+        auto shift = 126u - e;
+        auto r = m >> shift;
+        auto rem = m & ((1u << shift) - 1u);
+        auto halfway = 1u << (shift - 1u);
+        if (rem > halfway || (rem == halfway && (r & 1u))) { r++; }
+        return static_cast<uint16_t>(sign | r);
+    }
+    auto r = abs - 0x38000000u;// rebias exponent from 127 to 15
+    auto rem = r & 0x1fffu;
+    r >>= 13u;
+    if (rem > 0x1000u || (rem == 0x1000u && (r & 1u))) { r++; }
+    return static_cast<uint16_t>(sign | r);
+}
+
+[[nodiscard]] constexpr float half_bits_to_float(uint16_t h) noexcept {
+    auto sign = static_cast<uint32_t>(h & 0x8000u) << 16u;
+    auto e = (h >> 10u) & 0x1fu;
+    auto m = static_cast<uint32_t>(h & 0x3ffu);
+    if (e == 0x1fu) { return std::bit_cast<float>(sign | 0x7f800000u | (m << 13u)); }
+    if (e == 0u) {
+        auto v = static_cast<float>(m) * 0x1p-24f;
+        return sign == 0u ? v : -v;
+    }
+    return std::bit_cast<float>(sign | ((e + 112u) << 23u) | (m << 13u));
+}
+
+}// namespace detail
+
+struct half {
+
+private:
+    uint16_t _bits;
+
+public:
+    half() noexcept = default;
+    explicit constexpr half(float f) noexcept
+        : _bits{detail::float_to_half_bits(f)} {}
+    [[nodiscard]] static constexpr auto from_bits(uint16_t bits) noexcept {
+        half h;
+        h._bits = bits;
+        return h;
+    }
+    [[nodiscard]] constexpr auto bits() const noexcept { return _bits; }
+    // explicit, so that halves never silently decay to floats in arithmetic and overload resolution
+    [[nodiscard]] explicit constexpr operator float() const noexcept { return detail::half_bits_to_float(_bits); }
+
+    [[nodiscard]] constexpr auto operator+() const noexcept { return *this; }
+    [[nodiscard]] constexpr auto operator-() const noexcept { return from_bits(_bits ^ 0x8000u); }
+
+#define LUISA_MAKE_HALF_BINARY_AND_ASSIGNMENT_OPERATORS(op)                      \
+    [[nodiscard]] friend constexpr auto operator op(half lhs, half rhs) noexcept { \
+        return half{static_cast<float>(lhs) op static_cast<float>(rhs)};         \
+    }                                                                            \
+    constexpr half &operator op##=(half rhs) noexcept {                          \
+        return *this = *this op rhs;                                             \
+    }
+    LUISA_MAKE_HALF_BINARY_AND_ASSIGNMENT_OPERATORS(+)
+    LUISA_MAKE_HALF_BINARY_AND_ASSIGNMENT_OPERATORS(-)
+    LUISA_MAKE_HALF_BINARY_AND_ASSIGNMENT_OPERATORS(*)
+    LUISA_MAKE_HALF_BINARY_AND_ASSIGNMENT_OPERATORS(/)
+#undef LUISA_MAKE_HALF_BINARY_AND_ASSIGNMENT_OPERATORS
+
+#define LUISA_MAKE_HALF_COMPARISON_OPERATOR(op)                                    \
+    [[nodiscard]] friend constexpr bool operator op(half lhs, half rhs) noexcept { \
+        return static_cast<float>(lhs) op static_cast<float>(rhs);               \
+    }
+    LUISA_MAKE_HALF_COMPARISON_OPERATOR(==)
+    LUISA_MAKE_HALF_COMPARISON_OPERATOR(!=)
+    LUISA_MAKE_HALF_COMPARISON_OPERATOR(<)
+    LUISA_MAKE_HALF_COMPARISON_OPERATOR(<=)
+    LUISA_MAKE_HALF_COMPARISON_OPERATOR(>)
+    LUISA_MAKE_HALF_COMPARISON_OPERATOR(>=)
+#undef LUISA_MAKE_HALF_COMPARISON_OPERATOR
+};
+
+static_assert(sizeof(half) == 2u && alignof(half) == 2u);
+
+inline namespace half_literals {
+
+[[nodiscard]] constexpr auto operator""_h(long double v) noexcept {
+    return half{static_cast<float>(v)};
+}
+
+}// namespace half_literals
+
+// bulk conversions, accelerated with F16C on x86-64 when available
+void half_to_float(const half *src, float *dst, size_t n) noexcept;
+void float_to_half(const float *src, half *dst, size_t n) noexcept;
+
 template<typename T>
 using is_integral = std::disjunction<
     std::is_same<T, int>,
@@ -53,7 +158,9 @@ template<typename T>
 constexpr auto is_boolean_v = is_boolean<T>::value;
 
 template<typename T>
-using is_floating_point = std::is_same<T, float>;
+using is_floating_point = std::disjunction<
+    std::is_same<T, float>,
+    std::is_same<T, half>>;
 
 template<typename T>
 constexpr auto is_floating_point_v = is_floating_point<T>::value;
@@ -133,6 +240,7 @@ struct Vector : public detail::VectorStorage<T, N> {
     static_assert(std::disjunction_v<
                       std::is_same<T, bool>,
                       std::is_same<T, float>,
+                      std::is_same<T, half>,
                       std::is_same<T, int>,
                       std::is_same<T, uint>> && (N == 2 || N == 3 || N == 4),
                   "Invalid vector type");
@@ -266,6 +374,7 @@ LUISA_MAKE_VECTOR_TYPES(bool)
 LUISA_MAKE_VECTOR_TYPES(float)
 LUISA_MAKE_VECTOR_TYPES(int)
 LUISA_MAKE_VECTOR_TYPES(uint)
+LUISA_MAKE_VECTOR_TYPES(half)
 
 #undef LUISA_MAKE_VECTOR_TYPES
 
@@ -327,10 +436,10 @@ using float3x3 = Matrix<3>;
 using float4x4 = Matrix<4>;
 
 using basic_types = std::tuple<
-    bool, float, int, uint,
-    bool2, float2, int2, uint2,
-    bool3, float3, int3, uint3,
-    bool4, float4, int4, uint4,
+    bool, float, int, uint, half,
+    bool2, float2, int2, uint2, half2,
+    bool3, float3, int3, uint3, half3,
+    bool4, float4, int4, uint4, half4,
     float2x2, float3x3, float4x4>;
 
 [[nodiscard]] constexpr auto any(const bool2 v) noexcept { return v.x || v.y; }
@@ -362,14 +471,14 @@ template<typename T, size_t N, std::enable_if_t<std::negation_v<luisa::is_boolea
     }
 }
 
-template<typename T, size_t N>
+template<typename T, size_t N, std::enable_if_t<std::negation_v<std::is_same<T, luisa::half>>, int> = 0>
 [[nodiscard]] constexpr auto operator!(const luisa::Vector<T, N> v) noexcept {
     if constexpr (N == 2u) {
         return luisa::bool2{!v.x, !v.y};
     } else if constexpr (N == 3u) {
         return luisa::bool3{!v.x, !v.y, !v.z};
     } else {
-        return luisa::bool3{!v.x, !v.y, !v.z, !v.w};
+        return luisa::bool4{!v.x, !v.y, !v.z, !v.w};
     }
 }
 
@@ -577,6 +686,7 @@ LUISA_MAKE_TYPE_N(bool)
 LUISA_MAKE_TYPE_N(float)
 LUISA_MAKE_TYPE_N(int)
 LUISA_MAKE_TYPE_N(uint)
+LUISA_MAKE_TYPE_N(half)
 #undef LUISA_MAKE_TYPE_N
 
 // make float2x2
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 
 namespace luisa {
 
@@ -24,6 +25,11 @@ public:
         using namespace std::chrono_literals;
         return (curr - _last) / 1ns * 1e-6;
     }
+    // nanoseconds since the clock's epoch, comparable across threads
+    [[nodiscard]] static auto timestamp() noexcept {
+        using namespace std::chrono_literals;
+        return static_cast<uint64_t>(SystemClock::now().time_since_epoch() / 1ns);
+    }
 };
 
 }// namespace luisa
@@ -9,6 +9,7 @@
 #include <spdlog/fmt/fmt.h>
 #include <spdlog/spdlog.h>
 #include <core/platform.h>
+#include <core/trace.h>
 
 namespace luisa {
 
@@ -33,6 +34,9 @@ template<typename... Args>
             i, t.address, t.module, t.symbol, t.offset));
     }
     spdlog::error("{}", error_message);
+    if (auto events = trace_dump(); !events.empty()) {
+        spdlog::error("Recent trace events (most recent last):{}", events);
+    }
     std::abort();
 }
 
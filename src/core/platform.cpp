@@ -58,6 +58,115 @@ size_t pagesize() noexcept {
     return page_size;
 }
 
+uint32_t current_process_id() noexcept {
+    return static_cast<uint32_t>(GetCurrentProcessId());
+}
+
+size_t huge_page_size() noexcept {
+    static auto size = GetLargePageMinimum();
+    return size;
+}
+
+std::span<std::byte> allocate_pages(size_t size, PagePlacement placement) noexcept {
+    if (size == 0u) { return {}; }
+    auto allocate = [&placement](size_t size, DWORD flags) noexcept {
+        flags |= MEM_RESERVE | MEM_COMMIT;
+        return placement.numa_node >= 0
+                   ? VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, flags, PAGE_READWRITE,
+                                        static_cast<DWORD>(placement.numa_node))
+                   : VirtualAlloc(nullptr, size, flags, PAGE_READWRITE);
+    };
+    // large pages need the SeLockMemoryPrivilege, so fall back to small pages without it
+    if (auto large = huge_page_size(); (placement.huge_pages || placement.explicit_huge_pages) && large != 0u) {
+        auto large_size = (size + large - 1u) / large * large;
+        if (auto p = allocate(large_size, MEM_LARGE_PAGES); p != nullptr) {
+            return {static_cast<std::byte *>(p), large_size};
+        }
+        LUISA_VERBOSE_WITH_LOCATION(
+            "Failed to allocate {} bytes with large pages, reason: {}",
+            large_size, detail::win32_last_error_message());
+    }
+    auto page_size = pagesize();
+    size = (size + page_size - 1u) / page_size * page_size;
+    if (auto p = allocate(size, 0u); p != nullptr) {
+        return {static_cast<std::byte *>(p), size};
+    }
+    return {};
+}
+
+void free_pages(std::span<std::byte> pages) noexcept {
+    if (!pages.empty()) { VirtualFree(pages.data(), 0u, MEM_RELEASE); }
+}
+
+uint32_t numa_node_count() noexcept {
+    static auto count = [] {
+        ULONG highest = 0u;
+        return GetNumaHighestNodeNumber(&highest) ? static_cast<uint32_t>(highest + 1u) : 1u;
+    }();
+    return count;
+}
+
+std::vector<uint32_t> numa_node_processors(uint32_t node) noexcept {
+    std::vector<uint32_t> processors;
+    if (GROUP_AFFINITY affinity{}; GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity)) {
+        for (auto i = 0u; i < 64u; i++) {
+            if (affinity.Mask & (static_cast<KAFFINITY>(1u) << i)) {
+                processors.emplace_back(affinity.Group * 64u + i);
+            }
+        }
+    }
+    return processors;
+}
+
+uint32_t current_numa_node() noexcept {
+    PROCESSOR_NUMBER processor{};
+    GetCurrentProcessorNumberEx(&processor);
+    USHORT node = 0u;
+    return GetNumaProcessorNodeEx(&processor, &node) ? node : 0u;
+}
+
+bool bind_thread_to_numa_node(uint32_t node) noexcept {
+    GROUP_AFFINITY affinity{};
+    return GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) &&
+           SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+}
+
+std::span<const std::byte> memory_map_file(const std::filesystem::path &path) noexcept {
+    auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Failed to open file '{}' for mapping, reason: {}.",
+            path.string(), detail::win32_last_error_message());
+    }
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+    if (size.QuadPart == 0) [[unlikely]] {
+        CloseHandle(file);
+        LUISA_ERROR_WITH_LOCATION("Cannot map empty file '{}'.", path.string());
+    }
+    auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Failed to map file '{}', reason: {}.",
+            path.string(), detail::win32_last_error_message());
+    }
+    // the view keeps the mapping alive
+    auto address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (address == nullptr) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Failed to map view of file '{}', reason: {}.",
+            path.string(), detail::win32_last_error_message());
+    }
+    return {static_cast<const std::byte *>(address), static_cast<size_t>(size.QuadPart)};
+}
+
+void memory_unmap_file(std::span<const std::byte> mapping) noexcept {
+    if (!mapping.empty()) { UnmapViewOfFile(mapping.data()); }
+}
+
 void *dynamic_module_load(const std::filesystem::path &path) noexcept {
     if (!std::filesystem::exists(path)) [[unlikely]] {
         LUISA_ERROR_WITH_LOCATION("Dynamic module not found: {}.", path.string());
@@ -146,8 +255,19 @@ std::vector<TraceItem> backtrace() noexcept {
 
 #elif defined(LUISA_PLATFORM_UNIX)
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <thread>
+#include <fcntl.h>
 #include <unistd.h>
 #include <dlfcn.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
 #include <execinfo.h>
 #include <cxxabi.h>
 
@@ -161,6 +281,173 @@ size_t pagesize() noexcept {
     return page_size;
 }
 
+uint32_t current_process_id() noexcept {
+    return static_cast<uint32_t>(getpid());
+}
+
+namespace detail {
+
+// e.g., "0-3,8-11" from /sys/devices/system/node/node*/cpulist
+[[nodiscard]] std::vector<uint32_t> parse_cpu_list(std::string_view list) noexcept {
+    std::vector<uint32_t> cpus;
+    std::istringstream stream{std::string{list}};
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        uint32_t first = 0u;
+        uint32_t last = 0u;
+        if (auto n = std::sscanf(range.c_str(), "%u-%u", &first, &last); n == 1) {
+            cpus.emplace_back(first);
+        } else if (n == 2) {
+            for (auto i = first; i <= last; i++) { cpus.emplace_back(i); }
+        }
+    }
+    return cpus;
+}
+
+}// namespace detail
+
+size_t huge_page_size() noexcept {
+#ifdef __linux__
+    static auto size = [] {
+        std::ifstream meminfo{"/proc/meminfo"};
+        for (std::string line; std::getline(meminfo, line);) {
+            if (auto kb = 0ull; std::sscanf(line.c_str(), "Hugepagesize: %llu kB", &kb) == 1) {
+                return static_cast<size_t>(kb * 1024u);
+            }
+        }
+        return static_cast<size_t>(0u);
+    }();
+    return size;
+#else
+    return 0u;
+#endif
+}
+
+std::span<std::byte> allocate_pages(size_t size, PagePlacement placement) noexcept {
+    if (size == 0u) { return {}; }
+    auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    auto address = MAP_FAILED;
+#ifdef __linux__
+    if (auto huge = huge_page_size(); placement.explicit_huge_pages && huge != 0u) {
+        auto huge_size = (size + huge - 1u) / huge * huge;
+        address = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+        if (address != MAP_FAILED) {
+            size = huge_size;
+        } else {
+            LUISA_VERBOSE_WITH_LOCATION(
+                "Failed to allocate {} bytes from reserved huge pages, reason: {}.",
+                huge_size, strerror(errno));
+        }
+    }
+#endif
+    if (address == MAP_FAILED) {
+        auto page_size = pagesize();
+        size = (size + page_size - 1u) / page_size * page_size;
+        address = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (address == MAP_FAILED) [[unlikely]] { return {}; }
+#ifdef __linux__
+        if (placement.huge_pages || placement.explicit_huge_pages) { madvise(address, size, MADV_HUGEPAGE); }
+#endif
+    }
+#ifdef __linux__
+    // before the pages are touched; mbind() has no glibc wrapper without libnuma
+    if (placement.numa_node >= 0 && static_cast<uint32_t>(placement.numa_node) < numa_node_count() && numa_node_count() > 1u) {
+        constexpr auto mpol_preferred = 1;
+        constexpr auto bits = sizeof(unsigned long) * 8u;
+        std::vector<unsigned long> mask(numa_node_count() / bits + 1u, 0ul);
+        mask[placement.numa_node / bits] |= 1ul << (placement.numa_node % bits);
+        if (syscall(SYS_mbind, address, size, mpol_preferred, mask.data(), mask.size() * bits, 0u) != 0) {
+            LUISA_VERBOSE_WITH_LOCATION(
+                "Failed to bind {} bytes to NUMA node {}, reason: {}.",
+                size, placement.numa_node, strerror(errno));
+        }
+    }
+#endif
+    return {static_cast<std::byte *>(address), size};
+}
+
+void free_pages(std::span<std::byte> pages) noexcept {
+    if (!pages.empty()) { munmap(pages.data(), pages.size()); }
+}
+
+uint32_t numa_node_count() noexcept {
+#ifdef __linux__
+    static auto count = [] {
+        auto n = 0u;
+        while (std::filesystem::exists(fmt::format("/sys/devices/system/node/node{}", n))) { n++; }
+        return std::max(n, 1u);
+    }();
+    return count;
+#else
+    return 1u;
+#endif
+}
+
+std::vector<uint32_t> numa_node_processors(uint32_t node) noexcept {
+#ifdef __linux__
+    if (std::ifstream file{fmt::format("/sys/devices/system/node/node{}/cpulist", node)}; file.is_open()) {
+        std::string list;
+        std::getline(file, list);
+        return detail::parse_cpu_list(list);
+    }
+#endif
+    std::vector<uint32_t> processors;
+    if (node == 0u) {
+        processors.resize(std::max(std::thread::hardware_concurrency(), 1u));
+        std::iota(processors.begin(), processors.end(), 0u);
+    }
+    return processors;
+}
+
+uint32_t current_numa_node() noexcept {
+#ifdef __linux__
+    auto cpu = 0u;
+    auto node = 0u;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) { return node; }
+#endif
+    return 0u;
+}
+
+bool bind_thread_to_numa_node(uint32_t node) noexcept {
+#ifdef __linux__
+    auto processors = numa_node_processors(node);
+    if (processors.empty()) { return false; }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (auto p : processors) { CPU_SET(p, &cpus); }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+    return false;
+#endif
+}
+
+std::span<const std::byte> memory_map_file(const std::filesystem::path &path) noexcept {
+    auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Failed to open file '{}' for mapping, reason: {}.",
+            path.string(), strerror(errno));
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) [[unlikely]] {
+        close(fd);
+        LUISA_ERROR_WITH_LOCATION("Cannot map empty or unreadable file '{}'.", path.string());
+    }
+    auto size = static_cast<size_t>(info.st_size);
+    auto address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);// the mapping keeps the file alive
+    if (address == MAP_FAILED) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Failed to map file '{}', reason: {}.",
+            path.string(), strerror(errno));
+    }
+    return {static_cast<const std::byte *>(address), size};
+}
+
+void memory_unmap_file(std::span<const std::byte> mapping) noexcept {
+    if (!mapping.empty()) { munmap(const_cast<std::byte *>(mapping.data()), mapping.size()); }
+}
+
 void *dynamic_module_load(const std::filesystem::path &path) noexcept {
     if (!std::filesystem::exists(path)) [[unlikely]] {
         LUISA_ERROR_WITH_LOCATION("Dynamic module not found: {}.", path.string());
@@ -20,6 +20,9 @@
 #define LUISA_PLATFORM_UNIX
 #endif
 
+#include <span>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <string_view>
@@ -30,6 +33,31 @@ namespace luisa {
 [[nodiscard]] void *aligned_alloc(size_t alignment, size_t size) noexcept;
 void aligned_free(void *p) noexcept;
 [[nodiscard]] size_t pagesize() noexcept;
+[[nodiscard]] uint32_t current_process_id() noexcept;
+
+// placement of page allocations, see allocate_pages()
+struct PagePlacement {
+    bool huge_pages{false};         // transparent huge pages (large pages on Windows) where available
+    bool explicit_huge_pages{false};// reserved huge pages (MAP_HUGETLB) on Linux, else as huge_pages
+    int numa_node{-1};              // preferred NUMA node, or -1 for the default policy (first touch)
+};
+
+// zero-filled whole pages for large host allocations, an empty span on failure; huge pages and
+// NUMA placement are best effort, so the request is never failed just for them
+[[nodiscard]] std::span<std::byte> allocate_pages(size_t size, PagePlacement placement = {}) noexcept;
+void free_pages(std::span<std::byte> pages) noexcept;
+[[nodiscard]] size_t huge_page_size() noexcept;// 0 if not supported
+
+// NUMA topology, a single node with all processors where not supported
+[[nodiscard]] uint32_t numa_node_count() noexcept;
+[[nodiscard]] std::vector<uint32_t> numa_node_processors(uint32_t node) noexcept;
+[[nodiscard]] uint32_t current_numa_node() noexcept;
+// restricts the calling thread to the processors of the node, returns false on failure
+bool bind_thread_to_numa_node(uint32_t node) noexcept;
+
+// read-only mappings of whole files
+[[nodiscard]] std::span<const std::byte> memory_map_file(const std::filesystem::path &path) noexcept;
+void memory_unmap_file(std::span<const std::byte> mapping) noexcept;
 
 [[nodiscard]] std::string_view dynamic_module_prefix() noexcept;
 [[nodiscard]] std::string_view dynamic_module_extension() noexcept;
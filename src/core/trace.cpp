@@ -0,0 +1,123 @@
+//
+// Created by Mike Smith on 2021/9/10.
+//
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <core/trace.h>
+
+namespace luisa {
+
+namespace detail {
+
+// Single-producer ring owned by one thread at a time. Each slot carries the
+// sequence number of the event in it, so that dumping from another thread
+// can detect and skip slots being overwritten (seqlock style).
+struct alignas(64) TraceRing {
+
+    static constexpr auto capacity = 1024u;
+    static constexpr auto writing = ~0ull;
+
+    struct Slot {
+        std::atomic<uint64_t> sequence{writing};
+        TraceEvent event{};
+    };
+
+    std::array<Slot, capacity> slots;
+    std::atomic<uint64_t> head{0u};
+    std::atomic<uint32_t> thread_index{0u};
+    std::atomic<bool> in_use{false};
+};
+
+class TraceRegistry {
+
+private:
+    std::mutex _mutex;
+    std::vector<std::unique_ptr<TraceRing>> _rings;
+    uint32_t _thread_count{0u};
+
+public:
+    // rings are never freed, so a dump from a crashing thread never sees dangling ones
+    [[nodiscard]] static TraceRegistry &instance() noexcept {
+        static auto registry = new TraceRegistry;
+        return *registry;
+    }
+    [[nodiscard]] TraceRing *acquire() noexcept {
+        std::scoped_lock lock{_mutex};
+        auto iter = std::find_if(_rings.begin(), _rings.end(), [](auto &&r) noexcept {
+            return !r->in_use.load(std::memory_order_acquire);
+        });
+        auto ring = iter == _rings.end() ? _rings.emplace_back(std::make_unique<TraceRing>()).get() : iter->get();
+        ring->thread_index.store(_thread_count++, std::memory_order_relaxed);
+        ring->in_use.store(true, std::memory_order_release);
+        return ring;
+    }
+    template<typename F>
+    void for_each(F &&f) noexcept {
+        std::scoped_lock lock{_mutex};
+        for (auto &&r : _rings) { f(*r); }
+    }
+};
+
+struct TraceRingOwner {
+    TraceRing *ring{TraceRegistry::instance().acquire()};
+    uint32_t thread{ring->thread_index.load(std::memory_order_relaxed)};
+    ~TraceRingOwner() noexcept { ring->in_use.store(false, std::memory_order_release); }
+};
+
+void trace_record(const TraceSite *site, std::array<uint64_t, TraceEvent::max_payload_count> payloads) noexcept {
+    static thread_local TraceRingOwner owner;
+    auto ring = owner.ring;
+    auto sequence = ring->head.load(std::memory_order_relaxed);
+    auto &&slot = ring->slots[sequence % TraceRing::capacity];
+    slot.sequence.store(TraceRing::writing, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = TraceEvent{site, Clock::timestamp(), owner.thread, payloads};
+    slot.sequence.store(sequence, std::memory_order_release);
+    ring->head.store(sequence + 1u, std::memory_order_release);
+}
+
+}// namespace detail
+
+std::string trace_dump(size_t max_events_per_thread) noexcept {
+    std::vector<TraceEvent> items;
+    detail::TraceRegistry::instance().for_each([&](detail::TraceRing &ring) noexcept {
+        auto head = ring.head.load(std::memory_order_acquire);
+        auto count = std::min<uint64_t>({head, detail::TraceRing::capacity, max_events_per_thread});
+        for (auto s = head - count; s < head; s++) {
+            auto &&slot = ring.slots[s % detail::TraceRing::capacity];
+            if (slot.sequence.load(std::memory_order_acquire) != s) { continue; }
+            auto event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == s) { items.emplace_back(event); }
+        }
+    });
+    if (items.empty()) { return {}; }
+    std::stable_sort(items.begin(), items.end(), [](auto &&lhs, auto &&rhs) noexcept {
+        return lhs.timestamp < rhs.timestamp;
+    });
+    auto last = items.back().timestamp;
+    std::string dump;
+    for (auto &&e : items) {
+        auto &&p = e.payloads;
+        std::string message;
+        try {
+            message = fmt::vformat(e.site->format, fmt::make_format_args(p[0], p[1], p[2], p[3]));
+        } catch (const std::exception &) {
+            message = fmt::format("{} ({}, {}, {}, {})", e.site->format, p[0], p[1], p[2], p[3]);
+        }
+        dump.append(fmt::format(
+            "\n    [T{:>2}] -{:>10.3f} us: {} [{}:{}]",
+            e.thread, static_cast<double>(last - e.timestamp) * 1e-3,
+            message, e.site->file, e.site->line));
+    }
+    return dump;
+}
+
+}// namespace luisa
@@ -0,0 +1,72 @@
+//
+// Created by Mike Smith on 2021/9/10.
+//
+
+#pragma once
+
+#include <bit>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace luisa {
+
+// A call site of LUISA_TRACE, with the format string applied to the payloads on dump.
+struct TraceSite {
+    const char *format;
+    const char *file;
+    uint32_t line;
+};
+
+struct TraceEvent {
+    static constexpr auto max_payload_count = 4u;
+    const TraceSite *site;
+    uint64_t timestamp;// see Clock::timestamp()
+    uint32_t thread;   // rings are reused after threads exit, so events keep their thread index
+    std::array<uint64_t, max_payload_count> payloads;
+};
+
+namespace detail {
+
+void trace_record(const TraceSite *site, std::array<uint64_t, TraceEvent::max_payload_count> payloads) noexcept;
+
+template<typename T>
+[[nodiscard]] constexpr uint64_t trace_payload(T x) noexcept {
+    if constexpr (std::is_pointer_v<T>) {
+        return reinterpret_cast<uint64_t>(x);
+    } else if constexpr (std::is_enum_v<T>) {
+        return static_cast<uint64_t>(static_cast<std::underlying_type_t<T>>(x));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return std::bit_cast<uint64_t>(static_cast<double>(x));// formatted as integer bits
+    } else {
+        static_assert(std::is_integral_v<T>, "Trace payloads must be integers, enums or pointers.");
+        return static_cast<uint64_t>(x);
+    }
+}
+
+}// namespace detail
+
+// Records an event into the calling thread's trace ring. Writing is lock-free
+// and never formats: only the site pointer, a timestamp and the payloads are
+// stored, and the ring silently overwrites its oldest events.
+template<typename... Args>
+inline void trace(const TraceSite *site, Args... args) noexcept {
+    static_assert(sizeof...(Args) <= TraceEvent::max_payload_count, "Too many trace payloads.");
+    detail::trace_record(site, {detail::trace_payload(args)...});
+}
+
+// Formats the most recent events of every thread (oldest first), at most max_events_per_thread each.
+[[nodiscard]] std::string trace_dump(size_t max_events_per_thread = 64u) noexcept;
+
+}// namespace luisa
+
+#ifndef NDEBUG
+#define LUISA_TRACE(fmt, ...)                                                         \
+    do {                                                                              \
+        static constexpr ::luisa::TraceSite luisa_trace_site{fmt, __FILE__, __LINE__}; \
+        ::luisa::trace(&luisa_trace_site __VA_OPT__(, ) __VA_ARGS__);                  \
+    } while (false)
+#else
+#define LUISA_TRACE(...)
+#endif
@@ -102,6 +102,17 @@ inline void set_block_size(uint x, uint y = 1u, uint z = 1u) noexcept {
         uint3{std::max(x, 1u), std::max(y, 1u), std::max(z, 1u)});
 }
 
+// marks the callable being defined to be always inlined into its callers
+inline void force_inline() noexcept {
+    detail::FunctionBuilder::current()->set_force_inline(true);
+}
+
+// keeps an expression evaluated only for its side effects, e.g. an atomic operation
+template<typename T>
+inline void void_(T &&x) noexcept {
+    detail::FunctionBuilder::current()->void_(detail::extract_expression(std::forward<T>(x)));
+}
+
 template<typename... T>
 [[nodiscard]] inline auto multiple(T &&...v) noexcept {
     return std::make_tuple(detail::Expr{v}...);
@@ -137,6 +148,12 @@ template<typename T>
         return CallOp::MAKE_FLOAT3;
     } else if constexpr (std::is_same_v<T, float4>) {
         return CallOp::MAKE_FLOAT4;
+    } else if constexpr (std::is_same_v<T, half2>) {
+        return CallOp::MAKE_HALF2;
+    } else if constexpr (std::is_same_v<T, half3>) {
+        return CallOp::MAKE_HALF3;
+    } else if constexpr (std::is_same_v<T, half4>) {
+        return CallOp::MAKE_HALF4;
     } else {
         static_assert(always_false_v<T>);
     }
@@ -389,6 +406,7 @@ LUISA_MAKE_VECTOR(bool)
 LUISA_MAKE_VECTOR(int)
 LUISA_MAKE_VECTOR(uint)
 LUISA_MAKE_VECTOR(float)
+LUISA_MAKE_VECTOR(half)
 #undef LUISA_MAKE_VECTOR
 
 // make float2x2
@@ -7,6 +7,10 @@
 #include <runtime/command.h>
 #include <runtime/device.h>
 #include <runtime/shader.h>
+#include <runtime/block_size_tuner.h>
+#include <compile/inliner.h>
+#include <compile/loop_unroller.h>
+#include <compile/optimizer.h>
 #include <dsl/arg.h>
 #include <dsl/expr.h>
 
@@ -119,14 +123,27 @@ public:
     requires concepts::invocable_with_return<void, Def, detail::prototype_to_creation_t<Args>...>
     Kernel(Def &&def)
     noexcept {
-        _builder = detail::FunctionBuilder::define_kernel([&def] {
+        auto kernel = detail::FunctionBuilder::define_kernel([&def] {
             detail::FunctionBuilder::current()->set_block_size(detail::kernel_default_block_size<N>());
             std::apply(
                 std::forward<Def>(def),
                 std::tuple{detail::prototype_to_creation_t<Args>{detail::ArgumentCreation{}}...});
         });
+        kernel = Inliner{}.inline_kernel(std::move(kernel));
+        kernel = LoopUnroller{}.unroll_kernel(std::move(kernel));
+        _builder = Optimizer{}.optimize_kernel(std::move(kernel));
     }
     [[nodiscard]] const auto &function() const noexcept { return _builder; }
+
+    // wraps an already built kernel, e.g., one loaded with FunctionSerializer
+    [[nodiscard]] static Kernel from(SharedFunctionBuilder kernel) noexcept {
+        if (auto n = kernel->arguments().size(); n != sizeof...(Args)) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Kernel #{} has {} argument(s) while {} expected.",
+                hash_to_string(kernel->hash()), n, sizeof...(Args));
+        }
+        return Kernel{std::move(kernel)};
+    }
 };
 
 #define LUISA_KERNE_BASE(N)                                      \
@@ -271,25 +288,30 @@ public:
                      std::negation<is_kernel<std::remove_cvref_t<Def>>>,
                      std::is_invocable<Def, detail::prototype_to_creation_t<Args>...>>,
                  int> = 0>
-    Callable(Def &&def) noexcept
-        : _builder{detail::FunctionBuilder::define_callable([&def] {
-              if constexpr (std::is_same_v<Ret, void>) {
-                  std::apply(
-                      std::forward<Def>(def),
-                      std::tuple{detail::prototype_to_creation_t<Args>{detail::ArgumentCreation{}}...});
-              } else if constexpr (detail::is_tuple_v<Ret>) {
-                  auto ret = detail::tuple_to_var(
-                      std::apply(
-                          std::forward<Def>(def),
-                          std::tuple{detail::prototype_to_creation_t<Args>{detail::ArgumentCreation{}}...}));
-                  detail::FunctionBuilder::current()->return_(detail::extract_expression(ret));
-              } else {
-                  auto ret = std::apply(
-                      std::forward<Def>(def),
-                      std::tuple{detail::prototype_to_creation_t<Args>{detail::ArgumentCreation{}}...});
-                  detail::FunctionBuilder::current()->return_(detail::extract_expression(ret));
-              }
-          })} {}
+    Callable(Def &&def)
+    noexcept {
+        const detail::FunctionBuilder *callable = detail::FunctionBuilder::define_callable([&def] {
+            if constexpr (std::is_same_v<Ret, void>) {
+                std::apply(
+                    std::forward<Def>(def),
+                    std::tuple{detail::prototype_to_creation_t<Args>{detail::ArgumentCreation{}}...});
+            } else if constexpr (detail::is_tuple_v<Ret>) {
+                auto ret = detail::tuple_to_var(
+                    std::apply(
+                        std::forward<Def>(def),
+                        std::tuple{detail::prototype_to_creation_t<Args>{detail::ArgumentCreation{}}...}));
+                detail::FunctionBuilder::current()->return_(detail::extract_expression(ret));
+            } else {
+                auto ret = std::apply(
+                    std::forward<Def>(def),
+                    std::tuple{detail::prototype_to_creation_t<Args>{detail::ArgumentCreation{}}...});
+                detail::FunctionBuilder::current()->return_(detail::extract_expression(ret));
+            }
+        });
+        callable = Inliner{}.inline_callable(callable);
+        callable = LoopUnroller{}.unroll_callable(callable);
+        _builder = Optimizer{}.optimize_callable(callable);
+    }
 
     auto operator()(detail::prototype_to_callable_invocation_t<Args>... args) const noexcept {
         Invoke invoke;
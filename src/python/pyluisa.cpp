@@ -2,18 +2,162 @@
 // Created by Mike Smith on 2021/3/16.
 //
 
+#include <utility>
+
 #include <pybind11/stl.h>
 #include <pybind11/pybind11.h>
 
 #include <ast/interface.h>
 #include <ast/function_builder.h>
 #include <compile/cpp_codegen.h>
+#include <runtime/context.h>
+#include <runtime/device.h>
+#include <runtime/stream.h>
+#include <runtime/buffer.h>
+#include <runtime/image.h>
+
+namespace py = pybind11;
 
 namespace luisa::compute::python {
 
+// A command created from Python, holding the host objects it reads from or
+// writes into. Host memory is used in place through the buffer protocol, so
+// the objects are kept alive by the stream until it is synchronized.
+class PyCommand {
+
+private:
+    Command *_command;
+    py::object _host;
+
+public:
+    PyCommand(Command *command, py::object host) noexcept
+        : _command{command}, _host{std::move(host)} {}
+    PyCommand(PyCommand &&another) noexcept
+        : _command{std::exchange(another._command, nullptr)},
+          _host{std::move(another._host)} {}
+    PyCommand(const PyCommand &) = delete;
+    ~PyCommand() noexcept {
+        // never submitted, recycle through a list
+        if (_command != nullptr) { CommandList{}.append(_command); }
+    }
+    [[nodiscard]] auto submitted() const noexcept { return _command == nullptr; }
+    [[nodiscard]] auto take(std::vector<py::object> &keep_alive) noexcept {
+        if (_command == nullptr) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Command already submitted."); }
+        if (_host) { keep_alive.emplace_back(std::move(_host)); }
+        return std::exchange(_command, nullptr);
+    }
+};
+
+class PyStream {
+
+private:
+    Stream _stream;
+    std::vector<py::object> _keep_alive;
+
+public:
+    explicit PyStream(Stream stream) noexcept : _stream{std::move(stream)} {}
+    PyStream(PyStream &&) noexcept = default;
+    ~PyStream() noexcept {
+        if (_stream) {
+            py::gil_scoped_release release;
+            _stream.synchronize();
+        }
+    }
+    void dispatch(const py::args &commands) {
+        // cast everything first, so that a bad argument never leaves a half-filled command buffer
+        std::vector<PyCommand *> py_commands;
+        for (auto &&c : commands) {
+            auto &&command = c.cast<PyCommand &>();
+            if (command.submitted()) { throw py::value_error{"Command already submitted."}; }
+            py_commands.emplace_back(&command);
+        }
+        auto command_buffer = _stream.command_buffer();
+        for (auto c : py_commands) { command_buffer << c->take(_keep_alive); }
+        py::gil_scoped_release release;
+        command_buffer << commit();
+    }
+    void synchronize() {
+        {
+            py::gil_scoped_release release;
+            _stream.synchronize();
+        }
+        _keep_alive.clear();
+    }
+};
+
+// host memory of a buffer-protocol object, which must be C-contiguous
+[[nodiscard]] inline auto host_memory(const py::buffer &object, bool writable) {
+    auto info = object.request(writable);
+    auto expected_stride = info.itemsize;
+    for (auto i = info.ndim; i > 0; i--) {
+        if (info.shape[i - 1] != 1 && info.strides[i - 1] != expected_stride) {
+            throw py::value_error{"Host memory must be C-contiguous."};
+        }
+        expected_stride *= info.shape[i - 1];
+    }
+    return std::make_pair(info.ptr, static_cast<size_t>(info.size * info.itemsize));
 }
 
-namespace py = pybind11;
+template<typename T>
+void bind_buffer(py::module &m, const char *name) {
+    // host-mapped buffers expose their memory, e.g., numpy.asarray(buffer) aliases it
+    // and keeps the buffer alive; it must not be touched while commands use the buffer
+    py::class_<Buffer<T>>(m, name, py::buffer_protocol())
+        .def_buffer([](Buffer<T> &buffer) {
+            if (!buffer.is_mapped()) { throw py::buffer_error{"Only host-mapped buffers expose their memory."}; }
+            auto mapped = buffer.mapped();
+            return py::buffer_info{mapped.data(), static_cast<py::ssize_t>(mapped.size())};
+        })
+        .def_property_readonly("size", &Buffer<T>::size)
+        .def_property_readonly("size_bytes", &Buffer<T>::size_bytes)
+        .def_property_readonly("is_mapped", &Buffer<T>::is_mapped)
+        .def(
+            "copy_from", [](Buffer<T> &buffer, py::buffer host, size_t offset) {
+                auto [data, size_bytes] = host_memory(host, false);
+                if (size_bytes % sizeof(T) != 0u || offset + size_bytes / sizeof(T) > buffer.size()) {
+                    throw py::value_error{"Host memory does not fit in the buffer."};
+                }
+                auto command = buffer.view(offset, size_bytes / sizeof(T)).copy_from(data);
+                return PyCommand{command, std::move(host)};
+            },
+            py::arg("host"), py::arg("offset") = 0u)
+        .def(
+            "copy_to", [](const Buffer<T> &buffer, py::buffer host, size_t offset) {
+                auto [data, size_bytes] = host_memory(host, true);
+                if (size_bytes % sizeof(T) != 0u || offset + size_bytes / sizeof(T) > buffer.size()) {
+                    throw py::value_error{"Host memory does not fit in the buffer."};
+                }
+                auto command = buffer.view(offset, size_bytes / sizeof(T)).copy_to(data);
+                return PyCommand{command, std::move(host)};
+            },
+            py::arg("host"), py::arg("offset") = 0u);
+}
+
+template<typename T>
+void bind_image(py::module &m, const char *name) {
+    auto check = [](const Image<T> &image, size_t size_bytes) {
+        auto size = image.size();
+        if (size_bytes != pixel_storage_size(image.storage()) * size.x * size.y) {
+            throw py::value_error{"Host memory size does not match the image."};
+        }
+    };
+    py::class_<Image<T>>(m, name)
+        .def_property_readonly("width", [](const Image<T> &image) { return image.size().x; })
+        .def_property_readonly("height", [](const Image<T> &image) { return image.size().y; })
+        .def_property_readonly("storage", &Image<T>::storage)
+        .def("copy_from", [check](const Image<T> &image, py::buffer host) {
+            auto [data, size_bytes] = host_memory(host, false);
+            check(image, size_bytes);
+            return PyCommand{image.copy_from(data), std::move(host)};
+        })
+        .def("copy_to", [check](const Image<T> &image, py::buffer host) {
+            auto [data, size_bytes] = host_memory(host, true);
+            check(image, size_bytes);
+            return PyCommand{image.copy_to(data), std::move(host)};
+        });
+}
+
+}// namespace luisa::compute::python
 
 PYBIND11_MODULE(pyluisa, m) {
 
@@ -33,6 +177,7 @@ PYBIND11_MODULE(pyluisa, m) {
             LUISA_MAKE_TYPE_TAG_VALUE(FLOAT)
             LUISA_MAKE_TYPE_TAG_VALUE(INT)
             LUISA_MAKE_TYPE_TAG_VALUE(UINT)
+            LUISA_MAKE_TYPE_TAG_VALUE(HALF)
             LUISA_MAKE_TYPE_TAG_VALUE(VECTOR)
             LUISA_MAKE_TYPE_TAG_VALUE(MATRIX)
             LUISA_MAKE_TYPE_TAG_VALUE(ARRAY)
@@ -97,4 +242,74 @@ PYBIND11_MODULE(pyluisa, m) {
             .def(py::init<Codegen::Scratch &>())
             .def("emit", &CppCodegen::emit);
     }();
+
+    // runtime
+    [runtime = compute.def_submodule("runtime")] {
+        using namespace luisa::compute;
+        using namespace luisa::compute::python;
+
+        py::enum_<PixelStorage>(runtime, "PixelStorage")
+            .value("BYTE1", PixelStorage::BYTE1)
+            .value("BYTE2", PixelStorage::BYTE2)
+            .value("BYTE4", PixelStorage::BYTE4)
+            .value("SHORT1", PixelStorage::SHORT1)
+            .value("SHORT2", PixelStorage::SHORT2)
+            .value("SHORT4", PixelStorage::SHORT4)
+            .value("INT1", PixelStorage::INT1)
+            .value("INT2", PixelStorage::INT2)
+            .value("INT4", PixelStorage::INT4)
+            .value("HALF1", PixelStorage::HALF1)
+            .value("HALF2", PixelStorage::HALF2)
+            .value("HALF4", PixelStorage::HALF4)
+            .value("FLOAT1", PixelStorage::FLOAT1)
+            .value("FLOAT2", PixelStorage::FLOAT2)
+            .value("FLOAT4", PixelStorage::FLOAT4);
+
+        py::enum_<MappedBufferAccess>(runtime, "MappedBufferAccess")
+            .value("NONE", MappedBufferAccess::NONE)
+            .value("REMOTE", MappedBufferAccess::REMOTE)
+            .value("UNIFIED", MappedBufferAccess::UNIFIED);
+
+        py::class_<PyCommand>(runtime, "Command");
+
+        bind_buffer<float>(runtime, "FloatBuffer");
+        bind_buffer<int>(runtime, "IntBuffer");
+        bind_buffer<uint>(runtime, "UIntBuffer");
+        bind_image<float>(runtime, "FloatImage");
+        bind_image<int>(runtime, "IntImage");
+        bind_image<uint>(runtime, "UIntImage");
+
+        py::class_<PyStream>(runtime, "Stream")
+            .def("dispatch", &PyStream::dispatch)
+            .def("synchronize", &PyStream::synchronize);
+
+        py::class_<Device>(runtime, "Device")
+            .def("create_stream", [](Device &d) { return PyStream{d.create_stream()}; })
+            .def(
+                "create_buffer", [](Device &d, size_t size, std::string_view type, bool mapped) -> py::object {
+                    if (mapped && d.mapped_buffer_access() == MappedBufferAccess::NONE) {
+                        throw py::value_error{"Host-mapped buffers are not supported by the device."};
+                    }
+                    auto memory = mapped ? BufferMemory::HOST_MAPPED : BufferMemory::DEVICE;
+                    if (type == "float") { return py::cast(d.create_buffer<float>(size, memory)); }
+                    if (type == "int") { return py::cast(d.create_buffer<int>(size, memory)); }
+                    if (type == "uint") { return py::cast(d.create_buffer<uint>(size, memory)); }
+                    throw py::value_error{"Buffer element type must be 'float', 'int' or 'uint'."};
+                },
+                py::arg("size"), py::arg("type") = "float", py::arg("mapped") = false)
+            .def_property_readonly("mapped_buffer_access", &Device::mapped_buffer_access)
+            .def(
+                "create_image", [](Device &d, PixelStorage storage, uint width, uint height, std::string_view type) -> py::object {
+                    if (type == "float") { return py::cast(d.create_image<float>(storage, width, height)); }
+                    if (type == "int") { return py::cast(d.create_image<int>(storage, width, height)); }
+                    if (type == "uint") { return py::cast(d.create_image<uint>(storage, width, height)); }
+                    throw py::value_error{"Image pixel type must be 'float', 'int' or 'uint'."};
+                },
+                py::arg("storage"), py::arg("width"), py::arg("height"), py::arg("type") = "float");
+
+        // devices refer to their contexts, which must outlive them
+        py::class_<Context>(runtime, "Context")
+            .def(py::init([](std::string_view program) { return std::make_unique<Context>(program); }))
+            .def("create_device", &Context::create_device, py::arg("backend"), py::arg("index") = 0u, py::keep_alive<0, 1>());
+    }();
 }
@@ -0,0 +1,78 @@
+//
+// Created by Mike Smith on 2021/8/18.
+//
+
+#include <array>
+#include <fstream>
+#include <typeinfo>
+
+#include <core/hash.h>
+#include <runtime/context.h>
+#include <runtime/block_size_tuner.h>
+
+namespace luisa::compute {
+
+std::span<const uint3> BlockSizeTuner::candidates(size_t dimension) noexcept {
+    static constexpr std::array candidates_1d{
+        uint3{32u, 1u, 1u}, uint3{64u, 1u, 1u}, uint3{128u, 1u, 1u},
+        uint3{256u, 1u, 1u}, uint3{512u, 1u, 1u}, uint3{1024u, 1u, 1u}};
+    static constexpr std::array candidates_2d{
+        uint3{8u, 8u, 1u}, uint3{16u, 8u, 1u}, uint3{8u, 16u, 1u},
+        uint3{16u, 16u, 1u}, uint3{32u, 8u, 1u}, uint3{32u, 16u, 1u}, uint3{32u, 32u, 1u}};
+    static constexpr std::array candidates_3d{
+        uint3{4u, 4u, 4u}, uint3{8u, 4u, 4u}, uint3{8u, 8u, 4u},
+        uint3{8u, 8u, 8u}, uint3{16u, 8u, 4u}, uint3{16u, 8u, 8u}};
+    if (dimension == 1u) { return candidates_1d; }
+    if (dimension == 2u) { return candidates_2d; }
+    if (dimension == 3u) { return candidates_3d; }
+    LUISA_ERROR_WITH_LOCATION("Invalid kernel dimension {}.", dimension);
+}
+
+std::filesystem::path BlockSizeTuner::cache_path(const Device::Interface *device, uint64_t kernel_hash) noexcept {
+    // the best block size depends on the backend, the GPU and its driver
+    auto device_name = fmt::format("{}/{}", typeid(*device).name(), device->device_name());
+    auto device_hash = xxh3_hash64(device_name.data(), device_name.size());
+    return device->context().cache_directory() / "block_size" /
+           fmt::format("{}-{}.txt", hash_to_string(device_hash), hash_to_string(kernel_hash));
+}
+
+std::optional<uint3> BlockSizeTuner::load(const Device::Interface *device, uint64_t kernel_hash) noexcept {
+    std::ifstream file{cache_path(device, kernel_hash)};
+    if (!file.is_open()) { return std::nullopt; }
+    uint3 block_size;
+    if (!(file >> block_size.x >> block_size.y >> block_size.z) ||
+        block_size.x == 0u || block_size.y == 0u || block_size.z == 0u) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Ignoring invalid tuned block size cache for kernel #{}.",
+            hash_to_string(kernel_hash));
+        return std::nullopt;
+    }
+    return block_size;
+}
+
+void BlockSizeTuner::save(const Device::Interface *device, uint64_t kernel_hash, uint3 block_size) noexcept {
+    auto path = cache_path(device, kernel_hash);
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    std::ofstream file{path};
+    if (ec || !file.is_open()) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to save tuned block size to '{}'.",
+            path.string<char>());
+        return;
+    }
+    file << block_size.x << " " << block_size.y << " " << block_size.z << "\n";
+}
+
+void BlockSizeTuner::report(uint64_t kernel_hash, uint3 default_block_size, double default_time,
+                            uint3 best_block_size, double best_time) noexcept {
+    LUISA_INFO(
+        "Tuned block size for kernel #{}: ({}, {}, {}) -> ({}, {}, {}), "
+        "{:.3f} ms -> {:.3f} ms (speedup = {:.2f}x).",
+        hash_to_string(kernel_hash),
+        default_block_size.x, default_block_size.y, default_block_size.z,
+        best_block_size.x, best_block_size.y, best_block_size.z,
+        default_time, best_time, default_time / std::max(best_time, 1e-6));
+}
+
+}// namespace luisa::compute
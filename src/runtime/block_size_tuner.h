@@ -0,0 +1,102 @@
+//
+// Created by Mike Smith on 2021/8/18.
+//
+
+#pragma once
+
+#include <span>
+#include <optional>
+#include <filesystem>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/stream.h>
+#include <runtime/shader.h>
+#include <compile/function_rewriter.h>
+
+namespace luisa::compute {
+
+class BlockSizeTuner {
+
+public:
+    static constexpr auto warm_up_iterations = 2u;
+    static constexpr auto measure_iterations = 8u;
+
+public:
+    // candidate block sizes for kernels of the given dimension
+    [[nodiscard]] static std::span<const uint3> candidates(size_t dimension) noexcept;
+    // cached tuning results are keyed by the backend, the device name (with the driver,
+    // see Device::Interface::device_name()) and the kernel hash under the default block size
+    [[nodiscard]] static std::filesystem::path cache_path(const Device::Interface *device, uint64_t kernel_hash) noexcept;
+    [[nodiscard]] static std::optional<uint3> load(const Device::Interface *device, uint64_t kernel_hash) noexcept;
+    static void save(const Device::Interface *device, uint64_t kernel_hash, uint3 block_size) noexcept;
+    static void report(uint64_t kernel_hash, uint3 default_block_size, double default_time,
+                       uint3 best_block_size, double best_time) noexcept;
+};
+
+template<size_t N, typename... Args>
+Shader<N, Args...> Device::compile(const Kernel<N, Args...> &kernel, uint3 block_size) noexcept {
+    if (all(block_size == kernel.function()->block_size())) { return compile(kernel); }
+    // the copy keeps the kernel alive and leaves it (and its hash) untouched
+    return _create<Shader<N, Args...>>(FunctionRewriter::with_block_size(kernel.function(), block_size));
+}
+
+template<size_t N, typename... Args, typename Dispatch>
+Shader<N, Args...> Device::compile(const Kernel<N, Args...> &kernel, Stream &stream, Dispatch &&representative_dispatch) noexcept {
+
+    auto kernel_hash = kernel.function()->hash();
+    auto default_block_size = kernel.function()->block_size();
+    // shared memory is sized for the block size the kernel is written for
+    if (!kernel.function()->shared_variables().empty()) {
+        LUISA_VERBOSE_WITH_LOCATION(
+            "Not tuning the block size of kernel #{} with shared memory.",
+            hash_to_string(kernel_hash));
+        return compile(kernel);
+    }
+    if (auto cached = BlockSizeTuner::load(_impl.get(), kernel_hash)) {
+        LUISA_VERBOSE_WITH_LOCATION(
+            "Found tuned block size ({}, {}, {}) for kernel #{}.",
+            cached->x, cached->y, cached->z, hash_to_string(kernel_hash));
+        return compile(kernel, *cached);
+    }
+
+    auto measure = [&](const Shader<N, Args...> &shader) noexcept {
+        for (auto i = 0u; i < BlockSizeTuner::warm_up_iterations; i++) {
+            stream << representative_dispatch(shader);
+        }
+        stream << synchronize();
+        Clock clock;
+        for (auto i = 0u; i < BlockSizeTuner::measure_iterations; i++) {
+            stream << representative_dispatch(shader);
+        }
+        stream << synchronize();
+        return clock.toc() / BlockSizeTuner::measure_iterations;
+    };
+
+    auto best_shader = compile(kernel);
+    auto best_block_size = default_block_size;
+    auto default_time = measure(best_shader);
+    auto best_time = default_time;
+    for (auto block_size : BlockSizeTuner::candidates(N)) {
+        if (all(block_size == default_block_size)) { continue; }
+        auto shader = compile(kernel, block_size);
+        // launching with more threads than the device or the compiled kernel allows would fail
+        if (block_size.x * block_size.y * block_size.z > _impl->shader_max_block_threads(shader.handle())) {
+            LUISA_VERBOSE_WITH_LOCATION(
+                "Skipping block size ({}, {}, {}) beyond the limits of kernel #{}.",
+                block_size.x, block_size.y, block_size.z, hash_to_string(kernel_hash));
+            continue;
+        }
+        if (auto time = measure(shader); time < best_time) {
+            best_time = time;
+            best_block_size = block_size;
+            best_shader = std::move(shader);
+        }
+    }
+    BlockSizeTuner::save(_impl.get(), kernel_hash, best_block_size);
+    BlockSizeTuner::report(kernel_hash, default_block_size, default_time, best_block_size, best_time);
+    return best_shader;
+}
+
+}// namespace luisa::compute
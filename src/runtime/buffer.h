@@ -4,10 +4,15 @@
 
 #pragma once
 
+#include <span>
+#include <utility>
+
 #include <core/atomic.h>
+#include <core/platform.h>
 #include <core/concepts.h>
 #include <runtime/command.h>
 #include <runtime/resource.h>
+#include <runtime/file_copy.h>
 
 namespace luisa::compute {
 
@@ -17,6 +22,7 @@ struct Expr;
 }
 
 class Heap;
+class TransientPool;
 
 template<typename T>
 class BufferView;
@@ -33,30 +39,85 @@ class Buffer : public Resource {
 
 private:
     size_t _size{};
+    T *_mapped{nullptr};
 
 private:
     friend class Device;
-    Buffer(Device::Interface *device, size_t size) noexcept
-        : Resource{
-            device, Tag::BUFFER,
-            device->create_buffer(
-                size * sizeof(T),
+    Buffer(Device::Interface *device, size_t size, BufferMemory memory) noexcept
+        : Resource{device, Tag::BUFFER, _create(device, size * sizeof(T), memory), size * sizeof(T)},
+          _size{size} {
+        if (memory == BufferMemory::HOST_MAPPED) {
+            _mapped = static_cast<T *>(device->mapped_buffer_address(handle()));
+        }
+    }
+
+    Buffer(Device::Interface *device, const std::filesystem::path &path) noexcept
+        : Buffer{device, _map_file(device, path)} {}
+
+    Buffer(Device::Interface *device, std::span<const std::byte> mapping) noexcept
+        : Resource{device, Tag::BUFFER, device->create_file_buffer(mapping), mapping.size()},
+          _size{mapping.size() / sizeof(T)} {}
+
+    [[nodiscard]] static std::span<const std::byte> _map_file(Device::Interface *device, const std::filesystem::path &path) noexcept {
+        if (!device->file_buffers_supported()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "File-backed buffers are not supported by the device "
+                "(when creating buffer from file '{}').",
+                path.string());
+        }
+        return memory_map_file(path);
+    }
+
+    [[nodiscard]] static uint64_t _create(Device::Interface *device, size_t size_bytes, BufferMemory memory) noexcept {
+        if (memory == BufferMemory::DEVICE) {
+            return device->create_buffer(
+                size_bytes,
                 std::numeric_limits<uint64_t>::max(),
-                std::numeric_limits<uint32_t>::max())},
-          _size{size} {}
+                std::numeric_limits<uint32_t>::max());
+        }
+        if (device->mapped_buffer_access() == MappedBufferAccess::NONE) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Host-mapped buffers are not supported by the device.");
+        }
+        return device->create_mapped_buffer(size_bytes);
+    }
 
 public:
     Buffer() noexcept = default;
+    Buffer(Buffer &&another) noexcept
+        : Resource{std::move(another)},
+          _size{std::exchange(another._size, 0u)},
+          _mapped{std::exchange(another._mapped, nullptr)} {}
+    Buffer &operator=(Buffer &&rhs) noexcept {
+        if (this != &rhs) [[likely]] {
+            Resource::operator=(std::move(rhs));
+            _size = std::exchange(rhs._size, 0u);
+            _mapped = std::exchange(rhs._mapped, nullptr);
+        }
+        return *this;
+    }
     using Resource::operator bool;
 
     [[nodiscard]] auto size() const noexcept { return _size; }
     [[nodiscard]] auto size_bytes() const noexcept { return _size * sizeof(T); }
     [[nodiscard]] auto view() const noexcept { return BufferView<T>{this->handle(), 0u, _size}; }
     [[nodiscard]] auto view(size_t offset, size_t count) const noexcept { return view().subview(offset, count); }
+    [[nodiscard]] auto is_mapped() const noexcept { return _mapped != nullptr; }
+
+    // in-place host access to host-mapped buffers, which must not overlap with commands
+    // using the buffer, i.e., is valid between synchronizations of the streams using it
+    [[nodiscard]] std::span<T> mapped() const noexcept {
+        if (_mapped == nullptr) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Buffer #{} is not host-mapped.", this->handle());
+        }
+        return {_mapped, _size};
+    }
 
     [[nodiscard]] auto copy_to(void *data) const noexcept { return this->view().copy_to(data); }
     [[nodiscard]] auto copy_from(const void *data) { return this->view().copy_from(data); }
     [[nodiscard]] auto copy_from(BufferView<T> source) { return this->view().copy_from(source); }
+    [[nodiscard]] auto copy_from_file(std::filesystem::path path, size_t file_offset = 0u) const noexcept {
+        return this->view().copy_from_file(std::move(path), file_offset);
+    }
 
     template<typename I>
     [[nodiscard]] decltype(auto) operator[](I &&i) const noexcept {
@@ -79,6 +140,7 @@ private:
 
 private:
     friend class Heap;
+    friend class TransientPool;
     friend class Buffer<T>;
     BufferView(uint64_t handle, size_t offset_bytes, size_t size) noexcept
         : _handle{handle}, _offset_bytes{offset_bytes}, _size{size} {
@@ -98,7 +160,7 @@ public:
     [[nodiscard]] auto size_bytes() const noexcept { return _size * sizeof(T); }
 
     [[nodiscard]] auto subview(size_t offset_elements, size_t size_elements) const noexcept {
-        if (size_elements * sizeof(T) + offset_elements > _size) [[unlikely]] {
+        if (offset_elements + size_elements > _size) [[unlikely]] {
             LUISA_ERROR_WITH_LOCATION(
                 "Subview (with offset_elements = {}, size_elements = {}) "
                 "overflows buffer view (with size_elements = {}).",
@@ -138,6 +200,11 @@ public:
             this->size_bytes());
     }
 
+    // reads size_bytes() bytes of the file from file_offset, see runtime/file_copy.h
+    [[nodiscard]] auto copy_from_file(std::filesystem::path path, size_t file_offset = 0u) const noexcept {
+        return FileCopy::buffer(std::move(path), file_offset, _handle, _offset_bytes, size_bytes());
+    }
+
     template<typename I>
     [[nodiscard]] decltype(auto) operator[](I &&i) const noexcept {
         return detail::Expr<Buffer<T>>{*this}[std::forward<I>(i)];
@@ -0,0 +1,808 @@
+//
+// Created by Mike Smith on 2021/9/8.
+//
+
+#include <deque>
+#include <limits>
+#include <cstring>
+#include <unordered_map>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <core/platform.h>
+#include <ast/function_builder.h>
+#include <ast/function_serializer.h>
+#include <runtime/texture.h>
+#include <runtime/command.h>
+#include <runtime/capture_device.h>
+#include <runtime/destruction_queue.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+// commands in a dispatch record, in the order of LUISA_ALL_COMMANDS
+enum struct CaptureCommand : uint32_t {
+    BUFFER_UPLOAD,
+    BUFFER_DOWNLOAD,
+    BUFFER_COPY,
+    BUFFER_TO_TEXTURE_COPY,
+    SHADER_DISPATCH,
+    TEXTURE_UPLOAD,
+    TEXTURE_DOWNLOAD,
+    TEXTURE_COPY,
+    TEXTURE_TO_BUFFER_COPY,
+    ACCEL_UPDATE,
+    ACCEL_BUILD,
+    MESH_UPDATE,
+    MESH_BUILD
+};
+
+class CaptureWriter {
+
+private:
+    std::vector<std::byte> _bytes;
+
+public:
+    template<typename T>
+    void write(T x) noexcept {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write_bytes(&x, sizeof(T));
+    }
+    void write_bytes(const void *data, size_t size) noexcept {
+        auto p = static_cast<const std::byte *>(data);
+        _bytes.insert(_bytes.end(), p, p + size);
+    }
+    template<typename T>
+    void write_span(std::span<T> s) noexcept {
+        write<uint64_t>(s.size_bytes());
+        write_bytes(s.data(), s.size_bytes());
+    }
+    void clear() noexcept { _bytes.clear(); }
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return _bytes; }
+};
+
+class CaptureReader {
+
+private:
+    std::span<const std::byte> _data;
+    size_t _offset{0u};
+
+public:
+    explicit CaptureReader(std::span<const std::byte> data) noexcept : _data{data} {}
+    [[nodiscard]] std::span<const std::byte> read_bytes(size_t size) noexcept {
+        if (_offset + size > _data.size()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Truncated capture (offset = {}, required = {}, size = {}).",
+                _offset, size, _data.size());
+        }
+        auto s = _data.subspan(_offset, size);
+        _offset += size;
+        return s;
+    }
+    template<typename T>
+    [[nodiscard]] T read() noexcept {
+        T x;
+        std::memcpy(&x, read_bytes(sizeof(T)).data(), sizeof(T));
+        return x;
+    }
+    [[nodiscard]] auto read_span() noexcept { return read_bytes(read<uint64_t>()); }
+    [[nodiscard]] auto exhausted() const noexcept { return _offset == _data.size(); }
+};
+
+class CaptureCommandEncoder final : public CommandVisitor {
+
+private:
+    CaptureWriter &_writer;
+
+public:
+    explicit CaptureCommandEncoder(CaptureWriter &writer) noexcept : _writer{writer} {}
+
+    void visit(const BufferUploadCommand *command) noexcept override {
+        _writer.write(CaptureCommand::BUFFER_UPLOAD);
+        _writer.write(command->handle());
+        _writer.write(command->offset());
+        _writer.write_span(std::span{static_cast<const std::byte *>(command->data()), command->size()});
+    }
+    void visit(const BufferDownloadCommand *command) noexcept override {
+        _writer.write(CaptureCommand::BUFFER_DOWNLOAD);
+        _writer.write(command->handle());
+        _writer.write(command->offset());
+        _writer.write(command->size());
+    }
+    void visit(const BufferCopyCommand *command) noexcept override {
+        _writer.write(CaptureCommand::BUFFER_COPY);
+        _writer.write(command->src_handle());
+        _writer.write(command->dst_handle());
+        _writer.write(command->src_offset());
+        _writer.write(command->dst_offset());
+        _writer.write(command->size());
+    }
+    void visit(const BufferToTextureCopyCommand *command) noexcept override {
+        _writer.write(CaptureCommand::BUFFER_TO_TEXTURE_COPY);
+        _writer.write(command->buffer());
+        _writer.write(command->buffer_offset());
+        _writer.write(command->texture());
+        _writer.write(command->storage());
+        _writer.write(command->level());
+        _writer.write(command->offset());
+        _writer.write(command->size());
+    }
+    void visit(const ShaderDispatchCommand *command) noexcept override {
+        _writer.write(CaptureCommand::SHADER_DISPATCH);
+        _writer.write(command->handle());
+        _writer.write(command->dispatch_size());
+        _writer.write<uint64_t>(command->argument_count());
+        command->decode([this](uint32_t uid, auto argument) noexcept {
+            using T = decltype(argument);
+            if constexpr (std::is_same_v<T, ShaderDispatchCommand::BufferArgument>) {
+                _writer.write(ShaderDispatchCommand::Argument::Tag::BUFFER);
+                _writer.write(uid);
+                _writer.write(argument.handle);
+                _writer.write(argument.offset);
+            } else if constexpr (std::is_same_v<T, ShaderDispatchCommand::TextureArgument>) {
+                _writer.write(ShaderDispatchCommand::Argument::Tag::TEXTURE);
+                _writer.write(uid);
+                _writer.write(argument.handle);
+            } else if constexpr (std::is_same_v<T, ShaderDispatchCommand::TextureHeapArgument>) {
+                _writer.write(ShaderDispatchCommand::Argument::Tag::HEAP);
+                _writer.write(uid);
+                _writer.write(argument.handle);
+            } else if constexpr (std::is_same_v<T, ShaderDispatchCommand::AccelArgument>) {
+                _writer.write(ShaderDispatchCommand::Argument::Tag::ACCEL);
+                _writer.write(uid);
+                _writer.write(argument.handle);
+            } else {// uniforms
+                _writer.write(ShaderDispatchCommand::Argument::Tag::UNIFORM);
+                _writer.write(uid);
+                _writer.write_span(argument);
+            }
+        });
+    }
+    void visit(const TextureUploadCommand *command) noexcept override {
+        auto size = command->size();
+        auto size_bytes = pixel_storage_size(command->storage()) * size.x * size.y * size.z;
+        _writer.write(CaptureCommand::TEXTURE_UPLOAD);
+        _writer.write(command->handle());
+        _writer.write(command->storage());
+        _writer.write(command->level());
+        _writer.write(command->offset());
+        _writer.write(size);
+        _writer.write_span(std::span{static_cast<const std::byte *>(command->data()), size_bytes});
+    }
+    void visit(const TextureDownloadCommand *command) noexcept override {
+        _writer.write(CaptureCommand::TEXTURE_DOWNLOAD);
+        _writer.write(command->handle());
+        _writer.write(command->storage());
+        _writer.write(command->level());
+        _writer.write(command->offset());
+        _writer.write(command->size());
+    }
+    void visit(const TextureCopyCommand *command) noexcept override {
+        _writer.write(CaptureCommand::TEXTURE_COPY);
+        _writer.write(command->src_handle());
+        _writer.write(command->dst_handle());
+        _writer.write(command->src_level());
+        _writer.write(command->dst_level());
+        _writer.write(command->src_offset());
+        _writer.write(command->dst_offset());
+        _writer.write(command->size());
+    }
+    void visit(const TextureToBufferCopyCommand *command) noexcept override {
+        _writer.write(CaptureCommand::TEXTURE_TO_BUFFER_COPY);
+        _writer.write(command->buffer());
+        _writer.write(command->buffer_offset());
+        _writer.write(command->texture());
+        _writer.write(command->storage());
+        _writer.write(command->level());
+        _writer.write(command->offset());
+        _writer.write(command->size());
+    }
+    void visit(const AccelUpdateCommand *command) noexcept override {
+        _writer.write(CaptureCommand::ACCEL_UPDATE);
+        _writer.write(command->handle());
+        _writer.write<uint64_t>(command->first_instance_to_update());
+        _writer.write_span(command->updated_transforms());
+    }
+    void visit(const AccelBuildCommand *command) noexcept override {
+        _writer.write(CaptureCommand::ACCEL_BUILD);
+        _writer.write(command->handle());
+        _writer.write(command->hint());
+        _writer.write_span(command->instance_mesh_handles());
+        _writer.write_span(command->instance_transforms());
+    }
+    void visit(const MeshUpdateCommand *command) noexcept override {
+        _writer.write(CaptureCommand::MESH_UPDATE);
+        _writer.write(command->handle());
+    }
+    void visit(const MeshBuildCommand *command) noexcept override {
+        _writer.write(CaptureCommand::MESH_BUILD);
+        _writer.write(command->handle());
+        _writer.write(command->hint());
+        _writer.write(command->vertex_buffer_handle());
+        _writer.write(command->vertex_buffer_offset());
+        _writer.write(command->vertex_stride());
+        _writer.write(command->vertex_count());
+        _writer.write(command->triangle_buffer_handle());
+        _writer.write(command->triangle_buffer_offset());
+        _writer.write(command->triangle_count());
+    }
+};
+
+}// namespace detail
+
+CaptureDevice::CaptureDevice(Device::Handle device, const std::filesystem::path &path) noexcept
+    : Device::Interface{device->context()},
+      _device{std::move(device)},
+      _file{path, std::ios::binary} {
+    if (!_file) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Failed to open capture file '{}'.", path.string());
+    }
+    detail::CaptureWriter header;
+    header.write(magic);
+    header.write(version);
+    _write(header.bytes());
+    LUISA_INFO("Capturing device calls into '{}'.", path.string());
+}
+
+CaptureDevice::~CaptureDevice() noexcept { _file.flush(); }
+
+Device CaptureDevice::create(Device device, const std::filesystem::path &path) noexcept {
+    auto deleter = [](Device::Interface *d) noexcept {
+        d->destruction_queue().flush();
+        delete d;
+    };
+    return Device{Device::Handle{new CaptureDevice{device.impl(), path}, deleter}};
+}
+
+void CaptureDevice::_write(std::span<const std::byte> bytes) noexcept {
+    _file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+template<typename... T>
+void CaptureDevice::_record(Record record, T... fields) noexcept {
+    detail::CaptureWriter writer;
+    writer.write(record);
+    (writer.write(fields), ...);
+    std::scoped_lock lock{_mutex};
+    _write(writer.bytes());
+}
+
+uint64_t CaptureDevice::create_buffer(size_t size_bytes, uint64_t heap_handle, uint32_t index_in_heap) noexcept {
+    auto handle = _device->create_buffer(size_bytes, heap_handle, index_in_heap);
+    _record(Record::CREATE_BUFFER, handle, size_bytes, heap_handle, index_in_heap);
+    return handle;
+}
+
+void CaptureDevice::destroy_buffer(uint64_t handle) noexcept {
+    _record(Record::DESTROY_BUFFER, handle);
+    _device->destroy_buffer(handle);
+}
+
+MappedBufferAccess CaptureDevice::mapped_buffer_access() const noexcept {
+    return _device->mapped_buffer_access();
+}
+
+// replayed as a device buffer: writes through the mapping bypass commands, so they are not captured
+uint64_t CaptureDevice::create_mapped_buffer(size_t size_bytes) noexcept {
+    auto handle = _device->create_mapped_buffer(size_bytes);
+    _record(Record::CREATE_BUFFER, handle, size_bytes, std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint32_t>::max());
+    return handle;
+}
+
+void *CaptureDevice::mapped_buffer_address(uint64_t handle) noexcept {
+    return _device->mapped_buffer_address(handle);
+}
+
+bool CaptureDevice::file_buffers_supported() const noexcept {
+    return _device->file_buffers_supported();
+}
+
+// replayed as an uninitialized device buffer, as the file is not captured
+uint64_t CaptureDevice::create_file_buffer(std::span<const std::byte> mapping) noexcept {
+    auto handle = _device->create_file_buffer(mapping);
+    _record(Record::CREATE_BUFFER, handle, mapping.size(), std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint32_t>::max());
+    return handle;
+}
+
+uint64_t CaptureDevice::create_texture(PixelFormat format, uint dimension, uint width, uint height, uint depth, uint mipmap_levels, TextureSampler sampler, uint64_t heap_handle, uint32_t index_in_heap) {
+    auto handle = _device->create_texture(format, dimension, width, height, depth, mipmap_levels, sampler, heap_handle, index_in_heap);
+    _record(Record::CREATE_TEXTURE, handle, format, dimension, width, height, depth, mipmap_levels, sampler, heap_handle, index_in_heap);
+    return handle;
+}
+
+void CaptureDevice::destroy_texture(uint64_t handle) noexcept {
+    _record(Record::DESTROY_TEXTURE, handle);
+    _device->destroy_texture(handle);
+}
+
+uint64_t CaptureDevice::create_heap(size_t size) noexcept {
+    auto handle = _device->create_heap(size);
+    _record(Record::CREATE_HEAP, handle, size);
+    return handle;
+}
+
+size_t CaptureDevice::query_heap_memory_usage(uint64_t handle) noexcept {
+    return _device->query_heap_memory_usage(handle);
+}
+
+void CaptureDevice::destroy_heap(uint64_t handle) noexcept {
+    _record(Record::DESTROY_HEAP, handle);
+    _device->destroy_heap(handle);
+}
+
+uint64_t CaptureDevice::create_stream() noexcept {
+    auto handle = _device->create_stream();
+    _record(Record::CREATE_STREAM, handle);
+    return handle;
+}
+
+void CaptureDevice::destroy_stream(uint64_t handle) noexcept {
+    _record(Record::DESTROY_STREAM, handle);
+    _device->destroy_stream(handle);
+}
+
+void CaptureDevice::synchronize_stream(uint64_t stream_handle) noexcept {
+    _record(Record::SYNCHRONIZE_STREAM, stream_handle);
+    _device->synchronize_stream(stream_handle);
+    // keep the capture usable if the process dies afterwards
+    std::scoped_lock lock{_mutex};
+    _file.flush();
+}
+
+void CaptureDevice::_record_dispatch(uint64_t stream_handle, const CommandList &list) noexcept {
+    static thread_local detail::CaptureWriter writer;
+    writer.clear();
+    writer.write(Record::DISPATCH);
+    writer.write(stream_handle);
+    auto count = 0ull;
+    for (auto command : list) { static_cast<void>(command), count++; }
+    writer.write<uint64_t>(count);
+    detail::CaptureCommandEncoder encoder{writer};
+    for (auto command : list) { command->accept(encoder); }
+    std::scoped_lock lock{_mutex};
+    _write(writer.bytes());
+}
+
+void CaptureDevice::dispatch(uint64_t stream_handle, CommandList list) noexcept {
+    _record_dispatch(stream_handle, list);
+    _device->dispatch(stream_handle, std::move(list));
+}
+
+void CaptureDevice::dispatch_profiled(uint64_t stream_handle, CommandList list, TimestampCallback callback) noexcept {
+    _record_dispatch(stream_handle, list);
+    _device->dispatch_profiled(stream_handle, std::move(list), std::move(callback));
+}
+
+uint64_t CaptureDevice::create_shader(Function kernel) noexcept {
+    auto handle = _device->create_shader(kernel);
+    detail::CaptureWriter writer;
+    std::scoped_lock lock{_mutex};
+    if (_recorded_kernels.emplace(kernel.hash()).second) {
+        writer.write(Record::KERNEL);
+        writer.write(kernel.hash());
+        auto ast = FunctionSerializer::serialize(kernel);
+        writer.write_span(std::span{std::as_const(ast)});
+    }
+    writer.write(Record::CREATE_SHADER);
+    writer.write(handle);
+    writer.write(kernel.hash());
+    _write(writer.bytes());
+    return handle;
+}
+
+void CaptureDevice::destroy_shader(uint64_t handle) noexcept {
+    _record(Record::DESTROY_SHADER, handle);
+    _device->destroy_shader(handle);
+}
+
+uint64_t CaptureDevice::create_event() noexcept {
+    auto handle = _device->create_event();
+    _record(Record::CREATE_EVENT, handle);
+    return handle;
+}
+
+void CaptureDevice::destroy_event(uint64_t handle) noexcept {
+    _record(Record::DESTROY_EVENT, handle);
+    _device->destroy_event(handle);
+}
+
+void CaptureDevice::signal_event(uint64_t handle, uint64_t stream_handle) noexcept {
+    _record(Record::SIGNAL_EVENT, handle, stream_handle);
+    _device->signal_event(handle, stream_handle);
+}
+
+void CaptureDevice::wait_event(uint64_t handle, uint64_t stream_handle) noexcept {
+    _record(Record::WAIT_EVENT, handle, stream_handle);
+    _device->wait_event(handle, stream_handle);
+}
+
+void CaptureDevice::synchronize_event(uint64_t handle) noexcept {
+    _record(Record::SYNCHRONIZE_EVENT, handle);
+    _device->synchronize_event(handle);
+}
+
+// queries do not change any state, so they are not recorded
+std::string CaptureDevice::device_name() const noexcept {
+    return _device->device_name();
+}
+
+uint32_t CaptureDevice::shader_max_block_threads(uint64_t handle) noexcept {
+    return _device->shader_max_block_threads(handle);
+}
+
+bool CaptureDevice::query_event(uint64_t handle) noexcept {
+    return _device->query_event(handle);
+}
+
+uint64_t CaptureDevice::create_mesh() noexcept {
+    auto handle = _device->create_mesh();
+    _record(Record::CREATE_MESH, handle);
+    return handle;
+}
+
+void CaptureDevice::destroy_mesh(uint64_t handle) noexcept {
+    _record(Record::DESTROY_MESH, handle);
+    _device->destroy_mesh(handle);
+}
+
+uint64_t CaptureDevice::create_accel() noexcept {
+    auto handle = _device->create_accel();
+    _record(Record::CREATE_ACCEL, handle);
+    return handle;
+}
+
+void CaptureDevice::destroy_accel(uint64_t handle) noexcept {
+    _record(Record::DESTROY_ACCEL, handle);
+    _device->destroy_accel(handle);
+}
+
+namespace detail {
+
+class CaptureReplay {
+
+private:
+    using Record = CaptureDevice::Record;
+    using HandleMap = std::unordered_map<uint64_t, uint64_t>;
+
+    struct Shader {
+        uint64_t handle;
+        Function kernel;
+    };
+
+private:
+    Device::Interface *_device;
+    CaptureReader _reader;
+    CaptureReplayer::Options _options;
+    CaptureReplayer::Report _report;
+    HandleMap _buffers, _textures, _heaps, _streams, _events, _meshes, _accels;
+    std::unordered_map<uint64_t, Shader> _shaders;
+    std::unordered_map<uint64_t, std::shared_ptr<const FunctionBuilder>> _kernels;
+    // storage referenced by in-flight commands, released after the final synchronization
+    std::deque<std::vector<std::byte>> _host_buffers;
+    std::deque<std::vector<uint64_t>> _instance_meshes;
+    std::deque<std::vector<float4x4>> _instance_transforms;
+
+private:
+    [[nodiscard]] static uint64_t _map(const HandleMap &map, uint64_t handle, std::string_view what) noexcept {
+        auto iter = map.find(handle);
+        if (iter == map.cend()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Unknown {} handle {} in capture.", what, handle);
+        }
+        return iter->second;
+    }
+    [[nodiscard]] uint64_t _heap(uint64_t handle) const noexcept {
+        return handle == std::numeric_limits<uint64_t>::max() ? handle : _map(_heaps, handle, "heap");
+    }
+    [[nodiscard]] uint64_t _take(HandleMap &map, uint64_t handle, std::string_view what) noexcept {
+        auto h = _map(map, handle, what);
+        map.erase(handle);
+        return h;
+    }
+    [[nodiscard]] void *_host_buffer(size_t size) noexcept {
+        return _host_buffers.emplace_back(size).data();
+    }
+    [[nodiscard]] std::span<const float4x4> _transforms(std::span<const std::byte> bytes) noexcept {
+        auto &&t = _instance_transforms.emplace_back(bytes.size() / sizeof(float4x4));
+        std::memcpy(t.data(), bytes.data(), bytes.size());
+        return t;
+    }
+
+    [[nodiscard]] Command *_read_command() noexcept {
+        auto &&r = _reader;
+        switch (auto tag = r.read<CaptureCommand>()) {
+            case CaptureCommand::BUFFER_UPLOAD: {
+                auto handle = _map(_buffers, r.read<uint64_t>(), "buffer");
+                auto offset = r.read<size_t>();
+                auto data = r.read_span();
+                return BufferUploadCommand::create(handle, offset, data.size(), data.data());
+            }
+            case CaptureCommand::BUFFER_DOWNLOAD: {
+                auto handle = _map(_buffers, r.read<uint64_t>(), "buffer");
+                auto offset = r.read<size_t>();
+                auto size = r.read<size_t>();
+                return BufferDownloadCommand::create(handle, offset, size, _host_buffer(size));
+            }
+            case CaptureCommand::BUFFER_COPY: {
+                auto src = _map(_buffers, r.read<uint64_t>(), "buffer");
+                auto dst = _map(_buffers, r.read<uint64_t>(), "buffer");
+                auto src_offset = r.read<size_t>();
+                auto dst_offset = r.read<size_t>();
+                return BufferCopyCommand::create(src, dst, src_offset, dst_offset, r.read<size_t>());
+            }
+            case CaptureCommand::BUFFER_TO_TEXTURE_COPY:
+            case CaptureCommand::TEXTURE_TO_BUFFER_COPY: {
+                auto buffer = _map(_buffers, r.read<uint64_t>(), "buffer");
+                auto buffer_offset = r.read<size_t>();
+                auto texture = _map(_textures, r.read<uint64_t>(), "texture");
+                auto storage = r.read<PixelStorage>();
+                auto level = r.read<uint>();
+                auto offset = r.read<uint3>();
+                auto size = r.read<uint3>();
+                if (tag == CaptureCommand::BUFFER_TO_TEXTURE_COPY) {
+                    return BufferToTextureCopyCommand::create(buffer, buffer_offset, texture, storage, level, offset, size);
+                }
+                return TextureToBufferCopyCommand::create(buffer, buffer_offset, texture, storage, level, offset, size);
+            }
+            case CaptureCommand::SHADER_DISPATCH: {
+                auto shader_iter = _shaders.find(r.read<uint64_t>());
+                if (shader_iter == _shaders.cend()) [[unlikely]] {
+                    LUISA_ERROR_WITH_LOCATION("Unknown shader in capture.");
+                }
+                auto [handle, kernel] = shader_iter->second;
+                auto dispatch_size = r.read<uint3>();
+                auto argument_count = r.read<uint64_t>();
+                auto command = ShaderDispatchCommand::create(handle, kernel);
+                for (auto i = 0u; i < argument_count; i++) {
+                    using Tag = ShaderDispatchCommand::Argument::Tag;
+                    auto arg_tag = r.read<Tag>();
+                    auto uid = r.read<uint32_t>();
+                    switch (arg_tag) {
+                        case Tag::BUFFER: {
+                            auto buffer = _map(_buffers, r.read<uint64_t>(), "buffer");
+                            command->encode_buffer(uid, buffer, r.read<size_t>(), kernel.variable_usage(uid));
+                            break;
+                        }
+                        case Tag::TEXTURE:
+                            command->encode_texture(uid, _map(_textures, r.read<uint64_t>(), "texture"), kernel.variable_usage(uid));
+                            break;
+                        case Tag::HEAP: command->encode_heap(uid, _map(_heaps, r.read<uint64_t>(), "heap")); break;
+                        case Tag::ACCEL: command->encode_accel(uid, _map(_accels, r.read<uint64_t>(), "accel")); break;
+                        case Tag::UNIFORM: {
+                            auto data = r.read_span();
+                            auto alignment = 16u;
+                            for (auto arg : kernel.arguments()) {
+                                if (arg.uid() == uid) { alignment = arg.type()->alignment(); }
+                            }
+                            command->encode_uniform(uid, data.data(), data.size(), alignment);
+                            break;
+                        }
+                        default: LUISA_ERROR_WITH_LOCATION("Invalid shader argument in capture.");
+                    }
+                }
+                command->set_dispatch_size(dispatch_size);
+                return command;
+            }
+            case CaptureCommand::TEXTURE_UPLOAD: {
+                auto handle = _map(_textures, r.read<uint64_t>(), "texture");
+                auto storage = r.read<PixelStorage>();
+                auto level = r.read<uint>();
+                auto offset = r.read<uint3>();
+                auto size = r.read<uint3>();
+                return TextureUploadCommand::create(handle, storage, level, offset, size, r.read_span().data());
+            }
+            case CaptureCommand::TEXTURE_DOWNLOAD: {
+                auto handle = _map(_textures, r.read<uint64_t>(), "texture");
+                auto storage = r.read<PixelStorage>();
+                auto level = r.read<uint>();
+                auto offset = r.read<uint3>();
+                auto size = r.read<uint3>();
+                auto data = _host_buffer(pixel_storage_size(storage) * size.x * size.y * size.z);
+                return TextureDownloadCommand::create(handle, storage, level, offset, size, data);
+            }
+            case CaptureCommand::TEXTURE_COPY: {
+                auto src = _map(_textures, r.read<uint64_t>(), "texture");
+                auto dst = _map(_textures, r.read<uint64_t>(), "texture");
+                auto src_level = r.read<uint>();
+                auto dst_level = r.read<uint>();
+                auto src_offset = r.read<uint3>();
+                auto dst_offset = r.read<uint3>();
+                return TextureCopyCommand::create(src, dst, src_level, dst_level, src_offset, dst_offset, r.read<uint3>());
+            }
+            case CaptureCommand::ACCEL_UPDATE: {
+                auto handle = _map(_accels, r.read<uint64_t>(), "accel");
+                auto first = r.read<uint64_t>();
+                auto transforms = r.read_span();
+                if (transforms.empty()) { return AccelUpdateCommand::create(handle); }
+                return AccelUpdateCommand::create(handle, _transforms(transforms), first);
+            }
+            case CaptureCommand::ACCEL_BUILD: {
+                auto handle = _map(_accels, r.read<uint64_t>(), "accel");
+                auto hint = r.read<AccelBuildHint>();
+                auto mesh_bytes = r.read_span();
+                auto &&meshes = _instance_meshes.emplace_back(mesh_bytes.size() / sizeof(uint64_t));
+                std::memcpy(meshes.data(), mesh_bytes.data(), mesh_bytes.size());
+                for (auto &&m : meshes) { m = _map(_meshes, m, "mesh"); }
+                auto transforms = _transforms(r.read_span());
+                return AccelBuildCommand::create(handle, hint, std::span<const uint64_t>{meshes}, transforms);
+            }
+            case CaptureCommand::MESH_UPDATE:
+                return MeshUpdateCommand::create(_map(_meshes, r.read<uint64_t>(), "mesh"));
+            case CaptureCommand::MESH_BUILD: {
+                auto handle = _map(_meshes, r.read<uint64_t>(), "mesh");
+                auto hint = r.read<AccelBuildHint>();
+                auto v_buffer = _map(_buffers, r.read<uint64_t>(), "buffer");
+                auto v_offset = r.read<size_t>();
+                auto v_stride = r.read<size_t>();
+                auto v_count = r.read<size_t>();
+                auto t_buffer = _map(_buffers, r.read<uint64_t>(), "buffer");
+                auto t_offset = r.read<size_t>();
+                auto t_count = r.read<size_t>();
+                return MeshBuildCommand::create(handle, hint, v_buffer, v_offset, v_stride, v_count, t_buffer, t_offset, t_count);
+            }
+        }
+        LUISA_ERROR_WITH_LOCATION("Invalid command in capture.");
+    }
+
+    void _replay_dispatch() noexcept {
+        auto stream = _map(_streams, _reader.read<uint64_t>(), "stream");
+        auto count = _reader.read<uint64_t>();
+        CommandList list;
+        for (auto i = 0u; i < count; i++) { list.append(_read_command()); }
+        Clock clock;
+        _device->dispatch(stream, std::move(list));
+        if (_options.synchronize_each_dispatch) { _device->synchronize_stream(stream); }
+        auto time = clock.toc();
+        _report.dispatch_count++;
+        _report.command_count += count;
+        _report.dispatch_time += time;
+        _report.dispatch_times.emplace_back(time);
+    }
+
+    void _replay_record(Record record) noexcept {
+        auto &&r = _reader;
+        auto d = _device;
+        switch (record) {
+            case Record::CREATE_BUFFER: {
+                auto handle = r.read<uint64_t>();
+                auto size = r.read<size_t>();
+                auto heap = _heap(r.read<uint64_t>());
+                _buffers.emplace(handle, d->create_buffer(size, heap, r.read<uint32_t>()));
+                break;
+            }
+            case Record::DESTROY_BUFFER: d->destroy_buffer(_take(_buffers, r.read<uint64_t>(), "buffer")); break;
+            case Record::CREATE_TEXTURE: {
+                auto handle = r.read<uint64_t>();
+                auto format = r.read<PixelFormat>();
+                auto dimension = r.read<uint>();
+                auto width = r.read<uint>();
+                auto height = r.read<uint>();
+                auto depth = r.read<uint>();
+                auto levels = r.read<uint>();
+                auto sampler = r.read<TextureSampler>();
+                auto heap = _heap(r.read<uint64_t>());
+                auto index = r.read<uint32_t>();
+                _textures.emplace(handle, d->create_texture(format, dimension, width, height, depth, levels, sampler, heap, index));
+                break;
+            }
+            case Record::DESTROY_TEXTURE: d->destroy_texture(_take(_textures, r.read<uint64_t>(), "texture")); break;
+            case Record::CREATE_HEAP: {
+                auto handle = r.read<uint64_t>();
+                _heaps.emplace(handle, d->create_heap(r.read<size_t>()));
+                break;
+            }
+            case Record::DESTROY_HEAP: d->destroy_heap(_take(_heaps, r.read<uint64_t>(), "heap")); break;
+            case Record::CREATE_STREAM: _streams.emplace(r.read<uint64_t>(), d->create_stream()); break;
+            case Record::DESTROY_STREAM: d->destroy_stream(_take(_streams, r.read<uint64_t>(), "stream")); break;
+            case Record::SYNCHRONIZE_STREAM: {
+                auto stream = _map(_streams, r.read<uint64_t>(), "stream");
+                Clock clock;
+                d->synchronize_stream(stream);
+                _report.synchronize_time += clock.toc();
+                break;
+            }
+            case Record::DISPATCH: _replay_dispatch(); break;
+            case Record::KERNEL: {
+                auto hash = r.read<uint64_t>();
+                _kernels.emplace(hash, FunctionSerializer::deserialize_kernel(r.read_span()));
+                break;
+            }
+            case Record::CREATE_SHADER: {
+                auto handle = r.read<uint64_t>();
+                auto hash = r.read<uint64_t>();
+                auto iter = _kernels.find(hash);
+                if (iter == _kernels.cend()) [[unlikely]] {
+                    LUISA_ERROR_WITH_LOCATION("Unknown kernel #{} in capture.", hash_to_string(hash));
+                }
+                auto kernel = iter->second->function();
+                _shaders.emplace(handle, Shader{d->create_shader(kernel), kernel});
+                break;
+            }
+            case Record::DESTROY_SHADER: {
+                auto iter = _shaders.find(r.read<uint64_t>());
+                if (iter == _shaders.cend()) [[unlikely]] {
+                    LUISA_ERROR_WITH_LOCATION("Unknown shader in capture.");
+                }
+                d->destroy_shader(iter->second.handle);
+                _shaders.erase(iter);
+                break;
+            }
+            case Record::CREATE_EVENT: _events.emplace(r.read<uint64_t>(), d->create_event()); break;
+            case Record::DESTROY_EVENT: d->destroy_event(_take(_events, r.read<uint64_t>(), "event")); break;
+            case Record::SIGNAL_EVENT: {
+                auto event = _map(_events, r.read<uint64_t>(), "event");
+                d->signal_event(event, _map(_streams, r.read<uint64_t>(), "stream"));
+                break;
+            }
+            case Record::WAIT_EVENT: {
+                auto event = _map(_events, r.read<uint64_t>(), "event");
+                d->wait_event(event, _map(_streams, r.read<uint64_t>(), "stream"));
+                break;
+            }
+            case Record::SYNCHRONIZE_EVENT: {
+                auto event = _map(_events, r.read<uint64_t>(), "event");
+                Clock clock;
+                d->synchronize_event(event);
+                _report.synchronize_time += clock.toc();
+                break;
+            }
+            case Record::CREATE_MESH: _meshes.emplace(r.read<uint64_t>(), d->create_mesh()); break;
+            case Record::DESTROY_MESH: d->destroy_mesh(_take(_meshes, r.read<uint64_t>(), "mesh")); break;
+            case Record::CREATE_ACCEL: _accels.emplace(r.read<uint64_t>(), d->create_accel()); break;
+            case Record::DESTROY_ACCEL: d->destroy_accel(_take(_accels, r.read<uint64_t>(), "accel")); break;
+            default: LUISA_ERROR_WITH_LOCATION("Invalid record {} in capture.", to_underlying(record));
+        }
+    }
+
+    void _release() noexcept {
+        for (auto [_, s] : _streams) { _device->synchronize_stream(s); }
+        for (auto [_, s] : _shaders) { _device->destroy_shader(s.handle); }
+        for (auto [_, a] : _accels) { _device->destroy_accel(a); }
+        for (auto [_, m] : _meshes) { _device->destroy_mesh(m); }
+        for (auto [_, b] : _buffers) { _device->destroy_buffer(b); }
+        for (auto [_, t] : _textures) { _device->destroy_texture(t); }
+        for (auto [_, h] : _heaps) { _device->destroy_heap(h); }
+        for (auto [_, e] : _events) { _device->destroy_event(e); }
+        for (auto [_, s] : _streams) { _device->destroy_stream(s); }
+    }
+
+public:
+    CaptureReplay(Device::Interface *device, std::span<const std::byte> data, CaptureReplayer::Options options) noexcept
+        : _device{device}, _reader{data}, _options{options} {}
+
+    [[nodiscard]] auto run() noexcept {
+        if (_reader.read<uint64_t>() != CaptureDevice::magic) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid capture file.");
+        }
+        if (auto v = _reader.read<uint32_t>(); v != CaptureDevice::version) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Unsupported capture version {} (expected {}).",
+                v, CaptureDevice::version);
+        }
+        Clock clock;
+        while (!_reader.exhausted()) {
+            _replay_record(_reader.read<Record>());
+            _report.record_count++;
+        }
+        // resources the captured program did not release before exiting
+        _release();
+        _report.total_time = clock.toc();
+        return std::move(_report);
+    }
+};
+
+}// namespace detail
+
+CaptureReplayer::Report CaptureReplayer::replay(Device device, const std::filesystem::path &path, Options options) noexcept {
+    auto mapping = memory_map_file(path);
+    auto report = detail::CaptureReplay{device.impl().get(), mapping, options}.run();
+    memory_unmap_file(mapping);
+    LUISA_INFO(
+        "Replayed {} records with {} dispatches ({} commands) from '{}' in {} ms "
+        "(dispatch: {} ms, synchronize: {} ms).",
+        report.record_count, report.dispatch_count, report.command_count, path.string(),
+        report.total_time, report.dispatch_time, report.synchronize_time);
+    return report;
+}
+
+}// namespace luisa::compute
@@ -0,0 +1,130 @@
+//
+// Created by Mike Smith on 2021/9/8.
+//
+
+#pragma once
+
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include <unordered_set>
+#include <vector>
+
+#include <runtime/device.h>
+
+namespace luisa::compute {
+
+// Wraps another device and records every call made through the interface,
+// with upload payloads and the ASTs of created shaders, into a capture file
+// that CaptureReplayer can re-issue against any backend. Handles are
+// recorded as returned by the wrapped device and remapped on replay, so
+// captured kernels should take resources as arguments: resources captured
+// inside kernel ASTs keep their original handles.
+class CaptureDevice final : public Device::Interface {
+
+public:
+    static constexpr uint64_t magic = 0x4552555450414343ull;// "CCAPTURE"
+    static constexpr uint32_t version = 1u;
+
+    enum struct Record : uint32_t {
+        CREATE_BUFFER,
+        DESTROY_BUFFER,
+        CREATE_TEXTURE,
+        DESTROY_TEXTURE,
+        CREATE_HEAP,
+        DESTROY_HEAP,
+        CREATE_STREAM,
+        DESTROY_STREAM,
+        SYNCHRONIZE_STREAM,
+        DISPATCH,
+        KERNEL,// serialized AST, once per kernel hash
+        CREATE_SHADER,
+        DESTROY_SHADER,
+        CREATE_EVENT,
+        DESTROY_EVENT,
+        SIGNAL_EVENT,
+        WAIT_EVENT,
+        SYNCHRONIZE_EVENT,
+        CREATE_MESH,
+        DESTROY_MESH,
+        CREATE_ACCEL,
+        DESTROY_ACCEL
+    };
+
+private:
+    Device::Handle _device;
+    std::ofstream _file;
+    std::unordered_set<uint64_t> _recorded_kernels;
+    std::mutex _mutex;
+
+private:
+    template<typename... T>
+    void _record(Record record, T... fields) noexcept;
+    void _write(std::span<const std::byte> bytes) noexcept;
+    void _record_dispatch(uint64_t stream_handle, const CommandList &list) noexcept;
+
+public:
+    CaptureDevice(Device::Handle device, const std::filesystem::path &path) noexcept;
+    ~CaptureDevice() noexcept override;
+    [[nodiscard]] static Device create(Device device, const std::filesystem::path &path) noexcept;
+    std::string device_name() const noexcept override;
+    uint64_t create_buffer(size_t size_bytes, uint64_t heap_handle, uint32_t index_in_heap) noexcept override;
+    void destroy_buffer(uint64_t handle) noexcept override;
+    MappedBufferAccess mapped_buffer_access() const noexcept override;
+    uint64_t create_mapped_buffer(size_t size_bytes) noexcept override;
+    void *mapped_buffer_address(uint64_t handle) noexcept override;
+    bool file_buffers_supported() const noexcept override;
+    uint64_t create_file_buffer(std::span<const std::byte> mapping) noexcept override;
+    uint64_t create_texture(PixelFormat format, uint dimension, uint width, uint height, uint depth, uint mipmap_levels, TextureSampler sampler, uint64_t heap_handle, uint32_t index_in_heap) override;
+    void destroy_texture(uint64_t handle) noexcept override;
+    uint64_t create_heap(size_t size) noexcept override;
+    size_t query_heap_memory_usage(uint64_t handle) noexcept override;
+    void destroy_heap(uint64_t handle) noexcept override;
+    uint64_t create_stream() noexcept override;
+    void destroy_stream(uint64_t handle) noexcept override;
+    void synchronize_stream(uint64_t stream_handle) noexcept override;
+    void dispatch(uint64_t stream_handle, CommandList list) noexcept override;
+    void dispatch_profiled(uint64_t stream_handle, CommandList list, TimestampCallback callback) noexcept override;
+    uint64_t create_shader(Function kernel) noexcept override;
+    void destroy_shader(uint64_t handle) noexcept override;
+    uint32_t shader_max_block_threads(uint64_t handle) noexcept override;
+    uint64_t create_event() noexcept override;
+    void destroy_event(uint64_t handle) noexcept override;
+    void signal_event(uint64_t handle, uint64_t stream_handle) noexcept override;
+    void wait_event(uint64_t handle, uint64_t stream_handle) noexcept override;
+    void synchronize_event(uint64_t handle) noexcept override;
+    bool query_event(uint64_t handle) noexcept override;
+    uint64_t create_mesh() noexcept override;
+    void destroy_mesh(uint64_t handle) noexcept override;
+    uint64_t create_accel() noexcept override;
+    void destroy_accel(uint64_t handle) noexcept override;
+};
+
+// Re-issues a capture against a device, timing the dispatches.
+class CaptureReplayer {
+
+public:
+    struct Options {
+        // synchronizes the stream after each dispatch, so that dispatch
+        // times include execution instead of only enqueueing
+        bool synchronize_each_dispatch{false};
+    };
+
+    struct Report {
+        size_t record_count{0u};
+        size_t dispatch_count{0u};
+        size_t command_count{0u};
+        double total_time{0.0};      // in milliseconds
+        double dispatch_time{0.0};   // in milliseconds
+        double synchronize_time{0.0};// in milliseconds
+        std::vector<double> dispatch_times;
+    };
+
+public:
+    [[nodiscard]] static Report replay(Device device, const std::filesystem::path &path, Options options) noexcept;
+    [[nodiscard]] static Report replay(Device device, const std::filesystem::path &path) noexcept {
+        return replay(std::move(device), path, Options{});
+    }
+};
+
+}// namespace luisa::compute
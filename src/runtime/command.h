@@ -63,10 +63,8 @@ LUISA_MAP(LUISA_MAKE_COMMAND_POOL_DECL, LUISA_ALL_COMMANDS)
 #define LUISA_MAKE_COMMAND_COMMON_CREATE(Cmd)                                    \
     template<typename... Args>                                                   \
     [[nodiscard]] static auto create(Args &&...args) noexcept {                  \
-        Clock clock;                                                             \
         auto command = detail::pool_##Cmd().create(std::forward<Args>(args)...); \
-        LUISA_VERBOSE_WITH_LOCATION(                                             \
-            "Created {} in {} ms.", #Cmd, clock.toc());                          \
+        LUISA_TRACE("Created " #Cmd " at address {:#x}.", command);              \
         return command;                                                          \
     }
 
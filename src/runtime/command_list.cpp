@@ -26,6 +26,16 @@ void CommandList::append(Command *cmd) noexcept {
     }
 }
 
+Command *CommandList::pop_front() noexcept {
+    auto cmd = _head;
+    if (cmd != nullptr) {
+        _head = cmd->_next();
+        if (_head == nullptr) { _tail = nullptr; }
+        cmd->_next_command = nullptr;
+    }
+    return cmd;
+}
+
 CommandList::CommandList(CommandList &&another) noexcept
     : _head{another._head},
       _tail{another._tail} {
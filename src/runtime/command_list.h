@@ -19,11 +19,11 @@ public:
 
     public:
         explicit Iterator(Command *cmd) noexcept : _command{cmd} {}
-        [[nodiscard]] decltype(auto) operator++() noexcept {
+        decltype(auto) operator++() noexcept {
             _command = _command->_next();
             return (*this);
         }
-        [[nodiscard]] auto operator++(int) noexcept {
+        auto operator++(int) noexcept {
             auto self = *this;
             _command = _command->_next();
             return self;
@@ -45,6 +45,8 @@ public:
     CommandList &operator=(CommandList &&rhs) noexcept;
 
     void append(Command *cmd) noexcept;
+    // detaches the first command, nullptr if empty
+    [[nodiscard]] Command *pop_front() noexcept;
     [[nodiscard]] auto begin() const noexcept { return Iterator{_head}; }
     [[nodiscard]] auto end() const noexcept { return Iterator{nullptr}; }
     [[nodiscard]] auto empty() const noexcept { return _head == nullptr; }
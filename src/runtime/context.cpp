@@ -4,6 +4,7 @@
 
 #include <core/logging.h>
 #include <runtime/context.h>
+#include <runtime/destruction_queue.h>
 
 namespace luisa::compute {
 
@@ -48,7 +49,10 @@ Device Context::create_device(std::string_view backend_name, uint32_t index) noe
         _device_deleters.emplace_back(destroy);
         return std::make_pair(create, destroy);
     }();
-    return Device{Device::Handle{create(*this, index), destroy}};
+    return Device{Device::Handle{create(*this, index), [destroy](Device::Interface *device) noexcept {
+                      device->destruction_queue().flush();
+                      destroy(device);
+                  }}};
 }
 
 }// namespace luisa::compute
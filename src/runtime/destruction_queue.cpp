@@ -0,0 +1,295 @@
+//
+// Created by Mike Smith on 2021/9/14.
+//
+
+#include <utility>
+#include <iterator>
+#include <algorithm>
+
+#include <core/logging.h>
+#include <runtime/command_list.h>
+#include <runtime/destruction_queue.h>
+
+namespace luisa::compute {
+
+DestructionQueue::DestructionQueue(Device::Interface *device) noexcept
+    : _device{device} {}
+
+DestructionQueue::~DestructionQueue() noexcept {
+    // the backend is gone by now, so pending resources can only be reported
+    if (auto n = pending_count(); n != 0u) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Leaking {} resources pending destruction. "
+            "Did you forget to flush the destruction queue?",
+            n);
+    }
+}
+
+namespace detail {
+
+// gathers the resources used by commands, i.e. their bindings along with
+// the shaders, meshes and accels they refer to without binding them
+class CommandUseCollector final : public CommandVisitor {
+
+private:
+    std::vector<DestructionQueue::Use> &_uses;
+    size_t _previous_count{0u};
+
+private:
+    void _use(ResourceTag tag, uint64_t handle) noexcept {
+        _uses.emplace_back(DestructionQueue::Use{tag, handle});
+    }
+
+public:
+    explicit CommandUseCollector(std::vector<DestructionQueue::Use> &uses) noexcept : _uses{uses} {}
+    void collect(const Command *command) noexcept {
+        auto first = _uses.size();
+        for (auto b : command->resources()) {
+            switch (b.tag) {
+                case Command::Binding::Tag::BUFFER: _use(ResourceTag::BUFFER, b.handle); break;
+                case Command::Binding::Tag::TEXTURE: _use(ResourceTag::TEXTURE, b.handle); break;
+                case Command::Binding::Tag::HEAP: _use(ResourceTag::HEAP, b.handle); break;
+                case Command::Binding::Tag::ACCEL: _use(ResourceTag::ACCEL, b.handle); break;
+                default: break;
+            }
+        }
+        command->accept(*this);
+        // repeated commands, e.g. dispatches of a shader with the same arguments, are recorded once
+        auto count = _uses.size() - first;
+        if (count == _previous_count && count <= first &&
+            std::equal(_uses.cbegin() + first, _uses.cend(), _uses.cbegin() + (first - count),
+                       [](auto lhs, auto rhs) noexcept { return lhs.handle == rhs.handle && lhs.tag == rhs.tag; })) {
+            _uses.erase(_uses.cbegin() + first, _uses.cend());
+        } else {
+            _previous_count = count;
+        }
+    }
+    void visit(const BufferUploadCommand *) noexcept override {}
+    void visit(const BufferDownloadCommand *) noexcept override {}
+    void visit(const BufferCopyCommand *) noexcept override {}
+    void visit(const BufferToTextureCopyCommand *) noexcept override {}
+    void visit(const ShaderDispatchCommand *command) noexcept override { _use(ResourceTag::SHADER, command->handle()); }
+    void visit(const TextureUploadCommand *) noexcept override {}
+    void visit(const TextureDownloadCommand *) noexcept override {}
+    void visit(const TextureCopyCommand *) noexcept override {}
+    void visit(const TextureToBufferCopyCommand *) noexcept override {}
+    void visit(const AccelUpdateCommand *command) noexcept override { _use(ResourceTag::ACCEL, command->handle()); }
+    void visit(const AccelBuildCommand *command) noexcept override {
+        _use(ResourceTag::ACCEL, command->handle());
+        for (auto mesh : command->instance_mesh_handles()) { _use(ResourceTag::MESH, mesh); }
+    }
+    void visit(const MeshUpdateCommand *command) noexcept override { _use(ResourceTag::MESH, command->handle()); }
+    void visit(const MeshBuildCommand *command) noexcept override {
+        _use(ResourceTag::MESH, command->handle());
+        _use(ResourceTag::BUFFER, command->vertex_buffer_handle());
+        _use(ResourceTag::BUFFER, command->triangle_buffer_handle());
+    }
+};
+
+}// namespace detail
+
+std::span<const DestructionQueue::Use> DestructionQueue::collect(const CommandList &list) noexcept {
+    static thread_local std::vector<Use> uses;
+    uses.clear();
+    detail::CommandUseCollector collector{uses};
+    for (auto command : list) { collector.collect(command); }
+    return uses;
+}
+
+void DestructionQueue::on_dispatch(uint64_t stream_handle, std::span<const Use> uses) noexcept {
+    // nothing to destroy waits for lists without resources
+    if (uses.empty()) { return; }
+    auto has_fences = [&] {
+        std::scoped_lock lock{_mutex};
+        auto ticket = ++_ticket;
+        auto &&s = _streams.try_emplace(stream_handle, StreamState{ticket, 0u, 0u, 0u, false}).first->second;
+        s.dispatched = ticket;
+        for (auto u : uses) {
+            _last_uses[static_cast<uint32_t>(u.tag)].insert_or_assign(u.handle, LastUse{stream_handle, ticket});
+        }
+        return !_fences.empty();
+    }();
+    if (has_fences) { reclaim(); }
+}
+
+void DestructionQueue::on_synchronize(uint64_t stream_handle) noexcept {
+    auto has_fences = [&] {
+        std::scoped_lock lock{_mutex};
+        if (auto iter = _streams.find(stream_handle); iter != _streams.end()) {
+            iter->second.completed = iter->second.dispatched;
+        }
+        return !_fences.empty();
+    }();
+    if (has_fences) { reclaim(); }
+}
+
+bool DestructionQueue::_is_completed(LastUse use) const noexcept {
+    auto iter = _streams.find(use.stream);
+    return iter == _streams.end() ||
+           use.ticket < iter->second.created ||
+           use.ticket <= iter->second.completed;
+}
+
+uint64_t DestructionQueue::_signal(uint64_t stream_handle, StreamState &s) noexcept {
+    auto event = [this] {
+        if (_idle_events.empty()) { return _device->create_event(); }
+        auto e = _idle_events.back();
+        _idle_events.pop_back();
+        return e;
+    }();
+    _device->signal_event(event, stream_handle);
+    s.fenced = s.dispatched;
+    _fences.emplace_back(Fence{event, stream_handle, s.fenced, {}});
+    return event;
+}
+
+void DestructionQueue::_on_fence_passed(const Fence &f) noexcept {
+    if (auto iter = _streams.find(f.stream); iter != _streams.end()) {
+        auto &&s = iter->second;
+        s.completed = std::max(s.completed, f.ticket);
+        if (s.destroyed && s.completed >= s.dispatched) { _streams.erase(iter); }
+    }
+}
+
+void DestructionQueue::_destroy_now(ResourceTag tag, uint64_t handle) noexcept {
+    switch (tag) {
+        case ResourceTag::BUFFER: _device->destroy_buffer(handle); break;
+        case ResourceTag::TEXTURE: _device->destroy_texture(handle); break;
+        case ResourceTag::HEAP: _device->destroy_heap(handle); break;
+        case ResourceTag::MESH: _device->destroy_mesh(handle); break;
+        case ResourceTag::ACCEL: _device->destroy_accel(handle); break;
+        case ResourceTag::STREAM: _device->destroy_stream(handle); break;
+        case ResourceTag::EVENT: _device->destroy_event(handle); break;
+        case ResourceTag::SHADER: _device->destroy_shader(handle); break;
+    }
+}
+
+bool DestructionQueue::_defer(Entry entry, LastUse use) noexcept {
+    // uses on one stream are covered by the later one, uses on two streams are waited for one after another
+    if (_is_completed(use)) { use = std::exchange(entry.then, LastUse{}); }
+    if (_is_completed(entry.then)) {
+        entry.then = {};
+    } else if (entry.then.stream == use.stream) {
+        use.ticket = std::max(use.ticket, entry.then.ticket);
+        entry.then = {};
+    }
+    if (_is_completed(use)) { return false; }
+    // fence both uses now, rather than the second one only after the first has passed
+    for (auto u : {use, entry.then}) {
+        if (u.ticket != 0u) {
+            if (auto &&s = _streams.at(u.stream); s.fenced < u.ticket) {
+                static_cast<void>(_signal(u.stream, s));
+            }
+        }
+    }
+    // the earliest fence covering the use
+    auto fence = std::find_if(_fences.begin(), _fences.end(), [use](auto &&f) noexcept {
+        return f.stream == use.stream && f.ticket >= use.ticket;
+    });
+    fence->entries.emplace_back(entry);
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Deferred destruction of resource #{} until fence #{} on stream #{}.",
+        entry.handle, fence->event, use.stream);
+    return true;
+}
+
+void DestructionQueue::_destroy(ResourceTag tag, uint64_t handle, LastUse owner_use) noexcept {
+    auto deferred = [&] {
+        std::scoped_lock lock{_mutex};
+        if (tag == ResourceTag::STREAM) {
+            // fence the remaining work, so that later destroys never signal the dead stream
+            if (auto iter = _streams.find(handle); iter != _streams.end()) {
+                auto &&s = iter->second;
+                if (s.completed >= s.dispatched) {
+                    _streams.erase(iter);
+                } else {
+                    if (s.fenced < s.dispatched) { static_cast<void>(_signal(handle, s)); }
+                    s.destroyed = true;
+                }
+            }
+            return false;
+        }
+        auto &&uses = _last_uses[static_cast<uint32_t>(tag)];
+        auto use = LastUse{};
+        if (auto iter = uses.find(handle); iter != uses.end()) {
+            use = iter->second;
+            uses.erase(iter);
+        }
+        return _defer(Entry{tag, handle, owner_use}, use);
+    }();
+    if (!deferred) { _destroy_now(tag, handle); }
+    reclaim();
+}
+
+void DestructionQueue::destroy(ResourceTag tag, uint64_t handle) noexcept {
+    _destroy(tag, handle, LastUse{});
+}
+
+void DestructionQueue::destroy_after(ResourceTag tag, uint64_t handle, ResourceTag owner_tag, uint64_t owner_handle) noexcept {
+    auto owner_use = [&] {
+        std::scoped_lock lock{_mutex};
+        auto &&uses = _last_uses[static_cast<uint32_t>(owner_tag)];
+        auto iter = uses.find(owner_handle);
+        return iter == uses.end() ? LastUse{} : iter->second;
+    }();
+    _destroy(tag, handle, owner_use);
+}
+
+void DestructionQueue::reclaim() noexcept {
+    std::vector<Entry> ready;
+    {
+        std::scoped_lock lock{_mutex};
+        if (_fences.empty()) { return; }
+        // fences on a stream pass in order, so skip the stream after its first pending one
+        std::vector<uint64_t> blocked_streams;
+        auto passed = [&](Fence &f) noexcept {
+            if (std::find(blocked_streams.cbegin(), blocked_streams.cend(), f.stream) != blocked_streams.cend() ||
+                !_device->query_event(f.event)) {
+                blocked_streams.emplace_back(f.stream);
+                return false;
+            }
+            std::move(f.entries.begin(), f.entries.end(), std::back_inserter(ready));
+            _idle_events.emplace_back(f.event);
+            _on_fence_passed(f);
+            return true;
+        };
+        _fences.erase(std::remove_if(_fences.begin(), _fences.end(), passed), _fences.end());
+        // entries still waiting for another stream go to its fence
+        std::erase_if(ready, [this](auto &&e) noexcept { return _defer(Entry{e.tag, e.handle, {}}, e.then); });
+    }
+    for (auto e : ready) { _destroy_now(e.tag, e.handle); }
+}
+
+void DestructionQueue::flush() noexcept {
+    std::vector<Entry> ready;
+    std::vector<uint64_t> events;
+    {
+        std::scoped_lock lock{_mutex};
+        // entries waiting for another stream add fences meanwhile
+        while (!_fences.empty()) {
+            auto fences = std::exchange(_fences, {});
+            std::vector<Entry> passed;
+            for (auto &&f : fences) {
+                _device->synchronize_event(f.event);
+                std::move(f.entries.begin(), f.entries.end(), std::back_inserter(passed));
+                events.emplace_back(f.event);
+                _on_fence_passed(f);
+            }
+            std::erase_if(passed, [this](auto &&e) noexcept { return _defer(Entry{e.tag, e.handle, {}}, e.then); });
+            ready.insert(ready.end(), passed.cbegin(), passed.cend());
+        }
+        events.insert(events.end(), _idle_events.cbegin(), _idle_events.cend());
+        _idle_events.clear();
+    }
+    for (auto e : ready) { _destroy_now(e.tag, e.handle); }
+    for (auto e : events) { _device->destroy_event(e); }
+}
+
+size_t DestructionQueue::pending_count() const noexcept {
+    std::scoped_lock lock{_mutex};
+    size_t count = 0u;
+    for (auto &&f : _fences) { count += f.entries.size(); }
+    return count;
+}
+
+}// namespace luisa::compute
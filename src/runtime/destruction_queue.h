@@ -0,0 +1,108 @@
+//
+// Created by Mike Smith on 2021/9/14.
+//
+
+#pragma once
+
+#include <span>
+#include <array>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+#include <runtime/command.h>
+#include <runtime/device.h>
+
+namespace luisa::compute {
+
+// Per-device queue of stream-ordered resource destruction (see Resource).
+//
+// Streams report the resources their commands use (the bound resources, the
+// dispatched shaders, the built meshes and accels along with the instanced
+// meshes) and the events they signal or wait, which gives every resource the
+// stream and submission of its last use. Destroying a resource while that
+// submission may still be in flight signals (or joins) a fence event on the
+// stream and hands the handle to the backend only once the event has passed,
+// which is polled without blocking on later dispatches, destroys and
+// synchronizations. Heap slots wait for the last use of the heap as well,
+// since bindless dispatches bind the heap only. Resources never used by
+// streams are destroyed right away.
+//
+// Thread-safe, but a stream must not be dispatched to from several threads
+// at once (as for Stream itself).
+class DestructionQueue {
+
+public:
+    struct Use {
+        ResourceTag tag;
+        uint64_t handle;
+    };
+
+private:
+    struct LastUse {
+        uint64_t stream;
+        uint64_t ticket;
+    };
+
+    struct StreamState {
+        uint64_t created;   // ticket of the first dispatch, older tickets belong to a destroyed stream with the same handle
+        uint64_t dispatched;// ticket of the last dispatch
+        uint64_t fenced;    // ticket covered by the last fence signaled on the stream
+        uint64_t completed; // ticket known to be completed
+        bool destroyed;
+    };
+
+    struct Entry {
+        ResourceTag tag;
+        uint64_t handle;
+        LastUse then;// a use on another stream to wait for after the fence, ticket 0 if none
+    };
+
+    struct Fence {
+        uint64_t event;
+        uint64_t stream;
+        uint64_t ticket;
+        std::vector<Entry> entries;
+    };
+
+private:
+    Device::Interface *_device;
+    mutable std::mutex _mutex;
+    uint64_t _ticket{0u};
+    std::array<std::unordered_map<uint64_t, LastUse>, resource_tag_count> _last_uses;
+    std::unordered_map<uint64_t, StreamState> _streams;
+    std::vector<Fence> _fences;
+    std::vector<uint64_t> _idle_events;
+
+private:
+    [[nodiscard]] bool _is_completed(LastUse use) const noexcept;
+    [[nodiscard]] uint64_t _signal(uint64_t stream_handle, StreamState &s) noexcept;
+    [[nodiscard]] bool _defer(Entry entry, LastUse use) noexcept;
+    void _on_fence_passed(const Fence &f) noexcept;
+    void _destroy(ResourceTag tag, uint64_t handle, LastUse owner_use) noexcept;
+    void _destroy_now(ResourceTag tag, uint64_t handle) noexcept;
+
+public:
+    explicit DestructionQueue(Device::Interface *device) noexcept;
+    ~DestructionQueue() noexcept;
+    DestructionQueue(DestructionQueue &&) noexcept = delete;
+    DestructionQueue &operator=(DestructionQueue &&) noexcept = delete;
+
+    // gathers the resources used by the commands into a thread-local buffer, valid until the next call on the thread
+    [[nodiscard]] static std::span<const Use> collect(const CommandList &list) noexcept;
+    // to be called after the commands (or event operations) are submitted, so that fences signaled meanwhile do not cover them
+    void on_dispatch(uint64_t stream_handle, std::span<const Use> uses) noexcept;
+    void on_synchronize(uint64_t stream_handle) noexcept;
+    // destroys the resource once the last stream using it has passed the use
+    void destroy(ResourceTag tag, uint64_t handle) noexcept;
+    // destroys the resource once the last uses of both itself and its owner have passed,
+    // e.g. for heap slots, which bindless dispatches use through the heap binding only
+    void destroy_after(ResourceTag tag, uint64_t handle, ResourceTag owner_tag, uint64_t owner_handle) noexcept;
+    // destroys the resources whose fences have passed, never blocks
+    void reclaim() noexcept;
+    // waits for all fences and destroys the resources, must be called before the device is deleted
+    void flush() noexcept;
+    [[nodiscard]] size_t pending_count() const noexcept;
+};
+
+}// namespace luisa::compute
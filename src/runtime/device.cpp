@@ -0,0 +1,13 @@
+//
+// Created by Mike Smith on 2021/9/21.
+//
+
+#include <runtime/device.h>
+#include <runtime/destruction_queue.h>
+
+namespace luisa::compute {
+
+Device::Interface::Interface(const Context &ctx) noexcept
+    : _ctx{ctx}, _destruction_queue{std::make_shared<DestructionQueue>(this)} {}
+
+}// namespace luisa::compute
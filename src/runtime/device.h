@@ -6,18 +6,26 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <span>
+#include <limits>
 #include <memory>
+#include <vector>
 #include <functional>
+#include <string>
+#include <filesystem>
+#include <string_view>
 
 #include <util/arena.h>
 #include <core/concepts.h>
 #include <ast/function.h>
 #include <runtime/pixel.h>
+#include <runtime/resource_tracker.h>
 #include <runtime/command_list.h>
 
 namespace luisa::compute {
 
 class Context;
+class DestructionQueue;
 
 class Event;
 class Stream;
@@ -45,6 +53,28 @@ namespace detail {
 class FunctionBuilder;
 }
 
+// memory buffers are created in, see Device::create_buffer()
+enum struct BufferMemory : uint32_t {
+    DEVICE,     // device-local, reached by the host only through commands
+    HOST_MAPPED,// host-visible and persistently mapped, see Buffer<T>::mapped()
+};
+
+// how devices access host-mapped buffers, see Device::mapped_buffer_access()
+enum struct MappedBufferAccess : uint32_t {
+    NONE,   // not supported
+    REMOTE, // over the bus, e.g., pinned host memory for discrete GPUs, best for data read once
+    UNIFIED,// as fast as device-local memory, e.g., for CPU backends and unified memory
+};
+
+// execution interval of a command, in nanoseconds on the host clock (see Clock::timestamp())
+struct CommandTimestamps {
+    uint64_t start;
+    uint64_t end;
+    // timed on the host around a synchronization after the command, which serializes
+    // the stream and includes the submission latency in the interval
+    bool host_synchronous{false};
+};
+
 class Device {
 
 public:
@@ -52,12 +82,23 @@ public:
 
     private:
         const Context &_ctx;
+        ResourceTracker _resource_tracker;
+        std::shared_ptr<DestructionQueue> _destruction_queue;
 
     public:
-        explicit Interface(const Context &ctx) noexcept : _ctx{ctx} {}
+        explicit Interface(const Context &ctx) noexcept;// see definition in runtime/device.cpp
         virtual ~Interface() noexcept = default;
 
         [[nodiscard]] const Context &context() const noexcept { return _ctx; }
+        // updated by Resource, see runtime/resource_tracker.h
+        [[nodiscard]] ResourceTracker &resource_tracker() noexcept { return _resource_tracker; }
+        // defers destroying resources until streams have finished with them, see runtime/destruction_queue.h;
+        // must be flushed by the deleter of the device
+        [[nodiscard]] DestructionQueue &destruction_queue() noexcept { return *_destruction_queue; }
+
+        // identifies the physical device and its driver, e.g. for caches of tuning results,
+        // optional for backends: an empty name stands for any device of the backend
+        [[nodiscard]] virtual std::string device_name() const noexcept { return {}; }
 
         // buffer
         [[nodiscard]] virtual uint64_t create_buffer(
@@ -66,6 +107,19 @@ public:
             uint32_t index_in_heap) noexcept = 0;
         virtual void destroy_buffer(uint64_t handle) noexcept = 0;
 
+        // host-mapped buffers, optional for backends: they are destroyed with destroy_buffer()
+        // and stay mapped at mapped_buffer_address() until then; the default has no support
+        [[nodiscard]] virtual MappedBufferAccess mapped_buffer_access() const noexcept { return MappedBufferAccess::NONE; }
+        [[nodiscard]] virtual uint64_t create_mapped_buffer(size_t size_bytes) noexcept {
+            return create_buffer(size_bytes, std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint32_t>::max());
+        }
+        [[nodiscard]] virtual void *mapped_buffer_address(uint64_t /* handle */) noexcept { return nullptr; }
+        // read-only buffers over file mappings (see memory_map_file() in core/platform.h), optional for
+        // backends whose kernels read host memory in place, e.g., CPU ones: the backend takes over the
+        // mapping and unmaps it in destroy_buffer(); the default has no support
+        [[nodiscard]] virtual bool file_buffers_supported() const noexcept { return false; }
+        [[nodiscard]] virtual uint64_t create_file_buffer(std::span<const std::byte> /* mapping */) noexcept { return 0u; }
+
         // texture
         [[nodiscard]] virtual uint64_t create_texture(
             PixelFormat format, uint dimension,
@@ -87,9 +141,28 @@ public:
         virtual void synchronize_stream(uint64_t stream_handle) noexcept = 0;
         virtual void dispatch(uint64_t stream_handle, CommandList) noexcept = 0;
 
+        // profiled dispatch (see runtime/stream_profiler.h), optional for backends: the callback
+        // receives the timestamps of the commands in list order once they have executed; the
+        // default (in runtime/stream_profiler.cpp) submits and waits for the commands one by one
+        // and reports host-synchronous timestamps
+        using TimestampCallback = std::function<void(std::span<const CommandTimestamps>)>;
+        virtual void dispatch_profiled(uint64_t stream_handle, CommandList list, TimestampCallback callback) noexcept;
+
         // kernel
         virtual uint64_t create_shader(Function kernel) noexcept = 0;
         virtual void destroy_shader(uint64_t handle) noexcept = 0;
+        // the largest number of threads per block the shader can be dispatched with, given the limits
+        // of the device and of the compiled kernel (registers, etc.), optional for backends
+        [[nodiscard]] virtual uint32_t shader_max_block_threads(uint64_t /* handle */) noexcept { return 1024u; }
+
+        // precompiled shader binaries (see runtime/kernel_archive.h), optional for backends:
+        // an empty format means no support, and binaries must only be loaded by devices with
+        // the same format; the default falls back to compiling the kernel
+        [[nodiscard]] virtual std::string_view shader_binary_format() const noexcept { return {}; }
+        [[nodiscard]] virtual std::vector<std::byte> shader_binary(uint64_t /* handle */) noexcept { return {}; }
+        [[nodiscard]] virtual uint64_t create_shader_from_binary(Function kernel, std::span<const std::byte> /* binary */) noexcept {
+            return create_shader(kernel);
+        }
 
         // event
         [[nodiscard]] virtual uint64_t create_event() noexcept = 0;
@@ -97,6 +170,12 @@ public:
         virtual void signal_event(uint64_t handle, uint64_t stream_handle) noexcept = 0;
         virtual void wait_event(uint64_t handle, uint64_t stream_handle) noexcept = 0;
         virtual void synchronize_event(uint64_t handle) noexcept = 0;
+        // non-blocking: whether the work before the last signal has completed, optional
+        // for backends; the default waits for the event and always returns true
+        [[nodiscard]] virtual bool query_event(uint64_t handle) noexcept {
+            synchronize_event(handle);
+            return true;
+        }
 
         // accel
         virtual uint64_t create_mesh() noexcept = 0;
@@ -122,6 +201,11 @@ public:
         : _impl{std::move(handle)} {}
 
     [[nodiscard]] decltype(auto) context() const noexcept { return _impl->context(); }
+    [[nodiscard]] auto &impl() const noexcept { return _impl; }
+    [[nodiscard]] auto shader_binary_format() const noexcept { return _impl->shader_binary_format(); }
+    [[nodiscard]] auto mapped_buffer_access() const noexcept { return _impl->mapped_buffer_access(); }
+    [[nodiscard]] auto file_buffers_supported() const noexcept { return _impl->file_buffers_supported(); }
+    [[nodiscard]] auto &resource_tracker() const noexcept { return _impl->resource_tracker(); }
 
     [[nodiscard]] Stream create_stream() noexcept;                // see definition in runtime/stream.cpp
     [[nodiscard]] Event create_event() noexcept;                  // see definition in runtime/event.cpp
@@ -150,8 +234,15 @@ public:
     }
 
     template<typename T>
-    [[nodiscard]] auto create_buffer(size_t size) noexcept {
-        return _create<Buffer<T>>(size);
+    [[nodiscard]] auto create_buffer(size_t size, BufferMemory memory = BufferMemory::DEVICE) noexcept {
+        return _create<Buffer<T>>(size, memory);
+    }
+
+    // read-only buffer over the memory-mapped file (trailing bytes short of an element are left out),
+    // if file_buffers_supported(); otherwise, create a buffer and copy into it with copy_from_file()
+    template<typename T>
+    [[nodiscard]] auto create_file_buffer(const std::filesystem::path &path) noexcept {
+        return _create<Buffer<T>>(path);
     }
 
     // see definitions in dsl/func.h
@@ -159,6 +250,25 @@ public:
     [[nodiscard]] auto compile(const Kernel<N, Args...> &kernel) noexcept {
         return _create<Shader<N, Args...>>(kernel.function());
     }
+
+    // loads the precompiled binary if not empty, see runtime/kernel_archive.h
+    template<size_t N, typename... Args>
+    [[nodiscard]] auto compile(const Kernel<N, Args...> &kernel, std::span<const std::byte> binary) noexcept {
+        return _create<Shader<N, Args...>>(kernel.function(), binary);
+    }
+
+    // compiles a copy of the kernel with the given block size (the kernel itself
+    // is left as is), see definition in runtime/block_size_tuner.h
+    template<size_t N, typename... Args>
+    [[nodiscard]] Shader<N, Args...> compile(const Kernel<N, Args...> &kernel, uint3 block_size) noexcept;
+
+    // compiles with the block size tuned on the representative dispatch, see
+    // definition in runtime/block_size_tuner.h; unless a result is cached for the
+    // kernel, representative_dispatch(shader) is enqueued on the stream (warm-up +
+    // measure) times for the default and each candidate block size, binding the
+    // resources it names, so it must be safe to repeat (e.g., use scratch outputs)
+    template<size_t N, typename... Args, typename Dispatch>
+    [[nodiscard]] Shader<N, Args...> compile(const Kernel<N, Args...> &kernel, Stream &stream, Dispatch &&representative_dispatch) noexcept;
 };
 
 }// namespace luisa::compute
@@ -21,4 +21,8 @@ void Event::synchronize() const noexcept {
     device()->synchronize_event(handle());
 }
 
+bool Event::query() const noexcept {
+    return device()->query_event(handle());
+}
+
 }// namespace luisa::compute
@@ -27,6 +27,8 @@ public:
     [[nodiscard]] auto signal() const noexcept { return Signal{handle()}; }
     [[nodiscard]] auto wait() const noexcept { return Wait{handle()}; }
     void synchronize() const noexcept;
+    // true if the stream has passed the last signal, see Device::Interface::query_event()
+    [[nodiscard]] bool query() const noexcept;
 };
 
 }// namespace luisa::compute
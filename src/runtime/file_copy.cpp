@@ -0,0 +1,214 @@
+//
+// Created by Mike Smith on 2021/9/17.
+//
+
+#include <array>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+#include <core/platform.h>
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/buffer.h>
+#include <runtime/event.h>
+#include <runtime/stream.h>
+
+#ifdef LUISA_PLATFORM_UNIX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace luisa::compute {
+
+namespace detail {
+
+// sequential reads of a file range, hinting the next chunk to the kernel so
+// that it is read ahead while the current one is copied to the device
+class FileCopyReader : concepts::Noncopyable {
+
+private:
+    std::filesystem::path _path;
+    size_t _offset;
+    size_t _end;
+#ifdef LUISA_PLATFORM_UNIX
+    int _fd{-1};
+#else
+    std::ifstream _file;
+#endif
+
+public:
+    FileCopyReader(std::filesystem::path path, size_t offset, size_t size_bytes) noexcept
+        : _path{std::move(path)}, _offset{offset}, _end{offset + size_bytes} {
+#ifdef LUISA_PLATFORM_UNIX
+        _fd = open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (_fd == -1) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Failed to open file '{}' for copying, reason: {}.",
+                _path.string(), strerror(errno));
+        }
+#ifdef __linux__
+        posix_fadvise(_fd, static_cast<off_t>(offset), static_cast<off_t>(size_bytes), POSIX_FADV_SEQUENTIAL);
+#endif
+#else
+        _file.rdbuf()->pubsetbuf(nullptr, 0);// reads go straight into the staging memory
+        _file.open(_path, std::ios::binary);
+        if (!_file.is_open()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Failed to open file '{}' for copying.", _path.string());
+        }
+        _file.seekg(static_cast<std::streamoff>(offset));
+#endif
+    }
+
+    ~FileCopyReader() noexcept {
+#ifdef LUISA_PLATFORM_UNIX
+        close(_fd);
+#endif
+    }
+
+    void prefetch([[maybe_unused]] size_t size_bytes) noexcept {
+#ifdef __linux__
+        auto size = std::min(size_bytes, _end - _offset);
+        posix_fadvise(_fd, static_cast<off_t>(_offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#endif
+    }
+
+    void read(std::span<std::byte> data) noexcept {
+        auto fail = [this, &data] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Failed to read {} bytes at offset {} from file '{}'.",
+                data.size_bytes(), _offset, _path.string());
+        };
+#ifdef LUISA_PLATFORM_UNIX
+        for (auto p = data.data(), end = p + data.size_bytes(); p != end;) {
+            auto n = pread(_fd, p, end - p, static_cast<off_t>(_offset + (p - data.data())));
+            if (n == -1 && errno == EINTR) { continue; }
+            if (n <= 0) [[unlikely]] { fail(); }
+            p += n;
+        }
+#else
+        if (!_file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size_bytes()))) [[unlikely]] {
+            fail();
+        }
+#endif
+        _offset += data.size_bytes();
+    }
+};
+
+}// namespace detail
+
+// double-buffered staging memory of the file copies on a stream
+class FileCopyStaging : concepts::Noncopyable {
+
+public:
+    static constexpr auto slot_count = 2u;
+    static constexpr auto chunk_size = 16_mb;
+
+    struct Slot {
+        Buffer<std::byte> buffer;    // host-mapped, if supported by the device
+        std::vector<std::byte> host; // otherwise
+        std::span<std::byte> memory;
+        Event fence;
+        bool pending{false};
+    };
+
+private:
+    Device _device;
+    bool _mapped;
+    std::array<Slot, slot_count> _slots;
+    uint _next{0u};
+
+public:
+    explicit FileCopyStaging(Device::Handle device) noexcept
+        : _device{std::move(device)},
+          _mapped{_device.mapped_buffer_access() != MappedBufferAccess::NONE} {
+        for (auto &&s : _slots) { s.fence = _device.create_event(); }
+    }
+
+    ~FileCopyStaging() noexcept {
+        // host staging memory is read by the commands
+        for (auto &&s : _slots) {
+            if (s.pending) { s.fence.synchronize(); }
+        }
+    }
+
+    [[nodiscard]] auto is_mapped() const noexcept { return _mapped; }
+
+    // the next slot, with at least size_bytes bytes, once the stream is done with it
+    [[nodiscard]] Slot &acquire(size_t size_bytes) noexcept {
+        auto &&s = _slots[_next];
+        _next = (_next + 1u) % slot_count;
+        if (s.pending) {
+            s.fence.synchronize();
+            s.pending = false;
+        }
+        if (s.memory.size_bytes() < size_bytes) {
+            auto capacity = std::max(size_bytes, static_cast<size_t>(chunk_size));
+            if (_mapped) {
+                s.buffer = _device.create_buffer<std::byte>(capacity, BufferMemory::HOST_MAPPED);
+                s.memory = s.buffer.mapped();
+            } else {
+                s.host.resize(capacity);
+                s.memory = s.host;
+            }
+        }
+        return s;
+    }
+};
+
+Stream &Stream::operator<<(FileCopy copy) noexcept {
+    if (copy.size_bytes == 0u) { return *this; }
+    if (_file_staging == nullptr) { _file_staging = std::make_shared<FileCopyStaging>(shared_device()); }
+    auto &&staging = *_file_staging;
+    detail::FileCopyReader reader{copy.path, copy.file_offset, copy.size_bytes};
+    // reads a chunk into a slot and copies it with the command made from the slot
+    auto copy_chunk = [&](size_t size_bytes, auto &&make_command) noexcept {
+        auto &&slot = staging.acquire(size_bytes);
+        auto data = slot.memory.first(size_bytes);
+        reader.read(data);
+        reader.prefetch(FileCopyStaging::chunk_size);
+        *this << make_command(slot, data) << slot.fence.signal();
+        slot.pending = true;
+    };
+    reader.prefetch(FileCopyStaging::chunk_size);
+    if (copy.target == FileCopy::Target::BUFFER) {
+        for (auto offset = static_cast<size_t>(0u); offset < copy.size_bytes; offset += FileCopyStaging::chunk_size) {
+            auto size = std::min(copy.size_bytes - offset, static_cast<size_t>(FileCopyStaging::chunk_size));
+            auto dst_offset = copy.buffer_offset + offset;
+            copy_chunk(size, [&](FileCopyStaging::Slot &slot, std::span<std::byte> data) noexcept -> Command * {
+                if (staging.is_mapped()) {
+                    return BufferCopyCommand::create(slot.buffer.handle(), copy.handle, 0u, dst_offset, size);
+                }
+                return BufferUploadCommand::create(copy.handle, dst_offset, size, data.data());
+            });
+        }
+    } else {
+        // whole slices per chunk if they fit, rows of a slice otherwise
+        auto row_bytes = pixel_storage_size(copy.storage) * copy.size.x;
+        auto slice_bytes = row_bytes * copy.size.y;
+        auto rows = slice_bytes <= FileCopyStaging::chunk_size
+                        ? copy.size.y
+                        : std::max(static_cast<uint>(FileCopyStaging::chunk_size / row_bytes), 1u);
+        auto slices = rows == copy.size.y
+                          ? static_cast<uint>(FileCopyStaging::chunk_size / slice_bytes)
+                          : 1u;
+        for (auto z = 0u; z < copy.size.z; z += slices) {
+            for (auto y = 0u; y < copy.size.y; y += rows) {
+                auto offset = copy.offset + make_uint3(0u, y, z);
+                auto size = make_uint3(copy.size.x, std::min(rows, copy.size.y - y), std::min(slices, copy.size.z - z));
+                copy_chunk(row_bytes * size.y * size.z, [&](FileCopyStaging::Slot &slot, std::span<std::byte> data) noexcept -> Command * {
+                    if (staging.is_mapped()) {
+                        return BufferToTextureCopyCommand::create(
+                            slot.buffer.handle(), 0u, copy.handle, copy.storage, 0u, offset, size);
+                    }
+                    return TextureUploadCommand::create(copy.handle, copy.storage, 0u, offset, size, data.data());
+                });
+            }
+        }
+    }
+    return *this;
+}
+
+}// namespace luisa::compute
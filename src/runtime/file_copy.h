@@ -0,0 +1,51 @@
+//
+// Created by Mike Smith on 2021/9/17.
+//
+
+#pragma once
+
+#include <filesystem>
+
+#include <core/basic_types.h>
+#include <runtime/pixel.h>
+
+namespace luisa::compute {
+
+// Copy of a file range into a buffer or volume, made by copy_from_file() of the
+// views and executed by the stream it is sent to: the file is read in chunks
+// into double-buffered staging memory (host-mapped buffers if the device has
+// them), each chunk copied on the stream while the next one is read. The call
+// returns once the last chunk is submitted, so the copy is ordered like other
+// commands and the file may change afterwards. See runtime/file_copy.cpp.
+struct FileCopy {
+
+    enum struct Target : uint32_t {
+        BUFFER,
+        VOLUME
+    };
+
+    std::filesystem::path path;
+    size_t file_offset;
+    Target target;
+    uint64_t handle;
+    size_t size_bytes;
+    size_t buffer_offset;// buffers only
+    PixelStorage storage;// volumes only, with rows and slices tightly packed in the file
+    uint3 offset;
+    uint3 size;
+
+    [[nodiscard]] static auto buffer(std::filesystem::path path, size_t file_offset,
+                                     uint64_t handle, size_t offset_bytes, size_t size_bytes) noexcept {
+        return FileCopy{std::move(path), file_offset, Target::BUFFER, handle,
+                        size_bytes, offset_bytes, {}, {}, {}};
+    }
+
+    [[nodiscard]] static auto volume(std::filesystem::path path, size_t file_offset,
+                                     uint64_t handle, PixelStorage storage, uint3 offset, uint3 size) noexcept {
+        return FileCopy{std::move(path), file_offset, Target::VOLUME, handle,
+                        pixel_storage_size(storage) * size.x * size.y * size.z,
+                        0u, storage, offset, size};
+    }
+};
+
+}// namespace luisa::compute
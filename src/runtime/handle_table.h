@@ -0,0 +1,171 @@
+//
+// Created by Mike Smith on 2021/9/15.
+//
+
+#pragma once
+
+#include <new>
+#include <array>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <core/logging.h>
+#include <core/concepts.h>
+
+namespace luisa::compute {
+
+// Generational slot map for backend objects behind the uint64_t handles of
+// Device::Interface, i.e., for backends to use instead of casting pointers.
+//
+// A handle packs the generation of its slot (high 32 bits) and the slot index
+// (low 32 bits). Generations are odd while slots are occupied, so valid
+// handles are never zero, and destroying a slot bumps its generation, which
+// makes stale handles detectable: operator[] checks them in debug builds, and
+// contains() always does. Objects are stored in place in fixed-size chunks
+// that are never moved, so references stay valid until destruction.
+//
+// create() and destroy() are lock-free (a tagged free list and an atomic
+// bump index), and lookups are two loads. Objects themselves are not guarded.
+template<typename T>
+class HandleTable : concepts::Noncopyable {
+
+public:
+    static constexpr auto chunk_size_log2 = 10u;
+    static constexpr auto chunk_size = 1u << chunk_size_log2;
+    static constexpr auto max_chunk_count = 1u << 14u;
+    static constexpr auto capacity = chunk_size * max_chunk_count;
+
+private:
+    static constexpr auto invalid_index = ~0u;
+
+    struct Slot {
+        std::atomic<uint32_t> generation{0u};
+        std::atomic<uint32_t> next_free{invalid_index};
+        alignas(T) std::byte storage[sizeof(T)];
+        [[nodiscard]] auto object() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+    };
+
+private:
+    std::array<std::atomic<Slot *>, max_chunk_count> _chunks{};
+    std::atomic<uint64_t> _free_head{invalid_index};// (ABA tag << 32) | index
+    std::atomic<uint32_t> _next_index{0u};
+    std::atomic<size_t> _size{0u};
+
+private:
+    [[nodiscard]] Slot &_slot(uint32_t index) const noexcept {
+        return _chunks[index >> chunk_size_log2].load(std::memory_order_acquire)[index & (chunk_size - 1u)];
+    }
+
+    // whether the handle could refer to an occupied slot at all, i.e., before checking generations
+    [[nodiscard]] bool _is_occupied_index(uint32_t index, uint32_t generation) const noexcept {
+        return (generation & 1u) &&
+               index < std::min(_next_index.load(std::memory_order_acquire), capacity) &&
+               _chunks[index >> chunk_size_log2].load(std::memory_order_acquire) != nullptr;
+    }
+
+    [[nodiscard]] uint32_t _pop_free() noexcept {
+        auto head = _free_head.load(std::memory_order_acquire);
+        while (static_cast<uint32_t>(head) != invalid_index) {
+            auto next = _slot(static_cast<uint32_t>(head)).next_free.load(std::memory_order_relaxed);
+            auto new_head = (((head >> 32u) + 1u) << 32u) | next;
+            if (_free_head.compare_exchange_weak(head, new_head, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return static_cast<uint32_t>(head);
+            }
+        }
+        return invalid_index;
+    }
+
+    void _push_free(uint32_t index) noexcept {
+        auto &&slot = _slot(index);
+        auto head = _free_head.load(std::memory_order_relaxed);
+        auto new_head = 0ull;
+        do {
+            slot.next_free.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            new_head = (((head >> 32u) + 1u) << 32u) | index;
+        } while (!_free_head.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    [[nodiscard]] uint32_t _allocate_index() noexcept {
+        if (auto index = _pop_free(); index != invalid_index) { return index; }
+        auto index = _next_index.fetch_add(1u, std::memory_order_relaxed);
+        if (index >= capacity) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Handle table capacity ({}) exceeded.", capacity);
+        }
+        if (auto &&chunk = _chunks[index >> chunk_size_log2];
+            chunk.load(std::memory_order_acquire) == nullptr) {
+            auto slots = new Slot[chunk_size];
+            Slot *expected = nullptr;
+            if (!chunk.compare_exchange_strong(expected, slots, std::memory_order_acq_rel)) { delete[] slots; }
+        }
+        return index;
+    }
+
+public:
+    [[nodiscard]] static constexpr auto index(uint64_t handle) noexcept { return static_cast<uint32_t>(handle); }
+    [[nodiscard]] static constexpr auto generation(uint64_t handle) noexcept { return static_cast<uint32_t>(handle >> 32u); }
+
+    HandleTable() noexcept = default;
+    ~HandleTable() noexcept {
+        clear();
+        for (auto &&chunk : _chunks) { delete[] chunk.load(std::memory_order_relaxed); }
+    }
+
+    template<typename... Args>
+    [[nodiscard]] uint64_t create(Args &&...args) noexcept {
+        auto i = _allocate_index();
+        auto &&slot = _slot(i);
+        std::construct_at(slot.object(), std::forward<Args>(args)...);
+        auto g = slot.generation.load(std::memory_order_relaxed) + 1u;
+        slot.generation.store(g, std::memory_order_release);
+        _size.fetch_add(1u, std::memory_order_relaxed);
+        return (static_cast<uint64_t>(g) << 32u) | i;
+    }
+
+    void destroy(uint64_t handle) noexcept {
+        auto i = index(handle);
+        auto g = generation(handle);
+        if (!_is_occupied_index(i, g) ||
+            !_slot(i).generation.compare_exchange_strong(g, g + 1u, std::memory_order_acq_rel)) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Destroying invalid or stale handle {:#x}.", handle);
+        }
+        std::destroy_at(_slot(i).object());
+        _size.fetch_sub(1u, std::memory_order_relaxed);
+        _push_free(i);
+    }
+
+    [[nodiscard]] bool contains(uint64_t handle) const noexcept {
+        auto i = index(handle);
+        auto g = generation(handle);
+        return _is_occupied_index(i, g) && _slot(i).generation.load(std::memory_order_acquire) == g;
+    }
+
+    [[nodiscard]] T &operator[](uint64_t handle) const noexcept {
+#ifndef NDEBUG
+        if (!contains(handle)) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid or stale handle {:#x}.", handle);
+        }
+#endif
+        return *_slot(index(handle)).object();
+    }
+
+    // destroys all objects, must not race with other calls
+    void clear() noexcept {
+        auto count = std::min(_next_index.load(std::memory_order_acquire), capacity);
+        for (auto i = 0u; i < count; i++) {
+            if (auto &&slot = _slot(i); slot.generation.load(std::memory_order_relaxed) & 1u) {
+                std::destroy_at(slot.object());
+                slot.generation.fetch_add(1u, std::memory_order_relaxed);
+                _push_free(i);
+            }
+        }
+        _size.store(0u, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto size() const noexcept { return _size.load(std::memory_order_relaxed); }
+};
+
+}// namespace luisa::compute
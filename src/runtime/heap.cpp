@@ -2,8 +2,12 @@
 // Created by Mike Smith on 2021/4/7.
 //
 
+#include <array>
+#include <atomic>
+
 #include <runtime/device.h>
 #include <runtime/heap.h>
+#include <runtime/destruction_queue.h>
 
 namespace luisa::compute {
 
@@ -23,45 +27,178 @@ constexpr auto Heap::_compute_mip_levels(uint3 size, uint requested_levels) noex
                : std::min(requested_levels, max_levels);
 }
 
+// Slot states of one kind of heap resources. Pages of entries are created on
+// first touch, so sparse heaps only pay for the slots they use, and free slots
+// are kept on a lock-free (tagged) list, falling back to a bump index.
+//
+// A slot is claimed by moving its handle from invalid_handle to reserved, so
+// explicitly indexed slots and allocated ones never collide: entries on the
+// free list may have been taken meanwhile, and are dropped when popped. An
+// entry is pushed at most once at a time, tracked by its listed flag.
+class Heap::SlotTable {
+
+public:
+    static constexpr auto invalid_index = ~0u;
+    static constexpr auto reserved_handle = invalid_handle - 1u;
+
+private:
+    static constexpr auto page_size_log2 = 10u;
+    static constexpr auto page_size = 1u << page_size_log2;
+    static constexpr auto page_count = slot_count / page_size;
+
+    struct Entry {
+        std::atomic<uint64_t> handle{invalid_handle};
+        std::atomic<uint32_t> next_free{invalid_index};
+        std::atomic<bool> listed{false};
+    };
+
+    using Page = std::array<Entry, page_size>;
+
+private:
+    std::array<std::atomic<Page *>, page_count> _pages{};
+    std::atomic<uint64_t> _free_head{invalid_index};// (ABA tag << 32) | index
+    std::atomic<uint32_t> _next_index{0u};
+
+private:
+    [[nodiscard]] Entry *_find(uint32_t index) const noexcept {
+        auto page = _pages[index >> page_size_log2].load(std::memory_order_acquire);
+        return page == nullptr ? nullptr : &(*page)[index & (page_size - 1u)];
+    }
+
+    [[nodiscard]] Entry &_entry(uint32_t index) noexcept {
+        auto &&page = _pages[index >> page_size_log2];
+        auto p = page.load(std::memory_order_acquire);
+        if (p == nullptr) {
+            auto new_page = new Page;
+            if (page.compare_exchange_strong(p, new_page, std::memory_order_acq_rel)) {
+                p = new_page;
+            } else {
+                delete new_page;
+            }
+        }
+        return (*p)[index & (page_size - 1u)];
+    }
+
+    [[nodiscard]] uint32_t _pop_free() noexcept {
+        auto head = _free_head.load(std::memory_order_acquire);
+        while (static_cast<uint32_t>(head) != invalid_index) {
+            auto next = _find(static_cast<uint32_t>(head))->next_free.load(std::memory_order_relaxed);
+            auto new_head = (((head >> 32u) + 1u) << 32u) | next;
+            if (_free_head.compare_exchange_weak(head, new_head, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                auto index = static_cast<uint32_t>(head);
+                _find(index)->listed.store(false);
+                return index;
+            }
+        }
+        return invalid_index;
+    }
+
+    void _push_free(uint32_t index) noexcept {
+        auto &&entry = *_find(index);
+        if (entry.listed.exchange(true)) { return; }
+        auto head = _free_head.load(std::memory_order_relaxed);
+        auto new_head = 0ull;
+        do {
+            entry.next_free.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            new_head = (((head >> 32u) + 1u) << 32u) | index;
+        } while (!_free_head.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    [[nodiscard]] bool _try_reserve(Entry &entry) noexcept {
+        auto expected = invalid_handle;
+        return entry.handle.compare_exchange_strong(expected, reserved_handle);
+    }
+
+public:
+    SlotTable() noexcept = default;
+    ~SlotTable() noexcept {
+        for (auto &&p : _pages) { delete p.load(std::memory_order_relaxed); }
+    }
+    SlotTable(SlotTable &&) noexcept = delete;
+    SlotTable &operator=(SlotTable &&) noexcept = delete;
+
+    // reserves a free slot, returns invalid_index if all are in use
+    [[nodiscard]] uint32_t allocate() noexcept {
+        for (auto index = _pop_free(); index != invalid_index; index = _pop_free()) {
+            if (_try_reserve(*_find(index))) { return index; }
+        }
+        for (auto index = _next_index.load(std::memory_order_relaxed); index < slot_count;) {
+            if (_next_index.compare_exchange_weak(index, index + 1u, std::memory_order_relaxed)) {
+                // slots taken explicitly are skipped, and listed once they are freed
+                if (_try_reserve(_entry(index))) { return index; }
+                index++;
+            }
+        }
+        return invalid_index;
+    }
+
+    // stores the handle at the slot, returns the handle it replaces
+    [[nodiscard]] uint64_t exchange(uint32_t index, uint64_t handle) noexcept {
+        return _entry(index).handle.exchange(handle);
+    }
+
+    [[nodiscard]] uint64_t load(uint32_t index) const noexcept {
+        auto entry = _find(index);
+        return entry == nullptr ? invalid_handle : entry->handle.load();
+    }
+
+    // clears the slot, returns the handle it held
+    [[nodiscard]] uint64_t release(uint32_t index) noexcept {
+        auto entry = _find(index);
+        if (entry == nullptr) { return invalid_handle; }
+        auto handle = entry->handle.exchange(invalid_handle);
+        // slots beyond the bump index are handed out by it instead
+        if (handle != invalid_handle && index < _next_index.load()) { _push_free(index); }
+        return handle;
+    }
+};
+
+Heap::Heap() noexcept = default;
+Heap::~Heap() noexcept = default;
+Heap::Heap(Heap &&) noexcept = default;
+Heap &Heap::operator=(Heap &&) noexcept = default;
+
 Heap::Heap(Device::Interface *device, size_t capacity) noexcept
-    : Resource{device, Tag::HEAP, device->create_heap(capacity)},
+    : Resource{device, Tag::HEAP, device->create_heap(capacity), capacity},
       _capacity{capacity},
-      _texture_slots(slot_count, invalid_handle),
-      _buffer_slots(slot_count, invalid_handle) {}
+      _texture_slots{std::make_unique<SlotTable>()},
+      _buffer_slots{std::make_unique<SlotTable>()} {}
 
-TextureView2D Heap::create_texture(uint index, PixelStorage storage, uint2 size, TextureSampler sampler, uint mip_levels) noexcept {
-    if (auto h = _texture_slots[index]; h != invalid_handle) [[unlikely]] {
-        LUISA_WARNING_WITH_LOCATION(
-            "Overwriting texture #{} at {} in heap #{}.",
-            h, index, handle());
-        destroy_texture(index);
+uint Heap::_allocate_slot(SlotTable &slots) noexcept {
+    auto index = slots.allocate();
+    if (index == SlotTable::invalid_index) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("No free slots in heap (capacity: {}).", slot_count);
     }
-    auto valid_mip_levels = _compute_mip_levels(make_uint3(size, 1u), mip_levels);
-    if (valid_mip_levels == 1u
-        && (sampler.filter() == TextureSampler::Filter::TRILINEAR
-            || sampler.filter() == TextureSampler::Filter::ANISOTROPIC)) [[unlikely]] {
+    return index;
+}
+
+uint64_t Heap::_create_buffer(uint index, size_t size_bytes) noexcept {
+    if (index >= slot_count) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Invalid heap slot {} (slot count: {}).", index, slot_count);
+    }
+    if (auto h = _buffer_slots->load(index); h != invalid_handle && h != SlotTable::reserved_handle) [[unlikely]] {
         LUISA_WARNING_WITH_LOCATION(
-            "Textures without mipmaps do not support "
-            "trilinear or anisotropic sampling.");
-        sampler.set_filter(TextureSampler::Filter::BILINEAR);
+            "Overwriting buffer #{} at {} in heap #{}.",
+            h, index, handle());
+        destroy_buffer(index);
     }
-    auto handle = device()->create_texture(
-        pixel_storage_to_format<float>(storage), 2u,
-        size.x, size.y, 1u, valid_mip_levels,
-        sampler, this->handle(), index);
-    _texture_slots[index] = handle;
-    return {handle, storage, valid_mip_levels, size};
+    auto buffer_handle = device()->create_buffer(size_bytes, handle(), index);
+    static_cast<void>(_buffer_slots->exchange(index, buffer_handle));
+    return buffer_handle;
 }
 
-TextureView3D Heap::create_texture(uint index, PixelStorage storage, uint3 size, TextureSampler sampler, uint mip_levels) noexcept {
-    if (auto h = _texture_slots[index]; h != invalid_handle) [[unlikely]] {
+uint64_t Heap::_create_texture(uint index, PixelStorage storage, uint dim, uint3 size, TextureSampler &sampler, uint &mip_levels) noexcept {
+    if (index >= slot_count) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Invalid heap slot {} (slot count: {}).", index, slot_count);
+    }
+    if (auto h = _texture_slots->load(index); h != invalid_handle && h != SlotTable::reserved_handle) [[unlikely]] {
         LUISA_WARNING_WITH_LOCATION(
             "Overwriting texture #{} at {} in heap #{}.",
             h, index, handle());
         destroy_texture(index);
     }
-    auto valid_mip_levels = _compute_mip_levels(size, mip_levels);
-    if (valid_mip_levels == 1u
+    mip_levels = _compute_mip_levels(size, mip_levels);
+    if (mip_levels == 1u
         && (sampler.filter() == TextureSampler::Filter::TRILINEAR
             || sampler.filter() == TextureSampler::Filter::ANISOTROPIC)) [[unlikely]] {
         LUISA_WARNING_WITH_LOCATION(
@@ -69,33 +206,54 @@ TextureView3D Heap::create_texture(uint index, PixelStorage storage, uint3 size,
             "trilinear or anisotropic sampling.");
         sampler.set_filter(TextureSampler::Filter::BILINEAR);
     }
-    auto handle = device()->create_texture(
-        pixel_storage_to_format<float>(storage), 3u,
-        size.x, size.y, size.z, valid_mip_levels,
-        sampler, this->handle(), index);
-    _texture_slots[index] = handle;
-    return {handle, storage, valid_mip_levels, size};
+    auto texture_handle = device()->create_texture(
+        pixel_storage_to_format<float>(storage), dim,
+        size.x, size.y, size.z, mip_levels,
+        sampler, handle(), index);
+    static_cast<void>(_texture_slots->exchange(index, texture_handle));
+    return texture_handle;
+}
+
+TextureView2D Heap::create_texture(uint index, PixelStorage storage, uint2 size, TextureSampler sampler, uint mip_levels) noexcept {
+    auto handle = _create_texture(index, storage, 2u, make_uint3(size, 1u), sampler, mip_levels);
+    return {handle, storage, mip_levels, size};
+}
+
+TextureView3D Heap::create_texture(uint index, PixelStorage storage, uint3 size, TextureSampler sampler, uint mip_levels) noexcept {
+    auto handle = _create_texture(index, storage, 3u, size, sampler, mip_levels);
+    return {handle, storage, mip_levels, size};
+}
+
+Heap::Slot<TextureView2D> Heap::allocate_texture(PixelStorage storage, uint2 size, TextureSampler sampler, uint mip_levels) noexcept {
+    auto index = _allocate_slot(*_texture_slots);
+    return {index, create_texture(index, storage, size, sampler, mip_levels)};
+}
+
+Heap::Slot<TextureView3D> Heap::allocate_texture(PixelStorage storage, uint3 size, TextureSampler sampler, uint mip_levels) noexcept {
+    auto index = _allocate_slot(*_texture_slots);
+    return {index, create_texture(index, storage, size, sampler, mip_levels)};
 }
 
 void Heap::destroy_texture(uint32_t index) noexcept {
-    if (auto &&h = _texture_slots[index]; h == invalid_handle) [[unlikely]] {
+    if (auto h = _texture_slots->release(index);
+        h == invalid_handle || h == SlotTable::reserved_handle) [[unlikely]] {
         LUISA_WARNING_WITH_LOCATION(
             "Destroying already destroyed heap texture at slot {} in heap #{}.",
             index, handle());
     } else {
-        device()->destroy_texture(h);
-        h = invalid_handle;
+        // bindless dispatches use the slots through the heap binding
+        device()->destruction_queue().destroy_after(ResourceTag::TEXTURE, h, ResourceTag::HEAP, handle());
     }
 }
 
 void Heap::destroy_buffer(uint32_t index) noexcept {
-    if (auto &&h = _buffer_slots[index]; h == invalid_handle) [[unlikely]] {
+    if (auto h = _buffer_slots->release(index);
+        h == invalid_handle || h == SlotTable::reserved_handle) [[unlikely]] {
         LUISA_WARNING_WITH_LOCATION(
             "Destroying already destroyed heap buffer at slot {} in heap #{}.",
             index, handle());
     } else {
-        device()->destroy_buffer(h);
-        h = invalid_handle;
+        device()->destruction_queue().destroy_after(ResourceTag::BUFFER, h, ResourceTag::HEAP, handle());
     }
 }
 
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include <runtime/texture.h>
 #include <runtime/resource.h>
 
@@ -28,39 +30,55 @@ public:
     static constexpr auto slot_count = 65536u;
     static constexpr auto invalid_handle = std::numeric_limits<uint64_t>::max();
 
+    // a resource placed in a slot picked by the heap
+    template<typename View>
+    struct Slot {
+        uint index;
+        View view;
+    };
+
+    class SlotTable;
+
 private:
     size_t _capacity{};
-    std::vector<uint64_t> _texture_slots;
-    std::vector<uint64_t> _buffer_slots;
+    std::unique_ptr<SlotTable> _texture_slots;
+    std::unique_ptr<SlotTable> _buffer_slots;
 
 private:
     friend class Device;
     Heap(Device::Interface *device, size_t capacity) noexcept;
     [[nodiscard]] static constexpr auto _compute_mip_levels(uint3 size, uint requested_levels) noexcept;
+    [[nodiscard]] static uint _allocate_slot(SlotTable &slots) noexcept;
+    [[nodiscard]] uint64_t _create_buffer(uint index, size_t size_bytes) noexcept;
+    [[nodiscard]] uint64_t _create_texture(uint index, PixelStorage storage, uint dim, uint3 size, TextureSampler &sampler, uint &mip_levels) noexcept;
 
 public:
-    Heap() noexcept = default;
+    Heap() noexcept;
+    ~Heap() noexcept override;
+    Heap(Heap &&) noexcept;
+    Heap &operator=(Heap &&) noexcept;
     using Resource::operator bool;
 
     [[nodiscard]] auto capacity() const noexcept { return _capacity; }
     [[nodiscard]] auto allocated_size() const noexcept { return device()->query_heap_memory_usage(handle()); }
 
+    // places the buffer at the given slot, replacing the one there (if any)
     template<typename T>
     [[nodiscard]] BufferView<T> create_buffer(uint index, size_t size) noexcept {
-        if (auto h = _buffer_slots[index]; h != invalid_handle) [[unlikely]] {
-            LUISA_WARNING_WITH_LOCATION(
-                "Overwriting buffer #{} at {} in heap #{}.",
-                h, index, handle());
-            destroy_buffer(index);
-        }
-        auto buffer_handle = device()->create_buffer(size * sizeof(T), handle(), index);
-        _buffer_slots[index] = buffer_handle;
-        return {buffer_handle, 0u, size};
+        return {_create_buffer(index, size * sizeof(T)), 0u, size};
+    }
+    // places the buffer at a free slot, which is returned along with the buffer
+    template<typename T>
+    [[nodiscard]] Slot<BufferView<T>> allocate_buffer(size_t size) noexcept {
+        auto index = _allocate_slot(*_buffer_slots);
+        return {index, create_buffer<T>(index, size)};
     }
     void destroy_buffer(uint32_t index) noexcept;
 
     [[nodiscard]] TextureView2D create_texture(uint index, PixelStorage storage, uint2 size, TextureSampler sampler = TextureSampler{}, uint mip_levels = 1u) noexcept;
     [[nodiscard]] TextureView3D create_texture(uint index, PixelStorage storage, uint3 size, TextureSampler sampler = TextureSampler{}, uint mip_levels = 1u) noexcept;
+    [[nodiscard]] Slot<TextureView2D> allocate_texture(PixelStorage storage, uint2 size, TextureSampler sampler = TextureSampler{}, uint mip_levels = 1u) noexcept;
+    [[nodiscard]] Slot<TextureView3D> allocate_texture(PixelStorage storage, uint3 size, TextureSampler sampler = TextureSampler{}, uint mip_levels = 1u) noexcept;
     void destroy_texture(uint32_t index) noexcept;
 
     // see implementations in dsl/expr.h
@@ -15,6 +15,8 @@ class ImageView;
 template<typename T>
 class BufferView;
 
+class TransientPool;
+
 namespace detail {
 
 template<typename T>
@@ -44,7 +46,8 @@ private:
             device->create_texture(
               pixel_storage_to_format<T>(storage), 2u,
               size.x, size.y, 1u, 1u, {},
-              std::numeric_limits<uint64_t>::max(), 0u)},
+              std::numeric_limits<uint64_t>::max(), 0u),
+            pixel_storage_size(storage) * size.x * size.y},
           _size{size},
           _storage{storage} {}
 
@@ -104,6 +107,7 @@ private:
 
 private:
     friend class Image<T>;
+    friend class TransientPool;
 
     constexpr explicit ImageView(
         uint64_t handle,
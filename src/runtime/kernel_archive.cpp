@@ -0,0 +1,199 @@
+//
+// Created by Mike Smith on 2021/9/7.
+//
+
+#include <array>
+#include <fstream>
+#include <algorithm>
+
+#include <core/hash.h>
+#include <core/logging.h>
+#include <core/platform.h>
+#include <ast/function_serializer.h>
+#include <runtime/kernel_archive.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+[[nodiscard]] inline auto archive_hash(std::string_view s) noexcept {
+    return s.empty() ? 0ull : xxh3_hash64(s.data(), s.size());
+}
+
+[[nodiscard]] inline auto archive_entry_less(const KernelArchive::Entry &lhs, const KernelArchive::Entry &rhs) noexcept {
+    return lhs.name_hash < rhs.name_hash ||
+           (lhs.name_hash == rhs.name_hash && lhs.format_hash < rhs.format_hash);
+}
+
+}// namespace detail
+
+KernelArchive::Builder &KernelArchive::Builder::add(std::string_view name, Function kernel) noexcept {
+    if (kernel.tag() != Function::Tag::KERNEL) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Function '{}' added to kernel archive is not a kernel.", name);
+    }
+    _items.emplace_back(Item{std::string{name}, {}, kernel.hash(), FunctionSerializer::serialize(kernel)});
+    return *this;
+}
+
+KernelArchive::Builder &KernelArchive::Builder::add_binary(
+    std::string_view name, std::string_view format, Function kernel, std::vector<std::byte> binary) noexcept {
+    if (format.empty() || binary.empty()) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Empty binary for kernel '{}' added to archive.", name);
+    }
+    _items.emplace_back(Item{std::string{name}, std::string{format}, kernel.hash(), std::move(binary)});
+    return *this;
+}
+
+void KernelArchive::Builder::save(const std::filesystem::path &path) const noexcept {
+
+    static constexpr auto blob_alignment = 16u;
+    auto align = [](uint64_t x, uint64_t a) noexcept { return (x + a - 1u) / a * a; };
+
+    std::vector<Entry> entries;
+    entries.reserve(_items.size());
+    auto name_offset = sizeof(Header) + _items.size() * sizeof(Entry);
+    for (auto &&item : _items) {
+        Entry entry{};
+        entry.name_hash = detail::archive_hash(item.name);
+        entry.format_hash = detail::archive_hash(item.format);
+        entry.kernel_hash = item.kernel_hash;
+        entry.size = item.data.size();
+        entry.name_offset = name_offset;
+        entry.name_size = item.name.size();
+        name_offset += item.name.size();
+        entries.emplace_back(entry);
+    }
+    auto offset = align(name_offset, blob_alignment);
+    for (auto &&entry : entries) {
+        entry.offset = offset;
+        offset = align(offset + entry.size, blob_alignment);
+    }
+
+    // names and blobs are written in insertion order, the index is sorted afterwards
+    std::vector<Entry> index{entries};
+    std::sort(index.begin(), index.end(), detail::archive_entry_less);
+    for (auto i = 1u; i < index.size(); i++) {
+        if (!detail::archive_entry_less(index[i - 1u], index[i])) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Duplicate or colliding entry in kernel archive '{}'.",
+                path.string());
+        }
+    }
+
+    Header header{};
+    header.magic = magic;
+    header.version = version;
+    header.entry_count = static_cast<uint32_t>(index.size());
+    header.index_offset = sizeof(Header);
+    header.file_size = offset;
+
+    auto temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file{temp_path, std::ios::binary};
+        auto write = [&file](const void *data, size_t size) noexcept {
+            file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+        };
+        write(&header, sizeof(Header));
+        write(index.data(), index.size() * sizeof(Entry));
+        for (auto &&item : _items) { write(item.name.data(), item.name.size()); }
+        std::array<std::byte, blob_alignment> padding{};
+        auto position = name_offset;
+        for (auto i = 0u; i < _items.size(); i++) {
+            write(padding.data(), entries[i].offset - position);
+            write(_items[i].data.data(), _items[i].data.size());
+            position = entries[i].offset + entries[i].size;
+        }
+        write(padding.data(), offset - position);
+        if (!file) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Failed to write kernel archive '{}'.",
+                temp_path.string());
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Failed to move kernel archive to '{}': {}.",
+            path.string(), ec.message());
+    }
+    LUISA_INFO(
+        "Saved {} entries ({} bytes) to kernel archive '{}'.",
+        index.size(), offset, path.string());
+}
+
+KernelArchive::KernelArchive(const std::filesystem::path &path) noexcept
+    : _mapping{memory_map_file(path)} {
+    auto invalid = [&](std::string_view reason) noexcept {
+        memory_unmap_file(_mapping);
+        LUISA_ERROR_WITH_LOCATION("Invalid kernel archive '{}': {}.", path.string(), reason);
+    };
+    if (_mapping.size() < sizeof(Header)) { invalid("truncated header"); }
+    auto header = reinterpret_cast<const Header *>(_mapping.data());
+    if (header->magic != magic) { invalid("bad magic"); }
+    if (header->version != version) { invalid("unsupported version"); }
+    if (header->file_size != _mapping.size()) { invalid("size mismatch"); }
+    if (header->index_offset % alignof(Entry) != 0u ||
+        header->index_offset + header->entry_count * sizeof(Entry) > _mapping.size()) { invalid("bad index"); }
+    _entries = {reinterpret_cast<const Entry *>(_mapping.data() + header->index_offset), header->entry_count};
+    for (auto &&entry : _entries) {
+        if (entry.offset + entry.size > _mapping.size() ||
+            entry.name_offset + entry.name_size > _mapping.size()) { invalid("entry out of range"); }
+    }
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Mapped kernel archive '{}' with {} entries.",
+        path.string(), _entries.size());
+}
+
+KernelArchive::~KernelArchive() noexcept {
+    memory_unmap_file(_mapping);
+}
+
+std::string_view KernelArchive::name(const Entry &entry) const noexcept {
+    return {reinterpret_cast<const char *>(_mapping.data() + entry.name_offset), entry.name_size};
+}
+
+const KernelArchive::Entry *KernelArchive::_find(std::string_view name, std::string_view format) const noexcept {
+    Entry key{};
+    key.name_hash = detail::archive_hash(name);
+    key.format_hash = detail::archive_hash(format);
+    auto iter = std::lower_bound(_entries.begin(), _entries.end(), key, detail::archive_entry_less);
+    if (iter == _entries.end() ||
+        iter->name_hash != key.name_hash ||
+        iter->format_hash != key.format_hash ||
+        this->name(*iter) != name) { return nullptr; }
+    return &*iter;
+}
+
+bool KernelArchive::contains(std::string_view name) const noexcept {
+    return _find(name, {}) != nullptr;
+}
+
+std::span<const std::byte> KernelArchive::binary(std::string_view name, std::string_view format) const noexcept {
+    if (format.empty()) { return {}; }
+    auto entry = _find(name, format);
+    return entry == nullptr ? std::span<const std::byte>{} : _mapping.subspan(entry->offset, entry->size);
+}
+
+std::shared_ptr<const detail::FunctionBuilder> KernelArchive::function(std::string_view name) const noexcept {
+    auto entry = _find(name, {});
+    if (entry == nullptr) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Kernel '{}' not found in archive.", name);
+    }
+    {
+        std::scoped_lock lock{_mutex};
+        if (auto iter = _kernels.find(entry->name_hash); iter != _kernels.cend()) { return iter->second; }
+    }
+    // deserialize without holding the lock, concurrent loads of the same kernel are benign
+    auto kernel = FunctionSerializer::deserialize_kernel(_mapping.subspan(entry->offset, entry->size));
+    if (kernel->hash() != entry->kernel_hash) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Kernel '{}' loaded with hash {} while archived as {}.",
+            name, hash_to_string(kernel->hash()), hash_to_string(entry->kernel_hash));
+    }
+    std::scoped_lock lock{_mutex};
+    return _kernels.try_emplace(entry->name_hash, std::move(kernel)).first->second;
+}
+
+}// namespace luisa::compute
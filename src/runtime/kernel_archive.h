@@ -0,0 +1,170 @@
+//
+// Created by Mike Smith on 2021/9/7.
+//
+
+#pragma once
+
+#include <span>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+#include <core/concepts.h>
+#include <util/spin_mutex.h>
+#include <runtime/device.h>
+#include <runtime/shader.h>
+#include <dsl/func.h>
+
+namespace luisa::compute {
+
+template<size_t N, typename... Args>
+class ArchivedShader;
+
+// A single file holding many named kernels, each as a serialized AST (see
+// ast/function_serializer.h) plus optional precompiled binaries for backends
+// that support them. The file is memory-mapped and its index is used in
+// place, so opening an archive costs one mmap; kernels are deserialized on
+// first use and shaders are created on first dispatch.
+//
+// Layout (host-endian, all offsets from the file start):
+//   Header, Entry[entry_count] sorted by (name hash, format hash),
+//   names, then the blobs, each aligned to 16 bytes.
+class KernelArchive : concepts::Noncopyable {
+
+public:
+    static constexpr uint64_t magic = 0x00484352414b434cull;// "LCKARCH\0"
+    static constexpr uint32_t version = 1u;
+
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t entry_count;
+        uint64_t index_offset;
+        uint64_t file_size;
+    };
+
+    struct Entry {
+        uint64_t name_hash;
+        uint64_t format_hash;// 0 for serialized ASTs
+        uint64_t kernel_hash;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t name_offset;
+        uint64_t name_size;
+    };
+
+    // collects kernels and writes archives, e.g., on build machines
+    class Builder {
+
+    private:
+        struct Item {
+            std::string name;
+            std::string format;
+            uint64_t kernel_hash;
+            std::vector<std::byte> data;
+        };
+        std::vector<Item> _items;
+
+    public:
+        Builder &add(std::string_view name, Function kernel) noexcept;
+        Builder &add_binary(std::string_view name, std::string_view format, Function kernel, std::vector<std::byte> binary) noexcept;
+        template<size_t N, typename... Args>
+        Builder &add(std::string_view name, const Kernel<N, Args...> &kernel) noexcept {
+            return add(name, kernel.function()->function());
+        }
+        // also stores the binary compiled by the device, if supported by its backend
+        template<size_t N, typename... Args>
+        Builder &add(std::string_view name, const Kernel<N, Args...> &kernel, Device &device) noexcept {
+            add(name, kernel);
+            if (auto format = device.shader_binary_format(); !format.empty()) {
+                auto shader = device.compile(kernel);
+                add_binary(name, format, kernel.function()->function(),
+                           shader.device()->shader_binary(shader.handle()));
+            }
+            return *this;
+        }
+        // writes into a temporary file and renames it, so readers never see partial archives
+        void save(const std::filesystem::path &path) const noexcept;
+    };
+
+private:
+    std::span<const std::byte> _mapping;
+    std::span<const Entry> _entries;
+    mutable std::unordered_map<uint64_t, std::shared_ptr<const detail::FunctionBuilder>> _kernels;
+    mutable spin_mutex _mutex;
+
+private:
+    [[nodiscard]] const Entry *_find(std::string_view name, std::string_view format) const noexcept;
+
+public:
+    explicit KernelArchive(const std::filesystem::path &path) noexcept;
+    ~KernelArchive() noexcept;
+    [[nodiscard]] auto entries() const noexcept { return _entries; }
+    [[nodiscard]] std::string_view name(const Entry &entry) const noexcept;
+    [[nodiscard]] bool contains(std::string_view name) const noexcept;
+    // empty if the archive holds no binary of the format for the kernel
+    [[nodiscard]] std::span<const std::byte> binary(std::string_view name, std::string_view format) const noexcept;
+    // deserialized on first request, shared afterwards
+    [[nodiscard]] std::shared_ptr<const detail::FunctionBuilder> function(std::string_view name) const noexcept;
+
+    template<typename K>
+    [[nodiscard]] K kernel(std::string_view name) const noexcept { return K::from(function(name)); }
+
+    // the archive must outlive the returned shader
+    template<typename K>
+    [[nodiscard]] auto shader(Device device, std::string_view name) const noexcept;
+};
+
+// A shader loaded from a kernel archive on its first dispatch, using the
+// precompiled binary for the device when available.
+template<size_t N, typename... Args>
+class ArchivedShader {
+
+private:
+    struct State {
+        std::once_flag flag;
+        Shader<N, Args...> shader;
+    };
+
+private:
+    Device _device;
+    const KernelArchive *_archive;
+    std::string _name;
+    std::unique_ptr<State> _state;
+
+public:
+    ArchivedShader(Device device, const KernelArchive *archive, std::string_view name) noexcept
+        : _device{std::move(device)}, _archive{archive}, _name{name}, _state{std::make_unique<State>()} {}
+    [[nodiscard]] auto &name() const noexcept { return _name; }
+    [[nodiscard]] const Shader<N, Args...> &shader() const noexcept {
+        std::call_once(_state->flag, [this] {
+            auto kernel = _archive->kernel<Kernel<N, Args...>>(_name);
+            auto device = _device;
+            auto binary = _archive->binary(_name, device.shader_binary_format());
+            _state->shader = device.compile(kernel, binary);
+        });
+        return _state->shader;
+    }
+    [[nodiscard]] auto operator()(detail::prototype_to_shader_invocation_t<Args>... args) const noexcept {
+        return shader()(args...);
+    }
+};
+
+namespace detail {
+
+template<size_t N, typename... Args>
+ArchivedShader<N, Args...> archived_shader_of(const Kernel<N, Args...> *) noexcept;
+
+}// namespace detail
+
+template<typename K>
+auto KernelArchive::shader(Device device, std::string_view name) const noexcept {
+    using S = decltype(detail::archived_shader_of(std::declval<const K *>()));
+    return S{std::move(device), this, name};
+}
+
+}// namespace luisa::compute
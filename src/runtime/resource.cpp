@@ -3,21 +3,15 @@
 //
 
 #include <runtime/resource.h>
+#include <runtime/destruction_queue.h>
 
 namespace luisa::compute {
 
 void Resource::_destroy() noexcept {
     if (*this) {
-        switch (_tag) {
-            case Tag::BUFFER: _device->destroy_buffer(_handle); break;
-            case Tag::TEXTURE: _device->destroy_texture(_handle); break;
-            case Tag::HEAP: _device->destroy_heap(_handle); break;
-            case Tag::MESH: _device->destroy_mesh(_handle); break;
-            case Tag::ACCEL: _device->destroy_accel(_handle); break;
-            case Tag::STREAM: _device->destroy_stream(_handle); break;
-            case Tag::EVENT: _device->destroy_event(_handle); break;
-            case Tag::SHADER: _device->destroy_shader(_handle); break;
-        }
+        _device->destruction_queue().destroy(_tag, _handle);
+        _device->resource_tracker().on_destroy(_tag, _size_bytes);
+        _device = nullptr;
     }
 }
 
@@ -26,12 +20,15 @@ Resource &Resource::operator=(Resource &&rhs) noexcept {
         _destroy();
         _device = std::move(rhs._device);
         _handle = rhs._handle;
+        _size_bytes = rhs._size_bytes;
         _tag = rhs._tag;
     }
     return *this;
 }
 
-Resource::Resource(Device::Interface *device, Resource::Tag tag, uint64_t handle) noexcept
-: _device{device->shared_from_this()}, _handle{handle}, _tag{tag} {}
+Resource::Resource(Device::Interface *device, Resource::Tag tag, uint64_t handle, size_t size_bytes) noexcept
+    : _device{device->shared_from_this()}, _handle{handle}, _size_bytes{size_bytes}, _tag{tag} {
+    _device->resource_tracker().on_create(tag, size_bytes);
+}
 
 }
@@ -12,25 +12,18 @@ namespace luisa::compute {
 class Resource {
 
 public:
-    enum struct Tag : uint32_t {
-        BUFFER,
-        TEXTURE,
-        HEAP,
-        MESH,
-        ACCEL,
-        STREAM,
-        EVENT,
-        SHADER
-    };
+    using Tag = ResourceTag;
 
 private:
     Device::Handle _device{nullptr};
     uint64_t _handle{0u};
+    size_t _size_bytes{0u};
     Tag _tag{};
 
 protected:
     void _destroy() noexcept;
-    Resource(Device::Interface *device, Tag tag, uint64_t handle) noexcept;
+    // size_bytes is accounted in the device's resource tracker until destruction
+    Resource(Device::Interface *device, Tag tag, uint64_t handle, size_t size_bytes = 0u) noexcept;
 
 public:
     virtual ~Resource() noexcept { _destroy(); }
@@ -43,6 +36,7 @@ public:
     [[nodiscard]] auto device() const noexcept { return _device.get(); }
     [[nodiscard]] auto handle() const noexcept { return _handle; }
     [[nodiscard]] auto tag() const noexcept { return _tag; }
+    [[nodiscard]] auto tracked_size_bytes() const noexcept { return _size_bytes; }
     [[nodiscard]] explicit operator bool() const noexcept { return _device != nullptr; }
 };
 
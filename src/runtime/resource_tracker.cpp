@@ -0,0 +1,88 @@
+//
+// Created by Mike Smith on 2021/9/11.
+//
+
+#include <mutex>
+
+#include <runtime/resource_tracker.h>
+
+namespace luisa::compute {
+
+namespace detail {
+
+inline void atomic_max(std::atomic<size_t> &x, size_t value) noexcept {
+    auto old = x.load(std::memory_order_relaxed);
+    while (old < value && !x.compare_exchange_weak(old, value, std::memory_order_relaxed)) {}
+}
+
+}// namespace detail
+
+size_t ResourceTracker::_increase(Counter &c, size_t bytes) noexcept {
+    auto count = c.count.fetch_add(1u, std::memory_order_relaxed) + 1u;
+    detail::atomic_max(c.peak_count, count);
+    auto total = c.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    detail::atomic_max(c.peak_bytes, total);
+    return total;
+}
+
+void ResourceTracker::_check_budget(size_t old_total, size_t new_total) noexcept {
+    auto budget = _budget.load(std::memory_order_relaxed);
+    if ((old_total <= budget) != (new_total <= budget)) [[unlikely]] {
+        // invoked outside the lock, so the callback may release or create resources
+        auto callback = [this] {
+            std::scoped_lock lock{_budget_mutex};
+            return _budget_callback;
+        }();
+        if (callback) { callback(new_total, budget); }
+    }
+}
+
+void ResourceTracker::on_create(ResourceTag tag, size_t bytes) noexcept {
+    _increase(_counters[static_cast<uint32_t>(tag)], bytes);
+    if (auto new_total = _increase(_total, bytes); bytes != 0u) {
+        _check_budget(new_total - bytes, new_total);
+    }
+}
+
+void ResourceTracker::on_destroy(ResourceTag tag, size_t bytes) noexcept {
+    auto &&c = _counters[static_cast<uint32_t>(tag)];
+    c.count.fetch_sub(1u, std::memory_order_relaxed);
+    _total.count.fetch_sub(1u, std::memory_order_relaxed);
+    if (bytes != 0u) {
+        c.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        auto old_total = _total.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        _check_budget(old_total, old_total - bytes);
+    }
+}
+
+ResourceTracker::Usage ResourceTracker::usage(ResourceTag tag) const noexcept {
+    auto &&c = _counters[static_cast<uint32_t>(tag)];
+    return Usage{c.count.load(std::memory_order_relaxed),
+                 c.bytes.load(std::memory_order_relaxed),
+                 c.peak_count.load(std::memory_order_relaxed),
+                 c.peak_bytes.load(std::memory_order_relaxed)};
+}
+
+ResourceTracker::Usage ResourceTracker::total_usage() const noexcept {
+    return Usage{_total.count.load(std::memory_order_relaxed),
+                 _total.bytes.load(std::memory_order_relaxed),
+                 _total.peak_count.load(std::memory_order_relaxed),
+                 _total.peak_bytes.load(std::memory_order_relaxed)};
+}
+
+void ResourceTracker::set_budget(size_t bytes, BudgetCallback callback) noexcept {
+    std::scoped_lock lock{_budget_mutex};
+    _budget_callback = std::move(callback);
+    _budget.store(bytes, std::memory_order_relaxed);
+}
+
+void ResourceTracker::reset_peaks() noexcept {
+    auto reset = [](Counter &c) noexcept {
+        c.peak_count.store(c.count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        c.peak_bytes.store(c.bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    };
+    for (auto &&c : _counters) { reset(c); }
+    reset(_total);
+}
+
+}// namespace luisa::compute
@@ -0,0 +1,78 @@
+//
+// Created by Mike Smith on 2021/9/11.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#include <util/spin_mutex.h>
+
+namespace luisa::compute {
+
+enum struct ResourceTag : uint32_t {
+    BUFFER,
+    TEXTURE,
+    HEAP,
+    MESH,
+    ACCEL,
+    STREAM,
+    EVENT,
+    SHADER
+};
+
+constexpr auto resource_tag_count = static_cast<uint32_t>(ResourceTag::SHADER) + 1u;
+
+// Per-device counts and sizes of the live resources created through the
+// runtime (see Resource), with high-water marks. Sizes are the requested
+// sizes (buffer bytes, texel bytes of textures, heap capacities), not
+// the backend's allocation granularity; resources allocated from heaps are
+// covered by the heap's capacity. Counters are lock-free.
+class ResourceTracker {
+
+public:
+    struct Usage {
+        size_t count;
+        size_t bytes;
+        size_t peak_count;
+        size_t peak_bytes;
+    };
+
+    // called with the new total and the budget when the total crosses the budget in either direction
+    using BudgetCallback = std::function<void(size_t total_bytes, size_t budget_bytes)>;
+
+private:
+    struct alignas(64) Counter {
+        std::atomic<size_t> count{0u};
+        std::atomic<size_t> bytes{0u};
+        std::atomic<size_t> peak_count{0u};
+        std::atomic<size_t> peak_bytes{0u};
+    };
+
+private:
+    std::array<Counter, resource_tag_count> _counters;
+    Counter _total;
+    std::atomic<size_t> _budget{~0ull};
+    BudgetCallback _budget_callback;
+    spin_mutex _budget_mutex;
+
+private:
+    static size_t _increase(Counter &c, size_t bytes) noexcept;
+    void _check_budget(size_t old_total, size_t new_total) noexcept;
+
+public:
+    void on_create(ResourceTag tag, size_t bytes) noexcept;
+    void on_destroy(ResourceTag tag, size_t bytes) noexcept;
+    [[nodiscard]] Usage usage(ResourceTag tag) const noexcept;
+    [[nodiscard]] Usage total_usage() const noexcept;// over all tags
+    [[nodiscard]] auto budget() const noexcept { return _budget.load(std::memory_order_relaxed); }
+    // a budget of ~0ull disables the callback
+    void set_budget(size_t bytes, BudgetCallback callback) noexcept;
+    // restarts the high-water marks from the current usage
+    void reset_peaks() noexcept;
+};
+
+}// namespace luisa::compute
@@ -188,6 +188,12 @@ private:
             Tag::SHADER,
             device->create_shader(kernel.get())},
           _kernel{std::move(kernel)} {}
+    Shader(Device::Interface *device, std::shared_ptr<const detail::FunctionBuilder> kernel, std::span<const std::byte> binary) noexcept
+        : Resource{
+            device,
+            Tag::SHADER,
+            binary.empty() ? device->create_shader(kernel.get()) : device->create_shader_from_binary(kernel.get(), binary)},
+          _kernel{std::move(kernel)} {}
 
 public:
     Shader() noexcept = default;
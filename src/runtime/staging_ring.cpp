@@ -0,0 +1,95 @@
+//
+// Created by Mike Smith on 2021/9/18.
+//
+
+#include <algorithm>
+
+#include <core/logging.h>
+#include <core/mathematics.h>
+#include <runtime/staging_ring.h>
+
+namespace luisa::compute {
+
+StagingRing::StagingRing(size_t capacity, Allocator allocator, Deallocator deallocator) noexcept
+    : _allocator{std::move(allocator)},
+      _deallocator{std::move(deallocator)},
+      _capacity{std::max(next_pow2(capacity), alignment)} {}
+
+StagingRing::~StagingRing() noexcept {
+    if (_ring.address != nullptr) { _deallocator(_ring); }
+    for (auto &&o : _overflows) { _deallocator(o.block); }
+    for (auto block : _retired) { _deallocator(block); }
+}
+
+StagingRing::Allocation StagingRing::allocate(size_t size_bytes) noexcept {
+    auto size = std::max((size_bytes + alignment - 1u) / alignment * alignment, alignment);
+    if (size > _capacity) [[unlikely]] { return _allocate_overflow(size_bytes); }
+    std::call_once(_ring_created, [this] { _ring = _allocator(_capacity); });
+    auto head = _head.load(std::memory_order_relaxed);
+    for (;;) {
+        // allocations never wrap around, the rest of the ring is skipped instead
+        auto offset = head & (_capacity - 1u);
+        auto begin = offset + size > _capacity ? head + (_capacity - offset) : head;
+        auto end = begin + size;
+        if (end - _tail.load(std::memory_order_acquire) > _capacity) {
+            return _allocate_overflow(size_bytes);
+        }
+        if (_head.compare_exchange_weak(head, end, std::memory_order_relaxed, std::memory_order_relaxed)) {
+            return {_ring, begin & (_capacity - 1u), size_bytes};
+        }
+    }
+}
+
+StagingRing::Allocation StagingRing::_allocate_overflow(size_t size_bytes) noexcept {
+    _free_retired();
+    auto block = _allocator(std::max(size_bytes, alignment));
+    auto count = _overflow_count.fetch_add(1u, std::memory_order_relaxed);
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Staging ring (capacity = {}) overflowed into dedicated "
+        "block of {} bytes (overflow #{}).",
+        _capacity, size_bytes, count);
+    std::scoped_lock lock{_overflow_mutex};
+    _overflows.emplace_back(Overflow{_epoch.load(std::memory_order_relaxed), block});
+    _pending_overflow_count.fetch_add(1u, std::memory_order_relaxed);
+    return {block, 0u, size_bytes};
+}
+
+void StagingRing::_free_retired() noexcept {
+    if (_retired_count.load(std::memory_order_relaxed) == 0u) [[likely]] { return; }
+    std::vector<Block> retired;
+    {
+        std::scoped_lock lock{_overflow_mutex};
+        retired.swap(_retired);
+        _retired_count.store(0u, std::memory_order_relaxed);
+    }
+    for (auto block : retired) { _deallocator(block); }
+}
+
+StagingRing::Fence StagingRing::fence() noexcept {
+    _free_retired();
+    auto position = _head.load(std::memory_order_relaxed);
+    return {position, _epoch.fetch_add(1u, std::memory_order_relaxed)};
+}
+
+void StagingRing::reclaim(Fence fence) noexcept {
+    // released, so that the memory is not reused before the stream has finished with it
+    auto tail = _tail.load(std::memory_order_relaxed);
+    while (tail < fence.position &&
+           !_tail.compare_exchange_weak(tail, fence.position, std::memory_order_release, std::memory_order_relaxed)) {}
+    if (_pending_overflow_count.load(std::memory_order_relaxed) == 0u) [[likely]] { return; }
+    // passed overflow blocks are only retired here, to be freed outside the callback
+    std::scoped_lock lock{_overflow_mutex};
+    auto iter = std::partition(_overflows.begin(), _overflows.end(), [&fence](auto &&o) noexcept {
+        return o.epoch > fence.epoch;
+    });
+    for (auto o = iter; o != _overflows.end(); o++) { _retired.emplace_back(o->block); }
+    _overflows.erase(iter, _overflows.end());
+    _pending_overflow_count.store(_overflows.size(), std::memory_order_relaxed);
+    _retired_count.store(_retired.size(), std::memory_order_relaxed);
+}
+
+size_t StagingRing::in_flight_bytes() const noexcept {
+    return _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_relaxed);
+}
+
+}// namespace luisa::compute
@@ -0,0 +1,107 @@
+//
+// Created by Mike Smith on 2021/9/18.
+//
+
+#pragma once
+
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <functional>
+
+#include <core/concepts.h>
+#include <util/spin_mutex.h>
+
+namespace luisa::compute {
+
+// Host staging memory for the uploads and downloads of one stream, for
+// backends to allocate from while encoding commands.
+//
+// Allocations bump the head of a ring with a single CAS. Dispatching a command
+// list takes a fence (the head and an epoch), and once the stream has passed
+// the list, reclaim(fence) frees everything allocated before the fence by
+// moving the tail up to it. Requests that do not fit, i.e., larger than the
+// ring or while it is full of work in flight, overflow into dedicated blocks
+// retired by the same fences, so allocation never fails or waits.
+//
+// reclaim() never calls the deallocator, as it is typically called from
+// stream callbacks that must not free device-visible memory (e.g., CUDA host
+// functions). Retired blocks are freed by the next fence() or overflowing
+// allocate() instead, or when the ring is destroyed.
+//
+// The backend provides the memory (e.g., pinned host memory or shared device
+// buffers), the ring itself on the first allocation. allocate() is lock-free
+// (except on overflow) and thread-safe; fences must be taken in dispatch order
+// and reclaimed in completion order, which is the same on a stream.
+class StagingRing : concepts::Noncopyable {
+
+public:
+    struct Block {
+        std::byte *address;
+        uint64_t handle;// backend-defined, e.g., the buffer the address belongs to
+    };
+
+    using Allocator = std::function<Block(size_t size_bytes)>;
+    using Deallocator = std::function<void(Block block)>;
+
+    struct Allocation {
+        Block block;
+        size_t offset;// into the block
+        size_t size;
+        [[nodiscard]] auto data() const noexcept { return block.address + offset; }
+        [[nodiscard]] auto span() const noexcept { return std::span{data(), size}; }
+    };
+
+    struct Fence {
+        uint64_t position;
+        uint64_t epoch;
+    };
+
+    static constexpr auto alignment = static_cast<size_t>(16u);
+
+private:
+    struct Overflow {
+        uint64_t epoch;
+        Block block;
+    };
+
+private:
+    Allocator _allocator;
+    Deallocator _deallocator;
+    size_t _capacity;
+    std::once_flag _ring_created;
+    Block _ring{};
+    std::atomic<uint64_t> _head{0u};
+    std::atomic<uint64_t> _tail{0u};
+    std::atomic<uint64_t> _epoch{0u};
+    spin_mutex _overflow_mutex;
+    std::vector<Overflow> _overflows;
+    std::vector<Block> _retired;
+    std::atomic<size_t> _pending_overflow_count{0u};
+    std::atomic<size_t> _retired_count{0u};
+    std::atomic<size_t> _overflow_count{0u};
+
+private:
+    [[nodiscard]] Allocation _allocate_overflow(size_t size_bytes) noexcept;
+    void _free_retired() noexcept;
+
+public:
+    // the capacity is rounded up to a power of two
+    StagingRing(size_t capacity, Allocator allocator, Deallocator deallocator) noexcept;
+    // the stream must have passed all allocations
+    ~StagingRing() noexcept;
+
+    [[nodiscard]] Allocation allocate(size_t size_bytes) noexcept;
+    // covers the allocations made so far, to be reclaimed once the stream has passed them
+    [[nodiscard]] Fence fence() noexcept;
+    // safe to call in stream callbacks, see above
+    void reclaim(Fence fence) noexcept;
+
+    [[nodiscard]] auto capacity() const noexcept { return _capacity; }
+    [[nodiscard]] size_t in_flight_bytes() const noexcept;// in the ring, overflows excluded
+    // since creation
+    [[nodiscard]] auto overflow_count() const noexcept { return _overflow_count.load(std::memory_order_relaxed); }
+};
+
+}// namespace luisa::compute
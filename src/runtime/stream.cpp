@@ -5,6 +5,8 @@
 #include <utility>
 #include <runtime/device.h>
 #include <runtime/stream.h>
+#include <runtime/stream_profiler.h>
+#include <runtime/destruction_queue.h>
 
 namespace luisa::compute {
 
@@ -13,22 +15,48 @@ Stream Device::create_stream() noexcept {
 }
 
 void Stream::_dispatch(CommandList command_buffer) noexcept {
-    device()->dispatch(handle(), std::move(command_buffer));
+    // collected before the commands are recycled, but recorded after they are submitted
+    auto uses = DestructionQueue::collect(command_buffer);
+    if (_profiler == nullptr) [[likely]] {
+        device()->dispatch(handle(), std::move(command_buffer));
+    } else {
+        _dispatch_profiled(std::move(command_buffer));
+    }
+    device()->destruction_queue().on_dispatch(handle(), uses);
+}
+
+void Stream::_dispatch_profiled(CommandList command_buffer) noexcept {
+    auto first = _profiler->enqueue(handle(), command_buffer);
+    device()->dispatch_profiled(
+        handle(), std::move(command_buffer),
+        [profiler = _profiler, first](std::span<const CommandTimestamps> timestamps) noexcept {
+            profiler->complete(first, timestamps);
+        });
+}
+
+void Stream::_use_event(uint64_t event_handle) noexcept {
+    DestructionQueue::Use use{ResourceTag::EVENT, event_handle};
+    device()->destruction_queue().on_dispatch(handle(), std::span{&use, 1u});
 }
 
 Stream::Delegate Stream::operator<<(Command *cmd) noexcept {
     return Delegate{this} << cmd;
 }
 
-void Stream::_synchronize() noexcept { device()->synchronize_stream(handle()); }
+void Stream::_synchronize() noexcept {
+    device()->synchronize_stream(handle());
+    device()->destruction_queue().on_synchronize(handle());
+}
 
 Stream &Stream::operator<<(Event::Signal signal) noexcept {
     device()->signal_event(signal.handle, handle());
+    _use_event(signal.handle);
     return *this;
 }
 
 Stream &Stream::operator<<(Event::Wait wait) noexcept {
     device()->wait_event(wait.handle, handle());
+    _use_event(wait.handle);
     return *this;
 }
 
@@ -77,6 +105,12 @@ Stream::Delegate &&Stream::Delegate::operator<<(Stream::Synchronize) &&noexcept
     return std::move(*this);
 }
 
+Stream::Delegate &&Stream::Delegate::operator<<(FileCopy copy) &&noexcept {
+    _commit();
+    *_stream << std::move(copy);
+    return std::move(*this);
+}
+
 Stream::Delegate &&Stream::Delegate::operator<<(CommandBuffer::Commit) &&noexcept {
     _commit();
     return std::move(*this);
@@ -4,16 +4,21 @@
 
 #pragma once
 
+#include <memory>
 #include <utility>
 
 #include <util/spin_mutex.h>
 #include <runtime/resource.h>
 #include <runtime/event.h>
+#include <runtime/file_copy.h>
 #include <runtime/command_list.h>
 #include <runtime/command_buffer.h>
 
 namespace luisa::compute {
 
+class StreamProfiler;
+class FileCopyStaging;
+
 class Stream : public Resource {
 
 public:
@@ -41,11 +46,18 @@ public:
         Delegate &&operator<<(Event::Wait wait) &&noexcept;
         Delegate &&operator<<(CommandBuffer::Commit) &&noexcept;
         Delegate &&operator<<(Synchronize) &&noexcept;
+        Delegate &&operator<<(FileCopy copy) &&noexcept;
     };
 
+private:
+    std::shared_ptr<StreamProfiler> _profiler;
+    std::shared_ptr<FileCopyStaging> _file_staging;// created by the first file copy
+
 private:
     friend class Device;
     void _dispatch(CommandList command_buffer) noexcept;
+    void _dispatch_profiled(CommandList command_buffer) noexcept;
+    void _use_event(uint64_t event_handle) noexcept;
     explicit Stream(Device::Interface *device) noexcept;
     void _synchronize() noexcept;
 
@@ -55,10 +67,15 @@ public:
     Stream &operator<<(Event::Signal signal) noexcept;
     Stream &operator<<(Event::Wait wait) noexcept;
     Stream &operator<<(Synchronize) noexcept;
+    Stream &operator<<(FileCopy copy) noexcept;// see definition in runtime/file_copy.cpp
     Stream &operator<<(CommandBuffer::Commit) noexcept { return *this; }
     Delegate operator<<(Command *cmd) noexcept;
     [[nodiscard]] auto command_buffer() noexcept { return CommandBuffer{this}; }
     void synchronize() noexcept { _synchronize(); }
+    // records the timings of every dispatched command into the profiler (may be shared
+    // by several streams) until reset with nullptr; see runtime/stream_profiler.h
+    void set_profiler(std::shared_ptr<StreamProfiler> profiler) noexcept { _profiler = std::move(profiler); }
+    [[nodiscard]] auto &profiler() const noexcept { return _profiler; }
 };
 
 [[nodiscard]] constexpr auto synchronize() noexcept { return Stream::Synchronize{}; }
@@ -0,0 +1,182 @@
+//
+// Created by Mike Smith on 2021/9/9.
+//
+
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+#include <core/clock.h>
+#include <core/hash.h>
+#include <core/logging.h>
+#include <runtime/command.h>
+#include <runtime/stream_profiler.h>
+
+namespace luisa::compute {
+
+void Device::Interface::dispatch_profiled(uint64_t stream_handle, CommandList list, TimestampCallback callback) noexcept {
+    // without backend timestamps, serialize the commands and time them on the host;
+    // the leading synchronization keeps previously enqueued work out of the first interval
+    synchronize_stream(stream_handle);
+    std::vector<CommandTimestamps> timestamps;
+    while (auto command = list.pop_front()) {
+        CommandList single;
+        single.append(command);
+        auto start = Clock::timestamp();
+        dispatch(stream_handle, std::move(single));
+        synchronize_stream(stream_handle);
+        timestamps.emplace_back(CommandTimestamps{start, Clock::timestamp(), true});
+    }
+    callback(timestamps);
+}
+
+namespace detail {
+
+class CommandNameVisitor final : public CommandVisitor {
+
+private:
+    StreamProfiler::Record &_record;
+
+public:
+    explicit CommandNameVisitor(StreamProfiler::Record &r) noexcept : _record{r} {}
+    void visit(const BufferUploadCommand *) noexcept override { _record.name = "buffer_upload"; }
+    void visit(const BufferDownloadCommand *) noexcept override { _record.name = "buffer_download"; }
+    void visit(const BufferCopyCommand *) noexcept override { _record.name = "buffer_copy"; }
+    void visit(const BufferToTextureCopyCommand *) noexcept override { _record.name = "buffer_to_texture_copy"; }
+    void visit(const ShaderDispatchCommand *command) noexcept override {
+        _record.kernel_hash = command->kernel().hash();
+        _record.name = fmt::format("kernel_{}", hash_to_string(_record.kernel_hash));
+    }
+    void visit(const TextureUploadCommand *) noexcept override { _record.name = "texture_upload"; }
+    void visit(const TextureDownloadCommand *) noexcept override { _record.name = "texture_download"; }
+    void visit(const TextureCopyCommand *) noexcept override { _record.name = "texture_copy"; }
+    void visit(const TextureToBufferCopyCommand *) noexcept override { _record.name = "texture_to_buffer_copy"; }
+    void visit(const AccelUpdateCommand *) noexcept override { _record.name = "accel_update"; }
+    void visit(const AccelBuildCommand *) noexcept override { _record.name = "accel_build"; }
+    void visit(const MeshUpdateCommand *) noexcept override { _record.name = "mesh_update"; }
+    void visit(const MeshBuildCommand *) noexcept override { _record.name = "mesh_build"; }
+};
+
+}// namespace detail
+
+StreamProfiler::StreamProfiler() noexcept : _epoch{Clock::timestamp()} {}
+
+size_t StreamProfiler::enqueue(uint64_t stream, const CommandList &list) noexcept {
+    auto enqueue_time = Clock::timestamp();
+    std::vector<Record> records;
+    for (auto command : list) {
+        auto &&r = records.emplace_back();
+        r.stream = stream;
+        r.enqueue = enqueue_time;
+        detail::CommandNameVisitor visitor{r};
+        command->accept(visitor);
+    }
+    std::scoped_lock lock{_mutex};
+    _stream_indices.try_emplace(stream, static_cast<uint32_t>(_stream_indices.size()));
+    auto first = _base + _records.size();
+    std::move(records.begin(), records.end(), std::back_inserter(_records));
+    return first;
+}
+
+void StreamProfiler::complete(size_t first, std::span<const CommandTimestamps> timestamps) noexcept {
+    std::scoped_lock lock{_mutex};
+    if (first < _base) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Dropping {} command timestamps reported after the profiler was cleared.",
+            timestamps.size());
+        return;
+    }
+    auto offset = first - _base;
+    for (auto i = 0u; i < timestamps.size() && offset + i < _records.size(); i++) {
+        _records[offset + i].start = timestamps[i].start;
+        _records[offset + i].end = timestamps[i].end;
+        _records[offset + i].host_synchronous = timestamps[i].host_synchronous;
+    }
+}
+
+std::vector<StreamProfiler::Record> StreamProfiler::records() const noexcept {
+    std::scoped_lock lock{_mutex};
+    return _records;
+}
+
+std::vector<StreamProfiler::Aggregate> StreamProfiler::aggregates() const noexcept {
+    std::unordered_map<std::string, std::vector<double>> durations;
+    std::unordered_map<std::string, bool> host_synchronous;
+    {
+        std::scoped_lock lock{_mutex};
+        for (auto &&r : _records) {
+            if (r.end != 0u) {
+                durations[r.name].emplace_back(static_cast<double>(r.end - r.start) * 1e-6);
+                host_synchronous[r.name] |= r.host_synchronous;
+            }
+        }
+    }
+    std::vector<Aggregate> aggregates;
+    aggregates.reserve(durations.size());
+    for (auto &&[name, d] : durations) {
+        std::sort(d.begin(), d.end());
+        // nearest-rank percentiles
+        auto percentile = [&d = d](double p) noexcept {
+            auto rank = static_cast<size_t>(std::ceil(p * static_cast<double>(d.size())));
+            return d[std::clamp(rank, size_t{1u}, d.size()) - 1u];
+        };
+        Aggregate a;
+        a.name = name;
+        a.count = d.size();
+        for (auto t : d) { a.total += t; }
+        a.p50 = percentile(.5);
+        a.p99 = percentile(.99);
+        a.host_synchronous = host_synchronous[name];
+        aggregates.emplace_back(std::move(a));
+    }
+    std::sort(aggregates.begin(), aggregates.end(), [](auto &&lhs, auto &&rhs) noexcept {
+        return lhs.total > rhs.total;
+    });
+    return aggregates;
+}
+
+void StreamProfiler::export_chrome_trace(const std::filesystem::path &path) const noexcept {
+    std::ofstream file{path};
+    if (!file) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Failed to open trace file '{}'.", path.string());
+    }
+    // one process per stream, with the host enqueues and the executed commands as two threads
+    auto us = [this](uint64_t t) noexcept { return static_cast<double>(t - _epoch) * 1e-3; };
+    std::scoped_lock lock{_mutex};
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    auto separator = "\n";
+    for (auto [stream, index] : _stream_indices) {
+        file << separator
+             << fmt::format(R"({{"name":"process_name","ph":"M","pid":{},"args":{{"name":"Stream #{}"}}}},)", index, index) << "\n"
+             << fmt::format(R"({{"name":"thread_name","ph":"M","pid":{},"tid":0,"args":{{"name":"Host"}}}},)", index) << "\n"
+             << fmt::format(R"({{"name":"thread_name","ph":"M","pid":{},"tid":1,"args":{{"name":"Device"}}}})", index);
+        separator = ",\n";
+    }
+    for (auto &&r : _records) {
+        auto pid = _stream_indices.at(r.stream);
+        file << separator
+             << fmt::format(R"({{"name":"{}","cat":"enqueue","ph":"i","s":"t","pid":{},"tid":0,"ts":{:.3f}}})",
+                            r.name, pid, us(r.enqueue));
+        if (r.end != 0u) {
+            file << ",\n"
+                 << fmt::format(R"({{"name":"{}","cat":"command","ph":"X","pid":{},"tid":1,"ts":{:.3f},"dur":{:.3f},)"
+                                R"("args":{{"latency_us":{:.3f},"host_synchronous":{}}}}})",
+                                r.name, pid, us(r.start), static_cast<double>(r.end - r.start) * 1e-3,
+                                static_cast<double>(r.start - std::min(r.start, r.enqueue)) * 1e-3,
+                                r.host_synchronous);
+        }
+        separator = ",\n";
+    }
+    file << "\n]}\n";
+    LUISA_INFO("Exported {} profiled commands to '{}'.", _records.size(), path.string());
+}
+
+void StreamProfiler::clear() noexcept {
+    std::scoped_lock lock{_mutex};
+    _base += _records.size();
+    _records.clear();
+    _stream_indices.clear();
+}
+
+}// namespace luisa::compute
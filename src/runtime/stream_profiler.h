@@ -0,0 +1,66 @@
+//
+// Created by Mike Smith on 2021/9/9.
+//
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+#include <runtime/device.h>
+
+namespace luisa::compute {
+
+// Collects per-command timings from the streams it is attached to (see
+// Stream::set_profiler()). Each command is recorded with the host time it
+// was enqueued and its execution interval as reported by the backend; the
+// records can be exported as a Chrome trace (chrome://tracing, Perfetto)
+// or summarized per kernel. Streams without a profiler pay nothing.
+// Backends without device timestamps are timed on the host by waiting for
+// every command, which is flagged in the records since such numbers include
+// the submission latency and profiled streams no longer overlap their work.
+class StreamProfiler {
+
+public:
+    struct Record {
+        std::string name;       // "kernel_<hash>" for shader dispatches, the command type otherwise
+        uint64_t kernel_hash{0u};// 0 for non-dispatch commands
+        uint64_t stream{0u};
+        uint64_t enqueue{0u};// timestamps in nanoseconds, see Clock::timestamp()
+        uint64_t start{0u};
+        uint64_t end{0u};// 0 until the backend reports the command
+        bool host_synchronous{false};// see CommandTimestamps
+    };
+
+    struct Aggregate {
+        std::string name;
+        size_t count{0u};
+        double total{0.0};// in milliseconds
+        double p50{0.0};
+        double p99{0.0};
+        bool host_synchronous{false};// any of the commands was timed host-synchronously
+    };
+
+private:
+    mutable std::mutex _mutex;
+    std::vector<Record> _records;
+    std::unordered_map<uint64_t, uint32_t> _stream_indices;
+    size_t _base{0u};// number of records cleared, keeps late completions from hitting new records
+    uint64_t _epoch;
+
+public:
+    StreamProfiler() noexcept;
+    // appends the records of a command list and returns the sequence number of the first one
+    [[nodiscard]] size_t enqueue(uint64_t stream, const CommandList &list) noexcept;
+    void complete(size_t first, std::span<const CommandTimestamps> timestamps) noexcept;
+    [[nodiscard]] std::vector<Record> records() const noexcept;
+    // completed commands grouped by name, sorted by descending total time
+    [[nodiscard]] std::vector<Aggregate> aggregates() const noexcept;
+    void export_chrome_trace(const std::filesystem::path &path) const noexcept;
+    void clear() noexcept;
+};
+
+}// namespace luisa::compute
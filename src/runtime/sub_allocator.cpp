@@ -0,0 +1,246 @@
+//
+// Created by Mike Smith on 2021/9/12.
+//
+
+#include <bit>
+#include <iterator>
+#include <algorithm>
+
+#include <core/logging.h>
+#include <runtime/sub_allocator.h>
+
+namespace luisa::compute {
+
+SubAllocator::SubAllocator(Callbacks callbacks, size_t block_size, size_t alignment) noexcept
+    : _callbacks{std::move(callbacks)},
+      _block_size{block_size},
+      _alignment{alignment} {
+    if (!std::has_single_bit(alignment) || block_size % alignment != 0u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION(
+            "Invalid sub-allocator configuration (block size = {}, alignment = {}).",
+            block_size, alignment);
+    }
+    auto small_class_count = std::bit_width(std::max(small_size_limit / alignment, static_cast<size_t>(1u)));
+    _small_caches.resize(small_class_count);
+}
+
+SubAllocator::~SubAllocator() noexcept {
+    trim();
+    if (_allocation_count != 0u) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Destroying sub-allocator with {} live allocations ({} bytes).",
+            _allocation_count, _allocated_bytes);
+    }
+    for (auto block : _blocks) {
+        _callbacks.destroy_block(block->handle, block->size);
+        delete block;
+    }
+}
+
+std::pair<uint, uint> SubAllocator::_mapping(size_t units) noexcept {
+    if (units < sl_count) { return {0u, static_cast<uint>(units)}; }
+    auto f = static_cast<uint>(std::bit_width(units) - 1u);
+    auto s = static_cast<uint>((units >> (f - sl_log2)) ^ sl_count);
+    return {f - sl_log2 + 1u, s};
+}
+
+std::pair<uint, uint> SubAllocator::_mapping_search(size_t units) noexcept {
+    // round up to the next list boundary, so that any chunk in the found list fits
+    if (units >= sl_count) { units += (static_cast<size_t>(1u) << (std::bit_width(units) - 1u - sl_log2)) - 1u; }
+    return _mapping(units);
+}
+
+size_t SubAllocator::_round(size_t size) const noexcept {
+    auto rounded = (std::max(size, static_cast<size_t>(1u)) + _alignment - 1u) / _alignment * _alignment;
+    return rounded <= small_size_limit ? std::bit_ceil(rounded) : rounded;
+}
+
+int SubAllocator::_small_class(size_t rounded_size) const noexcept {
+    if (rounded_size > small_size_limit) { return -1; }
+    return static_cast<int>(std::bit_width(rounded_size / _alignment) - 1u);
+}
+
+void SubAllocator::_insert_free(Chunk *chunk) noexcept {
+    auto [fl, sl] = _mapping(_units(chunk->size));
+    auto &&head = _free_lists[fl][sl];
+    chunk->prev_free = nullptr;
+    chunk->next_free = head;
+    if (head != nullptr) { head->prev_free = chunk; }
+    head = chunk;
+    chunk->is_free = true;
+    chunk->block->empty = chunk->size == chunk->block->size;
+    _fl_bitmap |= static_cast<uint64_t>(1u) << fl;
+    _sl_bitmaps[fl] |= 1u << sl;
+}
+
+void SubAllocator::_remove_free(Chunk *chunk) noexcept {
+    auto [fl, sl] = _mapping(_units(chunk->size));
+    if (chunk->prev_free != nullptr) { chunk->prev_free->next_free = chunk->next_free; }
+    if (chunk->next_free != nullptr) { chunk->next_free->prev_free = chunk->prev_free; }
+    if (_free_lists[fl][sl] == chunk) {
+        _free_lists[fl][sl] = chunk->next_free;
+        if (chunk->next_free == nullptr) {
+            _sl_bitmaps[fl] &= ~(1u << sl);
+            if (_sl_bitmaps[fl] == 0u) { _fl_bitmap &= ~(static_cast<uint64_t>(1u) << fl); }
+        }
+    }
+    chunk->is_free = false;
+    chunk->block->empty = false;
+}
+
+SubAllocator::Chunk *SubAllocator::_find_free(size_t size) noexcept {
+    auto [fl, sl] = _mapping_search(_units(size));
+    if (fl >= fl_count) { return nullptr; }
+    auto sl_map = _sl_bitmaps[fl] & (~0u << sl);
+    if (sl_map == 0u) {
+        auto fl_map = fl + 1u < fl_count ? _fl_bitmap & (~static_cast<uint64_t>(0u) << (fl + 1u)) : 0u;
+        if (fl_map == 0u) { return nullptr; }
+        fl = static_cast<uint>(std::countr_zero(fl_map));
+        sl_map = _sl_bitmaps[fl];
+    }
+    sl = static_cast<uint>(std::countr_zero(sl_map));
+    auto chunk = _free_lists[fl][sl];
+    _remove_free(chunk);
+    return chunk;
+}
+
+SubAllocator::Chunk *SubAllocator::_create_block(size_t size) noexcept {
+    auto handle = _callbacks.create_block(size);
+    if (handle == 0u) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION("Failed to create device memory block of {} bytes.", size);
+        return nullptr;
+    }
+    auto block = new Block{handle, size, false};
+    _blocks.emplace_back(block);
+    auto chunk = _chunk_pool.create();
+    chunk->block = block;
+    chunk->size = size;
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Created device memory block #{} with {} bytes (blocks = {}).",
+        handle, size, _blocks.size());
+    return chunk;
+}
+
+void SubAllocator::_destroy_block(Block *block) noexcept {
+    _callbacks.destroy_block(block->handle, block->size);
+    _blocks.erase(std::find(_blocks.begin(), _blocks.end(), block));
+    delete block;
+}
+
+void SubAllocator::_release(Chunk *chunk) noexcept {
+    if (auto prev = chunk->prev_physical; prev != nullptr && prev->is_free) {
+        _remove_free(prev);
+        prev->size += chunk->size;
+        prev->next_physical = chunk->next_physical;
+        if (chunk->next_physical != nullptr) { chunk->next_physical->prev_physical = prev; }
+        _chunk_pool.recycle(chunk);
+        chunk = prev;
+    }
+    if (auto next = chunk->next_physical; next != nullptr && next->is_free) {
+        _remove_free(next);
+        chunk->size += next->size;
+        chunk->next_physical = next->next_physical;
+        if (next->next_physical != nullptr) { next->next_physical->prev_physical = chunk; }
+        _chunk_pool.recycle(next);
+    }
+    auto block = chunk->block;
+    if (chunk->size == block->size) {
+        // keep a single empty regular block in reserve, dedicated ones are always released
+        auto has_reserve = std::any_of(_blocks.cbegin(), _blocks.cend(), [block](auto b) noexcept {
+            return b != block && b->empty;
+        });
+        if (block->size > _block_size || has_reserve) {
+            _chunk_pool.recycle(chunk);
+            _destroy_block(block);
+            return;
+        }
+    }
+    _insert_free(chunk);
+}
+
+void SubAllocator::_drain_pending() noexcept {
+    auto chunk = _pending.exchange(nullptr, std::memory_order_acquire);
+    while (chunk != nullptr) {
+        auto next = chunk->next_pending;
+        _allocated_bytes -= chunk->size;
+        _allocation_count--;
+        if (auto c = _small_class(chunk->size);
+            c >= 0 && _small_caches[c].size() < small_cache_capacity) {
+            _small_caches[c].emplace_back(chunk);
+        } else {
+            _release(chunk);
+        }
+        chunk = next;
+    }
+}
+
+SubAllocator::Allocation SubAllocator::allocate(size_t size) noexcept {
+    auto rounded = _round(size);
+    std::scoped_lock lock{_mutex};
+    _drain_pending();
+    Chunk *chunk = nullptr;
+    if (auto c = _small_class(rounded); c >= 0 && !_small_caches[c].empty()) {
+        chunk = _small_caches[c].back();
+        _small_caches[c].pop_back();
+    } else if (rounded > _block_size) {
+        chunk = _create_block(rounded);
+    } else {
+        chunk = _find_free(rounded);
+        if (chunk == nullptr) { chunk = _create_block(_block_size); }
+        if (chunk != nullptr && chunk->size > rounded) {
+            auto rest = _chunk_pool.create();
+            rest->block = chunk->block;
+            rest->offset = chunk->offset + rounded;
+            rest->size = chunk->size - rounded;
+            rest->prev_physical = chunk;
+            rest->next_physical = chunk->next_physical;
+            if (chunk->next_physical != nullptr) { chunk->next_physical->prev_physical = rest; }
+            chunk->next_physical = rest;
+            chunk->size = rounded;
+            _insert_free(rest);
+        }
+    }
+    if (chunk == nullptr) [[unlikely]] { return {}; }
+    _allocated_bytes += chunk->size;
+    _allocation_count++;
+    return Allocation{chunk->block->handle, chunk->offset, chunk->size, chunk};
+}
+
+void SubAllocator::free(Allocation allocation) noexcept {
+    auto chunk = allocation.chunk;
+    if (chunk == nullptr) { return; }
+    auto head = _pending.load(std::memory_order_relaxed);
+    do {
+        chunk->next_pending = head;
+    } while (!_pending.compare_exchange_weak(head, chunk, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void SubAllocator::trim() noexcept {
+    std::scoped_lock lock{_mutex};
+    _drain_pending();
+    for (auto &&cache : _small_caches) {
+        for (auto chunk : cache) { _release(chunk); }
+        cache.clear();
+    }
+    // the reserve block is kept by _release(), release it as well
+    std::vector<Block *> empty_blocks;
+    std::copy_if(_blocks.cbegin(), _blocks.cend(), std::back_inserter(empty_blocks), [](auto b) noexcept { return b->empty; });
+    for (auto block : empty_blocks) {
+        auto [fl, sl] = _mapping(_units(block->size));
+        auto chunk = _free_lists[fl][sl];
+        while (chunk->block != block) { chunk = chunk->next_free; }
+        _remove_free(chunk);
+        _chunk_pool.recycle(chunk);
+        _destroy_block(block);
+    }
+}
+
+SubAllocator::Statistics SubAllocator::statistics() noexcept {
+    std::scoped_lock lock{_mutex};
+    _drain_pending();
+    Statistics s{_blocks.size(), 0u, _allocated_bytes, _allocation_count};
+    for (auto b : _blocks) { s.reserved_bytes += b->size; }
+    return s;
+}
+
+}// namespace luisa::compute
@@ -0,0 +1,134 @@
+//
+// Created by Mike Smith on 2021/9/12.
+//
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include <core/basic_types.h>
+#include <util/arena.h>
+
+namespace luisa::compute {
+
+// Backend-agnostic TLSF (two-level segregated fit) allocator carving small
+// allocations out of large device memory blocks. Backends provide callbacks
+// to create and destroy blocks, e.g., with cuMemAlloc/cuMemFree, and use
+// (block, offset) pairs as their buffers' memory.
+//
+// - Allocation and coalescing are O(1) with bitmap lookups over 64 x 16
+//   segregated free lists, under a mutex.
+// - Sizes up to small_size_limit are rounded to power-of-two classes whose
+//   freed chunks are cached without coalescing, so steady churn of small
+//   buffers hits a per-class free list.
+// - free() is lock-free: it pushes onto an intrusive stack that the next
+//   allocate() (or trim()) drains.
+// - Requests larger than the block size get dedicated blocks, and blocks
+//   that become entirely free are released beyond the one kept in reserve.
+class SubAllocator : concepts::Noncopyable {
+
+public:
+    struct Chunk;
+
+    struct Allocation {
+        uint64_t block{0u};// as returned by the block creation callback
+        size_t offset{0u};
+        size_t size{0u};
+        Chunk *chunk{nullptr};
+        [[nodiscard]] explicit operator bool() const noexcept { return chunk != nullptr; }
+    };
+
+    struct Callbacks {
+        // returns 0 on failure
+        std::function<uint64_t(size_t size)> create_block;
+        std::function<void(uint64_t block, size_t size)> destroy_block;
+    };
+
+    struct Statistics {
+        size_t block_count;
+        size_t reserved_bytes; // in blocks
+        size_t allocated_bytes;// in live allocations, after rounding
+        size_t allocation_count;
+    };
+
+    static constexpr auto default_block_size = static_cast<size_t>(64u) << 20u;
+    static constexpr auto default_alignment = static_cast<size_t>(256u);
+    static constexpr auto small_size_limit = static_cast<size_t>(64u) << 10u;
+    static constexpr auto small_cache_capacity = 64u;
+
+private:
+    static constexpr auto sl_log2 = 4u;
+    static constexpr auto sl_count = 1u << sl_log2;
+    static constexpr auto fl_count = 64u;
+
+    struct Block {
+        uint64_t handle;
+        size_t size;
+        bool empty;// covered by a single free chunk
+    };
+
+public:
+    struct Chunk {
+        Block *block;
+        size_t offset;
+        size_t size;
+        Chunk *prev_physical;
+        Chunk *next_physical;
+        Chunk *prev_free;
+        Chunk *next_free;
+        Chunk *next_pending;
+        bool is_free;
+    };
+
+private:
+    Callbacks _callbacks;
+    size_t _block_size;
+    size_t _alignment;
+    std::mutex _mutex;
+    Arena _arena;
+    Pool<Chunk> _chunk_pool{_arena};
+    std::vector<Block *> _blocks;
+    uint64_t _fl_bitmap{0u};
+    std::array<uint32_t, fl_count> _sl_bitmaps{};
+    std::array<std::array<Chunk *, sl_count>, fl_count> _free_lists{};
+    std::vector<std::vector<Chunk *>> _small_caches;
+    std::atomic<Chunk *> _pending{nullptr};
+    size_t _allocated_bytes{0u};
+    size_t _allocation_count{0u};
+
+private:
+    [[nodiscard]] static std::pair<uint, uint> _mapping(size_t units) noexcept;
+    [[nodiscard]] static std::pair<uint, uint> _mapping_search(size_t units) noexcept;
+    [[nodiscard]] size_t _units(size_t size) const noexcept { return size / _alignment; }
+    void _insert_free(Chunk *chunk) noexcept;
+    void _remove_free(Chunk *chunk) noexcept;
+    [[nodiscard]] Chunk *_find_free(size_t size) noexcept;
+    [[nodiscard]] Chunk *_create_block(size_t size) noexcept;
+    void _release(Chunk *chunk) noexcept;
+    void _drain_pending() noexcept;
+    void _destroy_block(Block *block) noexcept;
+    [[nodiscard]] size_t _round(size_t size) const noexcept;
+    [[nodiscard]] int _small_class(size_t rounded_size) const noexcept;
+
+public:
+    explicit SubAllocator(Callbacks callbacks,
+                          size_t block_size = default_block_size,
+                          size_t alignment = default_alignment) noexcept;
+    ~SubAllocator() noexcept;
+    // returns an empty allocation if block creation fails
+    [[nodiscard]] Allocation allocate(size_t size) noexcept;
+    // thread-safe and lock-free, the memory is reused after the next allocate() or trim()
+    void free(Allocation allocation) noexcept;
+    // drains pending frees and returns cached small chunks and empty blocks to the backend
+    void trim() noexcept;
+    [[nodiscard]] Statistics statistics() noexcept;
+    [[nodiscard]] auto block_size() const noexcept { return _block_size; }
+    [[nodiscard]] auto alignment() const noexcept { return _alignment; }
+};
+
+}// namespace luisa::compute
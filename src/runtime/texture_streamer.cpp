@@ -0,0 +1,358 @@
+//
+// Created by Mike Smith on 2021/9/16.
+//
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <algorithm>
+
+#include <core/logging.h>
+#include <runtime/texture_streamer.h>
+
+namespace luisa::compute {
+
+TextureStreamer::TextureStreamer(Stream &stream, Heap &heap, uint capacity, size_t budget_bytes,
+                                 uint tail_size, uint max_frames_in_flight) noexcept
+    : _stream{&stream},
+      _heap{&heap},
+      _budget_bytes{budget_bytes},
+      _tail_size{std::max(tail_size, 1u)},
+      _max_frames_in_flight{std::max(max_frames_in_flight, 1u)},
+      _feedback_reset(capacity, not_requested),
+      _table_host(capacity, make_uint2(invalid_slot, 0u)) {
+    Device device{stream.shared_device()};
+    _feedback = device.create_buffer<uint>(capacity);
+    _table = device.create_buffer<uint2>(capacity);
+    *_stream << _feedback.copy_from(_feedback_reset.data());
+    _dirty_end = capacity;
+    _io_thread = std::thread{[this] { _io_loop(); }};
+}
+
+TextureStreamer::~TextureStreamer() noexcept {
+    {
+        std::scoped_lock lock{_io_mutex};
+        _io_stop = true;
+    }
+    _io_cv.notify_one();
+    _io_thread.join();
+    _stream->synchronize();
+    _reclaim(true);
+    for (auto slot : _current.retired_slots) { _heap->destroy_texture(slot); }
+    for (auto &&r : _records) {
+        if (!r.alive) { continue; }
+        if (r.detail_slot != invalid_slot) { _heap->destroy_texture(r.detail_slot); }
+        _heap->destroy_texture(r.tail_slot);
+    }
+}
+
+size_t TextureStreamer::_chain_size_bytes(PixelStorage storage, uint2 size, uint first_level, uint mip_levels) noexcept {
+    size_t pixel_count = 0u;
+    for (auto level = first_level; level < mip_levels; level++) {
+        auto s = max(size >> level, 1u);
+        pixel_count += static_cast<size_t>(s.x) * s.y;
+    }
+    return pixel_count * pixel_storage_size(storage);
+}
+
+uint TextureStreamer::_full_mip_levels(uint2 size) noexcept {
+    return static_cast<uint>(std::bit_width(std::max(size.x, size.y)));
+}
+
+TextureStreamer::Loader TextureStreamer::raw_file_loader(std::filesystem::path path, PixelStorage storage,
+                                                         uint2 size, uint mip_levels) noexcept {
+    // the chain is contiguous in the file, so it takes a single read
+    return [path = std::move(path), storage, size, mip_levels](uint first_level, std::span<std::byte> pixels) noexcept {
+        std::ifstream file{path, std::ios::binary};
+        file.seekg(static_cast<std::streamoff>(_chain_size_bytes(storage, size, 0u, first_level)));
+        file.read(reinterpret_cast<char *>(pixels.data()), static_cast<std::streamsize>(pixels.size_bytes()));
+        if (!file) [[unlikely]] {
+            LUISA_WARNING_WITH_LOCATION(
+                "Failed to read mipmap levels {}-{} from '{}'.",
+                first_level, mip_levels - 1u, path.string());
+            return false;
+        }
+        return true;
+    };
+}
+
+TextureStreamer::LoadResult TextureStreamer::_load(LoadRequest request) noexcept {
+    LoadResult result{request.id, request.generation, request.level, {}, true};
+    result.pixels.resize(_chain_size_bytes(request.storage, request.size, request.level, request.mip_levels));
+    result.success = request.loader(request.level, result.pixels);
+    return result;
+}
+
+void TextureStreamer::_io_loop() noexcept {
+    for (;;) {
+        auto request = [this]() -> std::optional<LoadRequest> {
+            std::unique_lock lock{_io_mutex};
+            _io_cv.wait(lock, [this] { return _io_stop || !_load_requests.empty(); });
+            if (_io_stop) { return std::nullopt; }
+            auto r = std::move(_load_requests.front());
+            _load_requests.pop_front();
+            return r;
+        }();
+        if (!request) { break; }
+        auto result = _load(std::move(*request));
+        std::scoped_lock lock{_io_mutex};
+        _load_results.emplace_back(std::move(result));
+    }
+}
+
+void TextureStreamer::_upload_chain(TextureView2D texture, std::vector<std::byte> pixels) noexcept {
+    // the levels are submitted together, straight from the loaded chain
+    auto command_buffer = _stream->command_buffer();
+    size_t offset = 0u;
+    for (auto level = 0u; level < texture.mip_levels(); level++) {
+        command_buffer << texture.load(pixels.data() + offset, level);
+        offset += _chain_size_bytes(texture.storage(), texture.size(), level, level + 1u);
+    }
+    command_buffer << commit();
+    // kept alive until the commands are done
+    _current.uploads.emplace_back(std::move(pixels));
+}
+
+void TextureStreamer::_set_table(uint id, uint slot, uint base_level) noexcept {
+    _table_host[id] = make_uint2(slot, base_level);
+    if (_dirty_begin == _dirty_end) {
+        _dirty_begin = id;
+        _dirty_end = id + 1u;
+    } else {
+        _dirty_begin = std::min(_dirty_begin, id);
+        _dirty_end = std::max(_dirty_end, id + 1u);
+    }
+}
+
+void TextureStreamer::_retire(uint slot) noexcept {
+    _current.retired_slots.emplace_back(slot);
+}
+
+uint TextureStreamer::add(PixelStorage storage, uint2 size, uint mip_levels,
+                          TextureSampler sampler, Loader loader) noexcept {
+    auto full_levels = _full_mip_levels(size);
+    mip_levels = mip_levels == 0u ? full_levels : std::min(mip_levels, full_levels);
+    auto id = [this] {
+        if (_free_ids.empty()) {
+            auto id = static_cast<uint>(_records.size());
+            if (id >= _table_host.size()) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION(
+                    "Texture streamer capacity ({}) exceeded.",
+                    _table_host.size());
+            }
+            _records.emplace_back();
+            return id;
+        }
+        auto id = _free_ids.back();
+        _free_ids.pop_back();
+        return id;
+    }();
+    auto tail_level = 0u;
+    while (tail_level + 1u < mip_levels &&
+           std::max(size.x >> tail_level, size.y >> tail_level) > _tail_size) {
+        tail_level++;
+    }
+    auto tail = _load(LoadRequest{id, _generation, tail_level, loader, storage, size, mip_levels});
+    if (!tail.success) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Failed to load the tail (from level {}) of streaming texture #{}.",
+            tail_level, id);
+    }
+    auto tail_bytes = tail.pixels.size();
+    auto [tail_slot, tail_texture] = _heap->allocate_texture(
+        storage, max(size >> tail_level, 1u), sampler, mip_levels - tail_level);
+    _upload_chain(tail_texture, std::move(tail.pixels));
+    _records[id] = Record{std::move(loader), storage, sampler, size, mip_levels,
+                          tail_level, tail_slot, invalid_slot, tail_level,
+                          not_requested, not_requested, _generation++, _frame,
+                          0u, _lru.end(), true};
+    _tail_bytes += tail_bytes;
+    _resident_bytes += tail_bytes;
+    _set_table(id, tail_slot, tail_level);
+    return id;
+}
+
+void TextureStreamer::remove(uint id) noexcept {
+    auto &&r = _records[id];
+    if (!r.alive) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION("Removing invalid streaming texture #{}.", id);
+        return;
+    }
+    _evict(id);
+    auto tail_bytes = _chain_size_bytes(r.storage, r.size, r.tail_level, r.mip_levels);
+    _tail_bytes -= tail_bytes;
+    _resident_bytes -= tail_bytes;
+    _retire(r.tail_slot);
+    _set_table(id, invalid_slot, 0u);
+    r.loader = {};
+    r.alive = false;
+    _free_ids.emplace_back(id);
+}
+
+void TextureStreamer::_evict(uint id) noexcept {
+    auto &&r = _records[id];
+    if (r.detail_slot == invalid_slot) { return; }
+    _retire(r.detail_slot);
+    _lru.erase(r.lru);
+    _resident_bytes -= r.detail_bytes;
+    r.detail_slot = invalid_slot;
+    r.detail_bytes = 0u;
+    r.lru = _lru.end();
+    r.resident_level = r.tail_level;
+    _set_table(id, r.tail_slot, r.tail_level);
+}
+
+bool TextureStreamer::_make_room(size_t size_bytes) noexcept {
+    while (_resident_bytes + _pending_bytes + size_bytes > _budget_bytes) {
+        // never evict what is in use right now, which would only thrash
+        if (_lru.empty() || _records[_lru.front()].last_used >= _frame) { return false; }
+        _evict(_lru.front());
+        _evicted_count++;
+    }
+    return true;
+}
+
+void TextureStreamer::_touch(uint id, uint level) noexcept {
+    auto &&r = _records[id];
+    if (!r.alive) [[unlikely]] { return; }
+    if (r.wanted_level == not_requested) { _wanted_ids.emplace_back(id); }
+    r.wanted_level = std::min({r.wanted_level, level, r.mip_levels - 1u});
+    r.last_used = _frame;
+    if (r.detail_slot != invalid_slot) { _lru.splice(_lru.end(), _lru, r.lru); }
+}
+
+void TextureStreamer::request(uint id, uint level) noexcept {
+    if (id >= _records.size()) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION("Requesting invalid streaming texture #{}.", id);
+        return;
+    }
+    _touch(id, level);
+}
+
+void TextureStreamer::_apply_feedback(const Frame &frame) noexcept {
+    auto n = std::min(frame.feedback.size(), _records.size());
+    for (auto id = 0u; id < n; id++) {
+        if (auto level = frame.feedback[id]; level != not_requested) { _touch(id, level); }
+    }
+}
+
+void TextureStreamer::_publish_loads() noexcept {
+    std::vector<LoadResult> results;
+    {
+        std::scoped_lock lock{_io_mutex};
+        results.swap(_load_results);
+    }
+    for (auto &&result : results) {
+        _pending_bytes -= result.pixels.size();
+        _pending_count--;
+        auto &&r = _records[result.id];
+        if (!r.alive || r.generation != result.generation) { continue; }
+        r.pending_level = not_requested;
+        if (!result.success) [[unlikely]] {
+            LUISA_WARNING_WITH_LOCATION(
+                "Failed to load level {} of streaming texture #{}.",
+                result.level, result.id);
+            continue;
+        }
+        auto size_bytes = result.pixels.size();
+        auto [slot, texture] = _heap->allocate_texture(
+            r.storage, max(r.size >> result.level, 1u), r.sampler, r.mip_levels - result.level);
+        _upload_chain(texture, std::move(result.pixels));
+        if (r.detail_slot != invalid_slot) {
+            _retire(r.detail_slot);
+            _resident_bytes -= r.detail_bytes;
+        } else {
+            r.lru = _lru.emplace(_lru.end(), result.id);
+        }
+        r.detail_slot = slot;
+        r.detail_bytes = size_bytes;
+        r.resident_level = result.level;
+        _resident_bytes += size_bytes;
+        _set_table(result.id, slot, result.level);
+        _loaded_count++;
+    }
+}
+
+void TextureStreamer::_schedule_loads() noexcept {
+    // finest requests first, they are the most visible
+    std::sort(_wanted_ids.begin(), _wanted_ids.end(), [this](auto lhs, auto rhs) noexcept {
+        return _records[lhs].wanted_level < _records[rhs].wanted_level;
+    });
+    auto scheduled = false;
+    for (auto id : _wanted_ids) {
+        auto &&r = _records[id];
+        auto level = std::exchange(r.wanted_level, not_requested);
+        if (!r.alive || level >= r.resident_level || r.pending_level != not_requested) { continue; }
+        auto size_bytes = _chain_size_bytes(r.storage, r.size, level, r.mip_levels);
+        if (!_make_room(size_bytes)) { continue; }
+        {
+            std::scoped_lock lock{_io_mutex};
+            _load_requests.emplace_back(LoadRequest{id, r.generation, level, r.loader, r.storage, r.size, r.mip_levels});
+        }
+        r.pending_level = level;
+        _pending_bytes += size_bytes;
+        _pending_count++;
+        scheduled = true;
+    }
+    _wanted_ids.clear();
+    if (scheduled) { _io_cv.notify_one(); }
+}
+
+void TextureStreamer::_reclaim(bool wait) noexcept {
+    while (!_frames_in_flight.empty()) {
+        auto &&frame = _frames_in_flight.front();
+        if (wait || _frames_in_flight.size() > _max_frames_in_flight) {
+            frame.fence.synchronize();
+        } else if (!frame.fence.query()) {
+            break;
+        }
+        _apply_feedback(frame);
+        for (auto slot : frame.retired_slots) { _heap->destroy_texture(slot); }
+        _idle_fences.emplace_back(std::move(frame.fence));
+        _frames_in_flight.pop_front();
+    }
+}
+
+TextureStreamer::Statistics TextureStreamer::update() noexcept {
+    _publish_loads();
+    if (_dirty_begin != _dirty_end) {
+        auto table = _table.view().subview(_dirty_begin, _dirty_end - _dirty_begin);
+        std::vector<std::byte> entries(table.size_bytes());
+        std::memcpy(entries.data(), _table_host.data() + _dirty_begin, entries.size());
+        *_stream << table.copy_from(entries.data());
+        _current.uploads.emplace_back(std::move(entries));
+        _dirty_begin = 0u;
+        _dirty_end = 0u;
+    }
+    _current.fence = [this] {
+        if (_idle_fences.empty()) { return Device{_stream->shared_device()}.create_event(); }
+        auto e = std::move(_idle_fences.back());
+        _idle_fences.pop_back();
+        return e;
+    }();
+    _current.feedback.resize(_feedback_reset.size());
+    *_stream << _feedback.copy_to(_current.feedback.data())
+             << _feedback.copy_from(_feedback_reset.data())
+             << _current.fence.signal();
+    _frames_in_flight.emplace_back(std::move(_current));
+    _current = {};
+    // feedback of the frames that have passed drives the next loads
+    _reclaim(false);
+    _schedule_loads();
+    Statistics statistics{_frame, _resident_bytes, _tail_bytes, _budget_bytes,
+                          _pending_count, _loaded_count, _evicted_count};
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Texture streamer frame #{}: resident = {} bytes "
+        "(tails = {} bytes, budget = {} bytes), pending = {}, "
+        "loaded = {}, evicted = {}.",
+        statistics.frame, statistics.resident_bytes, statistics.tail_bytes,
+        statistics.budget_bytes, statistics.pending_count,
+        statistics.loaded_count, statistics.evicted_count);
+    _loaded_count = 0u;
+    _evicted_count = 0u;
+    _frame++;
+    return statistics;
+}
+
+}// namespace luisa::compute
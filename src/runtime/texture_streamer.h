@@ -0,0 +1,188 @@
+//
+// Created by Mike Smith on 2021/9/16.
+//
+
+#pragma once
+
+#include <list>
+#include <span>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <condition_variable>
+
+#include <core/concepts.h>
+#include <runtime/heap.h>
+#include <runtime/event.h>
+#include <runtime/stream.h>
+
+namespace luisa::compute {
+
+// Streams the mipmaps of many 2D textures in and out of a heap under a
+// memory budget, following the levels kernels actually sample.
+//
+// Each texture keeps its tail (levels no larger than tail_size) resident in
+// one heap slot. Finer levels live in a second slot holding the chain from
+// the finest resident level down, loaded from disk by an I/O thread and
+// evicted, least recently used first, when the budget runs out. Kernels find
+// the current slot through table(): entry i of it is (slot, base level) for
+// texture i, so level l is sampled as level l - base of the slot's texture.
+// They report what they need through feedback(): an atomic fetch_min of
+// the wanted level at entry i, which update() reads back and resets.
+//
+// Slot changes reach the table in stream order, and replaced slots are
+// destroyed only once the stream has passed the frame's event. Not
+// thread-safe (except for the loaders, which run on the I/O thread), and
+// the stream and heap must outlive the streamer.
+class TextureStreamer : concepts::Noncopyable {
+
+public:
+    // fills the pixels of the levels from first_level to the coarsest, back to back,
+    // called from the I/O thread, returns false on failure
+    using Loader = std::function<bool(uint first_level, std::span<std::byte> pixels)>;
+
+    struct Statistics {
+        uint64_t frame;
+        size_t resident_bytes;// tails included
+        size_t tail_bytes;
+        size_t budget_bytes;
+        size_t pending_count;// loads in flight
+        size_t loaded_count; // loads published in the frame
+        size_t evicted_count;// chains evicted in the frame
+    };
+
+    static constexpr auto default_tail_size = 64u;
+    static constexpr auto default_max_frames_in_flight = 2u;
+    static constexpr auto not_requested = ~0u;
+    static constexpr auto invalid_id = ~0u;
+
+private:
+    static constexpr auto invalid_slot = ~0u;
+
+    struct Record {
+        Loader loader;
+        PixelStorage storage;
+        TextureSampler sampler;
+        uint2 size;
+        uint mip_levels;
+        uint tail_level;
+        uint tail_slot;
+        uint detail_slot;
+        uint resident_level;// finest resident level
+        uint wanted_level;  // finest level requested since the last load
+        uint pending_level; // level of the load in flight, if any
+        uint64_t generation;// tells loads of removed textures apart
+        uint64_t last_used; // frame of the last request
+        size_t detail_bytes;
+        std::list<uint>::iterator lru;// into _lru, if the texture has a detail chain
+        bool alive;
+    };
+
+    struct LoadRequest {
+        uint id;
+        uint64_t generation;
+        uint level;
+        Loader loader;
+        PixelStorage storage;
+        uint2 size;
+        uint mip_levels;
+    };
+
+    struct LoadResult {
+        uint id;
+        uint64_t generation;
+        uint level;
+        std::vector<std::byte> pixels;// levels level..mip_levels - 1, back to back
+        bool success;
+    };
+
+    struct Frame {
+        Event fence;
+        std::vector<uint> feedback;                 // read back from the device
+        std::vector<std::vector<std::byte>> uploads;// host data of the commands
+        std::vector<uint> retired_slots;            // destroyed once the fence has passed
+    };
+
+private:
+    Stream *_stream;
+    Heap *_heap;
+    size_t _budget_bytes;
+    uint _tail_size;
+    uint _max_frames_in_flight;
+    Buffer<uint> _feedback;
+    Buffer<uint2> _table;
+    std::vector<uint> _feedback_reset;
+    std::vector<uint2> _table_host;
+    uint _dirty_begin{0u};
+    uint _dirty_end{0u};
+    std::vector<Record> _records;
+    std::vector<uint> _free_ids;
+    std::vector<uint> _wanted_ids;// textures requested since the last update
+    std::list<uint> _lru;// textures with detail chains, least recently used first
+    std::deque<Frame> _frames_in_flight;
+    std::vector<Event> _idle_fences;
+    Frame _current;
+    uint64_t _frame{0u};
+    uint64_t _generation{0u};
+    size_t _resident_bytes{0u};
+    size_t _tail_bytes{0u};
+    size_t _pending_bytes{0u};
+    size_t _pending_count{0u};
+    size_t _loaded_count{0u};
+    size_t _evicted_count{0u};
+
+    // I/O thread
+    std::mutex _io_mutex;
+    std::condition_variable _io_cv;
+    std::deque<LoadRequest> _load_requests;
+    std::vector<LoadResult> _load_results;
+    bool _io_stop{false};
+    std::thread _io_thread;
+
+private:
+    [[nodiscard]] static size_t _chain_size_bytes(PixelStorage storage, uint2 size, uint first_level, uint mip_levels) noexcept;
+    [[nodiscard]] static LoadResult _load(LoadRequest request) noexcept;
+    void _io_loop() noexcept;
+    [[nodiscard]] static uint _full_mip_levels(uint2 size) noexcept;
+    void _upload_chain(TextureView2D texture, std::vector<std::byte> pixels) noexcept;
+    void _set_table(uint id, uint slot, uint base_level) noexcept;
+    void _retire(uint slot) noexcept;
+    void _evict(uint id) noexcept;
+    [[nodiscard]] bool _make_room(size_t size_bytes) noexcept;
+    void _touch(uint id, uint level) noexcept;
+    void _apply_feedback(const Frame &frame) noexcept;
+    void _publish_loads() noexcept;
+    void _schedule_loads() noexcept;
+    void _reclaim(bool wait) noexcept;
+
+public:
+    TextureStreamer(Stream &stream, Heap &heap, uint capacity, size_t budget_bytes,
+                    uint tail_size = default_tail_size,
+                    uint max_frames_in_flight = default_max_frames_in_flight) noexcept;
+    ~TextureStreamer() noexcept;
+
+    // reads levels stored back to back in a raw file, finest first, tightly packed
+    [[nodiscard]] static Loader raw_file_loader(std::filesystem::path path, PixelStorage storage,
+                                                uint2 size, uint mip_levels) noexcept;
+
+    // loads the tail right away (on the calling thread) and returns the id of the texture
+    [[nodiscard]] uint add(PixelStorage storage, uint2 size, uint mip_levels,
+                           TextureSampler sampler, Loader loader) noexcept;
+    void remove(uint id) noexcept;
+    // requests a level from the host, as if a kernel had written it into the feedback
+    void request(uint id, uint level) noexcept;
+    // reads back feedback, publishes finished loads, evicts and schedules new loads;
+    // also uploads the table, so call it after add() before kernels read table()
+    Statistics update() noexcept;
+
+    [[nodiscard]] auto &table() const noexcept { return _table; }
+    [[nodiscard]] auto &feedback() const noexcept { return _feedback; }
+    [[nodiscard]] auto resident_level(uint id) const noexcept { return _records[id].resident_level; }
+    [[nodiscard]] auto resident_bytes() const noexcept { return _resident_bytes; }
+    [[nodiscard]] auto budget_bytes() const noexcept { return _budget_bytes; }
+};
+
+}// namespace luisa::compute
@@ -0,0 +1,200 @@
+//
+// Created by Mike Smith on 2021/9/13.
+//
+
+#include <limits>
+#include <algorithm>
+
+#include <core/logging.h>
+#include <runtime/texture.h>
+#include <runtime/destruction_queue.h>
+#include <runtime/transient_pool.h>
+
+namespace luisa::compute {
+
+TransientPool::TransientPool(Stream &stream, uint max_frames_in_flight, uint max_idle_frames) noexcept
+    : _device{stream.device()},
+      _stream{&stream},
+      _max_frames_in_flight{std::max(max_frames_in_flight, 1u)},
+      _max_idle_frames{max_idle_frames} {}
+
+TransientPool::~TransientPool() noexcept {
+    if (_storages.empty()) { return; }
+    if (_live_bytes != 0u) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Destroying transient pool with {} bytes of unreleased transients.",
+            _live_bytes);
+    }
+    _stream->synchronize();
+    std::vector<uint64_t> handles;
+    handles.reserve(_storages.size());
+    for (auto &&[handle, s] : _storages) { handles.emplace_back(handle); }
+    for (auto handle : handles) { _destroy(handle); }
+}
+
+uint64_t TransientPool::_create(ResourceTag tag, PixelFormat format, uint2 size, size_t size_bytes) noexcept {
+    auto handle = tag == ResourceTag::BUFFER
+                      ? _device->create_buffer(
+                            size_bytes,
+                            std::numeric_limits<uint64_t>::max(),
+                            std::numeric_limits<uint32_t>::max())
+                      : _device->create_texture(
+                            format, 2u, size.x, size.y, 1u, 1u, {},
+                            std::numeric_limits<uint64_t>::max(), 0u);
+    _device->resource_tracker().on_create(tag, size_bytes);
+    _storages.emplace(handle, Storage{tag, format, size, size_bytes, _current.frame, false, false});
+    _pool_bytes += size_bytes;
+    _current.created_count++;
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Created transient storage #{} with {} bytes (pool = {} bytes).",
+        handle, size_bytes, _pool_bytes);
+    return handle;
+}
+
+void TransientPool::_destroy(uint64_t handle) noexcept {
+    auto iter = _storages.find(handle);
+    auto &&s = iter->second;
+    _device->destruction_queue().destroy(s.tag, handle);
+    _device->resource_tracker().on_destroy(s.tag, s.size_bytes);
+    _pool_bytes -= s.size_bytes;
+    _storages.erase(iter);
+}
+
+uint64_t TransientPool::_acquire(uint64_t handle) noexcept {
+    auto &&s = _storages.at(handle);
+    s.in_use = true;
+    s.last_frame = _current.frame;
+    _live_bytes += s.size_bytes;
+    _current.peak_bytes = std::max(_current.peak_bytes, _live_bytes);
+    return handle;
+}
+
+uint64_t TransientPool::_acquire_buffer(size_t size_bytes) noexcept {
+    static constexpr auto alignment = static_cast<size_t>(256u);
+    size_bytes = (std::max(size_bytes, static_cast<size_t>(1u)) + alignment - 1u) / alignment * alignment;
+    _current.allocation_count++;
+    _current.requested_bytes += size_bytes;
+    // best fit, but never waste more than half of the storage
+    if (auto iter = _free_buffers.lower_bound(size_bytes);
+        iter != _free_buffers.end() && iter->first <= size_bytes * 2u) {
+        auto handle = iter->second;
+        _free_buffers.erase(iter);
+        return _acquire(handle);
+    }
+    return _acquire(_create(ResourceTag::BUFFER, {}, {}, size_bytes));
+}
+
+uint64_t TransientPool::_acquire_image(PixelFormat format, uint2 size) noexcept {
+    auto size_bytes = pixel_format_size(format) * size.x * size.y;
+    _current.allocation_count++;
+    _current.requested_bytes += size_bytes;
+    if (auto iter = _free_images.find(_image_key(format, size)); iter != _free_images.end()) {
+        auto handle = iter->second;
+        _free_images.erase(iter);
+        return _acquire(handle);
+    }
+    return _acquire(_create(ResourceTag::TEXTURE, format, size, size_bytes));
+}
+
+void TransientPool::_release(uint64_t handle) noexcept {
+    auto iter = _storages.find(handle);
+    if (iter == _storages.end() || !iter->second.in_use) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Invalid transient resource #{} to release.", handle);
+    }
+    auto &&s = iter->second;
+    s.in_use = false;
+    s.last_frame = _current.frame;
+    _live_bytes -= s.size_bytes;
+    _make_available(handle);
+    _released.emplace_back(handle);
+}
+
+void TransientPool::_make_available(uint64_t handle) noexcept {
+    if (auto &&s = _storages.at(handle); s.tag == ResourceTag::BUFFER) {
+        _free_buffers.emplace(s.size_bytes, handle);
+    } else {
+        _free_images.emplace(_image_key(s.format, s.size), handle);
+    }
+}
+
+void TransientPool::_remove_available(uint64_t handle, const Storage &s) noexcept {
+    auto erase = [handle](auto &&map, auto &&key) noexcept {
+        auto [first, last] = map.equal_range(key);
+        map.erase(std::find_if(first, last, [handle](auto &&p) noexcept { return p.second == handle; }));
+    };
+    if (s.tag == ResourceTag::BUFFER) {
+        erase(_free_buffers, s.size_bytes);
+    } else {
+        erase(_free_images, _image_key(s.format, s.size));
+    }
+}
+
+void TransientPool::_reclaim() noexcept {
+    // events are signaled in order on the stream, so stop at the first pending one
+    while (!_frames_in_flight.empty()) {
+        auto &&frame = _frames_in_flight.front();
+        if (_frames_in_flight.size() > _max_frames_in_flight) {
+            LUISA_VERBOSE_WITH_LOCATION(
+                "Waiting for transient pool frame with {} frames in flight.",
+                _frames_in_flight.size());
+            frame.fence.synchronize();
+        } else if (!frame.fence.query()) {
+            break;
+        }
+        for (auto handle : frame.storages) {
+            _storages.at(handle).parked = false;
+            _make_available(handle);
+        }
+        _idle_fences.emplace_back(std::move(frame.fence));
+        _frames_in_flight.pop_front();
+    }
+}
+
+void TransientPool::_trim() noexcept {
+    std::vector<uint64_t> idle;
+    for (auto &&[handle, s] : _storages) {
+        if (!s.in_use && !s.parked && s.last_frame + _max_idle_frames < _current.frame) {
+            _remove_available(handle, s);
+            idle.emplace_back(handle);
+        }
+    }
+    for (auto handle : idle) { _destroy(handle); }
+}
+
+TransientPool::FrameStatistics TransientPool::end_frame() noexcept {
+    auto fence = [this] {
+        if (_idle_fences.empty()) { return Device{_stream->shared_device()}.create_event(); }
+        auto e = std::move(_idle_fences.back());
+        _idle_fences.pop_back();
+        return e;
+    }();
+    *_stream << fence.signal();
+    // storage used in this frame waits for the event before serving later frames
+    Frame frame{std::move(fence), {}};
+    for (auto handle : _released) {
+        if (auto &&s = _storages.at(handle); !s.in_use && !s.parked) {
+            _remove_available(handle, s);
+            s.parked = true;
+            frame.storages.emplace_back(handle);
+        }
+    }
+    _released.clear();
+    _frames_in_flight.emplace_back(std::move(frame));
+    _reclaim();
+    _trim();
+    auto statistics = _current;
+    statistics.pool_bytes = _pool_bytes;
+    LUISA_VERBOSE_WITH_LOCATION(
+        "Transient pool frame #{}: peak = {} bytes, "
+        "requested = {} bytes, pool = {} bytes, "
+        "allocations = {} (created = {}).",
+        statistics.frame, statistics.peak_bytes,
+        statistics.requested_bytes, statistics.pool_bytes,
+        statistics.allocation_count, statistics.created_count);
+    _current = {};
+    _current.frame = statistics.frame + 1u;
+    _current.peak_bytes = _live_bytes;
+    return statistics;
+}
+
+}// namespace luisa::compute
@@ -0,0 +1,132 @@
+//
+// Created by Mike Smith on 2021/9/13.
+//
+
+#pragma once
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+#include <core/concepts.h>
+#include <runtime/buffer.h>
+#include <runtime/image.h>
+#include <runtime/event.h>
+#include <runtime/stream.h>
+
+namespace luisa::compute {
+
+// Scratch buffers and images for the commands of one stream, recycled from
+// frame to frame instead of being created and destroyed through the device.
+//
+// Within a frame, storage given back with release() may be handed out again
+// right away: commands run in stream order, so transients with disjoint
+// lifetimes alias the same memory as long as release() is called after the
+// last command using a transient has been recorded (into a CommandBuffer or
+// the stream), and the frame's commands reach the stream in recording order.
+// end_frame() signals an event on the stream; storage used in the frame is
+// recycled for later frames only once that event has passed, which is queried
+// without blocking unless more than max_frames_in_flight frames are pending.
+// Storage unused for max_idle_frames frames is destroyed.
+//
+// Not thread-safe, and the stream must outlive the pool.
+class TransientPool : concepts::Noncopyable {
+
+public:
+    struct FrameStatistics {
+        uint64_t frame;
+        size_t peak_bytes;     // peak storage bound to transients at once, i.e., the footprint with aliasing
+        size_t requested_bytes;// sum over all allocations, i.e., the footprint without aliasing
+        size_t pool_bytes;     // storage owned by the pool at the end of the frame
+        size_t allocation_count;
+        size_t created_count;// allocations that had to create storage
+    };
+
+    static constexpr auto default_max_frames_in_flight = 3u;
+    static constexpr auto default_max_idle_frames = 8u;
+
+private:
+    struct Storage {
+        ResourceTag tag;
+        PixelFormat format;
+        uint2 size;
+        size_t size_bytes;
+        uint64_t last_frame;
+        bool in_use;
+        bool parked;// waiting for the event of a frame
+    };
+
+    struct Frame {
+        Event fence;
+        std::vector<uint64_t> storages;
+    };
+
+    using ImageKey = std::pair<PixelFormat, uint64_t>;
+
+private:
+    Device::Interface *_device;
+    Stream *_stream;
+    std::unordered_map<uint64_t, Storage> _storages;
+    std::multimap<size_t, uint64_t> _free_buffers;
+    std::multimap<ImageKey, uint64_t> _free_images;
+    std::vector<uint64_t> _released;// released in the current frame
+    std::deque<Frame> _frames_in_flight;
+    std::vector<Event> _idle_fences;
+    FrameStatistics _current{};
+    size_t _live_bytes{0u};
+    size_t _pool_bytes{0u};
+    uint _max_frames_in_flight;
+    uint _max_idle_frames;
+
+private:
+    [[nodiscard]] static ImageKey _image_key(PixelFormat format, uint2 size) noexcept {
+        return {format, (static_cast<uint64_t>(size.x) << 32u) | size.y};
+    }
+    [[nodiscard]] uint64_t _acquire_buffer(size_t size_bytes) noexcept;
+    [[nodiscard]] uint64_t _acquire_image(PixelFormat format, uint2 size) noexcept;
+    [[nodiscard]] uint64_t _create(ResourceTag tag, PixelFormat format, uint2 size, size_t size_bytes) noexcept;
+    void _destroy(uint64_t handle) noexcept;
+    uint64_t _acquire(uint64_t handle) noexcept;
+    void _release(uint64_t handle) noexcept;
+    void _make_available(uint64_t handle) noexcept;
+    void _remove_available(uint64_t handle, const Storage &s) noexcept;
+    void _reclaim() noexcept;
+    void _trim() noexcept;
+
+public:
+    explicit TransientPool(Stream &stream,
+                           uint max_frames_in_flight = default_max_frames_in_flight,
+                           uint max_idle_frames = default_max_idle_frames) noexcept;
+    ~TransientPool() noexcept;
+
+    template<typename T>
+    [[nodiscard]] auto allocate_buffer(size_t size) noexcept {
+        return BufferView<T>{_acquire_buffer(size * sizeof(T)), 0u, size};
+    }
+
+    template<typename T>
+    [[nodiscard]] auto allocate_image(PixelStorage storage, uint2 size) noexcept {
+        return ImageView<T>{_acquire_image(pixel_storage_to_format<T>(storage), size), storage, {}, size};
+    }
+
+    template<typename T>
+    [[nodiscard]] auto allocate_image(PixelStorage storage, uint width, uint height) noexcept {
+        return allocate_image<T>(storage, make_uint2(width, height));
+    }
+
+    // the views (and subviews) must not be used in commands recorded afterwards
+    template<typename T>
+    void release(BufferView<T> buffer) noexcept { _release(buffer.handle()); }
+
+    template<typename T>
+    void release(ImageView<T> image) noexcept { _release(image.handle()); }
+
+    // signals the end of the frame on the stream, so commit the frame's command buffers first
+    FrameStatistics end_frame() noexcept;
+    [[nodiscard]] auto pool_bytes() const noexcept { return _pool_bytes; }
+    [[nodiscard]] auto stream() const noexcept { return _stream; }
+};
+
+}// namespace luisa::compute
@@ -6,6 +6,7 @@
 
 #include <runtime/pixel.h>
 #include <runtime/resource.h>
+#include <runtime/file_copy.h>
 
 namespace luisa::compute {
 
@@ -40,7 +41,8 @@ private:
             device->create_texture(
               pixel_storage_to_format<T>(storage), 3u,
               width, height, depth, 1u, {},
-              std::numeric_limits<uint64_t>::max(), 0u)},
+              std::numeric_limits<uint64_t>::max(), 0u),
+            pixel_storage_size(storage) * width * height * depth},
           _storage{storage},
           _size{width, height, depth} {}
 
@@ -81,6 +83,9 @@ public:
     [[nodiscard]] Command *copy_to(void *data) const noexcept { return view().copy_to(data); }
     [[nodiscard]] Command *copy_from(const void *data) const noexcept { return view().copy_from(data); }
     [[nodiscard]] Command *copy_from(VolumeView<T> src) const noexcept { return view().copy_from(src); }
+    [[nodiscard]] auto copy_from_file(std::filesystem::path path, size_t file_offset = 0u) const noexcept {
+        return view().copy_from_file(std::move(path), file_offset);
+    }
 
     template<typename U>
     [[nodiscard]] Command *copy_from(BufferView<U> src) const noexcept { return view().copy_from(src); }
@@ -166,6 +171,11 @@ public:
             _handle, _storage, 0u, _offset, _size);
     }
 
+    // reads the pixels of the view, tightly packed from file_offset, see runtime/file_copy.h
+    [[nodiscard]] auto copy_from_file(std::filesystem::path path, size_t file_offset = 0u) const noexcept {
+        return FileCopy::volume(std::move(path), file_offset, _handle, _storage, _offset, _size);
+    }
+
     [[nodiscard]] auto copy_to(void *data) const noexcept {
         return TextureDownloadCommand::create(
             _handle, _storage,
@@ -6,6 +6,7 @@
 
 #include <runtime/device.h>
 #include <runtime/context.h>
+#include <runtime/destruction_queue.h>
 
 namespace luisa::compute {
 
@@ -40,7 +41,10 @@ public:
     virtual void destroy_accel(uint64_t handle) noexcept override {}
 
     [[nodiscard]] static auto create(const Context &ctx) noexcept {
-        auto deleter = [](Device::Interface *d) { delete d; };
+        auto deleter = [](Device::Interface *d) {
+            d->destruction_queue().flush();
+            delete d;
+        };
         return Device{Device::Handle{new FakeDevice{ctx}, deleter}};
     }
     virtual uint64_t create_heap(size_t size) noexcept override { return _handle++; }
@@ -1,5 +1,10 @@
 from pyluisa.compute.ast import *
 from pyluisa.compute.compile import *
+from pyluisa.compute.runtime import *
+import numpy as np
+import pyluisa
+import sys
+import os
 
 
 def kernel(f):
@@ -26,3 +31,21 @@ def compile(f):
 
 
 compile(something)
+
+
+# runtime: host arrays are read and written in place, on the backend given
+# on the command line or in LUISA_BACKEND (backends are loaded from the
+# directory of the module)
+backend = sys.argv[1] if len(sys.argv) > 1 else os.environ.get("LUISA_BACKEND")
+if backend is None:
+    print("No backend given, skipping the runtime checks.")
+    sys.exit(0)
+context = Context(pyluisa.__file__)
+device = context.create_device(backend)
+stream = device.create_stream()
+buffer = device.create_buffer(1024, "float")
+source = np.arange(1024, dtype=np.float32)
+result = np.zeros_like(source)
+stream.dispatch(buffer.copy_from(source), buffer.copy_to(result))
+stream.synchronize()
+assert (source == result).all()
@@ -2,10 +2,14 @@
 // Created by Mike Smith on 2021/4/6.
 //
 
+#include <fstream>
+#include <filesystem>
+
 #include <runtime/context.h>
 #include <runtime/device.h>
 #include <runtime/stream.h>
 #include <runtime/event.h>
+#include <runtime/texture_streamer.h>
 #include <dsl/syntax.h>
 #include <tests/fake_device.h>
 
@@ -55,8 +59,20 @@ int main(int argc, char *argv[]) {
         image.write(coord, sample(heap, uv, t * 7.0f));
     };
 
+    // samples texture #0 of a TextureStreamer, reporting the finest level it needs
+    Kernel2D fill_streamed_image_kernel = [](HeapVar heap, BufferVar<uint2> table, BufferVar<uint> feedback, ImageVar<float> image) noexcept {
+        Var coord = dispatch_id().xy();
+        Var uv = make_float2(coord) / make_float2(dispatch_size().xy());
+        Var r = length(uv - 0.5f);
+        Var level = log(sin(sqrt(r) * 100.0f - constants::pi_over_two) + 2.0f) * 7.0f;
+        void_(feedback.atomic(0u).fetch_min(cast<uint>(level)));
+        Var entry = table[0u];
+        image.write(coord, heap.tex2d(entry.x).sample(uv, max(level - cast<float>(entry.y), 0.0f)));
+    };
+
     auto clear_image = device.compile(clear_image_kernel);
     auto fill_image = device.compile(fill_image_kernel);
+    auto fill_streamed_image = device.compile(fill_streamed_image_kernel);
 
     auto heap = device.create_heap();
     auto image_width = 0;
@@ -71,6 +87,7 @@ int main(int argc, char *argv[]) {
     auto stream = device.create_stream();
     auto upload_stream = device.create_stream();
 
+    auto logo_size = make_uint2(image_width, image_height);
     std::vector<uint8_t> mipmaps(image_width * image_height * 4u);
     auto in_pixels = image_pixels;
     auto out_pixels = mipmaps.data();
@@ -108,4 +125,32 @@ int main(int argc, char *argv[]) {
            << synchronize();
 
     stbi_write_png("result.png", 1024u, 1024u, 4u, host_image.data(), 0u);
+
+    // the same mipmaps streamed from disk under a budget that fits a few finer levels
+    auto mips_path = std::filesystem::temp_directory_path() / "luisa-compute-test-bindless-logo.mips";
+    {
+        std::ofstream file{mips_path, std::ios::binary};
+        file.write(reinterpret_cast<const char *>(image_pixels), logo_size.x * logo_size.y * 4u);
+        file.write(reinterpret_cast<const char *>(mipmaps.data()), out_pixels - mipmaps.data());
+    }
+    {
+        TextureStreamer streamer{stream, heap, 16u, 1_mb};
+        auto streamed = streamer.add(
+            PixelStorage::BYTE4, logo_size, 0u, TextureSampler::trilinear_edge(),
+            TextureStreamer::raw_file_loader(mips_path, PixelStorage::BYTE4, logo_size, 0u));
+        for (auto frame = 0u; frame < 16u; frame++) {
+            // uploads the table before kernels read it, including the entries set by add()
+            auto statistics = streamer.update();
+            stream << clear_image(device_image).dispatch(1024u, 1024u)
+                   << fill_streamed_image(heap, streamer.table(), streamer.feedback(), device_image)
+                          .dispatch(1024u, 1024u);
+            LUISA_INFO("Streamed texture at level {} ({} bytes resident).",
+                       streamer.resident_level(streamed), statistics.resident_bytes);
+        }
+        stream << device_image.view().copy_to(host_image.data())
+               << synchronize();
+    }
+    // the loader reads the file until the streamer is gone
+    std::filesystem::remove(mips_path);
+    stbi_write_png("result-streamed.png", 1024u, 1024u, 4u, host_image.data(), 0u);
 }
@@ -0,0 +1,135 @@
+//
+// Created by Mike Smith on 2021/9/21.
+//
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/stream.h>
+#include <runtime/buffer.h>
+#include <dsl/syntax.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+// records the kernels shaders are created from, with configurable device limits
+class RecordingDevice final : public FakeDevice {
+
+public:
+    std::vector<uint3> block_sizes;
+    std::vector<uint64_t> hashes;
+    std::string name{"Fake GPU (driver 1)"};
+    uint32_t max_block_threads{256u};
+
+public:
+    using FakeDevice::FakeDevice;
+    uint64_t create_shader(Function kernel) noexcept override {
+        block_sizes.emplace_back(kernel.block_size());
+        hashes.emplace_back(kernel.hash());
+        return FakeDevice::create_shader(kernel);
+    }
+    std::string device_name() const noexcept override { return name; }
+    uint32_t shader_max_block_threads(uint64_t) noexcept override { return max_block_threads; }
+};
+
+void check(bool condition, std::string_view what) noexcept {
+    if (!condition) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Check failed: {}.", what); }
+}
+
+}// namespace
+
+// Checks that compiling variants of a kernel with other block sizes, as the
+// block size tuner does, never modifies the kernel shared with the caller.
+int main(int argc, char *argv[]) {
+
+    log_level_verbose();
+
+    Context context{argv[0]};
+    auto d = new RecordingDevice{context};
+    Device device{Device::Handle{d, [](Device::Interface *p) noexcept {
+                                     p->destruction_queue().flush();
+                                     delete p;
+                                 }}};
+    auto stream = device.create_stream();
+    auto buffer = device.create_buffer<uint>(1024u);
+
+    Kernel1D kernel = [](BufferUInt buffer) noexcept {
+        auto i = dispatch_id().x;
+        buffer[i] = buffer[i] * 2u + 1u;
+    };
+    auto kernel_hash = kernel.function()->hash();
+    auto default_block_size = kernel.function()->block_size();
+    auto expect_kernel_unchanged = [&] {
+        check(kernel.function()->hash() == kernel_hash &&
+                  all(kernel.function()->block_size() == default_block_size),
+              "kernel unchanged");
+    };
+
+    // explicit block sizes compile copies of the kernel
+    auto variant = device.compile(kernel, uint3{64u, 1u, 1u});
+    check(all(d->block_sizes.back() == uint3{64u, 1u, 1u}) && d->hashes.back() != kernel_hash, "variant compiled");
+    expect_kernel_unchanged();
+    auto same = device.compile(kernel, default_block_size);
+    check(all(d->block_sizes.back() == default_block_size) && d->hashes.back() == kernel_hash, "default compiled");
+
+    // tuning dispatches every candidate within the limits on the stream, unless cached
+    std::filesystem::remove(BlockSizeTuner::cache_path(device.impl().get(), kernel_hash));
+    auto dispatch_count = 0u;
+    auto representative_dispatch = [&](auto &&shader) noexcept {
+        dispatch_count++;
+        return shader(buffer).dispatch(1024u);
+    };
+    auto first_shader = d->block_sizes.size();
+    auto tuned = device.compile(kernel, stream, representative_dispatch);
+    auto candidate_count = 1u;
+    auto measured_count = 1u;
+    for (auto block_size : BlockSizeTuner::candidates(1u)) {
+        if (any(block_size != default_block_size)) {
+            candidate_count++;
+            if (block_size.x * block_size.y * block_size.z <= d->max_block_threads) { measured_count++; }
+        }
+    }
+    check(measured_count < candidate_count, "some candidates beyond the limits");
+    check(d->block_sizes.size() - first_shader == candidate_count, "candidates compiled once each");
+    check(dispatch_count == measured_count * (BlockSizeTuner::warm_up_iterations + BlockSizeTuner::measure_iterations),
+          "representative dispatches within the limits");
+    expect_kernel_unchanged();
+    auto best_block_size = BlockSizeTuner::load(device.impl().get(), kernel_hash);
+    check(best_block_size.has_value(), "tuned block size cached");
+    check(best_block_size->x * best_block_size->y * best_block_size->z <= d->max_block_threads,
+          "tuned block size within the limits");
+    LUISA_INFO("Tuned block size: ({}, {}, {}).", best_block_size->x, best_block_size->y, best_block_size->z);
+
+    dispatch_count = 0u;
+    auto cached = device.compile(kernel, stream, representative_dispatch);
+    check(dispatch_count == 0u && all(d->block_sizes.back() == *best_block_size), "cached block size used");
+    expect_kernel_unchanged();
+
+    // other GPUs or drivers of the same backend are tuned anew
+    auto tuned_path = BlockSizeTuner::cache_path(device.impl().get(), kernel_hash);
+    d->name = "Fake GPU (driver 2)";
+    check(BlockSizeTuner::cache_path(device.impl().get(), kernel_hash) != tuned_path &&
+              !BlockSizeTuner::load(device.impl().get(), kernel_hash).has_value(),
+          "cache keyed by device name");
+    d->name = "Fake GPU (driver 1)";
+
+    // kernels with shared memory are sized for their own block size and never tuned
+    Kernel1D shared_kernel = [](BufferUInt buffer) noexcept {
+        Shared<uint> scratch{256u};
+        auto i = dispatch_id().x;
+        scratch[thread_id().x] = buffer[i];
+        group_memory_barrier();
+        buffer[i] = scratch[255u - thread_id().x];
+    };
+    auto untuned = device.compile(shared_kernel, stream, representative_dispatch);
+    check(dispatch_count == 0u && all(d->block_sizes.back() == shared_kernel.function()->block_size()),
+          "shared memory kernel not tuned");
+    LUISA_INFO("All checks passed.");
+}
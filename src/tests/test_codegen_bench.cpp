@@ -0,0 +1,71 @@
+//
+// Created by Mike Smith on 2021/9/3.
+//
+
+#include <string>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <runtime/context.h>
+#include <compile/cpp_codegen.h>
+#include <compile/optimizer.h>
+#include <dsl/syntax.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+// Measures the throughput of CppCodegen on a large kernel.
+// Usage: test_codegen_bench [statement count = 4096] [iterations = 50]
+int main(int argc, char *argv[]) {
+
+    auto statement_count = argc > 1 ? std::stoul(argv[1]) : 4096ul;
+    auto iterations = argc > 2 ? std::stoul(argv[2]) : 50ul;
+
+    // measure the generator, not the optimizer
+    Optimizer::default_config() = {false, false, false};
+
+    Clock clock;
+    Callable step = [](Float x, Float y) noexcept {
+        return sin(x) * 0.5f + cos(y) * 0.25f + 1.0f;
+    };
+    Kernel1D kernel_def = [&](BufferFloat4 buffer, Float scale) noexcept {
+        auto i = dispatch_id().x;
+        Float4 v = buffer[i];
+        for (auto s = 0ul; s < statement_count; s++) {
+            switch (s % 4u) {
+                case 0u: v.x = step(v.y, scale) + static_cast<float>(s); break;
+                case 1u: v.y = max(v.x * v.z, 0.5f) - v.w; break;
+                case 2u: v.z = dot(v.xy(), make_float2(scale, 2.0f)); break;
+                default: if_(v.x > v.y, [&] { v.w = clamp(v.w, 0.0f, 1.0f); }); break;
+            }
+        }
+        buffer[i] = v;
+    };
+    auto kernel = kernel_def.function()->function();
+    LUISA_INFO("Built kernel with {} statements in {} ms.", statement_count, clock.toc());
+
+    auto bench = [&](std::string_view name, auto &&emit) noexcept {
+        auto bytes = 0.0;
+        clock.tic();
+        for (auto i = 0ul; i < iterations; i++) { bytes += static_cast<double>(emit()); }
+        auto ms = clock.toc();
+        LUISA_INFO("{}: {:.3f} ms per kernel, {:.2f} MB/s, {:.1f} KB of source.",
+                   name, ms / static_cast<double>(iterations),
+                   bytes / (1024.0 * 1024.0) / (ms * 1e-3),
+                   bytes / static_cast<double>(iterations) / 1024.0);
+    };
+
+    bench("Fresh scratch", [&] {
+        Codegen::Scratch scratch;
+        CppCodegen codegen{scratch};
+        codegen.emit(kernel);
+        return scratch.size();
+    });
+
+    bench("Pooled scratch", [&] {
+        auto scratch = Codegen::ScratchPool::acquire();
+        CppCodegen codegen{*scratch};
+        codegen.emit(kernel);
+        return scratch->size();
+    });
+}
@@ -0,0 +1,268 @@
+//
+// Created by Mike Smith on 2021/9/21.
+//
+
+#include <array>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+
+#include <core/logging.h>
+#include <runtime/heap.h>
+#include <runtime/buffer.h>
+#include <runtime/stream.h>
+#include <runtime/context.h>
+#include <runtime/transient_pool.h>
+#include <rtx/accel.h>
+#include <rtx/mesh.h>
+#include <dsl/syntax.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+// tracks live resources and recycles buffer handles (most recently destroyed
+// first) like real backends do; streams complete only when told to, all
+// together or one by one
+class RecyclingDevice final : public FakeDevice {
+
+private:
+    uint64_t _next_handle{100u};
+    std::vector<uint64_t> _free_buffers;
+
+public:
+    std::unordered_set<uint64_t> live_buffers;
+    std::unordered_set<uint64_t> live_streams;
+    std::unordered_set<uint64_t> live_others;// shaders, meshes, accels and events
+    std::unordered_map<uint64_t, uint64_t> signaled_streams;// event -> stream
+    std::unordered_set<uint64_t> completed_streams;
+    size_t signal_count{0u};
+    bool completed{false};
+
+private:
+    uint64_t _create_other() noexcept {
+        live_others.emplace(_next_handle);
+        return _next_handle++;
+    }
+    void _destroy_other(uint64_t handle) noexcept {
+        if (live_others.erase(handle) == 0u) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid resource #{} to destroy.", handle);
+        }
+    }
+
+public:
+    using FakeDevice::FakeDevice;
+    uint64_t create_buffer(size_t, uint64_t, uint32_t) noexcept override {
+        auto handle = _next_handle++;
+        if (!_free_buffers.empty()) {
+            handle = _free_buffers.back();
+            _free_buffers.pop_back();
+        }
+        live_buffers.emplace(handle);
+        return handle;
+    }
+    void destroy_buffer(uint64_t handle) noexcept override {
+        if (live_buffers.erase(handle) == 0u) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Invalid buffer #{} to destroy.", handle);
+        }
+        _free_buffers.emplace_back(handle);
+    }
+    uint64_t create_stream() noexcept override {
+        live_streams.emplace(_next_handle);
+        return _next_handle++;
+    }
+    void destroy_stream(uint64_t handle) noexcept override { live_streams.erase(handle); }
+    void signal_event(uint64_t handle, uint64_t stream_handle) noexcept override {
+        if (!live_streams.contains(stream_handle)) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Signaling destroyed stream #{}.", stream_handle);
+        }
+        signaled_streams.insert_or_assign(handle, stream_handle);
+        signal_count++;
+    }
+    bool query_event(uint64_t handle) noexcept override {
+        return completed || completed_streams.contains(signaled_streams.at(handle));
+    }
+    uint64_t create_shader(Function) noexcept override { return _create_other(); }
+    void destroy_shader(uint64_t handle) noexcept override { _destroy_other(handle); }
+    uint64_t create_mesh() noexcept override { return _create_other(); }
+    void destroy_mesh(uint64_t handle) noexcept override { _destroy_other(handle); }
+    uint64_t create_accel() noexcept override { return _create_other(); }
+    void destroy_accel(uint64_t handle) noexcept override { _destroy_other(handle); }
+    uint64_t create_event() noexcept override { return _create_other(); }
+    void destroy_event(uint64_t handle) noexcept override { _destroy_other(handle); }
+};
+
+void check(bool condition, std::string_view what) noexcept {
+    if (!condition) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Check failed: {}.", what); }
+}
+
+}// namespace
+
+// Exercises the stream-ordered destruction of resources on a fake device (run with ASan).
+int main(int argc, char *argv[]) {
+
+    log_level_verbose();
+
+    Context context{argv[0]};
+    auto d = new RecyclingDevice{context};
+    Device device{Device::Handle{d, [](Device::Interface *p) noexcept {
+                                     p->destruction_queue().flush();
+                                     delete p;
+                                 }}};
+    auto &&queue = device.impl()->destruction_queue();
+    auto stream = device.create_stream();
+    std::vector<float> host(16u);
+
+    // resources never used in commands are destroyed right away
+    { auto unused = device.create_buffer<float>(16u); }
+    check(d->live_buffers.empty(), "unused buffer destroyed");
+
+    // used ones wait for a fence, which later destroys join
+    auto a = device.create_buffer<float>(16u);
+    auto b = device.create_buffer<float>(16u);
+    stream << a.copy_from(host.data()) << b.copy_from(host.data());
+    a = {};
+    check(d->live_buffers.size() == 2u && d->signal_count == 1u, "in-flight buffer deferred");
+    b = {};
+    check(d->live_buffers.size() == 2u && d->signal_count == 1u, "fence joined");
+    check(queue.pending_count() == 2u, "two pending resources");
+    d->completed = true;
+    queue.reclaim();
+    check(d->live_buffers.empty() && queue.pending_count() == 0u, "deferred buffers destroyed");
+    d->completed = false;
+
+    // synchronization marks the stream completed
+    auto c = device.create_buffer<float>(16u);
+    stream << c.copy_from(host.data()) << synchronize();
+    c = {};
+    check(d->live_buffers.empty() && d->signal_count == 1u, "synchronized buffer destroyed");
+
+    // destroyed streams fence their remaining work, later destroys never signal them
+    auto other_stream = device.create_stream();
+    auto e = device.create_buffer<float>(16u);
+    other_stream << e.copy_from(host.data());
+    other_stream = {};
+    check(d->signal_count == 2u, "stream retirement fenced");
+    e = {};
+    check(d->signal_count == 2u && d->live_buffers.size() == 1u, "retirement fence joined");
+    d->completed = true;
+    queue.reclaim();
+    d->completed = false;
+    check(d->live_buffers.empty(), "buffer of destroyed stream destroyed");
+
+    // so are the shaders, meshes, accels and events used by streams, even
+    // temporaries destroyed right after the commands using them are dispatched
+    Kernel1D kernel = [](BufferFloat buffer) noexcept { buffer[dispatch_id().x] = 1.0f; };
+    auto f = device.create_buffer<float>(16u);
+    auto instance_transforms = std::array{make_float4x4(1.0f)};
+    std::array<uint64_t, 4u> others{};
+    {
+        auto shader = device.compile(kernel);
+        auto mesh = device.create_mesh();
+        auto accel = device.create_accel();
+        auto event = device.create_event();
+        auto instance_meshes = std::array{mesh.handle()};
+        stream << shader(f).dispatch(16u)
+               << accel.build(AccelBuildHint::FAST_TRACE, instance_meshes, instance_transforms)
+               << event.signal();
+        others = {shader.handle(), mesh.handle(), accel.handle(), event.handle()};
+    }
+    for (auto h : others) { check(d->live_others.contains(h), "in-flight shader, mesh, accel and event deferred"); }
+    {
+        auto unused = device.compile(kernel);
+        auto handle = unused.handle();
+        unused = {};
+        check(!d->live_others.contains(handle), "unused shader destroyed");
+    }
+    d->completed = true;
+    queue.reclaim();
+    d->completed = false;
+    for (auto h : others) { check(!d->live_others.contains(h), "shader, mesh, accel and event destroyed"); }
+    f = {};
+
+    // heap resources are stream-ordered as well, and leave no stale last use
+    // behind for the (recycled) handle of the next buffer
+    auto heap = device.create_heap(1_mb);
+    auto slot = heap.allocate_buffer<float>(16u);
+    stream << slot.view.copy_from(host.data());
+    heap.destroy_buffer(slot.index);
+    check(d->live_buffers.contains(slot.view.handle()), "in-flight heap buffer deferred");
+    d->completed = true;
+    queue.reclaim();
+    d->completed = false;
+    check(d->live_buffers.empty(), "heap buffer destroyed");
+    auto signal_count = d->signal_count;
+    {
+        auto recycled = device.create_buffer<float>(16u);
+        check(recycled.handle() == slot.view.handle(), "heap buffer handle recycled");
+    }
+    check(d->live_buffers.empty() && d->signal_count == signal_count, "recycled heap buffer handle destroyed right away");
+
+    // slots also wait for the bindless dispatches reading them through the heap
+    // binding, and for their direct uses on other streams
+    Kernel1D bindless_kernel = [](HeapVar heap, BufferFloat out) noexcept {
+        auto i = dispatch_id().x;
+        out[i] = heap.buffer<float>(0u).read(i);
+    };
+    auto bindless = device.compile(bindless_kernel);
+    {
+        auto out = device.create_buffer<float>(16u);
+        auto bindless_slot = heap.allocate_buffer<float>(16u);
+        stream << bindless(heap, out).dispatch(16u);
+        heap.destroy_buffer(bindless_slot.index);
+        check(d->live_buffers.contains(bindless_slot.view.handle()), "heap buffer read by bindless dispatch deferred");
+        d->completed = true;
+        queue.reclaim();
+        d->completed = false;
+        check(!d->live_buffers.contains(bindless_slot.view.handle()), "heap buffer read by bindless dispatch destroyed");
+
+        auto copy_stream = device.create_stream();
+        bindless_slot = heap.allocate_buffer<float>(16u);
+        copy_stream << bindless_slot.view.copy_from(host.data());
+        stream << bindless(heap, out).dispatch(16u);
+        heap.destroy_buffer(bindless_slot.index);
+        d->completed_streams.emplace(stream.handle());
+        queue.reclaim();
+        check(d->live_buffers.contains(bindless_slot.view.handle()), "heap buffer copied on another stream deferred");
+        d->completed_streams.emplace(copy_stream.handle());
+        queue.reclaim();
+        check(!d->live_buffers.contains(bindless_slot.view.handle()), "heap buffer destroyed after both streams");
+        d->completed_streams.clear();
+
+        // in the other order as well
+        bindless_slot = heap.allocate_buffer<float>(16u);
+        copy_stream << bindless_slot.view.copy_from(host.data());
+        stream << bindless(heap, out).dispatch(16u);
+        heap.destroy_buffer(bindless_slot.index);
+        d->completed_streams.emplace(copy_stream.handle());
+        queue.reclaim();
+        check(d->live_buffers.contains(bindless_slot.view.handle()), "heap buffer read by later bindless dispatch deferred");
+        d->completed_streams.emplace(stream.handle());
+        queue.reclaim();
+        check(!d->live_buffers.contains(bindless_slot.view.handle()), "heap buffer destroyed after both streams");
+        d->completed_streams.clear();
+    }
+    check(d->live_buffers.empty() && queue.pending_count() == 0u, "bindless heap buffers destroyed");
+
+    // so are the idle transient storages trimmed by pools
+    {
+        TransientPool pool{stream, TransientPool::default_max_frames_in_flight, 0u};
+        auto transient = pool.allocate_buffer<float>(16u);
+        auto transient_handle = transient.handle();
+        stream << transient.copy_from(host.data());
+        pool.release(transient);
+        d->completed = true;
+        static_cast<void>(pool.end_frame());
+        static_cast<void>(pool.end_frame());// trims the storage
+        check(d->live_buffers.empty(), "idle transient buffer destroyed");
+        signal_count = d->signal_count;
+        auto recycled = device.create_buffer<float>(16u);
+        check(recycled.handle() == transient_handle, "transient buffer handle recycled");
+        recycled = {};
+        check(d->live_buffers.empty() && d->signal_count == signal_count, "recycled transient handle destroyed right away");
+    }
+    d->completed = false;
+    LUISA_INFO("All checks passed.");
+}
@@ -0,0 +1,105 @@
+//
+// Created by Mike Smith on 2021/9/21.
+//
+
+#include <cmath>
+#include <vector>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/stream.h>
+#include <runtime/buffer.h>
+#include <compile/cpp_codegen.h>
+#include <dsl/syntax.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+void check(bool condition, std::string_view what) noexcept {
+    if (!condition) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Check failed: {}.", what); }
+}
+
+}// namespace
+
+// Checks that kernels compute in half precision and store halves, against
+// the same operations on the host.
+int main(int argc, char *argv[]) {
+
+    log_level_verbose();
+
+    Kernel1D half_kernel = [](BufferVar<half> a, BufferVar<half> b, BufferVar<half> result, BufferFloat widened) noexcept {
+        auto i = dispatch_id().x;
+        Var<half> x = a[i];
+        Var<half> y = b[i];
+        Var<half> z = x * y + 0.5_h;
+        if_(z > x, [&] { z -= y; });
+        Var<half2> v = make_half2(z, x);
+        result[i] = v.x + v.y / 4.0_h;
+        widened[i] = cast<float>(z);
+    };
+
+    // halves are declared and operated on as such, never widened implicitly
+    Codegen::Scratch scratch;
+    CppCodegen codegen{scratch};
+    codegen.emit(half_kernel.function()->function());
+    check(scratch.view().find("half2") != std::string_view::npos, "half vectors in codegen");
+    check(scratch.view().find("half(") != std::string_view::npos, "half literals in codegen");
+
+#if defined(LUISA_BACKEND_CPP_ENABLED) || defined(LUISA_BACKEND_CUDA_ENABLED) || \
+    defined(LUISA_BACKEND_METAL_ENABLED) || defined(LUISA_BACKEND_DX_ENABLED)
+    Context context{argv[0]};
+#if defined(LUISA_BACKEND_CPP_ENABLED)
+    auto device = context.create_device("cpp");
+#elif defined(LUISA_BACKEND_CUDA_ENABLED)
+    auto device = context.create_device("cuda");
+#elif defined(LUISA_BACKEND_METAL_ENABLED)
+    auto device = context.create_device("metal");
+#else
+    auto device = context.create_device("dx");
+#endif
+
+    static constexpr auto n = 1024u;
+    std::vector<half> a(n);
+    std::vector<half> b(n);
+    for (auto i = 0u; i < n; i++) {
+        a[i] = half{static_cast<float>(i) * 0.125f - 64.0f};
+        b[i] = half{1.0f / static_cast<float>(i + 1u)};
+    }
+    auto a_buffer = device.create_buffer<half>(n);
+    auto b_buffer = device.create_buffer<half>(n);
+    auto result_buffer = device.create_buffer<half>(n);
+    auto widened_buffer = device.create_buffer<float>(n);
+    auto shader = device.compile(half_kernel);
+    auto stream = device.create_stream();
+    std::vector<half> result(n);
+    std::vector<float> widened(n);
+    stream << a_buffer.copy_from(a.data())
+           << b_buffer.copy_from(b.data())
+           << shader(a_buffer, b_buffer, result_buffer, widened_buffer).dispatch(n)
+           << result_buffer.copy_to(result.data())
+           << widened_buffer.copy_to(widened.data())
+           << synchronize();
+
+    // every operation rounds to half, backends may fuse the multiply-add though
+    auto close = [](half lhs, half rhs) noexcept {
+        auto l = static_cast<float>(lhs);
+        auto r = static_cast<float>(rhs);
+        return std::abs(l - r) <= 0x1p-9f * std::max(std::abs(r), 1.0f);
+    };
+    for (auto i = 0u; i < n; i++) {
+        auto z = a[i] * b[i] + 0.5_h;
+        if (z > a[i]) { z -= b[i]; }
+        auto expected = z + a[i] / 4.0_h;
+        check(close(result[i], expected), "half result");
+        check(close(half{widened[i]}, z) && static_cast<float>(half{widened[i]}) == widened[i],
+              "half widened to float");
+    }
+    LUISA_INFO("Half kernel results match the host.");
+#else
+    LUISA_WARNING("No backend to run the kernels on.");
+#endif
+    LUISA_INFO("All checks passed.");
+}
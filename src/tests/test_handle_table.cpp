@@ -0,0 +1,115 @@
+//
+// Created by Mike Smith on 2021/9/21.
+//
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <core/logging.h>
+#include <runtime/handle_table.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+// owns heap memory, so that ASan catches objects used after destruction
+struct Object {
+    uint64_t value;
+    std::vector<uint64_t> payload;
+    explicit Object(uint64_t v) noexcept : value{v}, payload(4u, v) {}
+    [[nodiscard]] bool is_valid(uint64_t v) const noexcept {
+        return value == v && payload.size() == 4u && payload.back() == v;
+    }
+};
+
+void check(bool condition, std::string_view what) noexcept {
+    if (!condition) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Check failed: {}.", what); }
+}
+
+}// namespace
+
+// Exercises HandleTable on the host (run with ASan/TSan): generation reuse of
+// slots, and lookups of long-lived handles racing with create/destroy churn.
+int main() {
+
+    static constexpr auto churn_thread_count = 6u;
+    static constexpr auto lookup_thread_count = 2u;
+    static constexpr auto iterations = 100000u;
+    static constexpr auto stable_count = 1000u;
+
+    using Table = HandleTable<Object>;
+    Table table;
+
+    // destroyed slots are reused with a new generation, so stale handles are detected
+    auto first = table.create(7u);
+    check(first != 0u && table.contains(first) && table[first].is_valid(7u), "created handle");
+    auto stale = first;
+    for (auto i = 0u; i < 16u; i++) {
+        table.destroy(stale);
+        check(!table.contains(stale), "destroyed handle is stale");
+        auto reused = table.create(i);
+        check(Table::index(reused) == Table::index(first), "slot reused");
+        check(Table::generation(reused) != Table::generation(stale) &&
+                  (Table::generation(reused) & 1u) == 1u,
+              "generation bumped and odd");
+        check(!table.contains(first), "first handle stays stale");
+        stale = reused;
+    }
+    table.destroy(stale);
+    check(table.size() == 0u, "table empty");
+
+    // long-lived objects must stay intact while other threads churn through slots
+    std::vector<uint64_t> stable;
+    for (auto i = 0u; i < stable_count; i++) { stable.emplace_back(table.create(i)); }
+    std::atomic<bool> churning{true};
+    std::vector<std::thread> lookup_threads;
+    for (auto t = 0u; t < lookup_thread_count; t++) {
+        lookup_threads.emplace_back([&, t] {
+            std::mt19937 random{t + 1000u};
+            while (churning.load(std::memory_order_relaxed)) {
+                auto i = random() % stable_count;
+                check(table.contains(stable[i]) && table[stable[i]].is_valid(i), "stable object intact");
+                check(!table.contains(first), "stale handle never revived");
+            }
+        });
+    }
+    std::vector<std::thread> churn_threads;
+    for (auto t = 0u; t < churn_thread_count; t++) {
+        churn_threads.emplace_back([&, t] {
+            std::mt19937 random{t};
+            std::vector<std::pair<uint64_t, uint64_t>> live;
+            for (auto i = 0u; i < iterations; i++) {
+                if (live.empty() || random() % 2u == 0u) {
+                    auto value = static_cast<uint64_t>(random());
+                    live.emplace_back(table.create(value), value);
+                } else {
+                    auto k = random() % live.size();
+                    auto [handle, value] = live[k];
+                    check(table.contains(handle) && table[handle].is_valid(value), "churned object intact");
+                    table.destroy(handle);
+                    check(!table.contains(handle), "churned handle stale after destruction");
+                    live[k] = live.back();
+                    live.pop_back();
+                }
+            }
+            for (auto [handle, value] : live) { table.destroy(handle); }
+        });
+    }
+    for (auto &&t : churn_threads) { t.join(); }
+    churning = false;
+    for (auto &&t : lookup_threads) { t.join(); }
+    check(table.size() == stable_count, "only stable objects left");
+    for (auto i = 0u; i < stable_count; i++) {
+        check(table[stable[i]].is_valid(i), "stable object intact after churn");
+    }
+
+    // clear() destroys everything, and the table remains usable
+    table.clear();
+    check(table.size() == 0u && !table.contains(stable.front()), "table cleared");
+    auto h = table.create(42u);
+    check(table.size() == 1u && table.contains(h) && table[h].is_valid(42u), "table usable after clear");
+    LUISA_INFO("All checks passed.");
+}
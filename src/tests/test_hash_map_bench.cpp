@@ -0,0 +1,123 @@
+//
+// Created by Mike Smith on 2021/9/20.
+//
+
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <util/vstring.h>
+#include <util/HashMap.h>
+#include <util/NodeHashMap.h>
+
+using namespace luisa;
+
+namespace {
+
+template<typename Map, typename K>
+void bench_map(std::string_view name, const std::vector<K> &keys, const auto &hits, const auto &misses, size_t iterations) noexcept {
+    constexpr auto is_std = requires(Map m, K k) { m.emplace(k, 0u); };
+    Clock clock;
+    auto report = [&](std::string_view op, size_t count, uint64_t checksum) noexcept {
+        auto ms = clock.toc();
+        LUISA_INFO("{:>14} {:<14} {:>8.2f} ns/op (checksum = {})",
+                   name, op, ms * 1e6 / static_cast<double>(count * iterations), checksum);
+    };
+    auto find = [](Map &map, const auto &key) noexcept -> const uint * {
+        if constexpr (is_std) {
+            auto iter = map.find(key);
+            return iter == map.end() ? nullptr : &iter->second;
+        } else {
+            auto index = map.Find(key);
+            return index ? &index.Value() : nullptr;
+        }
+    };
+    std::vector<Map> maps(iterations);
+    clock.tic();
+    for (auto &&map : maps) {
+        for (auto i = 0u; i < keys.size(); i++) {
+            if constexpr (is_std) {
+                map.emplace(keys[i], i);
+            } else {
+                map.Emplace(keys[i], i);
+            }
+        }
+    }
+    report("insert", keys.size(), maps.front().size());
+    auto lookup = [&](std::string_view op, const auto &queries) noexcept {
+        auto checksum = static_cast<uint64_t>(0u);
+        clock.tic();
+        for (auto &&map : maps) {
+            for (auto &&q : queries) {
+                if (auto v = find(map, q)) { checksum += *v; }
+            }
+        }
+        report(op, queries.size(), checksum);
+    };
+    lookup("find (hit)", hits);
+    lookup("find (miss)", misses);
+    auto checksum = static_cast<uint64_t>(0u);
+    clock.tic();
+    for (auto &&map : maps) {
+        for (auto &&p : map) { checksum += p.second; }
+    }
+    report("iterate", keys.size(), checksum);
+    clock.tic();
+    for (auto &&map : maps) {
+        for (auto i = 0u; i < keys.size(); i += 2u) {
+            if constexpr (is_std) {
+                map.erase(keys[i]);
+            } else {
+                map.Remove(keys[i]);
+            }
+        }
+    }
+    report("remove (half)", keys.size() / 2u, maps.front().size());
+    lookup("find (churned)", hits);
+}
+
+template<typename K>
+void bench_all(std::string_view suite, const std::vector<K> &keys, const auto &hits, const auto &misses, size_t iterations) noexcept {
+    LUISA_INFO("{} ({} keys):", suite, keys.size());
+    bench_map<HashMap<K, uint>>("HashMap", keys, hits, misses, iterations);
+    bench_map<NodeHashMap<K, uint>>("NodeHashMap", keys, hits, misses, iterations);
+    bench_map<std::unordered_map<K, uint, vstd::hash<K>>>("unordered_map", keys, hits, misses, iterations);
+}
+
+}// namespace
+
+// Compares HashMap with NodeHashMap and std::unordered_map (with the same hashes)
+// on integer keys and on string keys looked up by views, e.g., names in a buffer.
+// Usage: test_hash_map_bench [key count = 100000] [iterations = 10]
+int main(int argc, char *argv[]) {
+
+    auto key_count = argc > 1 ? std::stoul(argv[1]) : 100000ul;
+    auto iterations = argc > 2 ? std::stoul(argv[2]) : 10ul;
+
+    std::mt19937_64 random{19260817u};
+    std::vector<uint64_t> integers(key_count * 2u);
+    for (auto &&i : integers) { i = random(); }
+    std::vector<uint64_t> integer_keys{integers.cbegin(), integers.cbegin() + key_count};
+    std::vector<uint64_t> integer_misses{integers.cbegin() + key_count, integers.cend()};
+    auto integer_hits = integer_keys;
+    std::shuffle(integer_hits.begin(), integer_hits.end(), random);
+    bench_all("Integer keys", integer_keys, integer_hits, integer_misses, iterations);
+
+    std::vector<std::string> names;
+    names.reserve(key_count * 2u);
+    for (auto i = 0ul; i < key_count * 2u; i++) { names.emplace_back(fmt::format("resource/{:016x}", integers[i])); }
+    std::vector<vstd::string> string_keys;
+    std::vector<vstd::string_view> string_hits;
+    std::vector<vstd::string_view> string_misses;
+    for (auto i = 0ul; i < key_count; i++) {
+        string_keys.emplace_back(vstd::string_view{names[i].data(), names[i].size()});
+        string_hits.emplace_back(names[i].data(), names[i].size());
+        string_misses.emplace_back(names[i + key_count].data(), names[i + key_count].size());
+    }
+    std::shuffle(string_hits.begin(), string_hits.end(), random);
+    bench_all("String keys", string_keys, string_hits, string_misses, iterations);
+}
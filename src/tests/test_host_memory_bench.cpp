@@ -0,0 +1,81 @@
+//
+// Created by Mike Smith on 2021/9/19.
+//
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <core/platform.h>
+
+using namespace luisa;
+
+// Measures the host memory bandwidth for each pair of thread and memory NUMA
+// nodes, with default and huge pages, as seen by the C++ JIT backend workers.
+// Usage: test_host_memory_bench [size MiB = 1024] [iterations = 5]
+int main(int argc, char *argv[]) {
+
+    auto size = (argc > 1 ? std::stoul(argv[1]) : 1024ul) * 1024ul * 1024ul;
+    auto iterations = argc > 2 ? std::stoul(argv[2]) : 5ul;
+    auto node_count = numa_node_count();
+    LUISA_INFO("{} NUMA node(s), huge page size = {} KiB.", node_count, huge_page_size() / 1024u);
+
+    // runs f(begin, end) over the words on all processors of the node
+    auto parallel_for = [](uint32_t node, size_t count, auto &&f) noexcept {
+        auto thread_count = std::max(numa_node_processors(node).size(), static_cast<size_t>(1u));
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count);
+        for (auto i = 0u; i < thread_count; i++) {
+            threads.emplace_back([&, i] {
+                bind_thread_to_numa_node(node);
+                f(count * i / thread_count, count * (i + 1u) / thread_count);
+            });
+        }
+        for (auto &&t : threads) { t.join(); }
+    };
+
+    Clock clock;
+    for (auto huge : {false, true}) {
+        for (auto memory_node = 0u; memory_node < node_count; memory_node++) {
+            auto pages = allocate_pages(size, {.huge_pages = huge, .numa_node = static_cast<int>(memory_node)});
+            if (pages.empty()) {
+                LUISA_WARNING("Failed to allocate {} MiB on node {}.", size >> 20u, memory_node);
+                continue;
+            }
+            auto words = std::span{reinterpret_cast<uint64_t *>(pages.data()), pages.size() / sizeof(uint64_t)};
+            // first touch from the memory node, in case the placement is only a preference
+            parallel_for(memory_node, words.size(), [&](size_t begin, size_t end) noexcept {
+                std::iota(words.begin() + begin, words.begin() + end, begin);
+            });
+            for (auto thread_node = 0u; thread_node < node_count; thread_node++) {
+                std::atomic<uint64_t> checksum{0u};
+                clock.tic();
+                for (auto i = 0ul; i < iterations; i++) {
+                    parallel_for(thread_node, words.size(), [&](size_t begin, size_t end) noexcept {
+                        checksum.fetch_add(std::accumulate(words.begin() + begin, words.begin() + end, uint64_t{0u}),
+                                           std::memory_order_relaxed);
+                    });
+                }
+                auto read_ms = clock.toc();
+                clock.tic();
+                for (auto i = 0ul; i < iterations; i++) {
+                    parallel_for(thread_node, words.size(), [&](size_t begin, size_t end) noexcept {
+                        std::fill(words.begin() + begin, words.begin() + end, i);
+                    });
+                }
+                auto write_ms = clock.toc();
+                auto gb = static_cast<double>(pages.size()) * static_cast<double>(iterations) / 1e9;
+                LUISA_INFO("{} pages, threads on node {}, memory on node {}: "
+                           "read {:.2f} GB/s, write {:.2f} GB/s (checksum = {}).",
+                           huge ? "Huge" : "Default", thread_node, memory_node,
+                           gb / (read_ms * 1e-3), gb / (write_ms * 1e-3), checksum.load());
+            }
+            free_pages(pages);
+        }
+    }
+}
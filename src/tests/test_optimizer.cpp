@@ -0,0 +1,151 @@
+//
+// Created by Mike Smith on 2021/9/21.
+//
+
+#include <vector>
+#include <numeric>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/stream.h>
+#include <runtime/buffer.h>
+#include <compile/cpp_codegen.h>
+#include <compile/inliner.h>
+#include <compile/loop_unroller.h>
+#include <compile/optimizer.h>
+#include <dsl/syntax.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+void set_passes_enabled(bool enabled) noexcept {
+    Inliner::default_config().enabled = enabled;
+    LoopUnroller::default_config().enabled = enabled;
+    Optimizer::default_config() = {enabled, enabled, enabled};
+}
+
+}// namespace
+
+// Checks that the kernels rewritten by the inliner, the loop unroller and the
+// optimizer stay valid (run with ASan) and compute the same results as the
+// un-optimized kernels.
+int main(int argc, char *argv[]) {
+
+    log_level_verbose();
+
+    // callables defined inside a kernel live in the source kernel's arena,
+    // which must outlive the rewritten kernels referring to them
+    auto local_callable_kernel = [](BufferUInt buffer) noexcept {
+        Callable collatz = [](UInt x) noexcept { return ite(x % 2u == 0u, x / 2u, 3u * x + 1u); };
+        Callable greater_than_one = [](UInt x) noexcept { return x > 1u; };
+        auto i = dispatch_id().x;
+        UInt x = buffer[i];
+        UInt steps = 0u;
+        // calls in loop conditions are not inlined
+        while_(greater_than_one(x), [&] {
+            x = collatz(x);
+            steps += 1u;
+        });
+        buffer[i] = steps;
+    };
+    for (auto inline_calls : {false, true}) {
+        set_passes_enabled(true);
+        Inliner::default_config().enabled = inline_calls;
+        Kernel1D kernel = local_callable_kernel;
+        auto callables = kernel.function()->custom_callables();
+        if (callables.empty()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Kernel-local callable is missing.");
+        }
+        LUISA_INFO("Kernel-local callable #{} (inliner {}).",
+                   hash_to_string(callables[0].hash()),
+                   inline_calls ? "enabled" : "disabled");
+        Codegen::Scratch scratch;
+        CppCodegen codegen{scratch};
+        codegen.emit(kernel.function()->function());
+    }
+
+    // inlined and unrolled kernels vs. their un-optimized versions
+#if defined(LUISA_BACKEND_CPP_ENABLED) || defined(LUISA_BACKEND_CUDA_ENABLED) || \
+    defined(LUISA_BACKEND_METAL_ENABLED) || defined(LUISA_BACKEND_DX_ENABLED)
+    Callable mix = [](UInt a, UInt b) noexcept {
+        auto h = a * 0x9e3779b9u + b;
+        return h ^ (h >> 16u);
+    };
+    Callable mix3 = [&](UInt a, UInt b, UInt c) noexcept {
+        return mix(mix(a, b), c);
+    };
+    auto inline_def = [&](BufferUInt buffer) noexcept {
+        Callable local_mix = [&](UInt a) noexcept { return mix3(a, 1u, 2u) + mix(a, 3u); };
+        auto i = dispatch_id().x;
+        UInt x = buffer[i];
+        if_(x % 3u == 0u, [&] { x = local_mix(x); });
+        buffer[i] = mix3(x, i, local_mix(i));
+    };
+    auto unroll_def = [&](BufferUInt buffer) noexcept {
+        auto i = dispatch_id().x;
+        UInt x = buffer[i];
+        for (auto j : range(4u)) {
+            for (auto k : range(3u)) { x = mix(x, j * (2u * k + 1u)); }
+        }
+        UInt n = 3u;
+        while_(n < 9u, [&] {
+            x += mix(x, n);
+            n += 2u;
+        });
+        buffer[i] = x;
+    };
+
+    Context context{argv[0]};
+#if defined(LUISA_BACKEND_CPP_ENABLED)
+    auto device = context.create_device("cpp");
+#elif defined(LUISA_BACKEND_CUDA_ENABLED)
+    auto device = context.create_device("cuda");
+#elif defined(LUISA_BACKEND_METAL_ENABLED)
+    auto device = context.create_device("metal");
+#else
+    auto device = context.create_device("dx");
+#endif
+
+    static constexpr auto n = 4096u;
+    auto stream = device.create_stream();
+    auto buffer = device.create_buffer<uint>(n);
+    std::vector<uint> input(n);
+    std::iota(input.begin(), input.end(), 0u);
+    auto run = [&](auto &&def, bool optimized) noexcept {
+        set_passes_enabled(optimized);
+        Kernel1D kernel = def;
+        auto shader = device.compile(kernel);
+        std::vector<uint> result(n);
+        stream << buffer.copy_from(input.data())
+               << shader(buffer).dispatch(n)
+               << buffer.copy_to(result.data())
+               << synchronize();
+        return std::make_pair(kernel.function(), result);
+    };
+    auto check = [&](std::string_view name, auto &&def) noexcept {
+        auto [reference_kernel, reference] = run(def, false);
+        auto [optimized_kernel, optimized] = run(def, true);
+        if (optimized_kernel->hash() == reference_kernel->hash()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Kernel '{}' is not transformed.", name);
+        }
+        for (auto i = 0u; i < n; i++) {
+            if (optimized[i] != reference[i]) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION(
+                    "Kernel '{}' mismatches at {}: {} (optimized) vs. {} (reference).",
+                    name, i, optimized[i], reference[i]);
+            }
+        }
+        LUISA_INFO("Kernel '{}': {} -> {} node(s), results match.", name,
+                   Optimizer::count_nodes(reference_kernel->function()),
+                   Optimizer::count_nodes(optimized_kernel->function()));
+    };
+    check("inline", inline_def);
+    check("unroll", unroll_def);
+    set_passes_enabled(true);
+#else
+    LUISA_WARNING("No backend to run the kernels on.");
+#endif
+}
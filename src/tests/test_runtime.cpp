@@ -3,6 +3,8 @@
 //
 
 #include <numeric>
+#include <algorithm>
+#include <fstream>
 
 #include <core/clock.h>
 #include <util/dynamic_module.h>
@@ -11,6 +13,7 @@
 #include <runtime/stream.h>
 #include <runtime/buffer.h>
 #include <runtime/heap.h>
+#include <runtime/transient_pool.h>
 #include <dsl/syntax.h>
 #include <tests/fake_device.h>
 
@@ -162,4 +165,59 @@ int main(int argc, char *argv[]) {
         static_cast<void>(heap.destroy_buffer(i));
         LUISA_INFO("Used size: {}", heap.allocated_size());
     }
+    for (auto i = 0u; i < 4u; i++) {
+        auto [index, buffer] = heap.allocate_buffer<float>(1024u);// reuses the freed slots
+        LUISA_INFO("Allocated heap buffer #{} at slot {}.", buffer.handle(), index);
+        heap.destroy_buffer(index);
+    }
+
+    if (device.mapped_buffer_access() != MappedBufferAccess::NONE) {
+        // written in place, then copied on the device without staging
+        auto mapped = device.create_buffer<float>(16384u, BufferMemory::HOST_MAPPED);
+        std::copy(data.cbegin(), data.cend(), mapped.mapped().begin());
+        std::fill(results.begin(), results.end(), 0.0f);
+        stream << buffer.copy_from(mapped)
+               << buffer.copy_to(results.data())
+               << synchronize();
+        if (results != data) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Mismatched buffer contents copied from a mapped buffer.");
+        }
+        // and read back in place after the device writes it
+        std::fill(mapped.mapped().begin(), mapped.mapped().end(), 0.0f);
+        stream << mapped.copy_from(buffer) << synchronize();
+        if (!std::equal(data.cbegin(), data.cend(), mapped.mapped().begin())) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Mismatched mapped buffer contents after a device copy.");
+        }
+        // the mapping moves along with the buffer
+        auto moved = std::move(mapped);
+        if (mapped.is_mapped() || mapped.size() != 0u || !moved.is_mapped()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Mapping not moved with the buffer.");
+        }
+    }
+
+    // streamed from disk in chunks, or read in place where the device supports file-backed buffers
+    auto data_path = context.cache_directory() / "test_runtime_data.bin";
+    std::ofstream{data_path, std::ios::binary}.write(reinterpret_cast<const char *>(data.data()), data.size() * sizeof(float));
+    clock.tic();
+    stream << buffer.copy_from_file(data_path) << synchronize();
+    LUISA_INFO("Copied from file in {} ms.", clock.toc());
+    if (device.file_buffers_supported()) {
+        auto file_buffer = device.create_file_buffer<float>(data_path);
+        stream << buffer.copy_from(file_buffer) << synchronize();
+    }
+
+    TransientPool transient_pool{stream};
+    for (auto frame = 0u; frame < 4u; frame++) {
+        auto command_buffer = stream.command_buffer();
+        auto scratch = transient_pool.allocate_buffer<float>(16384u);
+        command_buffer << scratch.copy_from(buffer);
+        transient_pool.release(scratch);
+        auto another_scratch = transient_pool.allocate_buffer<float>(16384u);// aliases scratch
+        command_buffer << another_scratch.copy_from(buffer)
+                       << commit();
+        transient_pool.release(another_scratch);
+        auto statistics = transient_pool.end_frame();
+        LUISA_INFO("Transient frame #{}: peak = {} bytes, requested = {} bytes.",
+                   statistics.frame, statistics.peak_bytes, statistics.requested_bytes);
+    }
 }
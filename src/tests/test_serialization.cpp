@@ -0,0 +1,124 @@
+//
+// Created by Mike Smith on 2021/9/6.
+//
+
+#include <numeric>
+
+#include <core/clock.h>
+#include <core/logging.h>
+#include <ast/function_serializer.h>
+#include <compile/cpp_codegen.h>
+#include <runtime/context.h>
+#include <runtime/kernel_archive.h>
+#include <runtime/capture_device.h>
+#include <dsl/syntax.h>
+
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    std::vector<float> weights(64u);
+    std::iota(weights.begin(), weights.end(), 1.0f);
+
+    Callable lerp_weight = [&](Float x, UInt i) noexcept {
+        Constant w = weights;
+        return lerp(x, w[i % 64u], 0.5f);
+    };
+
+    Callable accumulate = [&](Float x, UInt n) noexcept {
+        Var sum = 0.0f;
+        for (auto i : range(n)) { sum += lerp_weight(x, i); }
+        return sum;
+    };
+
+    Clock clock;
+    Kernel1D<Buffer<float>, uint> kernel_def = [&](BufferFloat buffer, UInt n) noexcept {
+        auto i = dispatch_x();
+        Var x = buffer[i];
+        Var y = make_float3(x, accumulate(x, n), 1.0f);
+        if_(y.x > 1.0f, [&] { y = make_float3(y.x, y.z, y.y); });
+        switch_(i % 3u)
+            .case_(0u, [&] { x = dot(y, y); })
+            .default_([&] { x = length(y); });
+        buffer[i] = x + lerp_weight(y.z, 3u);
+    };
+    auto define_time = clock.toc();
+
+    auto original = kernel_def.function()->function();
+    clock.tic();
+    auto blob = FunctionSerializer::serialize(original);
+    auto serialize_time = clock.toc();
+    clock.tic();
+    auto loaded_builder = FunctionSerializer::deserialize_kernel(blob);
+    auto load_time = clock.toc();
+    auto loaded = loaded_builder->function();
+
+    LUISA_INFO(
+        "Serialized kernel to {} bytes (define: {:.3f} ms, serialize: {:.3f} ms, load: {:.3f} ms).",
+        blob.size(), define_time, serialize_time, load_time);
+    if (loaded.hash() != original.hash()) {
+        LUISA_ERROR_WITH_LOCATION(
+            "Hash mismatch: {} vs. {}.",
+            hash_to_string(original.hash()), hash_to_string(loaded.hash()));
+    }
+
+    auto generate = [](Function f) noexcept {
+        Codegen::Scratch scratch;
+        CppCodegen codegen{scratch};
+        codegen.emit(f);
+        return std::string{scratch.view()};
+    };
+    if (generate(original) != generate(loaded)) {
+        LUISA_ERROR_WITH_LOCATION("Generated code mismatch after loading.");
+    }
+
+    // loaded kernels can be used as typed kernels again
+    Kernel1D<Buffer<float>, uint> loaded_kernel = Kernel1D<Buffer<float>, uint>::from(loaded_builder);
+    LUISA_INFO("Round trip succeeded for kernel #{}.", hash_to_string(loaded_kernel.function()->hash()));
+
+    // kernel archives: build once, then map and materialize lazily
+    Context context{argv[0]};
+    auto device = FakeDevice::create(context);
+    auto archive_path = context.cache_directory() / "test_serialization.lcka";
+    KernelArchive::Builder{}
+        .add("accumulate", kernel_def, device)
+        .add("loaded", loaded_kernel)
+        .save(archive_path);
+
+    clock.tic();
+    KernelArchive archive{archive_path};
+    auto shader = archive.shader<Kernel1D<Buffer<float>, uint>>(device, "accumulate");
+    auto open_time = clock.toc();
+    auto buffer = device.create_buffer<float>(1024u);
+    auto stream = device.create_stream();
+    clock.tic();
+    stream << shader(buffer, 16u).dispatch(1024u) << synchronize();
+    LUISA_INFO(
+        "Opened archive with {} entries in {:.3f} ms, first dispatch in {:.3f} ms.",
+        archive.entries().size(), open_time, clock.toc());
+    if (archive.function("loaded")->hash() != original.hash()) {
+        LUISA_ERROR_WITH_LOCATION("Hash mismatch for archived kernel.");
+    }
+
+    // capture device calls and replay them on a fresh device
+    auto capture_path = context.cache_directory() / "test_serialization.lccap";
+    {
+        auto capture = CaptureDevice::create(device, capture_path);
+        auto captured_shader = capture.compile(kernel_def);
+        auto captured_buffer = capture.create_buffer<float>(1024u);
+        std::vector<float> host(1024u);
+        std::iota(host.begin(), host.end(), 0.0f);
+        auto captured_stream = capture.create_stream();
+        captured_stream << captured_buffer.copy_from(host.data())
+                        << captured_shader(captured_buffer, 16u).dispatch(1024u)
+                        << captured_buffer.copy_to(host.data())
+                        << synchronize();
+    }
+    auto report = CaptureReplayer::replay(FakeDevice::create(context), capture_path);
+    if (report.dispatch_count == 0u || report.command_count != 3u) {
+        LUISA_ERROR_WITH_LOCATION("Unexpected replay of {} commands.", report.command_count);
+    }
+}
@@ -10,6 +10,7 @@
 #include <runtime/image.h>
 #include <runtime/stream.h>
 #include <runtime/buffer.h>
+#include <runtime/stream_profiler.h>
 #include <dsl/syntax.h>
 #include <tests/fake_device.h>
 
@@ -55,6 +56,9 @@ int main(int argc, char *argv[]) {
         auto index = dispatch_id().x;
         store(result, index, add(load(source, index), x));
     };
+    device.resource_tracker().set_budget(4u * 1024u * 1024u, [](size_t total, size_t budget) noexcept {
+        LUISA_INFO("Device memory usage crossed the budget: {} / {} bytes.", total, budget);
+    });
     auto kernel = device.compile(kernel_def);
 
     static constexpr auto n = 1024u * 1024u;
@@ -80,7 +84,27 @@ int main(int argc, char *argv[]) {
     auto t2 = clock.toc();
 
     LUISA_INFO("Dispatched in {} ms. Finished in {} ms.", t1, t2);
+    auto buffer_usage = device.resource_tracker().usage(Resource::Tag::BUFFER);
+    LUISA_INFO("Buffers: {} live ({} bytes), peak {} bytes.",
+               buffer_usage.count, buffer_usage.bytes, buffer_usage.peak_bytes);
     LUISA_INFO("Results: {}, {}, {}, {}, ..., {}, {}.",
                results[0], results[1], results[2], results[3],
                results[n - 2u], results[n - 1u]);
+
+    // the same work again, with per-command timings
+    auto profiler = std::make_shared<StreamProfiler>();
+    stream.set_profiler(profiler);
+    stream << buffer.copy_from(data.data());
+    for (auto i = 0; i < 10; i++) {
+        stream << kernel(buffer, result_buffer, 3).dispatch(n);
+    }
+    stream << result_buffer.copy_to(results.data())
+           << synchronize();
+    stream.set_profiler(nullptr);
+    for (auto &&a : profiler->aggregates()) {
+        LUISA_INFO("{}: count = {}, total = {:.3f} ms, p50 = {:.3f} ms, p99 = {:.3f} ms{}.",
+                   a.name, a.count, a.total, a.p50, a.p99,
+                   a.host_synchronous ? " (host-synchronous)" : "");
+    }
+    profiler->export_chrome_trace(context.cache_directory() / "test_simple_trace.json");
 }
@@ -0,0 +1,150 @@
+//
+// Created by Mike Smith on 2021/9/21.
+//
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+
+#include <core/logging.h>
+#include <runtime/staging_ring.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+// Exercises StagingRing on the host (run with ASan): encoder threads allocate
+// and fill staging memory, including requests that overflow the ring, while a
+// completion thread plays the stream, validates the contents and reclaims the
+// fences in order. The completion thread must never free memory.
+int main() {
+
+    static constexpr auto list_count = 2000u;
+    static constexpr auto encoder_count = 4u;
+    static constexpr auto allocations_per_encoder = 4u;
+
+    std::atomic<int64_t> live_blocks{0};
+    std::atomic<std::thread::id> completion_thread_id;
+    StagingRing ring{
+        1000u,
+        [&](size_t size) noexcept {
+            live_blocks.fetch_add(1);
+            return StagingRing::Block{static_cast<std::byte *>(std::malloc(size)), 0u};
+        },
+        [&](StagingRing::Block block) noexcept {
+            if (std::this_thread::get_id() == completion_thread_id.load()) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION("Staging memory freed in the completion callback.");
+            }
+            live_blocks.fetch_sub(1);
+            std::free(block.address);
+        }};
+    if (ring.capacity() != 1024u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Unexpected ring capacity {}.", ring.capacity());
+    }
+
+    // overflow blocks are retired by the fences covering them and freed by the next fence()
+    auto expect_live_blocks = [&](int64_t expected) noexcept {
+        if (auto n = live_blocks.load(); n != expected) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Expected {} live block(s), found {}.", expected, n);
+        }
+    };
+    static_cast<void>(ring.allocate(4096u));
+    auto first = ring.fence();
+    static_cast<void>(ring.allocate(4096u));
+    auto second = ring.fence();
+    ring.reclaim(first);
+    expect_live_blocks(2);
+    static_cast<void>(ring.fence());
+    expect_live_blocks(1);
+    ring.reclaim(second);
+    static_cast<void>(ring.fence());
+    expect_live_blocks(0);
+
+    struct Item {
+        StagingRing::Allocation allocation;
+        uint8_t tag;
+    };
+    struct List {
+        std::vector<Item> items;
+        StagingRing::Fence fence{};
+    };
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<List> lists;
+    auto done = false;
+    std::thread completion{[&] {
+        completion_thread_id = std::this_thread::get_id();
+        for (;;) {
+            std::unique_lock lock{mutex};
+            cv.wait(lock, [&] { return done || !lists.empty(); });
+            if (lists.empty()) { return; }
+            auto list = std::move(lists.front());
+            lists.pop_front();
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::microseconds{50});
+            for (auto &&item : list.items) {
+                for (auto b : item.allocation.span()) {
+                    if (static_cast<uint8_t>(b) != item.tag) [[unlikely]] {
+                        LUISA_ERROR_WITH_LOCATION("Staging memory overwritten while in flight.");
+                    }
+                }
+            }
+            ring.reclaim(list.fence);
+        }
+    }};
+
+    std::mt19937 random{19260817u};
+    auto max_position = static_cast<uint64_t>(0u);
+    for (auto i = 0u; i < list_count; i++) {
+        List list;
+        std::mutex list_mutex;
+        auto tag = static_cast<uint8_t>(0u);
+        std::vector<std::thread> encoders;
+        for (auto e = 0u; e < encoder_count; e++) {
+            encoders.emplace_back([&, seed = random()] {
+                std::mt19937 r{seed};
+                for (auto k = 0u; k < allocations_per_encoder; k++) {
+                    // a few requests are larger than the ring
+                    auto size = r() % 200u + (r() % 50u == 0u ? 2000u : 0u);
+                    auto allocation = ring.allocate(size);
+                    std::scoped_lock lock{list_mutex};
+                    auto t = ++tag;
+                    std::memset(allocation.data(), t, size);
+                    list.items.emplace_back(Item{allocation, t});
+                }
+            });
+        }
+        for (auto &&e : encoders) { e.join(); }
+        list.fence = ring.fence();
+        max_position = std::max(max_position, list.fence.position);
+        {
+            std::scoped_lock lock{mutex};
+            lists.emplace_back(std::move(list));
+        }
+        cv.notify_one();
+    }
+    {
+        std::scoped_lock lock{mutex};
+        done = true;
+    }
+    cv.notify_one();
+    completion.join();
+
+    // the last reclaim() only retired the passed overflow blocks
+    auto retired_blocks = live_blocks.load() - 1;
+    static_cast<void>(ring.fence());
+    LUISA_INFO("Ring wrapped around {} time(s), {} overflow(s), {} block(s) freed by the final fence.",
+               max_position / ring.capacity(), ring.overflow_count(), retired_blocks - (live_blocks.load() - 1));
+    if (max_position <= ring.capacity() || ring.overflow_count() == 0u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("The ring did not both wrap around and overflow.");
+    }
+    if (ring.in_flight_bytes() != 0u) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("{} byte(s) still in flight.", ring.in_flight_bytes());
+    }
+    expect_live_blocks(1);// the ring itself
+}
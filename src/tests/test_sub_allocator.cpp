@@ -0,0 +1,127 @@
+//
+// Created by Mike Smith on 2021/9/21.
+//
+
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include <core/logging.h>
+#include <runtime/sub_allocator.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+void check_disjoint(std::vector<SubAllocator::Allocation> allocations, size_t alignment) noexcept {
+    std::sort(allocations.begin(), allocations.end(), [](auto &&lhs, auto &&rhs) noexcept {
+        return lhs.block < rhs.block || (lhs.block == rhs.block && lhs.offset < rhs.offset);
+    });
+    for (auto i = 0u; i < allocations.size(); i++) {
+        auto &&a = allocations[i];
+        if (a.offset % alignment != 0u) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION("Misaligned allocation at offset {}.", a.offset);
+        }
+        if (i != 0u) {
+            auto &&prev = allocations[i - 1u];
+            if (prev.block == a.block && prev.offset + prev.size > a.offset) [[unlikely]] {
+                LUISA_ERROR_WITH_LOCATION(
+                    "Overlapping allocations [{}, {}) and [{}, {}) in block {}.",
+                    prev.offset, prev.offset + prev.size, a.offset, a.offset + a.size, a.block);
+            }
+        }
+    }
+}
+
+}// namespace
+
+// Stress-tests SubAllocator on the host (run with ASan): random churn of small
+// and oversized allocations, frees racing with allocations on other threads,
+// and the blocks returned by trim() and the destructor.
+int main() {
+
+    static constexpr auto block_size = static_cast<size_t>(1u) << 20u;
+    static constexpr auto alignment = static_cast<size_t>(256u);
+    static constexpr auto thread_count = 4u;
+    static constexpr auto iterations = 50000u;
+
+    std::atomic<int64_t> live_blocks{0};
+    auto next_block = static_cast<uint64_t>(1u);
+    std::mutex block_mutex;
+    {
+        SubAllocator allocator{
+            SubAllocator::Callbacks{
+                .create_block = [&](size_t) noexcept {
+                    live_blocks.fetch_add(1);
+                    std::scoped_lock lock{block_mutex};
+                    return (next_block++) << 40u;
+                },
+                .destroy_block = [&](uint64_t, size_t) noexcept { live_blocks.fetch_sub(1); }},
+            block_size, alignment};
+
+        // each thread allocates and frees its own allocations, while
+        // the frees of the others are drained by its allocate() calls
+        std::mutex live_mutex;
+        std::vector<SubAllocator::Allocation> all_live;
+        std::vector<std::thread> threads;
+        for (auto t = 0u; t < thread_count; t++) {
+            threads.emplace_back([&, t] {
+                std::mt19937 random{t};
+                std::vector<SubAllocator::Allocation> live;
+                for (auto i = 0u; i < iterations; i++) {
+                    if (live.empty() || random() % 3u != 0u) {
+                        // a few are larger than a block
+                        auto size = random() % 4u == 0u ? random() % (3u * block_size) : random() % 5000u;
+                        auto allocation = allocator.allocate(size);
+                        if (!allocation || allocation.size < size) [[unlikely]] {
+                            LUISA_ERROR_WITH_LOCATION("Failed to allocate {} bytes.", size);
+                        }
+                        live.emplace_back(allocation);
+                    } else {
+                        auto index = random() % live.size();
+                        allocator.free(live[index]);
+                        live[index] = live.back();
+                        live.pop_back();
+                    }
+                }
+                std::scoped_lock lock{live_mutex};
+                all_live.insert(all_live.end(), live.cbegin(), live.cend());
+            });
+        }
+        for (auto &&t : threads) { t.join(); }
+        check_disjoint(all_live, alignment);
+
+        auto statistics = allocator.statistics();
+        if (statistics.allocation_count != all_live.size()) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Allocation count {} mismatches {} live allocations.",
+                statistics.allocation_count, all_live.size());
+        }
+        LUISA_INFO("{} live allocation(s) of {} bytes in {} block(s) of {} bytes.",
+                   statistics.allocation_count, statistics.allocated_bytes,
+                   statistics.block_count, statistics.reserved_bytes);
+
+        // everything goes back to the backend once freed and trimmed
+        for (auto a : all_live) { allocator.free(a); }
+        allocator.trim();
+        statistics = allocator.statistics();
+        if (statistics.allocation_count != 0u || statistics.allocated_bytes != 0u ||
+            statistics.block_count != 0u || live_blocks.load() != 0) [[unlikely]] {
+            LUISA_ERROR_WITH_LOCATION(
+                "Leaked after trim: {} allocation(s), {} bytes, {} block(s), {} live block(s).",
+                statistics.allocation_count, statistics.allocated_bytes,
+                statistics.block_count, live_blocks.load());
+        }
+
+        // and the destructor releases the blocks still holding allocations
+        for (auto i = 0u; i < 100u; i++) { static_cast<void>(allocator.allocate(i * 1000u)); }
+    }
+    if (live_blocks.load() != 0) [[unlikely]] {
+        LUISA_ERROR_WITH_LOCATION("Leaked {} block(s) after destruction.", live_blocks.load());
+    }
+    LUISA_INFO("All checks passed.");
+}
@@ -0,0 +1,154 @@
+//
+// Created by Mike Smith on 2021/9/21.
+//
+
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+
+#include <core/logging.h>
+#include <runtime/device.h>
+#include <runtime/context.h>
+#include <runtime/stream.h>
+#include <runtime/texture.h>
+#include <runtime/transient_pool.h>
+#include <tests/fake_device.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+// tracks the live storage and lets the test decide when signaled events pass
+class PoolDevice final : public FakeDevice {
+
+public:
+    std::unordered_set<uint64_t> live_buffers;
+    std::unordered_set<uint64_t> live_textures;
+    std::vector<uint64_t> signaled;// in stream order, not yet passed
+    size_t wait_count{0u};
+
+public:
+    using FakeDevice::FakeDevice;
+    uint64_t create_buffer(size_t size_bytes, uint64_t heap_handle, uint32_t index_in_heap) noexcept override {
+        auto handle = FakeDevice::create_buffer(size_bytes, heap_handle, index_in_heap);
+        live_buffers.emplace(handle);
+        return handle;
+    }
+    void destroy_buffer(uint64_t handle) noexcept override { live_buffers.erase(handle); }
+    uint64_t create_texture(PixelFormat format, uint dimension, uint width, uint height, uint depth, uint mipmap_levels,
+                            TextureSampler sampler, uint64_t heap_handle, uint32_t index_in_heap) override {
+        auto handle = FakeDevice::create_texture(format, dimension, width, height, depth, mipmap_levels,
+                                                 sampler, heap_handle, index_in_heap);
+        live_textures.emplace(handle);
+        return handle;
+    }
+    void destroy_texture(uint64_t handle) noexcept override { live_textures.erase(handle); }
+    void signal_event(uint64_t handle, uint64_t) noexcept override { signaled.emplace_back(handle); }
+    bool query_event(uint64_t handle) noexcept override {
+        return std::find(signaled.cbegin(), signaled.cend(), handle) == signaled.cend();
+    }
+    void synchronize_event(uint64_t handle) noexcept override {
+        // the stream passes the events in order
+        if (auto iter = std::find(signaled.begin(), signaled.end(), handle); iter != signaled.end()) {
+            signaled.erase(signaled.begin(), iter + 1);
+            wait_count++;
+        }
+    }
+    void synchronize_stream(uint64_t) noexcept override { signaled.clear(); }
+    void complete() noexcept { signaled.clear(); }
+};
+
+void check(bool condition, std::string_view what) noexcept {
+    if (!condition) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Check failed: {}.", what); }
+}
+
+}// namespace
+
+// Checks that transient storage is aliased within a frame, recycled across
+// frames only once the frame's event has passed, and released in the end.
+int main(int argc, char *argv[]) {
+
+    log_level_verbose();
+
+    Context context{argv[0]};
+    auto d = new PoolDevice{context};
+    Device device{Device::Handle{d, [](Device::Interface *p) noexcept {
+                                     p->destruction_queue().flush();
+                                     delete p;
+                                 }}};
+    auto stream = device.create_stream();
+    static constexpr auto max_frames_in_flight = 2u;
+    static constexpr auto max_idle_frames = 4u;
+
+    {
+        TransientPool pool{stream, max_frames_in_flight, max_idle_frames};
+
+        // transients with disjoint lifetimes in a frame share storage
+        auto a = pool.allocate_buffer<float>(1000u);
+        auto a_handle = a.handle();
+        pool.release(a);
+        auto b = pool.allocate_buffer<float>(900u);
+        check(b.handle() == a_handle, "released buffer reused in the same frame");
+        auto c = pool.allocate_buffer<float>(5000u);
+        check(c.handle() != a_handle, "larger buffer created");
+        auto image = pool.allocate_image<float>(PixelStorage::BYTE4, 64u, 64u);
+        pool.release(image);
+        auto same_image = pool.allocate_image<float>(PixelStorage::BYTE4, 64u, 64u);
+        check(same_image.handle() == image.handle(), "released image reused in the same frame");
+        auto other_image = pool.allocate_image<float>(PixelStorage::BYTE4, 32u, 32u);
+        check(other_image.handle() != image.handle(), "images matched by size");
+        pool.release(b);
+        pool.release(c);
+        pool.release(same_image);
+        pool.release(other_image);
+        auto first = pool.end_frame();
+        check(first.allocation_count == 6u && first.created_count == 4u, "first frame allocations");
+        check(first.peak_bytes < first.requested_bytes, "aliasing shrinks the footprint");
+        check(first.pool_bytes == pool.pool_bytes() && d->live_buffers.size() == 2u && d->live_textures.size() == 2u,
+              "first frame storage");
+
+        // storage of a frame still in flight is not handed out again
+        auto in_flight = pool.allocate_buffer<float>(1000u);
+        check(in_flight.handle() != a_handle && d->live_buffers.size() == 3u, "in-flight storage not reused");
+        pool.release(in_flight);
+        auto second = pool.end_frame();
+        check(second.created_count == 1u, "second frame created storage");
+
+        // once the events have passed, the storage serves the frames after the next end_frame()
+        d->complete();
+        static_cast<void>(pool.end_frame());
+        auto recycled = pool.allocate_buffer<float>(1000u);
+        auto recycled_image = pool.allocate_image<float>(PixelStorage::BYTE4, 64u, 64u);
+        check(d->live_buffers.size() == 3u && d->live_textures.size() == 2u, "storage recycled after the events");
+        pool.release(recycled);
+        pool.release(recycled_image);
+        auto third = pool.end_frame();
+        check(third.created_count == 0u && third.allocation_count == 2u, "third frame recycled everything");
+
+        // too many frames in flight make the host wait for the oldest
+        for (auto i = 0u; i <= max_frames_in_flight; i++) {
+            auto t = pool.allocate_buffer<float>(1000u);
+            pool.release(t);
+            static_cast<void>(pool.end_frame());
+        }
+        check(d->wait_count != 0u, "throttled to the frames in flight");
+
+        // idle storage is destroyed after a while
+        for (auto i = 0u; i <= max_idle_frames + max_frames_in_flight + 1u; i++) {
+            d->complete();
+            static_cast<void>(pool.end_frame());
+        }
+        check(pool.pool_bytes() == 0u && d->live_buffers.empty() && d->live_textures.empty(), "idle storage trimmed");
+
+        // storage still owned by the pool is destroyed with it
+        static_cast<void>(pool.allocate_buffer<float>(1000u));
+        auto kept = pool.allocate_buffer<float>(2000u);
+        pool.release(kept);
+        static_cast<void>(pool.end_frame());
+        check(d->live_buffers.size() == 2u, "storage before destruction");
+    }
+    device.impl()->destruction_queue().flush();
+    check(d->live_buffers.empty() && d->live_textures.empty(), "storage released with the pool");
+    LUISA_INFO("All checks passed.");
+}
@@ -8,6 +8,11 @@
 #include <variant>
 #include <atomic>
 #include <iostream>
+#include <bit>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <numeric>
 
 #include <spdlog/spdlog.h>
 
@@ -90,6 +95,7 @@ std::string_view tag_name(Type::Tag tag) noexcept {
     if (tag == Type::Tag::FLOAT) { return "float"sv; }
     if (tag == Type::Tag::INT) { return "int"sv; }
     if (tag == Type::Tag::UINT) { return "uint"sv; }
+    if (tag == Type::Tag::HALF) { return "half"sv; }
     if (tag == Type::Tag::VECTOR) { return "vector"sv; }
     if (tag == Type::Tag::MATRIX) { return "matrix"sv; }
     if (tag == Type::Tag::ARRAY) { return "array"sv; }
@@ -125,6 +131,81 @@ void print(const Type *info, int level = 0) {
     std::cout << indent_string << "}\n";
 }
 
+void check(bool condition, std::string_view what) noexcept {
+    if (!condition) [[unlikely]] { LUISA_ERROR_WITH_LOCATION("Check failed: {}.", what); }
+}
+
+// checks half <-> float conversions, including the bulk (F16C) paths against the scalar ones
+void check_half_conversions() noexcept {
+
+    auto bits_of = [](float f) noexcept { return half{f}.bits(); };
+
+    // every half survives a round trip through float, except for NaN payloads
+    std::vector<half> halves;
+    for (auto b = 0u; b <= 0xffffu; b++) { halves.emplace_back(half::from_bits(static_cast<uint16_t>(b))); }
+    for (auto h : halves) {
+        auto f = static_cast<float>(h);
+        auto is_nan = (h.bits() & 0x7c00u) == 0x7c00u && (h.bits() & 0x3ffu) != 0u;
+        check(std::isnan(f) == is_nan, "NaN preserved when widening");
+        check(is_nan ? std::isnan(static_cast<float>(half{f})) : bits_of(f) == h.bits(), "half round trip");
+    }
+
+    // denormals, infinities and signed zeros
+    check(bits_of(0x1p-24f) == 0x0001u, "smallest denormal");
+    check(bits_of(0x1.ff8p-15f) == 0x03ffu, "largest denormal");
+    check(bits_of(0x1p-14f) == 0x0400u, "smallest normal");
+    check(bits_of(0x1p-26f) == 0x0000u && bits_of(-0x1p-26f) == 0x8000u, "underflow to signed zero");
+    check(bits_of(-0.0f) == 0x8000u, "negative zero");
+    check(bits_of(65504.0f) == 0x7bffu && bits_of(65519.0f) == 0x7bffu, "largest finite");
+    check(bits_of(1e10f) == 0x7c00u && bits_of(-1e10f) == 0xfc00u, "overflow to infinity");
+    check(bits_of(INFINITY) == 0x7c00u && bits_of(-INFINITY) == 0xfc00u, "infinities");
+    check(std::isnan(static_cast<float>(half{NAN})), "NaN");
+
+    // ties round to even, also into denormals, across binades and into infinity
+    check(bits_of(0x1p-25f) == 0x0000u && bits_of(0x1.8p-24f) == 0x0002u, "denormal ties");
+    check(bits_of(0x1.8p-25f) == 0x0001u, "above denormal tie");
+    check(bits_of(1.0f + 0x1p-11f) == 0x3c00u && bits_of(1.0f + 0x3p-11f) == 0x3c02u, "normal ties");
+    check(bits_of(0x1.ffcp-15f) == 0x0400u, "tie from denormals into normals");
+    check(bits_of(2.0f - 0x1p-11f) == 0x4000u, "tie into the next binade");
+    check(bits_of(65520.0f) == 0x7c00u, "tie into infinity");
+    for (auto b = 0u; b < 0x7bffu; b++) {
+        auto lo = static_cast<float>(half::from_bits(static_cast<uint16_t>(b)));
+        auto hi = static_cast<float>(half::from_bits(static_cast<uint16_t>(b + 1u)));
+        auto mid = std::midpoint(lo, hi);
+        auto even = (b & 1u) == 0u ? b : b + 1u;
+        check(bits_of(mid) == even && bits_of(-mid) == (even | 0x8000u), "tie to even");
+        check(bits_of(std::nextafter(mid, 0.0f)) == b && bits_of(std::nextafter(mid, hi)) == b + 1u, "round to nearest");
+    }
+
+    // the bulk conversions agree with the scalar ones, also in the tails not covered by SIMD
+    std::vector<float> floats(halves.size());
+    half_to_float(halves.data(), floats.data(), halves.size());
+    for (auto i = 0u; i < halves.size(); i++) {
+        auto expected = static_cast<float>(halves[i]);
+        check(std::isnan(expected) ? std::isnan(floats[i]) :
+                                     std::bit_cast<uint32_t>(floats[i]) == std::bit_cast<uint32_t>(expected),
+              "bulk half to float");
+    }
+    std::mt19937 random{19260817u};
+    floats.resize(100003u);
+    for (auto &&f : floats) {
+        auto r = random();
+        // mostly around the range of half, with some of every float
+        f = r % 4u == 0u ? std::bit_cast<float>(static_cast<uint32_t>(random())) :
+                           std::ldexp(static_cast<float>(random()) / 0x1p32f, static_cast<int>(r % 48u) - 30);
+        if (r % 8u == 1u) { f = -f; }
+    }
+    std::vector<half> converted(floats.size());
+    float_to_half(floats.data(), converted.data(), floats.size());
+    for (auto i = 0u; i < floats.size(); i++) {
+        auto expected = half{floats[i]};
+        check(std::isnan(floats[i]) ? std::isnan(static_cast<float>(converted[i])) :
+                                      converted[i].bits() == expected.bits(),
+              "bulk float to half");
+    }
+    LUISA_INFO("Half conversions checked.");
+}
+
 int main() {
 
     using namespace luisa;
@@ -137,6 +218,8 @@ int main() {
     LUISA_WARNING("warning...");
     LUISA_WARNING_WITH_LOCATION("warning with location...");
 
+    check_half_conversions();
+
     LUISA_INFO("size = {}, alignment = {}", sizeof(AA), alignof(AA));
     LUISA_INFO("size = {}, alignment = {}", sizeof(BB), alignof(BB));
 
@@ -2,13 +2,74 @@
 #include <util/vstlconfig.h>
 #include <type_traits>
 #include <stdint.h>
+#include <string.h>
 #include <memory>
-#include <util/Pool.h>
-#include <util/vector.h>
+#include <utility>
+#include <bit>
+#include <concepts>
 #include <util/Hash.h>
 #include <util/MetaLib.h>
 #include <util/VAllocator.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VENGINE_HASHMAP_SSE2
+#endif
+
+namespace vstd::detail {
+struct HashMapCtrl {
+	// full slots hold the low 7 bits of the hash, non-negative
+	static constexpr int8_t Empty = -128;
+	static constexpr int8_t Deleted = -2;
+	static constexpr int8_t Sentinel = -1;// after the last slot, stops iteration
+};
+// control bytes of the 16 slots from a position, with one bit per slot in the masks
+struct HashMapGroup {
+	static constexpr size_t Width = 16;
+#ifdef VENGINE_HASHMAP_SSE2
+	__m128i ctrl;
+	explicit HashMapGroup(int8_t const* pos) noexcept : ctrl(_mm_loadu_si128(reinterpret_cast<__m128i const*>(pos))) {}
+	uint32_t Match(int8_t h2) const noexcept {
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+	}
+	uint32_t MatchEmptyOrDeleted() const noexcept {
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(HashMapCtrl::Sentinel), ctrl)));
+	}
+#else
+	int8_t ctrl[Width];
+	explicit HashMapGroup(int8_t const* pos) noexcept { memcpy(ctrl, pos, Width); }
+	uint32_t Match(int8_t h2) const noexcept {
+		uint32_t mask = 0;
+		for (size_t i = 0; i < Width; ++i) mask |= static_cast<uint32_t>(ctrl[i] == h2) << i;
+		return mask;
+	}
+	uint32_t MatchEmptyOrDeleted() const noexcept {
+		uint32_t mask = 0;
+		for (size_t i = 0; i < Width; ++i) mask |= static_cast<uint32_t>(ctrl[i] < HashMapCtrl::Sentinel) << i;
+		return mask;
+	}
+#endif
+	uint32_t MatchEmpty() const noexcept { return Match(HashMapCtrl::Empty); }
+};
+// control bytes of tables without slots, so that lookups need no special case
+alignas(16) inline constexpr int8_t HashMapEmptyGroup[HashMapGroup::Width] = {
+	HashMapCtrl::Sentinel, HashMapCtrl::Empty, HashMapCtrl::Empty, HashMapCtrl::Empty,
+	HashMapCtrl::Empty, HashMapCtrl::Empty, HashMapCtrl::Empty, HashMapCtrl::Empty,
+	HashMapCtrl::Empty, HashMapCtrl::Empty, HashMapCtrl::Empty, HashMapCtrl::Empty,
+	HashMapCtrl::Empty, HashMapCtrl::Empty, HashMapCtrl::Empty, HashMapCtrl::Empty};
+// keys of another type looked up without conversion, e.g., string_view for vstd::string
+template<typename K, typename Key, typename Hash>
+concept HashMapLookupKey = !std::is_same_v<std::remove_cvref_t<Key>, K> && requires(Hash const& hash, K const& k, Key const& key) {
+	typename Hash::is_transparent;
+	{ hash(key) } -> std::convertible_to<size_t>;
+	{ k == key } -> std::convertible_to<bool>;
+};
+}// namespace vstd::detail
 
+// Open-addressing hash map in the style of Swiss tables: one control byte per
+// slot (empty, deleted, or 7 bits of the hash) probed a group of 16 at a time,
+// with the elements inline in the slot array. Insertions may rehash and move
+// the elements, invalidating Index, iterators and references to them; use
+// NodeHashMap (util/NodeHashMap.h) for elements that must stay in place.
 template<typename K, typename V, typename Hash = vstd::hash<K>, typename Equal = std::equal_to<K>, VEngine_AllocType allocType = VEngine_AllocType::VEngine>
 class HashMap {
 public:
@@ -27,69 +88,64 @@ public:
 		NodePair(A&& a, B&&... b) : first(std::forward<A>(a)), second(std::forward<B>(b)...) {}
 	};
 
-	struct LinkNode : public NodePair {
-		LinkNode* last = nullptr;
-		LinkNode* next = nullptr;
-		size_t arrayIndex;
-		LinkNode() noexcept {}
-		template<typename A, typename... B>
-		LinkNode(size_t arrayIndex, A&& key, B&&... args) noexcept : NodePair(std::forward<A>(key), std::forward<B>(args)...), arrayIndex(arrayIndex) {}
-
-		static void Add(LinkNode*& source, LinkNode* dest) noexcept {
-			if (!source) {
-				source = dest;
-			} else {
-				if (source->next) {
-					source->next->last = dest;
-				}
-				dest->next = source->next;
-				dest->last = source;
-				source->next = dest;
-			}
-		}
-	};
+private:
+	using Ctrl = vstd::detail::HashMapCtrl;
+	using Group = vstd::detail::HashMapGroup;
 
 public:
 	struct Iterator {
 	private:
-		LinkNode** ii;
+		int8_t const* ctrl;
+		NodePair* node;
+		void SkipEmpty() noexcept {
+			while (*ctrl < Ctrl::Sentinel) {
+				auto shift = std::countr_one(Group(ctrl).MatchEmptyOrDeleted());
+				ctrl += shift;
+				node += shift;
+			}
+		}
 
 	public:
-		Iterator(LinkNode** ii) : ii(ii) {}
+		Iterator(int8_t const* ctrl, NodePair* node) : ctrl(ctrl), node(node) { SkipEmpty(); }
 		bool operator==(const Iterator& ite) const noexcept {
-			return ii == ite.ii;
+			return ctrl == ite.ctrl;
 		}
 		bool operator!=(const Iterator& ite) const noexcept {
-			return ii != ite.ii;
+			return ctrl != ite.ctrl;
 		}
 		void operator++() noexcept {
-			++ii;
+			++ctrl;
+			++node;
+			SkipEmpty();
 		}
 		void operator--() noexcept {
-			--ii;
+			do {
+				--ctrl;
+				--node;
+			} while (*ctrl < 0);
 		}
 		void operator++(int32_t) noexcept {
-			ii++;
+			operator++();
 		}
 		void operator--(int32_t) noexcept {
-			ii--;
+			operator--();
 		}
 
 		NodePair const* operator->() const noexcept {
-			return *ii;
+			return node;
 		}
 		NodePair const& operator*() const noexcept {
 			return *operator->();
 		}
 	};
 	struct Index {
-		friend class SelfType;
+		friend SelfType;
 
 	private:
 		const SelfType* map;
 		size_t hashValue;
-		SelfType::LinkNode* node;
-		Index(const SelfType* map, size_t hashValue, SelfType::LinkNode* node) noexcept : map(map), hashValue(hashValue), node(node) {}
+		NodePair* node;
+		Index(const SelfType* map, size_t hashValue, NodePair* node) noexcept : map(map), hashValue(hashValue), node(node) {}
 
 	public:
 		Index() : map(nullptr), hashValue(0), node(nullptr) {}
@@ -105,140 +161,188 @@ public:
 		bool operator!=(const Index& a) const noexcept {
 			return !operator==(a);
 		}
-		inline K const& Key() const noexcept;
-		inline V& Value() const noexcept;
+		K const& Key() const noexcept { return node->first; }
+		V& Value() const noexcept { return node->second; }
 	};
 
 private:
-	ArrayList<LinkNode*, allocType> allocatedNodes;
-	struct HashArray {
-	private:
-		LinkNode** nodesPtr = nullptr;
-		size_t mSize;
-		VAllocHandle<allocType> allocHandle;
-
-	public:
-		HashArray(HashArray&& map)
-			: nodesPtr(map.nodesPtr),
-			  mSize(map.mSize) {
-			map.mSize = 0;
-			map.nodesPtr = nullptr;
-		}
-		size_t size() const noexcept { return mSize; }
-		HashArray() noexcept : mSize(0) {}
-		void ClearAll() {
-			memset(nodesPtr, 0, sizeof(LinkNode*) * mSize);
-		}
-
-		HashArray(size_t mSize) noexcept : mSize(mSize) {
-			nodesPtr = (LinkNode**)allocHandle.Malloc(sizeof(LinkNode*) * mSize);
-			memset(nodesPtr, 0, sizeof(LinkNode*) * mSize);
-		}
-		HashArray(HashArray& arr) noexcept : nodesPtr(arr.nodesPtr) {
-
-			mSize = arr.mSize;
-			arr.nodesPtr = nullptr;
-		}
-		void operator=(HashArray& arr) noexcept {
-			nodesPtr = arr.nodesPtr;
-			mSize = arr.mSize;
-			arr.nodesPtr = nullptr;
-		}
-		void operator=(HashArray&& arr) noexcept {
-			operator=(arr);
-		}
-		~HashArray() noexcept {
-			if (nodesPtr) allocHandle.Free(nodesPtr);
-		}
-		LinkNode* const& operator[](size_t i) const noexcept {
-			return nodesPtr[i];
-		}
-		LinkNode*& operator[](size_t i) noexcept {
-			return nodesPtr[i];
-		}
-	};
-
-	HashArray nodeVec;
-	Pool<LinkNode, allocType, true> pool;
+	// capacity is 0 or 2^n - 1 slots, followed in the control bytes by the sentinel
+	// and copies of the first 15 so that groups can be loaded from any slot
+	int8_t* ctrl;
+	NodePair* slots;
+	size_t capacity;
+	size_t mSize;
+	size_t growthLeft;
+	VAllocHandle<allocType> allocHandle;
 	inline static const Hash hsFunc;
 	inline static const Equal eqFunc;
-	template<typename A, typename... B>
-	LinkNode* GetNewLinkNode(A&& key, B&&... args) {
-		LinkNode* newNode = pool.New(allocatedNodes.size(), std::forward<A>(key), std::forward<B>(args)...);
-		allocatedNodes.push_back(newNode);
-		return newNode;
-	}
-	template<typename A>
-	LinkNode* GetNewLinkNode(A&& key) {
-		LinkNode* newNode = pool.New(allocatedNodes.size(), std::forward<A>(key));
-		allocatedNodes.push_back(newNode);
-		return newNode;
-	}
-	void DeleteLinkNode(LinkNode* oldNode) {
-		auto ite = allocatedNodes.end() - 1;
-		if (*ite != oldNode) {
-			(*ite)->arrayIndex = oldNode->arrayIndex;
-			allocatedNodes[oldNode->arrayIndex] = *ite;
+	static constexpr size_t MinCapacity = Group::Width - 1;
+
+	template<typename Key>
+	static size_t GetHash(Key const& key) noexcept {
+		// mixed, as 7 bits of it are taken from the bottom and the probe from the rest
+		uint64_t h = hsFunc(key);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		return static_cast<size_t>(h);
+	}
+	static size_t H1(size_t hash) noexcept { return hash >> 7; }
+	static int8_t H2(size_t hash) noexcept { return static_cast<int8_t>(hash & 0x7f); }
+	template<typename Key>
+	static bool KeyEqual(K const& a, Key const& b) noexcept {
+		if constexpr (std::is_same_v<Key, K> || requires { typename Equal::is_transparent; }) {
+			return eqFunc(a, b);
+		} else {
+			return a == b;
 		}
-		allocatedNodes.erase(ite);
-		pool.Delete(oldNode);
 	}
-	static size_t GetPow2Size(size_t capacity) noexcept {
-		size_t ssize = 1;
-		while (ssize < capacity)
-			ssize <<= 1;
-		return ssize;
+	// triangular over the groups, which visits each of them once for 2^n groups
+	struct ProbeSeq {
+		size_t mask;
+		size_t offset;
+		size_t index = 0;
+		ProbeSeq(size_t hash, size_t mask) noexcept : mask(mask), offset(hash & mask) {}
+		size_t Offset(size_t i) const noexcept { return (offset + i) & mask; }
+		void Next() noexcept {
+			index += Group::Width;
+			offset = (offset + index) & mask;
+		}
+	};
+	static size_t CapacityToGrowth(size_t capacity) noexcept {
+		return capacity - capacity / 8;
 	}
-	static size_t GetHash(size_t hash, size_t size) noexcept {
-		return hash & (size - 1);
+	static size_t GrowthToCapacity(size_t growth) noexcept {
+		size_t capacity = MinCapacity;
+		while (CapacityToGrowth(capacity) < growth) capacity = capacity * 2 + 1;
+		return capacity;
 	}
-	void Resize(size_t newCapacity) noexcept {
-		size_t capacity = nodeVec.size();
-		if (capacity >= newCapacity) return;
-		allocatedNodes.reserve(newCapacity);
-		HashArray newNode(newCapacity);
-		for (auto node : allocatedNodes) {
-			auto next = node->next;
-			node->last = nullptr;
-			node->next = nullptr;
-			size_t hashValue = hsFunc(node->first);
-			hashValue = GetHash(hashValue, newCapacity);
-			LinkNode*& targetHeaderLink = newNode[hashValue];
-			if (!targetHeaderLink) {
-				targetHeaderLink = node;
-			} else {
-				node->next = targetHeaderLink;
-				targetHeaderLink->last = node;
-				targetHeaderLink = node;
+	static size_t SlotOffset(size_t capacity) noexcept {
+		return (capacity + Group::Width + alignof(NodePair) - 1) & ~(alignof(NodePair) - 1);
+	}
+	void SetEmpty() noexcept {
+		ctrl = const_cast<int8_t*>(vstd::detail::HashMapEmptyGroup);
+		slots = nullptr;
+		capacity = 0;
+		mSize = 0;
+		growthLeft = 0;
+	}
+	void ResetCtrl() noexcept {
+		memset(ctrl, Ctrl::Empty, capacity + Group::Width);
+		ctrl[capacity] = Ctrl::Sentinel;
+		growthLeft = CapacityToGrowth(capacity) - mSize;
+	}
+	void SetCtrl(size_t i, int8_t h) noexcept {
+		ctrl[i] = h;
+		ctrl[((i - (Group::Width - 1)) & capacity) + (Group::Width - 1)] = h;
+	}
+	void DestroyAll() noexcept {
+		if constexpr (!std::is_trivially_destructible_v<NodePair>) {
+			for (size_t i = 0; i < capacity; ++i) {
+				if (ctrl[i] >= 0) slots[i].~NodePair();
 			}
 		}
-		nodeVec = newNode;
 	}
-	static Index EmptyIndex() noexcept {
-		return Index(nullptr, -1, nullptr);
+	template<typename Key>
+	NodePair* FindNode(Key const& key, size_t hash) const noexcept {
+		auto h2 = H2(hash);
+		for (ProbeSeq seq(H1(hash), capacity);; seq.Next()) {
+			Group group(ctrl + seq.offset);
+			for (auto mask = group.Match(h2); mask != 0; mask &= mask - 1) {
+				auto node = slots + seq.Offset(std::countr_zero(mask));
+				if (KeyEqual(node->first, key)) [[likely]]
+					return node;
+			}
+			if (group.MatchEmpty()) return nullptr;
+		}
+	}
+	size_t FindFirstNonFull(size_t hash) const noexcept {
+		for (ProbeSeq seq(H1(hash), capacity);; seq.Next()) {
+			if (auto mask = Group(ctrl + seq.offset).MatchEmptyOrDeleted()) {
+				return seq.Offset(std::countr_zero(mask));
+			}
+		}
+	}
+	void Resize(size_t newCapacity) noexcept {
+		auto oldCtrl = ctrl;
+		auto oldSlots = slots;
+		auto oldCapacity = capacity;
+		auto memory = reinterpret_cast<uint8_t*>(allocHandle.Malloc(SlotOffset(newCapacity) + sizeof(NodePair) * newCapacity));
+		ctrl = reinterpret_cast<int8_t*>(memory);
+		slots = reinterpret_cast<NodePair*>(memory + SlotOffset(newCapacity));
+		capacity = newCapacity;
+		ResetCtrl();
+		for (size_t i = 0; i < oldCapacity; ++i) {
+			if (oldCtrl[i] < 0) continue;
+			auto hash = GetHash(oldSlots[i].first);
+			auto j = FindFirstNonFull(hash);
+			SetCtrl(j, H2(hash));
+			new (slots + j) NodePair(std::move(oldSlots[i].first), std::move(oldSlots[i].second));
+			oldSlots[i].~NodePair();
+		}
+		if (oldCapacity != 0) allocHandle.Free(oldCtrl);
+	}
+	// the node of the key, or a slot for it with only the control byte set
+	template<typename Key>
+	std::pair<NodePair*, bool> FindOrPrepareInsert(Key const& key, size_t hash) noexcept {
+		if (auto node = FindNode(key, hash)) return {node, false};
+		auto i = FindFirstNonFull(hash);
+		if (growthLeft == 0 && ctrl[i] != Ctrl::Deleted) [[unlikely]] {
+			// only drops the deleted slots if they take up at least half of the growth
+			Resize(capacity == 0
+					   ? MinCapacity
+					   : (mSize <= CapacityToGrowth(capacity) / 2 ? capacity : capacity * 2 + 1));
+			i = FindFirstNonFull(hash);
+		}
+		++mSize;
+		growthLeft -= (ctrl[i] == Ctrl::Empty);
+		SetCtrl(i, H2(hash));
+		return {slots + i, true};
+	}
+	void EraseAt(size_t i) noexcept {
+		slots[i].~NodePair();
+		--mSize;
+		// no probe can have passed the slot if there is an empty one within a group on either
+		// side of it, so it may be empty again instead of marked deleted
+		auto emptyBefore = Group(ctrl + ((i - Group::Width) & capacity)).MatchEmpty();
+		auto emptyAfter = Group(ctrl + i).MatchEmpty();
+		auto wasNeverFull = emptyBefore && emptyAfter &&
+							static_cast<size_t>(std::countr_zero(emptyAfter) + std::countl_zero(static_cast<uint16_t>(emptyBefore))) < Group::Width;
+		SetCtrl(i, wasNeverFull ? Ctrl::Empty : Ctrl::Deleted);
+		growthLeft += wasNeverFull;
+	}
+	template<typename Key>
+	Index FindIndex(Key const& key) const noexcept {
+		auto hash = GetHash(key);
+		return Index(this, hash, FindNode(key, hash));
+	}
+	template<typename Key>
+	void RemoveKey(Key const& key) noexcept {
+		if (auto node = FindNode(key, GetHash(key))) EraseAt(node - slots);
 	}
-
 public:
 	size_t Size() const {
-		return allocatedNodes.size();
+		return mSize;
 	}
 	decltype(auto) begin() const {
-		return Iterator(allocatedNodes.begin());
+		return Iterator(ctrl, slots);
 	}
 	decltype(auto) end() const {
-		return Iterator(allocatedNodes.end());
+		return Iterator(ctrl + capacity, slots + capacity);
 	}
 	//////////////////Construct & Destruct
-	HashMap(size_t capacity) noexcept : pool(capacity) {
-		if (capacity < 2) capacity = 2;
-		capacity = GetPow2Size(capacity);
-		nodeVec = HashArray(capacity);
-		allocatedNodes.reserve(capacity);
+	// with room for capacity elements
+	HashMap(size_t capacity) noexcept {
+		SetEmpty();
+		if (capacity != 0) Resize(GrowthToCapacity(capacity));
 	}
 	HashMap(SelfType&& map)
-		: allocatedNodes(std::move(map.allocatedNodes)),
-		  nodeVec(std::move(map.nodeVec)),
-		  pool(std::move(map.pool)) {
+		: ctrl(map.ctrl),
+		  slots(map.slots),
+		  capacity(map.capacity),
+		  mSize(map.mSize),
+		  growthLeft(map.growthLeft) {
+		map.SetEmpty();
 	}
 
 	void operator=(SelfType&& map) {
@@ -246,132 +350,58 @@ public:
 		new (this) SelfType(std::move(map));
 	}
 	~HashMap() noexcept {
-		for (auto& ite : allocatedNodes) {
-			pool.Delete(ite);
-		}
+		DestroyAll();
+		if (capacity != 0) allocHandle.Free(ctrl);
 	}
 	HashMap() noexcept : HashMap(16) {}
 	///////////////////////
 	Index Insert(const K& key, const V& value) noexcept {
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue;
-
-		auto a = nodeVec.size();
-		hashValue = GetHash(hashOriginValue, nodeVec.size());
-		for (LinkNode* node = nodeVec[hashValue]; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				node->second = value;
-				return Index(this, hashOriginValue, node);
-			}
-		}
-
-		size_t targetCapacity = (size_t)((allocatedNodes.size() + 1) / 0.75);
-		if (targetCapacity < 16) targetCapacity = 16;
-		if (targetCapacity >= nodeVec.size()) {
-			Resize(GetPow2Size(targetCapacity));
-			hashValue = GetHash(hashOriginValue, nodeVec.size());
+		auto hash = GetHash(key);
+		auto [node, isNew] = FindOrPrepareInsert(key, hash);
+		if (isNew) {
+			new (node) NodePair(key, value);
+		} else {
+			node->second = value;
 		}
-		LinkNode* newNode = GetNewLinkNode(key, value);
-		LinkNode::Add(nodeVec[hashValue], newNode);
-		return Index(this, hashOriginValue, newNode);
+		return Index(this, hash, node);
 	}
 
 	Index Insert(const K& key, V&& value) noexcept {
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue;
-
-		auto a = nodeVec.size();
-		hashValue = GetHash(hashOriginValue, nodeVec.size());
-		for (LinkNode* node = nodeVec[hashValue]; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				node->second = std::move(value);
-				return Index(this, hashOriginValue, node);
-			}
-		}
-
-		size_t targetCapacity = (size_t)((allocatedNodes.size() + 1) / 0.75);
-		if (targetCapacity < 16) targetCapacity = 16;
-		if (targetCapacity >= nodeVec.size()) {
-			Resize(GetPow2Size(targetCapacity));
-			hashValue = GetHash(hashOriginValue, nodeVec.size());
+		auto hash = GetHash(key);
+		auto [node, isNew] = FindOrPrepareInsert(key, hash);
+		if (isNew) {
+			new (node) NodePair(key, std::move(value));
+		} else {
+			node->second = std::move(value);
 		}
-		LinkNode* newNode = GetNewLinkNode(key, std::move(value));
-		LinkNode::Add(nodeVec[hashValue], newNode);
-		return Index(this, hashOriginValue, newNode);
+		return Index(this, hash, node);
 	}
 	template<typename... ARGS>
 	Index ForceEmplace(const K& key, ARGS&&... args) {
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue;
-
-		auto a = nodeVec.size();
-		hashValue = GetHash(hashOriginValue, nodeVec.size());
-		for (LinkNode* node = nodeVec[hashValue]; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				//node->second = std::move(value);
-				node->second.~V();
-				new (&node->second) V(std::forward<ARGS>(args)...);
-				return Index(this, hashOriginValue, node);
-			}
-		}
-
-		size_t targetCapacity = (size_t)((allocatedNodes.size() + 1) / 0.75);
-		if (targetCapacity < 16) targetCapacity = 16;
-		if (targetCapacity >= nodeVec.size()) {
-			Resize(GetPow2Size(targetCapacity));
-			hashValue = GetHash(hashOriginValue, nodeVec.size());
+		auto hash = GetHash(key);
+		auto [node, isNew] = FindOrPrepareInsert(key, hash);
+		if (isNew) {
+			new (node) NodePair(key, std::forward<ARGS>(args)...);
+		} else {
+			node->second.~V();
+			new (&node->second) V(std::forward<ARGS>(args)...);
 		}
-		LinkNode* newNode = GetNewLinkNode(key, std::forward<ARGS>(args)...);
-		LinkNode::Add(nodeVec[hashValue], newNode);
-		return Index(this, hashOriginValue, newNode);
+		return Index(this, hash, node);
 	}
 	template<typename... ARGS>
 	Index Emplace(const K& key, ARGS&&... args) {
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue;
-
-		auto a = nodeVec.size();
-		hashValue = GetHash(hashOriginValue, nodeVec.size());
-		for (LinkNode* node = nodeVec[hashValue]; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				return Index(this, hashOriginValue, node);
-			}
-		}
-
-		size_t targetCapacity = (size_t)((allocatedNodes.size() + 1) / 0.75);
-		if (targetCapacity < 16) targetCapacity = 16;
-		if (targetCapacity >= nodeVec.size()) {
-			Resize(GetPow2Size(targetCapacity));
-			hashValue = GetHash(hashOriginValue, nodeVec.size());
-		}
-		LinkNode* newNode = GetNewLinkNode(key, std::forward<ARGS>(args)...);
-		LinkNode::Add(nodeVec[hashValue], newNode);
-		return Index(this, hashOriginValue, newNode);
+		auto hash = GetHash(key);
+		auto [node, isNew] = FindOrPrepareInsert(key, hash);
+		if (isNew) new (node) NodePair(key, std::forward<ARGS>(args)...);
+		return Index(this, hash, node);
 	}
 	template<typename... ARGS>
 	Index TryEmplace(bool& isNewElement, const K& key, ARGS&&... args) {
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue;
-
-		auto a = nodeVec.size();
-		hashValue = GetHash(hashOriginValue, nodeVec.size());
-		for (LinkNode* node = nodeVec[hashValue]; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				isNewElement = false;
-				return Index(this, hashOriginValue, node);
-			}
-		}
-
-		size_t targetCapacity = (size_t)((allocatedNodes.size() + 1) / 0.75);
-		if (targetCapacity < 16) targetCapacity = 16;
-		if (targetCapacity >= nodeVec.size()) {
-			Resize(GetPow2Size(targetCapacity));
-			hashValue = GetHash(hashOriginValue, nodeVec.size());
-		}
-		LinkNode* newNode = GetNewLinkNode(key, std::forward<ARGS>(args)...);
-		LinkNode::Add(nodeVec[hashValue], newNode);
-		isNewElement = true;
-		return Index(this, hashOriginValue, newNode);
+		auto hash = GetHash(key);
+		auto [node, isNew] = FindOrPrepareInsert(key, hash);
+		if (isNew) new (node) NodePair(key, std::forward<ARGS>(args)...);
+		isNewElement = isNew;
+		return Index(this, hash, node);
 	}
 
 	//void(size_t, K const&, V&)
@@ -381,137 +411,92 @@ public:
 		static constexpr size_t ArgSize = FuncArgCount<FuncType>;
 		using ReturnType = typename FunctionDataType<FuncType>::RetType;
 		static_assert(std::is_same_v<ReturnType, void>, "Iterate functor must return void!");
-		if constexpr (ArgSize == 3) {
-			for (size_t i = 0; i < allocatedNodes.size(); ++i) {
-				auto vv = allocatedNodes[i];
-				func(i, (K const&)vv->first, vv->second);
-			}
-		} else if constexpr (ArgSize == 2) {
-			for (auto vv : allocatedNodes) {
+		size_t index = 0;
+		for (size_t i = 0; i < capacity; ++i) {
+			if (ctrl[i] < 0) continue;
+			auto vv = slots + i;
+			if constexpr (ArgSize == 3) {
+				func(index++, (K const&)vv->first, vv->second);
+			} else if constexpr (ArgSize == 2) {
 				func((K const&)vv->first, vv->second);
-			}
-		} else if constexpr (ArgSize == 1) {
-			for (auto vv : allocatedNodes) {
+			} else if constexpr (ArgSize == 1) {
 				func(vv->second);
+			} else {
+				static_assert(std::_Always_false<Func>, "Invalid Iterate Functions");
 			}
-		} else {
-			static_assert(std::_Always_false<Func>, "Invalid Iterate Functions");
 		}
 	}
+	// room for capacity elements without rehashing
 	void Reserve(size_t capacity) noexcept {
-		size_t newCapacity = GetPow2Size(capacity);
-		Resize(newCapacity);
+		if (CapacityToGrowth(this->capacity) < capacity) Resize(GrowthToCapacity(capacity));
 	}
 	Index Find(const K& key) const noexcept {
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue = GetHash(hashOriginValue, nodeVec.size());
-		for (LinkNode* node = nodeVec[hashValue]; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				return Index(this, hashOriginValue, node);
-			}
-		}
-
-		return EmptyIndex();
+		return FindIndex(key);
+	}
+	template<typename Key>
+	requires vstd::detail::HashMapLookupKey<K, Key, Hash>
+	Index Find(const Key& key) const noexcept {
+		return FindIndex(key);
 	}
 	void Remove(const K& key) noexcept {
-
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue = GetHash(hashOriginValue, nodeVec.size());
-		LinkNode*& startNode = nodeVec[hashValue];
-		for (LinkNode* node = startNode; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				if (startNode == node) {
-					startNode = node->next;
-				}
-				if (node->next)
-					node->next->last = node->last;
-				if (node->last)
-					node->last->next = node->next;
-				DeleteLinkNode(node);
-				return;
-			}
-		}
+		RemoveKey(key);
+	}
+	template<typename Key>
+	requires vstd::detail::HashMapLookupKey<K, Key, Hash>
+	void Remove(const Key& key) noexcept {
+		RemoveKey(key);
 	}
 
 	void Remove(const Index& ite) noexcept {
-
-		size_t hashValue = GetHash(ite.hashValue, nodeVec.size());
-		if (nodeVec[hashValue] == ite.node) {
-			nodeVec[hashValue] = ite.node->next;
-		}
-		if (ite.node->last)
-			ite.node->last->next = ite.node->next;
-		if (ite.node->next)
-			ite.node->next->last = ite.node->last;
-		DeleteLinkNode(ite.node);
+		EraseAt(ite.node - slots);
 	}
 	V& operator[](const K& key) noexcept {
-
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue = GetHash(hashOriginValue, nodeVec.size());
-		for (LinkNode* node = nodeVec[hashValue]; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				return node->second;
-			}
-		}
-
-		return *(V*)nullptr;
+		return FindIndex(key).node->second;
 	}
 	V const& operator[](const K& key) const noexcept {
-
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue = GetHash(hashOriginValue, nodeVec.size());
-		for (LinkNode* node = nodeVec[hashValue]; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				return node->second;
-			}
-		}
-
-		return *(V const*)nullptr;
+		return FindIndex(key).node->second;
+	}
+	template<typename Key>
+	requires vstd::detail::HashMapLookupKey<K, Key, Hash>
+	V& operator[](const Key& key) noexcept {
+		return FindIndex(key).node->second;
+	}
+	template<typename Key>
+	requires vstd::detail::HashMapLookupKey<K, Key, Hash>
+	V const& operator[](const Key& key) const noexcept {
+		return FindIndex(key).node->second;
 	}
 	bool TryGet(const K& key, V& value) const noexcept {
-
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue = GetHash(hashOriginValue, nodeVec.size());
-		for (LinkNode* node = nodeVec[hashValue]; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				value = node->second;
-				return true;
-			}
+		if (auto node = FindNode(key, GetHash(key))) {
+			value = node->second;
+			return true;
 		}
-
 		return false;
 	}
-	bool Contains(const K& key) const noexcept {
-
-		size_t hashOriginValue = hsFunc(key);
-		size_t hashValue = GetHash(hashOriginValue, nodeVec.size());
-		for (LinkNode* node = nodeVec[hashValue]; node != nullptr; node = node->next) {
-			if (eqFunc(node->first, key)) {
-				return true;
-			}
+	template<typename Key>
+	requires vstd::detail::HashMapLookupKey<K, Key, Hash>
+	bool TryGet(const Key& key, V& value) const noexcept {
+		if (auto node = FindNode(key, GetHash(key))) {
+			value = node->second;
+			return true;
 		}
-
 		return false;
 	}
+	bool Contains(const K& key) const noexcept {
+		return FindNode(key, GetHash(key)) != nullptr;
+	}
+	template<typename Key>
+	requires vstd::detail::HashMapLookupKey<K, Key, Hash>
+	bool Contains(const Key& key) const noexcept {
+		return FindNode(key, GetHash(key)) != nullptr;
+	}
 	void Clear() noexcept {
-		if (allocatedNodes.empty()) return;
-		nodeVec.ClearAll();
-		for (auto& ite : allocatedNodes) {
-			pool.Delete(ite);
-		}
-		allocatedNodes.clear();
+		if (mSize == 0 && growthLeft == CapacityToGrowth(capacity)) return;
+		DestroyAll();
+		mSize = 0;
+		ResetCtrl();
 	}
-	size_t size() const noexcept { return allocatedNodes.size(); }
+	size_t size() const noexcept { return mSize; }
 
-	size_t GetCapacity() const noexcept { return nodeVec.size(); }
+	size_t GetCapacity() const noexcept { return capacity; }
 };
-
-template<typename K, typename V, typename Hash, typename Equal, VEngine_AllocType allocType>
-inline K const& HashMap<K, V, Hash, Equal, allocType>::Index::Key() const noexcept {
-	return node->first;
-}
-template<typename K, typename V, typename Hash, typename Equal, VEngine_AllocType allocType>
-inline V& HashMap<K, V, Hash, Equal, allocType>::Index::Value() const noexcept {
-	return node->second;
-}
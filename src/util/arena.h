@@ -139,7 +139,7 @@ public:
     T &emplace_back(Args &&...args) {
         if (_size == _capacity) {
             _capacity = next_pow2(_capacity * 2u);
-            LUISA_VERBOSE_WITH_LOCATION(
+            LUISA_TRACE(
                 "Capacity of ArenaVector exceeded, reallocating for {} ({} bytes).",
                 _capacity, _capacity * sizeof(T));
             auto new_data = _arena.allocate<T>(_capacity);
@@ -215,9 +215,9 @@ public:
             return std::make_pair(_count, _total);
         }();
         auto object = luisa::construct_at(&node->object, std::forward<Args>(args)...);
-        LUISA_VERBOSE_WITH_LOCATION(
-            "Created pool object at address {} (available = {}, total = {}).",
-            fmt::ptr(object), count, total);
+        LUISA_TRACE(
+            "Created pool object at address {:#x} (available = {}, total = {}).",
+            object, count, total);
         return object;
     }
 
@@ -230,9 +230,9 @@ public:
             _count++;
             return std::make_pair(_count, _total);
         }();
-        LUISA_VERBOSE_WITH_LOCATION(
-            "Recycled pool object at address {} (available = {}, total = {}).",
-            fmt::ptr(object), count, total);
+        LUISA_TRACE(
+            "Recycled pool object at address {:#x} (available = {}, total = {}).",
+            object, count, total);
     }
 };
 
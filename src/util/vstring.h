@@ -470,16 +470,25 @@ inline vstd::wstring operator+(const wchar_t* c, const vstd::wstring& str) noexc
 
 #include <util/Hash.h>
 namespace vstd {
+// transparent, so that HashMap looks up views without copying them into strings
 template<>
 struct hash<vstd::string> {
+	using is_transparent = void;
 	inline size_t operator()(const vstd::string& str) const noexcept {
 		return Hash::CharArrayHash(str.c_str(), str.size());
 	}
+	inline size_t operator()(const vstd::string_view& str) const noexcept {
+		return Hash::CharArrayHash(str.c_str(), str.size());
+	}
 };
 template<>
 struct hash<vstd::wstring> {
+	using is_transparent = void;
 	inline size_t operator()(const vstd::wstring& str) const noexcept {
 		return Hash::CharArrayHash((const char*)str.c_str(), str.size() * 2);
 	}
+	inline size_t operator()(const vstd::wstring_view& str) const noexcept {
+		return Hash::CharArrayHash((const char*)str.c_str(), str.size() * 2);
+	}
 };
 }// namespace vstd